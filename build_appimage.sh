@@ -3,10 +3,19 @@ set -e
 
 # Script to build AppImage for KDE Browser Picker
 # Requires: linuxdeploy, linuxdeploy-plugin-qt
+#
+# Set OPTIMIZE_STARTUP=1 to build with LTO and PGO (see tools/pgo/build-optimized.sh)
+#
+# The image is packed with appimagetool using SQUASHFS_COMP (default: zstd) and
+# SQUASHFS_BLOCK_SIZE (default: 1M), which favours decompression speed over size.
+# resources/appimage/AppRun adds the extracted runtime cache mode.
 
 APP_NAME="kde-browser-picker"
 APP_VERSION="1.0.0"
 ARCH=$(uname -m)
+SQUASHFS_COMP="${SQUASHFS_COMP:-zstd}"
+SQUASHFS_BLOCK_SIZE="${SQUASHFS_BLOCK_SIZE:-1M}"
+BENCH_RUNS="${BENCH_RUNS:-20}"
 
 # Colors for output
 RED='\033[0;31m'
@@ -31,18 +40,25 @@ rm -rf $BUILD_DIR
 mkdir -p $BUILD_DIR
 cd $BUILD_DIR
 
-# Configure with CMake
-echo -e "${YELLOW}Configuring with CMake...${NC}"
-cmake .. \
-    -DCMAKE_BUILD_TYPE=Release \
-    -DCMAKE_INSTALL_PREFIX=/usr \
-    -DENABLE_CLANG_TIDY=OFF \
-    -DENABLE_CPPCHECK=OFF \
-    -DBUILD_TESTS=OFF
-
-# Build
-echo -e "${YELLOW}Building...${NC}"
-make -j$(nproc)
+if [ "${OPTIMIZE_STARTUP:-0}" = "1" ]; then
+    # Instrumented build, training run and optimized rebuild in this directory
+    echo -e "${YELLOW}Building with startup optimizations (LTO + PGO)...${NC}"
+    ../tools/pgo/build-optimized.sh . -DCMAKE_INSTALL_PREFIX=/usr -DKDE_INSTALL_LIBDIR=lib
+else
+    # Configure with CMake
+    echo -e "${YELLOW}Configuring with CMake...${NC}"
+    cmake .. \
+        -DCMAKE_BUILD_TYPE=Release \
+        -DCMAKE_INSTALL_PREFIX=/usr \
+        -DKDE_INSTALL_LIBDIR=lib \
+        -DENABLE_CLANG_TIDY=OFF \
+        -DENABLE_CPPCHECK=OFF \
+        -DBUILD_TESTS=OFF
+
+    # Build
+    echo -e "${YELLOW}Building...${NC}"
+    make -j$(nproc)
+fi
 
 # Create AppDir
 echo -e "${YELLOW}Creating AppDir...${NC}"
@@ -99,19 +115,67 @@ if [ ! -f ../linuxdeploy-plugin-qt-${ARCH}.AppImage ]; then
     chmod +x ../linuxdeploy-plugin-qt-${ARCH}.AppImage
 fi
 
-# Create AppImage
-echo -e "${YELLOW}Creating AppImage...${NC}"
-export LDAI_OUTPUT="${APP_NAME}-${APP_VERSION}-${ARCH}.AppImage"
-export LDAI_UPDATE_INFORMATION="gh-releases-zsync|moezakura|kde-browser-picker|latest|${APP_NAME}-*-${ARCH}.AppImage.zsync"
+# Download appimagetool if not present
+if [ ! -f ../appimagetool-${ARCH}.AppImage ]; then
+    echo -e "${YELLOW}Downloading appimagetool...${NC}"
+    wget -c "https://github.com/AppImage/appimagetool/releases/download/continuous/appimagetool-${ARCH}.AppImage" -P ..
+    chmod +x ../appimagetool-${ARCH}.AppImage
+fi
 
+# Deploy libraries and Qt plugins into the AppDir
+echo -e "${YELLOW}Deploying dependencies...${NC}"
 ../linuxdeploy-${ARCH}.AppImage \
     --appdir AppDir \
     --plugin qt \
-    --output appimage \
     --desktop-file=AppDir/usr/share/applications/${APP_NAME}.desktop \
     --icon-file=AppDir/usr/share/icons/hicolor/128x128/apps/${APP_NAME}.png \
     --executable=AppDir/usr/bin/${APP_NAME}
 
+# Entry point with the extracted runtime cache; linuxdeploy's AppRun is kept as the inner entry
+mv AppDir/AppRun AppDir/AppRun.linuxdeploy
+install -m 755 ../resources/appimage/AppRun AppDir/AppRun
+install -m 755 ../resources/appimage/kbp-content-hash AppDir/kbp-content-hash
+AppDir/kbp-content-hash AppDir > AppDir/.kbp-content-hash
+
+# Create AppImage
+echo -e "${YELLOW}Creating AppImage (${SQUASHFS_COMP}, ${SQUASHFS_BLOCK_SIZE} blocks)...${NC}"
+APPIMAGE_FILE="${APP_NAME}-${APP_VERSION}-${ARCH}.AppImage"
+ARCH=${ARCH} ../appimagetool-${ARCH}.AppImage \
+    --comp "${SQUASHFS_COMP}" \
+    --mksquashfs-opt -b --mksquashfs-opt "${SQUASHFS_BLOCK_SIZE}" \
+    -u "gh-releases-zsync|moezakura|kde-browser-picker|latest|${APP_NAME}-*-${ARCH}.AppImage.zsync" \
+    AppDir "${APPIMAGE_FILE}"
+
+# Startup comparison: mounted image vs. extracted cache (first run excluded)
+median_ms() {
+    local samples=()
+    local start end
+    for _ in $(seq "${BENCH_RUNS}"); do
+        start=$(date +%s%N)
+        "$@" > /dev/null 2>&1 || true
+        end=$(date +%s%N)
+        samples+=($(( (end - start) / 1000000 )))
+    done
+    printf '%s\n' "${samples[@]}" | sort -n | awk '{ a[NR] = $1 } END { print a[int((NR + 1) / 2)] }'
+}
+
+BENCH_HOME="$(mktemp -d)"
+if XDG_CACHE_HOME="${BENCH_HOME}/cache" XDG_DATA_HOME="${BENCH_HOME}/data" QT_QPA_PLATFORM=offscreen \
+        ./"${APPIMAGE_FILE}" --version > /dev/null 2>&1; then
+    echo -e "${YELLOW}Measuring startup (median of ${BENCH_RUNS} runs of --version)...${NC}"
+    export XDG_CACHE_HOME="${BENCH_HOME}/cache" XDG_DATA_HOME="${BENCH_HOME}/data" QT_QPA_PLATFORM=offscreen
+    MOUNTED=$(KBP_APPIMAGE_CACHE=0 median_ms ./"${APPIMAGE_FILE}" --version)
+    CACHED=$(median_ms ./"${APPIMAGE_FILE}" --version)
+    LAUNCHER=$(median_ms "${BENCH_HOME}/data/kde-browser-picker/launcher" --version)
+    unset XDG_CACHE_HOME XDG_DATA_HOME QT_QPA_PLATFORM
+    printf '  %-40s %6s ms\n' "mounted image (KBP_APPIMAGE_CACHE=0)" "${MOUNTED}"
+    printf '  %-40s %6s ms\n' "AppImage with extracted cache" "${CACHED}"
+    printf '  %-40s %6s ms\n' "launcher (no mount, --register-default)" "${LAUNCHER}"
+else
+    echo -e "${YELLOW}Skipping startup measurement (the AppImage cannot run here, e.g. no FUSE)${NC}"
+fi
+rm -rf "${BENCH_HOME}"
+
 # Move AppImage to parent directory
 mv *.AppImage ..
 
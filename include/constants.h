@@ -20,6 +20,12 @@ namespace Constants {
     constexpr int DEFAULT_TIMEOUT = 10;
     constexpr int MIN_TIMEOUT = 5;
     constexpr int MAX_TIMEOUT = 60;
+
+    /**
+     * @brief 起動中のブラウザへのURLの受け渡しで応答を待つ最大時間（ミリ秒）
+     * 受け渡しはGUIスレッドで行うため短くし、応答がなければ通常の起動に切り替える
+     */
+    constexpr int REMOTE_OPEN_TIMEOUT_MS = 300;
     
     /**
      * @brief 制限値
@@ -77,11 +83,16 @@ namespace Constants {
     constexpr auto CONFIG_GROUP_GENERAL = "General";
     constexpr auto CONFIG_GROUP_BROWSERS = "Browsers";
     constexpr auto CONFIG_GROUP_LAST_USED = "LastUsed";
+    constexpr auto CONFIG_GROUP_LAUNCH_STATS = "LaunchStats";
+    constexpr auto CONFIG_GROUP_HOST_HISTORY = "HostHistory";
+    constexpr auto CONFIG_GROUP_SPECULATIVE = "Speculative";
     
     constexpr auto CONFIG_KEY_DEFAULT_TIMEOUT = "DefaultTimeout";
     constexpr auto CONFIG_KEY_REMEMBER_LAST_USED = "RememberLastUsed";
     constexpr auto CONFIG_KEY_SHOW_TRAY_ICON = "ShowTrayIcon";
     constexpr auto CONFIG_KEY_WINDOW_GEOMETRY = "WindowGeometry";
+    constexpr auto CONFIG_KEY_DNS_PREFETCH = "DnsPrefetch";
+    constexpr auto CONFIG_KEY_IDLE_RECLAIM_SECONDS = "IdleReclaimSeconds";
     
     /**
      * @brief ブラウザタイプ
@@ -106,6 +117,16 @@ namespace Constants {
         NotFound
     };
 
+    /**
+     * @brief 先行起動のキャンセル時の扱い
+     * ピッカーがキャンセルされたとき、先行起動したブラウザを残すか終了するか
+     */
+    // Speculative warm-start cancel policy
+    enum class SpeculativeCancelPolicy {
+        Keep,
+        Close
+    };
+
     /**
      * @brief YAML設定
      * YAMLによるブラウザ起動コマンドの上書き設定
@@ -114,6 +135,63 @@ namespace Constants {
     constexpr auto YAML_CONFIG_FILENAME_YAML = "kde-browser-picker.yaml";
     constexpr auto YAML_CONFIG_FILENAME_YML = "kde-browser-picker.yml";
     constexpr auto YAML_ENV_PATH = "KDE_BROWSER_PICKER_YAML"; // テスト・上級者向け: 明示パス指定
+    constexpr auto YAML_SYSTEM_CONFIG_DIR = "/etc/xdg"; // $XDG_CONFIG_DIRS が未設定の場合のシステム全体の層
+
+    /**
+     * @brief メモリ逼迫（PSI）設定
+     * 逼迫時に起動済みのブラウザを優先するためのしきい値
+     */
+    // Memory pressure (PSI)
+    constexpr auto MEMORY_PRESSURE_PATH = "/proc/pressure/memory";
+    constexpr double DEFAULT_MEMORY_PRESSURE_THRESHOLD = 10.0; // some avg10 (%)
+
+    /**
+     * @brief リソース使用量の表示
+     * 起動中のブラウザのPSS/CPU集計結果のキャッシュ期間
+     */
+    // Resource telemetry
+    constexpr int TELEMETRY_CACHE_MS = 2000;
+
+    /**
+     * @brief 先行起動の予測
+     * frecencyで予測する場合の最小スコア（直近4日以内に3回起動で300）
+     */
+    // Speculative warm-start
+    constexpr double SPECULATIVE_MIN_FRECENCY = 300.0;
+
+    /**
+     * @brief プロファイルのアバター
+     * サムネイルの最大サイズ（物理ピクセル、32px表示の2倍まで対応）
+     */
+    // Profile avatars
+    constexpr int AVATAR_SIZE = 64;
+
+    /**
+     * @brief アイドル時のメモリ解放
+     * 非表示のまま経過すると項目のウィジェット・画像・キャッシュを破棄する秒数（0で解放しない）と、
+     * 再表示時に一覧を作り直す時間の上限の目安（初回描画の予算）
+     */
+    // Idle memory reclamation
+    constexpr int DEFAULT_IDLE_RECLAIM_SECONDS = 60;
+    constexpr int FIRST_PAINT_BUDGET_MS = 50;
+
+    /**
+     * @brief トレイのクイック起動
+     * メニューに表示するプロファイル数と、URLなしで起動する場合に開くページ
+     */
+    // Tray quick launch
+    constexpr int TRAY_QUICK_LAUNCH_COUNT = 5;
+    constexpr auto FIREFOX_NEW_WINDOW_URL = "about:home";
+    constexpr auto CHROME_NEW_WINDOW_URL = "chrome://newtab/";
+
+    /**
+     * @brief グローバルショートカット
+     * kglobalaccel のコンポーネント名・アクション名と既定のキー
+     */
+    // Global shortcut
+    constexpr auto GLOBAL_SHORTCUT_COMPONENT = "kde-browser-picker";
+    constexpr auto GLOBAL_SHORTCUT_ACTION = "open-clipboard-url";
+    constexpr auto GLOBAL_SHORTCUT_DEFAULT = "Meta+Alt+B";
 }
 
 #endif // KDE_BROWSER_PICKER_CONSTANTS_H
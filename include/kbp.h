@@ -0,0 +1,161 @@
+/**
+ * @file kbp.h
+ * @brief 組み込み用のコアライブラリ（libkbp-core）のC API
+ *
+ * ピッカーを別プロセスとして起動する代わりに、ブラウザとプロファイルの検出、
+ * URLの振り分け先の決定、起動を呼び出し側のプロセス内で行うためのAPIです。
+ *
+ * - コンテキストは不透明なハンドルで、kbp_open() で作成し kbp_close() で破棄します
+ * - 結果は呼び出し側が用意したバッファに書き込みます（ライブラリが確保したメモリを返すことはありません）
+ * - QCoreApplication / QApplication は不要です（検出は同期的に行い、イベントループを使用しません）
+ * - 文字列は全てUTF-8です
+ * - 1つのコンテキストを複数のスレッドから同時に使用しないでください
+ *
+ * 構造体の配置と関数の引数は KBP_API_VERSION が同じ間は変更しません。
+ */
+
+#ifndef KBP_H
+#define KBP_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(KBP_BUILDING_CORE)
+#define KBP_EXPORT __attribute__((visibility("default")))
+#else
+#define KBP_EXPORT
+#endif
+
+/** @brief C APIのバージョン（互換性のない変更で増やす） */
+#define KBP_API_VERSION 1
+
+#define KBP_BROWSER_ID_MAX 32       ///< ブラウザIDの最大長（終端のNULを含む）
+#define KBP_PROFILE_ID_MAX 256      ///< プロファイルIDの最大長（終端のNULを含む）
+#define KBP_DISPLAY_NAME_MAX 256    ///< 表示名の最大長（終端のNULを含む）
+
+/**
+ * @brief 結果コード
+ */
+typedef enum kbp_status {
+    KBP_OK = 0,                         ///< 成功
+    KBP_ERROR_INVALID_ARGUMENT = 1,     ///< 引数が不正（NULLなど）
+    KBP_ERROR_VERSION_MISMATCH = 2,     ///< kbp_open() に渡したAPIバージョンに対応していない
+    KBP_ERROR_OUT_OF_MEMORY = 3,        ///< コンテキストを確保できない
+    KBP_ERROR_INVALID_URL = 4,          ///< URLが検証を通らない
+    KBP_ERROR_NOT_FOUND = 5,            ///< 該当するプロファイルがない
+    KBP_ERROR_BUFFER_TOO_SMALL = 6,     ///< 配列に全ての結果が収まらない（収まる分は書き込み済み）
+    KBP_ERROR_LAUNCH_FAILED = 7         ///< ブラウザの起動に失敗
+} kbp_status;
+
+/**
+ * @brief 振り分け先を決めた理由
+ */
+typedef enum kbp_reason {
+    KBP_REASON_HOST = 0,        ///< 前回このホストを開いたプロファイル
+    KBP_REASON_DEFAULT = 1      ///< デフォルトプロファイル（最後に使用したもの、または一覧の先頭）
+} kbp_reason;
+
+/** @brief コンテキスト（不透明なハンドル） */
+typedef struct kbp_context kbp_context;
+
+/**
+ * @brief コンテキストの確保に使う関数
+ * @note NULLを渡した場合は malloc() / free() を使用します。
+ *       ライブラリ内部（Qt・KConfig）の確保は対象外です
+ */
+typedef struct kbp_allocator {
+    void* (*allocate)(size_t size, size_t alignment, void* user_data);  ///< 確保（失敗時はNULL）
+    void (*deallocate)(void* pointer, void* user_data);                  ///< 解放
+    void* user_data;                                                      ///< 各関数に渡す値
+} kbp_allocator;
+
+/**
+ * @brief 検出されたプロファイル
+ */
+typedef struct kbp_profile {
+    char browser[KBP_BROWSER_ID_MAX];           ///< ブラウザID（"firefox", "chrome"など）
+    char profile_id[KBP_PROFILE_ID_MAX];        ///< プロファイルID
+    char display_name[KBP_DISPLAY_NAME_MAX];    ///< 表示名（収まらない場合は文字の境界で切り詰め）
+    int is_enabled;                             ///< 設定で有効かどうか
+    int is_default;                             ///< ブラウザのデフォルトプロファイルかどうか
+} kbp_profile;
+
+/**
+ * @brief URLの振り分け先
+ */
+typedef struct kbp_target {
+    char browser[KBP_BROWSER_ID_MAX];       ///< ブラウザID
+    char profile_id[KBP_PROFILE_ID_MAX];    ///< プロファイルID
+    kbp_reason reason;                      ///< 選んだ理由
+} kbp_target;
+
+/**
+ * @brief コンテキストを作成し、ブラウザとプロファイルを検出
+ * @param api_version 呼び出し側がビルドされた KBP_API_VERSION
+ * @param allocator コンテキストの確保に使う関数（NULL可）
+ * @param out 作成したコンテキストの格納先
+ * @return KBP_OK: 成功
+ * @note 設定（kde-browser-pickerrc と YAML）はピッカーと共有します
+ */
+KBP_EXPORT kbp_status kbp_open(int api_version, const kbp_allocator* allocator, kbp_context** out);
+
+/**
+ * @brief コンテキストを破棄
+ * @param context kbp_open() で作成したコンテキスト（NULL可）
+ */
+KBP_EXPORT void kbp_close(kbp_context* context);
+
+/**
+ * @brief ブラウザとプロファイルを検出し直す
+ * @param context コンテキスト
+ * @return KBP_OK: 成功
+ */
+KBP_EXPORT kbp_status kbp_refresh(kbp_context* context);
+
+/**
+ * @brief URLを開くプロファイルを決定（起動はしない）
+ * @param context コンテキスト
+ * @param url 開くURL（スキームのない場合はコマンドラインと同じく "https://" を補う。"-" で始まる値は不正）
+ * @param target 結果の格納先
+ * @return KBP_OK: 成功, KBP_ERROR_NOT_FOUND: 有効なプロファイルがない
+ */
+KBP_EXPORT kbp_status kbp_resolve(kbp_context* context, const char* url, kbp_target* target);
+
+/**
+ * @brief プロファイルの一覧を取得
+ * @param context コンテキスト
+ * @param profiles 結果の格納先の配列（capacity が0の場合はNULL可）
+ * @param capacity 配列の要素数
+ * @param count 全体の件数の格納先
+ * @return KBP_OK: 成功, KBP_ERROR_BUFFER_TOO_SMALL: capacity が *count より小さい
+ * @note 表示順に並びます。IDが KBP_*_ID_MAX に収まらないプロファイルは含めません
+ */
+KBP_EXPORT kbp_status kbp_list_profiles(kbp_context* context, kbp_profile* profiles, size_t capacity,
+                                        size_t* count);
+
+/**
+ * @brief プロファイルを指定してURLを開く
+ * @param context コンテキスト
+ * @param browser ブラウザID（NULLの場合は kbp_resolve() の結果を使用）
+ * @param profile_id プロファイルID（browser がNULLの場合は無視）
+ * @param url 開くURL（kbp_resolve() と同じ検証）
+ * @return KBP_OK: 成功
+ * @note ピッカーから開いた場合と同様に、最後に使用したプロファイルと起動履歴を記録します
+ */
+KBP_EXPORT kbp_status kbp_launch(kbp_context* context, const char* browser, const char* profile_id,
+                                 const char* url);
+
+/**
+ * @brief 結果コードの説明
+ * @return 静的な文字列（解放不要）
+ */
+KBP_EXPORT const char* kbp_status_string(kbp_status status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // KBP_H
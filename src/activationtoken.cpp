@@ -0,0 +1,97 @@
+/**
+ * @file activationtoken.cpp
+ * @brief ActivationTokenクラスの実装
+ */
+
+#include "activationtoken.h"
+
+#include <QDebug>
+#include <QTimer>
+#include <QWindow>
+
+#include <KStartupInfo>
+#include <KWindowSystem>
+#if QT_VERSION_MAJOR >= 6
+#include <KWaylandExtras>
+#endif
+
+namespace {
+
+/// captureInherited() で保存したトークン
+ActivationToken::Token s_inherited;
+
+} // namespace
+
+ActivationToken::ActivationToken(QObject* parent)
+    : QObject(parent)
+    , m_timeout(new QTimer(this))
+    , m_pendingSerial(-1)
+{
+    m_timeout->setSingleShot(true);
+    connect(m_timeout, &QTimer::timeout, this, [this]() {
+        qDebug() << "No activation token from the compositor, using the inherited one";
+        finish(inherited());
+    });
+
+#if QT_VERSION_MAJOR >= 6
+    connect(KWaylandExtras::self(), &KWaylandExtras::xdgActivationTokenArrived,
+#else
+    connect(KWindowSystem::self(), &KWindowSystem::xdgActivationTokenArrived,
+#endif
+            this, [this](int serial, const QString& token) {
+        if (serial != m_pendingSerial) {
+            return;
+        }
+        Token result;
+        result.xdgActivationToken = token;
+        finish(token.isEmpty() ? inherited() : result);
+    });
+}
+
+void ActivationToken::captureInherited()
+{
+    s_inherited.xdgActivationToken = qEnvironmentVariable("XDG_ACTIVATION_TOKEN");
+    s_inherited.startupId = qEnvironmentVariable("DESKTOP_STARTUP_ID");
+}
+
+ActivationToken::Token ActivationToken::inherited()
+{
+    return s_inherited;
+}
+
+void ActivationToken::request(QWindow* window, const QString& appId, Callback callback, int timeoutMs)
+{
+    m_callback = std::move(callback);
+
+    if (KWindowSystem::isPlatformWayland() && window) {
+        // 直前の入力イベントのシリアルで要求すると、合成器はユーザー操作による起動とみなす
+#if QT_VERSION_MAJOR >= 6
+        m_pendingSerial = static_cast<int>(KWaylandExtras::lastInputSerial(window));
+        KWaylandExtras::requestXdgActivationToken(window, static_cast<quint32>(m_pendingSerial), appId);
+#else
+        m_pendingSerial = static_cast<int>(KWindowSystem::lastInputSerial(window));
+        KWindowSystem::requestXdgActivationToken(window, static_cast<quint32>(m_pendingSerial), appId);
+#endif
+        m_timeout->start(timeoutMs);
+        return;
+    }
+
+    Token token = inherited();
+    if (KWindowSystem::isPlatformX11()) {
+        // 現在のX時刻を含む新しい起動IDは、ピッカーへの最後の入力より新しいため拒否されない
+        token.startupId = QString::fromLatin1(KStartupInfo::createNewStartupId());
+    }
+    finish(token);
+}
+
+void ActivationToken::finish(const Token& token)
+{
+    m_timeout->stop();
+    m_pendingSerial = -1;
+
+    Callback callback = std::move(m_callback);
+    m_callback = nullptr;
+    if (callback) {
+        callback(token);
+    }
+}
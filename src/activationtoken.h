@@ -0,0 +1,87 @@
+/**
+ * @file activationtoken.h
+ * @brief 起動するブラウザへのアクティベーショントークンの受け渡し
+ *
+ * KWinのフォーカス奪取防止により、起動中のブラウザに開いたタブが
+ * 背面のウィンドウに留まることを防ぐため、ピッカー自身のアクティベーション
+ * コンテキストからトークンを取得してブラウザへ渡します。
+ *
+ * - Wayland: xdg-activation-v1 のトークン（XDG_ACTIVATION_TOKEN）
+ * - X11: 起動通知ID（DESKTOP_STARTUP_ID）
+ */
+
+#ifndef ACTIVATIONTOKEN_H
+#define ACTIVATIONTOKEN_H
+
+#include <QObject>
+#include <QString>
+
+#include <functional>
+
+#include "launchtoken.h"
+
+class QWindow;
+class QTimer;
+
+/**
+ * @class ActivationToken
+ * @brief アクティベーショントークンの取得
+ *
+ * トークンはユーザー操作（クリック・キー入力）の直後に request() で取得し、
+ * 1回の起動にのみ使用します。合成器がトークンを発行しない環境では、
+ * ピッカー自身が起動時に受け取ったトークンを使用します。
+ */
+class ActivationToken : public QObject {
+    Q_OBJECT
+
+public:
+    /// ブラウザに渡すトークン（コアライブラリと共通）
+    using Token = LaunchToken;
+
+    using Callback = std::function<void(const Token&)>;
+
+    explicit ActivationToken(QObject* parent = nullptr);
+    ~ActivationToken() override = default;
+
+    // コピーコンストラクタと代入演算子を削除
+    ActivationToken(const ActivationToken&) = delete;
+    ActivationToken& operator=(const ActivationToken&) = delete;
+
+    /**
+     * @brief ピッカーが受け取ったトークンを環境変数から保存
+     * @note QApplication の作成前に呼び出すこと（Qtが自身のウィンドウの
+     *       アクティベーションに使用して環境変数から削除するため）
+     */
+    static void captureInherited();
+
+    /**
+     * @brief captureInherited() で保存したトークンを取得
+     */
+    static Token inherited();
+
+    /**
+     * @brief 新しいトークンを要求
+     * @param window ユーザー操作を受けたウィンドウ
+     * @param appId 起動するアプリケーションのID（デスクトップファイル名）
+     * @param callback トークン取得後（またはタイムアウト後）に呼び出される関数
+     * @param timeoutMs 合成器の応答を待つ最大時間（ミリ秒）
+     */
+    void request(QWindow* window, const QString& appId, Callback callback, int timeoutMs = 200);
+
+    /**
+     * @brief 要求の完了待ちかどうか
+     */
+    bool isPending() const { return static_cast<bool>(m_callback); }
+
+private:
+    /**
+     * @brief 要求を完了してコールバックを呼び出す
+     */
+    void finish(const Token& token);
+
+    Callback m_callback;      ///< 実行中の要求のコールバック
+    QTimer* m_timeout;        ///< 合成器の応答待ちタイマー
+    int m_pendingSerial;      ///< 実行中のWayland要求のシリアル（-1: なし）
+};
+
+#endif // ACTIVATIONTOKEN_H
@@ -0,0 +1,140 @@
+/**
+ * @file avatarloader.cpp
+ * @brief AvatarLoaderクラスの実装
+ */
+
+#include "avatarloader.h"
+#include "constants.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QMetaObject>
+#include <QStandardPaths>
+
+AvatarLoader::AvatarLoader(const QString& cacheDir, QObject* parent)
+    : QObject(parent)
+    , m_cacheDir(cacheDir)
+{
+    if (m_cacheDir.isEmpty()) {
+        m_cacheDir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) +
+                     "/kde-browser-picker/avatars";
+    }
+    m_pool.setMaxThreadCount(1);
+}
+
+AvatarLoader::~AvatarLoader()
+{
+    // 読み込み中のタスクが this を参照するため完了を待つ
+    m_pool.waitForDone();
+}
+
+QImage AvatarLoader::cached(const QString& path) const
+{
+    return m_cache.value(path).image;
+}
+
+void AvatarLoader::clearCache()
+{
+    m_cache = QHash<QString, Entry>();
+}
+
+void AvatarLoader::request(const QString& path)
+{
+    if (path.isEmpty() || m_inFlight.contains(path)) {
+        return;
+    }
+
+    m_inFlight.insert(path);
+    const QDateTime knownMtime = m_cache.value(path).mtime;
+    const QString cacheDir = m_cacheDir;
+    m_pool.start([this, path, knownMtime, cacheDir]() {
+        // 更新日時が変わっていなければ画像は読まない
+        const QDateTime mtime = QFileInfo(path).lastModified();
+        const bool unchanged = mtime.isValid() && mtime == knownMtime;
+        QImage image;
+        if (!unchanged && mtime.isValid()) {
+            image = loadThumbnail(path, QSize(Constants::AVATAR_SIZE, Constants::AVATAR_SIZE), cacheDir);
+        }
+
+        QMetaObject::invokeMethod(this, [this, path, mtime, unchanged, image]() {
+            m_inFlight.remove(path);
+            if (unchanged) {
+                return;
+            }
+            const bool hadImage = !m_cache.value(path).image.isNull();
+            if (image.isNull() && !hadImage) {
+                return;
+            }
+            m_cache.insert(path, Entry{mtime, image});
+            emit avatarLoaded(path, image);
+        }, Qt::QueuedConnection);
+    });
+}
+
+QImage AvatarLoader::loadThumbnail(const QString& path, const QSize& size, const QString& cacheDir,
+                                   QDateTime* mtime)
+{
+    const QFileInfo info(path);
+    if (!info.isFile()) {
+        return QImage();
+    }
+    const QDateTime modified = info.lastModified();
+    if (mtime) *mtime = modified;
+
+    // 同じ更新日時のサムネイルがあればそれを使う
+    const QString thumbnail = cacheDir.isEmpty() ? QString() : cacheDir + "/" + thumbnailName(path, modified);
+    if (!thumbnail.isEmpty()) {
+        QImageReader cachedReader(thumbnail, "png");
+        QImage image = cachedReader.read();
+        if (!image.isNull()) {
+            return image;
+        }
+    }
+
+    // 元の画像は縮小しながらデコードし、フルサイズの画像は作らない
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+    const QSize original = reader.size();
+    if (original.isValid() && (original.width() > size.width() || original.height() > size.height())) {
+        reader.setScaledSize(original.scaled(size, Qt::KeepAspectRatio));
+    }
+    QImage image = reader.read();
+    if (image.isNull()) {
+        return QImage();
+    }
+    if (image.width() > size.width() || image.height() > size.height()) {
+        // サイズを事前に取得できない形式
+        image = image.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+
+    if (!thumbnail.isEmpty() && QDir().mkpath(cacheDir)) {
+        // 同じ画像の古いサムネイルを削除
+        const QString prefix = thumbnailName(path, QDateTime()).section('-', 0, 0);
+        const QStringList stale = QDir(cacheDir).entryList({prefix + "-*.png"}, QDir::Files);
+        for (const QString& name : stale) {
+            QFile::remove(cacheDir + "/" + name);
+        }
+
+        // 他のインスタンスが途中のファイルを読まないよう、一時ファイルから置き換える
+        const QString temporary = thumbnail + ".tmp";
+        QImageWriter writer(temporary, "png");
+        if (writer.write(image)) {
+            QFile::rename(temporary, thumbnail);
+        } else {
+            QFile::remove(temporary);
+        }
+    }
+
+    return image;
+}
+
+QString AvatarLoader::thumbnailName(const QString& path, const QDateTime& mtime)
+{
+    const QByteArray hash = QCryptographicHash::hash(QFile::encodeName(path), QCryptographicHash::Sha1).toHex();
+    return QString::fromLatin1(hash) + "-" + QString::number(mtime.isValid() ? mtime.toMSecsSinceEpoch() : 0) +
+           ".png";
+}
@@ -0,0 +1,110 @@
+/**
+ * @file avatarloader.h
+ * @brief Chromiumプロファイルのアバター画像の非同期読み込み
+ *
+ * アバター画像（"Google Profile Picture.png" など）をワーカースレッドで
+ * 表示サイズに縮小して読み込み、更新日時をキーにしたサムネイルとして
+ * ディスクとメモリにキャッシュします。GUIスレッドは画像のI/Oを行いません。
+ */
+
+#ifndef AVATARLOADER_H
+#define AVATARLOADER_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QHash>
+#include <QImage>
+#include <QSet>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+
+/**
+ * @class AvatarLoader
+ * @brief アバター画像のローダー
+ *
+ * 読み込みの手順（ワーカースレッド）:
+ * 1. 画像ファイルの更新日時を取得し、メモリキャッシュと同じなら何もしない
+ * 2. 同じ更新日時のサムネイルがディスクキャッシュにあればそれを読み込む
+ * 3. なければ QImageReader::setScaledSize() で縮小デコードし、サムネイルを保存
+ */
+class AvatarLoader : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief コンストラクタ
+     * @param cacheDir サムネイルの保存先（空の場合は ~/.cache/kde-browser-picker/avatars）
+     * @param parent 親オブジェクト
+     */
+    explicit AvatarLoader(const QString& cacheDir = QString(), QObject* parent = nullptr);
+    ~AvatarLoader() override;
+
+    // コピーコンストラクタと代入演算子を削除
+    AvatarLoader(const AvatarLoader&) = delete;
+    AvatarLoader& operator=(const AvatarLoader&) = delete;
+
+    /**
+     * @brief メモリキャッシュ上の画像を取得（I/Oなし）
+     * @param path 画像ファイルのパス
+     * @return 読み込み済みの画像（未読み込みの場合はnull）
+     */
+    QImage cached(const QString& path) const;
+
+    /**
+     * @brief 非同期に読み込みを要求
+     * @param path 画像ファイルのパス
+     * @note 結果は画像が新しく読み込まれた場合のみ、GUIスレッドで avatarLoaded() として通知されます
+     */
+    void request(const QString& path);
+
+    /**
+     * @brief メモリキャッシュの画像を破棄（ディスクのサムネイルは残す）
+     * @note 次の request() ではディスクのサムネイルから読み直します
+     */
+    void clearCache();
+
+    /**
+     * @brief 同期的にサムネイルを読み込む（テスト・ワーカースレッド用）
+     * @param path 画像ファイルのパス
+     * @param size サムネイルの最大サイズ
+     * @param cacheDir サムネイルの保存先（空の場合は保存しない）
+     * @param mtime 画像ファイルの更新日時の格納先（nullptr可）
+     * @return 縮小済みの画像（ファイルがない・読み込めない場合はnull）
+     */
+    static QImage loadThumbnail(const QString& path, const QSize& size, const QString& cacheDir,
+                                QDateTime* mtime = nullptr);
+
+    /**
+     * @brief サムネイルのファイル名を作成
+     * @param path 画像ファイルのパス
+     * @param mtime 画像ファイルの更新日時
+     * @return "<パスのSHA-1>-<更新日時(ms)>.png"
+     */
+    static QString thumbnailName(const QString& path, const QDateTime& mtime);
+
+signals:
+    /**
+     * @brief 画像が読み込まれたときに発行されるシグナル
+     * @param path 画像ファイルのパス
+     * @param image 縮小済みの画像（ファイルが削除された場合はnull）
+     */
+    void avatarLoaded(const QString& path, const QImage& image);
+
+private:
+    /**
+     * @struct Entry
+     * @brief メモリキャッシュのエントリ
+     */
+    struct Entry {
+        QDateTime mtime;     ///< 読み込み時の更新日時
+        QImage image;        ///< 縮小済みの画像
+    };
+
+    QString m_cacheDir;               ///< サムネイルの保存先
+    QHash<QString, Entry> m_cache;    ///< パス -> 読み込み済みの画像
+    QSet<QString> m_inFlight;         ///< 読み込み中のパス
+    QThreadPool m_pool;               ///< 読み込み用のワーカー（1スレッド）
+};
+
+#endif // AVATARLOADER_H
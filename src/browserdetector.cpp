@@ -8,8 +8,12 @@
  */
 
 #include "browserdetector.h"
+#include "detectionarena.h"
+#include "remoteopen.h"
+#include "tracepoints.h"
 
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QTextStream>
 #include <QJsonDocument>
@@ -22,10 +26,96 @@
 #include <QStringList>
 #include <QUrl>
 #include <QRegularExpression>
+#include <QFileInfo>
+#include <QSysInfo>
+#include <QSaveFile>
+#include <QMetaObject>
+
+#include <QThreadPool>
+
+#include <cerrno>
+#include <charconv>
+#include <iterator>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace {
+
+/// スナップショットの形式のバージョン
+constexpr int SNAPSHOT_VERSION = 1;
+
+/// 検出対象のブラウザID（検出順）
+const QStringList& detectableBrowsers()
+{
+    static const QStringList ids = {"firefox", "chrome", "chromium"};
+    return ids;
+}
+
+/**
+ * @brief Local State の info_cache からアバター画像のパスを決定
+ * @param configDir ユーザーデータディレクトリ
+ * @param entry info_cache のエントリ
+ * @param arena 検出のアリーナ
+ * @return 画像ファイルの絶対パス（該当なしの場合は空）
+ * @note ファイルの存在確認はワーカースレッドでの読み込み時に行う
+ */
+QString chromiumAvatarPath(std::string_view configDir, const DetectionArena::ChromiumEntry& entry,
+                           DetectionArena& arena)
+{
+    // サインイン中のGoogleアカウントの写真（プロファイルディレクトリ内）
+    if (!entry.gaiaPicture.empty() && entry.gaiaPicture.find('/') == std::string_view::npos &&
+        entry.useGaiaPicture) {
+        return DetectionArena::toQString(arena.join({configDir, "/", entry.directory, "/", entry.gaiaPicture}));
+    }
+
+    // 組み込みアバター "chrome://theme/IDR_PROFILE_AVATAR_<n>" はダウンロード済みの高解像度版のみ使用
+    static constexpr std::string_view highResAvatars[] = {
+        "avatar_generic.png", "avatar_generic_aqua.png", "avatar_generic_blue.png",
+        "avatar_generic_green.png", "avatar_generic_orange.png", "avatar_generic_purple.png",
+        "avatar_generic_red.png", "avatar_generic_yellow.png", "avatar_secret_agent.png",
+        "avatar_superhero.png", "avatar_volley_ball.png", "avatar_businessman.png",
+        "avatar_ninja.png", "avatar_alien.png", "avatar_smiley.png", "avatar_flower.png",
+        "avatar_pizza.png", "avatar_soccer.png", "avatar_burger.png", "avatar_cat.png",
+        "avatar_cupcake.png", "avatar_dog.png", "avatar_horse.png", "avatar_margarita.png",
+        "avatar_note.png", "avatar_sun_cloud.png",
+    };
+    constexpr std::string_view builtinPrefix = "chrome://theme/IDR_PROFILE_AVATAR_";
+    if (entry.avatarIcon.substr(0, builtinPrefix.size()) == builtinPrefix) {
+        const std::string_view digits = entry.avatarIcon.substr(builtinPrefix.size());
+        size_t index = 0;
+        const auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), index);
+        if (!digits.empty() && error == std::errc() && end == digits.data() + digits.size() &&
+            index < std::size(highResAvatars)) {
+            return DetectionArena::toQString(arena.join({configDir, "/Avatars/", highResAvatars[index]}));
+        }
+    }
+
+    return QString();
+}
+
+/// パスの最後の要素（トレースでブラウザを示すために使う）
+std::string_view fileName(std::string_view path)
+{
+    const size_t slash = path.rfind('/');
+    return slash == std::string_view::npos ? path : path.substr(slash + 1);
+}
+
+} // namespace
 
 BrowserDetector::BrowserDetector(QObject* parent)
     : QObject(parent)
+    , m_detectionsPending(0)
+{
+    m_detectionPool.setMaxThreadCount(detectableBrowsers().size());
+}
+
+BrowserDetector::~BrowserDetector()
 {
+    // 実行中の検出タスクが this を参照するため、中断して完了を待つ
+    cancelDetection();
+    m_detectionPool.waitForDone();
 }
 
 QMap<QString, BrowserDetector::BrowserInfo> BrowserDetector::detectBrowsers()
@@ -37,67 +127,354 @@ QMap<QString, BrowserDetector::BrowserInfo> BrowserDetector::detectBrowsers()
         return m_cachedBrowsers;
     }
 
+    cancelDetection();
+
     QMap<QString, BrowserInfo> browsers;
+    for (const QString& browserId : detectableBrowsers()) {
+        BrowserInfo info = probeBrowser(browserId);
+        if (!info.executable.isEmpty()) {
+            browsers[browserId] = info;
+            emit browserDetected(browserId);
+        }
+    }
 
-    // Firefoxを検出（YAML上書き優先）
-    if (m_enabledOverrides.contains("firefox") && !m_enabledOverrides.value("firefox")) {
-        // 明示的に無効化
-    } else {
-    QString firefoxExec = m_execOverrides.value("firefox");
-    if (firefoxExec.isEmpty()) {
-        firefoxExec = findExecutable(Constants::FIREFOX_EXECUTABLE);
+    m_cachedBrowsers = browsers;
+    m_lastDetection = QDateTime::currentDateTime();
+    m_verifiedBrowsers = QSet<QString>(detectableBrowsers().begin(), detectableBrowsers().end());
+    
+    return browsers;
+}
+
+BrowserDetector::BrowserInfo BrowserDetector::probeBrowser(const QString& browserId, const std::stop_token& stop)
+{
+    if (m_probeHook) {
+        m_probeHook(browserId, stop);
     }
-    if (!firefoxExec.isEmpty()) {
-        BrowserInfo firefox("Firefox", firefoxExec, Constants::BrowserType::Firefox);
-        firefox.iconPath = "/usr/share/icons/hicolor/48x48/apps/firefox.png";
-        firefox.profiles = getFirefoxProfiles();
-        browsers["firefox"] = firefox;
-        emit browserDetected("firefox");
+
+    // YAMLで明示的に無効化されたブラウザ
+    if (stop.stop_requested() ||
+        (m_enabledOverrides.contains(browserId) && !m_enabledOverrides.value(browserId))) {
+        return BrowserInfo();
     }
+
+    QElapsedTimer traceTimer;
+    if (KBP_TRACE_ENABLED(detection_end)) {
+        traceTimer.start();
     }
+    KBP_TRACE(detection_start, qUtf8Printable(browserId));
 
-    // Google Chromeを検出（YAML上書き優先）
-    if (m_enabledOverrides.contains("chrome") && !m_enabledOverrides.value("chrome")) {
-        // 無効化
+    // パスの連結やファイルの内容などの作業データはこのアリーナに置き、関数の終了時にまとめて破棄する
+    DetectionArena arena;
+    BrowserInfo info = browserSkeleton(browserId, arena);
+    if (info.executable.isEmpty() || stop.stop_requested()) {
+        KBP_TRACE(detection_end, qUtf8Printable(browserId), -1, traceTimer.nsecsElapsed() / 1000);
+        return BrowserInfo();
+    }
+
+    const QString chromeName = browserId == QLatin1String("chrome") ? QStringLiteral("google-chrome")
+                                                                    : QStringLiteral("chromium");
+    if (m_profileReader) {
+        info.profiles = m_profileReader(info.type == Constants::BrowserType::Firefox ? QStringLiteral("firefox")
+                                                                                    : chromeName,
+                                        stop);
     } else {
-        QString chromeExec = m_execOverrides.value("chrome");
-        if (chromeExec.isEmpty()) {
-            chromeExec = findExecutableFromList(Constants::CHROME_EXECUTABLE_VARIANTS);
+        info.profiles = info.type == Constants::BrowserType::Firefox
+            ? getFirefoxProfiles(arena, stop)
+            : getChromeProfiles(chromeName, arena, stop);
+    }
+    if (stop.stop_requested()) {
+        KBP_TRACE(detection_end, qUtf8Printable(browserId), -1, traceTimer.nsecsElapsed() / 1000);
+        return BrowserInfo();
+    }
+
+    // 起動引数はここで一度だけ展開し、起動時にはURLを追加するだけにする
+    compileLaunchTemplates(browserId, info);
+    KBP_TRACE(detection_end, qUtf8Printable(browserId), static_cast<int>(info.profiles.size()),
+              traceTimer.nsecsElapsed() / 1000);
+    return info;
+}
+
+BrowserDetector::BrowserInfo BrowserDetector::browserSkeleton(const QString& browserId,
+                                                              DetectionArena& arena) const
+{
+    // 実行ファイル（YAML上書き優先）
+    QString exec = m_execOverrides.value(browserId);
+    BrowserInfo info;
+    if (browserId == "firefox") {
+        if (exec.isEmpty()) {
+            exec = findExecutable(Constants::FIREFOX_EXECUTABLE, arena);
         }
-        if (!chromeExec.isEmpty()) {
-            BrowserInfo chrome("Google Chrome", chromeExec, Constants::BrowserType::Chrome);
-            chrome.iconPath = "/usr/share/icons/hicolor/48x48/apps/google-chrome.png";
-            chrome.profiles = getChromeProfiles("google-chrome");
-            browsers["chrome"] = chrome;
-            emit browserDetected("chrome");
+        info = BrowserInfo("Firefox", exec, Constants::BrowserType::Firefox);
+        info.iconPath = "/usr/share/icons/hicolor/48x48/apps/firefox.png";
+    } else if (browserId == "chrome") {
+        if (exec.isEmpty()) {
+            exec = findExecutableFromList(Constants::CHROME_EXECUTABLE_VARIANTS, arena);
         }
+        info = BrowserInfo("Google Chrome", exec, Constants::BrowserType::Chrome);
+        info.iconPath = "/usr/share/icons/hicolor/48x48/apps/google-chrome.png";
+    } else if (browserId == "chromium") {
+        if (exec.isEmpty()) {
+            exec = findExecutable(Constants::CHROMIUM_EXECUTABLE, arena);
+        }
+        info = BrowserInfo("Chromium", exec, Constants::BrowserType::Chromium);
+        info.iconPath = "/usr/share/icons/hicolor/48x48/apps/chromium.png";
+    }
+    return info;
+}
+
+void BrowserDetector::startDetection()
+{
+    cancelDetection();
+
+    m_detectionStop = std::stop_source();
+    const std::stop_token stop = m_detectionStop.get_token();
+    m_pendingBrowsers.clear();
+    m_detectionsPending = detectableBrowsers().size();
+
+    // 遅いブラウザ（NFS上のホームなど）が他のブラウザの検出を待たせないよう並列に実行
+    for (const QString& browserId : detectableBrowsers()) {
+        m_detectionPool.start([this, browserId, stop]() {
+            const BrowserInfo info = probeBrowser(browserId, stop);
+            QMetaObject::invokeMethod(this, [this, browserId, stop, info]() {
+                if (stop.stop_requested()) {
+                    return;
+                }
+                if (!info.executable.isEmpty()) {
+                    m_pendingBrowsers.insert(browserId, info);
+                }
+                if (--m_detectionsPending > 0) {
+                    return;
+                }
+
+                m_cachedBrowsers = m_pendingBrowsers;
+                m_pendingBrowsers.clear();
+                m_lastDetection = QDateTime::currentDateTime();
+                m_verifiedBrowsers = QSet<QString>(detectableBrowsers().begin(), detectableBrowsers().end());
+                for (auto it = m_cachedBrowsers.cbegin(); it != m_cachedBrowsers.cend(); ++it) {
+                    emit browserDetected(it.key());
+                }
+                saveSnapshot();
+                emit detectionFinished();
+            }, Qt::QueuedConnection);
+        });
     }
+}
+
+void BrowserDetector::cancelDetection()
+{
+    if (m_detectionsPending == 0) {
+        return;
+    }
+
+    // 実行中の検出は中断要求を見て終了し、GUIスレッドへの結果は破棄される
+    m_detectionStop.request_stop();
+    m_detectionsPending = 0;
+    m_pendingBrowsers.clear();
+}
 
-    // Chromiumを検出（YAML上書き優先）
-    if (m_enabledOverrides.contains("chromium") && !m_enabledOverrides.value("chromium")) {
-        // 無効化
+bool BrowserDetector::resolveProfile(const QString& browser, const QString& profile)
+{
+    if (!detectableBrowsers().contains(browser) || !isValidProfileName(profile) ||
+        (m_enabledOverrides.contains(browser) && !m_enabledOverrides.value(browser))) {
+        return false;
+    }
+
+    // このセッションで全プロファイルを検出済み
+    if (m_verifiedBrowsers.contains(browser)) {
+        return m_cachedBrowsers.contains(browser) && m_cachedBrowsers[browser].profiles.contains(profile);
+    }
+
+    if (m_cachedBrowsers.contains(browser) && m_cachedBrowsers[browser].profiles.contains(profile)) {
+        // スナップショット・前回の確認結果: 実行ファイルとプロファイルディレクトリだけを確認
+        const BrowserInfo& info = m_cachedBrowsers[browser];
+        const QFileInfo exec(info.executable);
+        const QString execOverride = m_execOverrides.value(browser);
+        if ((execOverride.isEmpty() || execOverride == info.executable) &&
+            exec.isFile() && exec.isExecutable() &&
+            QFileInfo(profileDirectory(browser, profile)).isDir()) {
+            return true;
+        }
+    }
+
+    return lookupProfile(browser, profile);
+}
+
+bool BrowserDetector::lookupProfile(const QString& browser, const QString& profile)
+{
+    DetectionArena arena;
+    BrowserInfo info = browserSkeleton(browser, arena);
+    const QFileInfo exec(info.executable);
+    if (info.executable.isEmpty() || !exec.isFile() || !exec.isExecutable()) {
+        m_cachedBrowsers.remove(browser);
+        return false;
+    }
+
+    // プロファイル一覧（profiles.ini / Local State）から対象のエントリだけを取り出す
+    QMap<QString, ProfileInfo> found;
+    const std::pmr::string dataDir = arena.utf8(userDataDirectory(browser));
+    if (info.type == Constants::BrowserType::Firefox) {
+        parseFirefoxIni(dataDir, found, arena, profile);
+        const auto it = found.find(profile);
+        if (it != found.end() && !DetectionArena::isDirectory(arena.join({dataDir, "/", arena.utf8(it->path)}))) {
+            found.erase(it);
+        }
     } else {
-        QString chromiumExec = m_execOverrides.value("chromium");
-        if (chromiumExec.isEmpty()) {
-            chromiumExec = findExecutable(Constants::CHROMIUM_EXECUTABLE);
+        parseChromiumLocalState(dataDir, found, arena, profile);
+    }
+
+    // 既存のエントリ（スナップショット由来など）は残し、対象のプロファイルだけを更新する
+    BrowserInfo& cached = m_cachedBrowsers[browser];
+    const QMap<QString, ProfileInfo> others = cached.profiles;
+    cached = info;
+    cached.profiles = others;
+    if (found.isEmpty()) {
+        cached.profiles.remove(profile);
+        return false;
+    }
+
+    BrowserInfo single = info;
+    single.profiles = found;
+    compileLaunchTemplates(browser, single);
+    cached.profiles.insert(profile, single.profiles.value(profile));
+    return true;
+}
+
+bool BrowserDetector::loadSnapshot()
+{
+    if (m_snapshotPath.isEmpty()) {
+        return false;
+    }
+
+    QFile file(m_snapshotPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    if (root.value("version").toInt() != SNAPSHOT_VERSION) {
+        return false;
+    }
+
+    QMap<QString, BrowserInfo> browsers;
+    const QJsonObject browsersObj = root.value("browsers").toObject();
+    for (auto it = browsersObj.begin(); it != browsersObj.end(); ++it) {
+        const QString browserId = it.key();
+        if (!detectableBrowsers().contains(browserId) ||
+            (m_enabledOverrides.contains(browserId) && !m_enabledOverrides.value(browserId))) {
+            continue;
         }
-        if (!chromiumExec.isEmpty()) {
-            BrowserInfo chromium("Chromium", chromiumExec, Constants::BrowserType::Chromium);
-            chromium.iconPath = "/usr/share/icons/hicolor/48x48/apps/chromium.png";
-            chromium.profiles = getChromeProfiles("chromium");
-            browsers["chromium"] = chromium;
-            emit browserDetected("chromium");
+
+        const QJsonObject b = it.value().toObject();
+        BrowserInfo info(b.value("name").toString(), b.value("executable").toString(),
+                         static_cast<Constants::BrowserType>(b.value("type").toInt()));
+        info.iconPath = b.value("iconPath").toString();
+        if (info.executable.isEmpty() || info.type == Constants::BrowserType::Unknown) {
+            continue;
         }
+
+        const QJsonObject profilesObj = b.value("profiles").toObject();
+        for (auto pit = profilesObj.begin(); pit != profilesObj.end(); ++pit) {
+            const QJsonObject p = pit.value().toObject();
+            ProfileInfo profile(p.value("name").toString(), p.value("path").toString());
+            profile.displayName = p.value("displayName").toString(profile.name);
+            profile.isDefault = p.value("isDefault").toBool();
+            profile.avatarPath = p.value("avatarPath").toString();
+            const qint64 lastUsed = static_cast<qint64>(p.value("lastUsed").toDouble());
+            if (lastUsed > 0) {
+                profile.lastUsed = QDateTime::fromMSecsSinceEpoch(lastUsed);
+            }
+            if (isValidProfileName(pit.key()) && !profile.path.isEmpty()) {
+                info.profiles.insert(pit.key(), profile);
+            }
+        }
+
+        // 起動テンプレートは現在の設定で展開し直す
+        compileLaunchTemplates(browserId, info);
+        browsers.insert(browserId, info);
     }
 
+    if (browsers.isEmpty()) {
+        return false;
+    }
+
+    // 未確認の情報のため、detectBrowsers() のキャッシュとしては扱わない
     m_cachedBrowsers = browsers;
-    m_lastDetection = QDateTime::currentDateTime();
-    
-    return browsers;
+    m_lastDetection = QDateTime();
+    m_verifiedBrowsers.clear();
+    return true;
+}
+
+void BrowserDetector::saveSnapshot() const
+{
+    if (m_snapshotPath.isEmpty()) {
+        return;
+    }
+
+    QJsonObject browsersObj;
+    for (auto it = m_cachedBrowsers.cbegin(); it != m_cachedBrowsers.cend(); ++it) {
+        QJsonObject profilesObj;
+        for (auto pit = it->profiles.cbegin(); pit != it->profiles.cend(); ++pit) {
+            QJsonObject p;
+            p["name"] = pit->name;
+            p["path"] = pit->path;
+            p["displayName"] = pit->displayName;
+            p["isDefault"] = pit->isDefault;
+            p["avatarPath"] = pit->avatarPath;
+            p["lastUsed"] = pit->lastUsed.isValid() ? static_cast<double>(pit->lastUsed.toMSecsSinceEpoch()) : 0.0;
+            profilesObj[pit.key()] = p;
+        }
+
+        QJsonObject b;
+        b["name"] = it->name;
+        b["executable"] = it->executable;
+        b["iconPath"] = it->iconPath;
+        b["type"] = static_cast<int>(it->type);
+        b["profiles"] = profilesObj;
+        browsersObj[it.key()] = b;
+    }
+
+    QJsonObject root;
+    root["version"] = SNAPSHOT_VERSION;
+    root["browsers"] = browsersObj;
+
+    QDir().mkpath(QFileInfo(m_snapshotPath).absolutePath());
+    QSaveFile file(m_snapshotPath);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+        file.commit();
+    }
+}
+
+void BrowserDetector::compileLaunchTemplates(const QString& browserId, BrowserInfo& browserInfo) const
+{
+    const LaunchTemplate browserTemplate = m_launchTemplates.value(LaunchTemplate::key(browserId));
+    const QString dataDir = userDataDirectory(browserId);
+
+    for (auto it = browserInfo.profiles.begin(); it != browserInfo.profiles.end(); ++it) {
+        QStringList baseArgs;
+        if (browserInfo.type == Constants::BrowserType::Firefox) {
+            baseArgs << QStringLiteral("-P") << it.key();
+        } else {
+            baseArgs << QStringLiteral("--profile-directory=") + it.key();
+        }
+
+        // ブラウザ全体 → プロファイル固有の順に結合（環境変数は後者が優先）
+        LaunchTemplate tmpl = browserTemplate;
+        if (!m_launchTemplates.isEmpty()) {
+            tmpl.append(m_launchTemplates.value(LaunchTemplate::key(browserId, it.key())));
+        }
+        if (tmpl.isEmpty()) {
+            // テンプレートがない場合（大半のプロファイル）は展開するものがない
+            it->launch = LaunchTemplate::Compiled();
+            it->launch.args = baseArgs;
+            continue;
+        }
+        it->launch = tmpl.compile(baseArgs, it.key(), dataDir + "/" + it->path);
+    }
 }
 
 bool BrowserDetector::isBrowserInstalled(const QString& browserName) const
 {
+    DetectionArena arena;
     auto existsAndExec = [](const QString& p) {
         if (p.isEmpty()) return false;
         QFileInfo fi(p);
@@ -107,15 +484,15 @@ bool BrowserDetector::isBrowserInstalled(const QString& browserName) const
     if (browserName == "firefox") {
         if (m_enabledOverrides.contains("firefox") && !m_enabledOverrides.value("firefox")) return false;
         if (existsAndExec(m_execOverrides.value("firefox"))) return true;
-        return !findExecutable(Constants::FIREFOX_EXECUTABLE).isEmpty();
+        return !findExecutable(Constants::FIREFOX_EXECUTABLE, arena).isEmpty();
     } else if (browserName == "chrome") {
         if (m_enabledOverrides.contains("chrome") && !m_enabledOverrides.value("chrome")) return false;
         if (existsAndExec(m_execOverrides.value("chrome"))) return true;
-        return !findExecutable(Constants::CHROME_EXECUTABLE).isEmpty();
+        return !findExecutable(Constants::CHROME_EXECUTABLE, arena).isEmpty();
     } else if (browserName == "chromium") {
         if (m_enabledOverrides.contains("chromium") && !m_enabledOverrides.value("chromium")) return false;
         if (existsAndExec(m_execOverrides.value("chromium"))) return true;
-        return !findExecutable(Constants::CHROMIUM_EXECUTABLE).isEmpty();
+        return !findExecutable(Constants::CHROMIUM_EXECUTABLE, arena).isEmpty();
     }
     return false;
 }
@@ -128,6 +505,96 @@ QString BrowserDetector::getBrowserIcon(const QString& browserName) const
     return QString();
 }
 
+bool BrowserDetector::isProfileRunning(const QString& browser, const QString& profile) const
+{
+    if (!m_cachedBrowsers.contains(browser)) {
+        return false;
+    }
+
+    switch (m_cachedBrowsers[browser].type) {
+    case Constants::BrowserType::Firefox: {
+        // Firefoxは起動中のプロファイルに "lock" -> "IP:+PID" のリンクを作成する
+        const QString profileDir = profileDirectory(browser, profile);
+        return !profileDir.isEmpty() && isLockOwnerAlive(profileDir + "/lock", ":+");
+    }
+
+    case Constants::BrowserType::Chrome:
+    case Constants::BrowserType::Chromium:
+        // Chrome/Chromiumは全プロファイルを1つのプロセスで扱うため、
+        // ユーザーデータディレクトリの "SingletonLock" -> "hostname-PID" を確認する
+        return isLockOwnerAlive(userDataDirectory(browser) + "/SingletonLock", "-");
+
+    default:
+        return false;
+    }
+}
+
+QString BrowserDetector::desktopFileId(const QString& browser)
+{
+    if (browser == "firefox") {
+        return "firefox";
+    } else if (browser == "chrome") {
+        return "google-chrome";
+    } else if (browser == "chromium") {
+        return "chromium";
+    }
+    return QString();
+}
+
+QString BrowserDetector::userDataDirectory(const QString& browser) const
+{
+    if (browser == "firefox") {
+        return getFirefoxProfilePath();
+    } else if (browser == "chrome") {
+        return getChromeProfilePath("google-chrome");
+    } else if (browser == "chromium") {
+        return getChromeProfilePath("chromium");
+    }
+    return QString();
+}
+
+QString BrowserDetector::profileDirectory(const QString& browser, const QString& profile) const
+{
+    if (!m_cachedBrowsers.contains(browser)) {
+        return QString();
+    }
+
+    const BrowserInfo& browserInfo = m_cachedBrowsers[browser];
+    if (!browserInfo.profiles.contains(profile)) {
+        return QString();
+    }
+
+    return userDataDirectory(browser) + "/" + browserInfo.profiles[profile].path;
+}
+
+bool BrowserDetector::isLockOwnerAlive(const QString& linkPath, const QString& separator)
+{
+    const QString target = QFileInfo(linkPath).symLinkTarget();
+    if (target.isEmpty()) {
+        return false;
+    }
+
+    // symLinkTarget() は絶対パスを返すため、ファイル名部分のみを対象にする
+    const QString owner = QFileInfo(target).fileName();
+    const int sep = owner.lastIndexOf(separator);
+    if (sep < 0) {
+        return false;
+    }
+
+    // Chromiumのロックはホスト名を含むため、別ホスト（NFSホーム等）のロックは無視する
+    if (separator == "-" && owner.left(sep) != QSysInfo::machineHostName()) {
+        return false;
+    }
+
+    bool ok = false;
+    const qint64 pid = owner.mid(sep + separator.size()).toLongLong(&ok);
+    if (!ok || pid <= 0) {
+        return false;
+    }
+
+    return ::kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+}
+
 bool BrowserDetector::isValidUrl(const QString& url)
 {
     if (url.isEmpty()) {
@@ -180,6 +647,14 @@ QString BrowserDetector::sanitizeUrl(const QString& url)
     return sanitized;
 }
 
+QString BrowserDetector::completeUrlScheme(const QString& url)
+{
+    if (url.isEmpty() || url.contains("://")) {
+        return url;
+    }
+    return url.startsWith("www.") ? "https://" + url : "https://www." + url;
+}
+
 QString BrowserDetector::sanitizeProfileName(const QString& profileName)
 {
     QString sanitized = profileName;
@@ -197,8 +672,84 @@ QString BrowserDetector::sanitizeProfileName(const QString& profileName)
     return sanitized;
 }
 
-bool BrowserDetector::launchBrowser(const QString& browser, const QString& profile, const QString& url)
+QList<BrowserDetector::ContainerInfo> BrowserDetector::detectContainers(const QString& browser,
+                                                                       const QString& profile) const
+{
+    if (!m_cachedBrowsers.contains(browser) ||
+        m_cachedBrowsers[browser].type != Constants::BrowserType::Firefox) {
+        return {};
+    }
+
+    const QString profileDir = profileDirectory(browser, profile);
+    if (profileDir.isEmpty()) {
+        return {};
+    }
+
+    QFile file(profileDir + "/containers.json");
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+
+    return parseContainers(file.readAll());
+}
+
+QList<BrowserDetector::ContainerInfo> BrowserDetector::parseContainers(const QByteArray& json)
+{
+    // 組み込みコンテナは名前の代わりにローカライズ用IDを持つ
+    static const QMap<QString, QString> builtinNames = {
+        {"userContextPersonal.label", "Personal"},
+        {"userContextWork.label", "Work"},
+        {"userContextBanking.label", "Banking"},
+        {"userContextShopping.label", "Shopping"},
+    };
+
+    QList<ContainerInfo> containers;
+    const QJsonDocument doc = QJsonDocument::fromJson(json);
+    if (!doc.isObject()) {
+        return containers;
+    }
+
+    const QJsonArray identities = doc.object().value("identities").toArray();
+    for (const QJsonValue& value : identities) {
+        const QJsonObject identity = value.toObject();
+        // 非公開の identity はサムネイル生成や拡張機能ストレージ用
+        if (!identity.value("public").toBool(false)) {
+            continue;
+        }
+
+        ContainerInfo info;
+        info.userContextId = identity.value("userContextId").toInt();
+        info.name = identity.value("name").toString();
+        if (info.name.isEmpty()) {
+            const QString l10nId = identity.value("l10nID").toString();
+            info.name = builtinNames.value(l10nId, l10nId);
+        }
+        info.color = identity.value("color").toString();
+        info.icon = identity.value("icon").toString();
+
+        if (info.userContextId > 0 && !info.name.isEmpty()) {
+            containers.append(info);
+        }
+    }
+
+    return containers;
+}
+
+QString BrowserDetector::containerUrl(const QString& container, const QString& url)
 {
+    return QString("ext+container:name=%1&url=%2")
+        .arg(QString::fromLatin1(QUrl::toPercentEncoding(container)),
+             QString::fromLatin1(QUrl::toPercentEncoding(url)));
+}
+
+bool BrowserDetector::launchBrowser(const QString& browser, const QString& profile, const QString& url,
+                                    const QString& container)
+{
+    QElapsedTimer traceTimer;
+    if (KBP_TRACE_ENABLED(launch)) {
+        traceTimer.start();
+    }
+
     // 入力をサニタイズして検証
     QString sanitizedUrl = sanitizeUrl(url);
     QString sanitizedProfile = sanitizeProfileName(profile);
@@ -226,27 +777,51 @@ bool BrowserDetector::launchBrowser(const QString& browser, const QString& profi
         return false;
     }
 
-    QStringList args;
-    
-    switch (browserInfo.type) {
-    case Constants::BrowserType::Firefox:
-        args << "-P" << sanitizedProfile << sanitizedUrl;
-        break;
-        
-    case Constants::BrowserType::Chrome:
-    case Constants::BrowserType::Chromium:
-        args << QString("--profile-directory=%1").arg(sanitizedProfile) << sanitizedUrl;
-        break;
-        
-    default:
+    // コンテナはFirefoxのみ。URLの検証後に ext+container: へ包む
+    QString sanitizedContainer = container;
+    sanitizedContainer.remove(QChar('\0'));
+    sanitizedContainer = sanitizedContainer.trimmed();
+    if (!sanitizedContainer.isEmpty()) {
+        if (browserInfo.type != Constants::BrowserType::Firefox) {
+            emit launchError(tr("Containers are not supported by %1").arg(browser));
+            return false;
+        }
+        sanitizedUrl = containerUrl(sanitizedContainer, sanitizedUrl);
+    }
+
+    if (browserInfo.type == Constants::BrowserType::Unknown) {
         emit launchError(tr("Unknown browser type"));
         return false;
     }
 
+    // 検出時に展開済みの引数プレフィックス（-P / --profile-directory と起動テンプレート）にURLを加えるだけ
+    const LaunchTemplate::Compiled launch = browserInfo.profiles.value(sanitizedProfile).launch;
+    const QStringList args = launch.argumentsFor(sanitizedUrl);
+
+    // トークンは1回の起動にのみ使用する
+    const LaunchToken token = m_activationToken;
+    m_activationToken = LaunchToken();
+
+    // 起動中のプロファイルには、リモートプロトコルで直接URLを渡す
+    if (isProfileRunning(browser, sanitizedProfile) &&
+        openInRunningBrowser(browser, sanitizedProfile, sanitizedUrl, token)) {
+        KBP_TRACE(launch, qUtf8Printable(browser), qUtf8Printable(sanitizedProfile), "remote", 1, 0LL,
+                  traceTimer.nsecsElapsed() / 1000);
+        return true;
+    }
+
     QProcess* process = new QProcess(this);
     process->setProgram(browserInfo.executable);
     process->setArguments(args);
     
+    // 起動テンプレートの環境変数と、新しいウィンドウをフォーカスするためのトークンを渡す
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    for (auto it = launch.env.begin(); it != launch.env.end(); ++it) {
+        env.insert(it.key(), it.value());
+    }
+    token.applyTo(env);
+    process->setProcessEnvironment(env);
+    
     // アプリケーション終了後もプロセスが継続するようにデタッチ
     connect(process, &QProcess::started, [process]() {
         process->disconnect();
@@ -257,39 +832,150 @@ bool BrowserDetector::launchBrowser(const QString& browser, const QString& profi
         emit launchError(tr("Failed to launch %1: %2").arg(browser).arg(static_cast<int>(error)));
     });
     
-    return process->startDetached();
+    qint64 pid = 0;
+    const bool started = process->startDetached(&pid);
+    KBP_TRACE(launch, qUtf8Printable(browser), qUtf8Printable(sanitizedProfile), "exec", started ? 1 : 0,
+              static_cast<long long>(pid), traceTimer.nsecsElapsed() / 1000);
+    return started;
 }
 
-QString BrowserDetector::findExecutable(const QString& name) const
+bool BrowserDetector::openInRunningBrowser(const QString& browser, const QString& profile, const QString& url,
+                                           const LaunchToken& token) const
 {
-    // まずPATH内をチェック
-    QString path = QStandardPaths::findExecutable(name);
-    if (!path.isEmpty()) {
-        return path;
+    const BrowserInfo& browserInfo = m_cachedBrowsers[browser];
+    RemoteOpen::Result result = RemoteOpen::Result::NotRunning;
+
+    switch (browserInfo.type) {
+    case Constants::BrowserType::Firefox:
+        // -P はFirefox側で起動時に消費されるため、転送するのはURLのみ
+        result = RemoteOpen::openInFirefox(profile, {browserInfo.executable, url}, token.remoteToken());
+        break;
+
+    case Constants::BrowserType::Chrome:
+    case Constants::BrowserType::Chromium: {
+        QStringList argv = {browserInfo.executable, QString("--profile-directory=%1").arg(profile)};
+        if (!token.xdgActivationToken.isEmpty()) {
+            // 起動中のChromiumはこのスイッチのトークンで既存ウィンドウをアクティブ化する
+            argv << QString("--xdg-activation-token=%1").arg(token.xdgActivationToken);
+        }
+        argv << url;
+        result = RemoteOpen::openInChromium(userDataDirectory(browser), argv);
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    if (result != RemoteOpen::Result::Delivered) {
+        qDebug() << "Remote open unavailable for" << browser << profile << "- falling back to exec";
+        return false;
+    }
+    return true;
+}
+
+bool BrowserDetector::warmUpBrowser(const QString& browser, const QString& profile, qint64* pid)
+{
+    if (pid) {
+        *pid = 0;
     }
     
-    // 一般的なインストール先をチェック
-    QStringList commonPaths = {
-        "/usr/bin/" + name,
-        "/usr/local/bin/" + name,
-        "/opt/" + name + "/" + name,
-        QDir::homePath() + "/.local/bin/" + name
-    };
+    const QString sanitizedProfile = sanitizeProfileName(profile);
+    if (!isValidProfileName(sanitizedProfile) ||
+        !m_cachedBrowsers.contains(browser) ||
+        !m_cachedBrowsers[browser].profiles.contains(sanitizedProfile)) {
+        return false;
+    }
     
-    for (const QString& p : commonPaths) {
-        if (QFile::exists(p) && QFileInfo(p).isExecutable()) {
-            return p;
+    const BrowserInfo& browserInfo = m_cachedBrowsers[browser];
+    switch (browserInfo.type) {
+    case Constants::BrowserType::Chrome:
+    case Constants::BrowserType::Chromium: {
+        // 先行起動したプロセスがそのままインスタンスになるため、起動テンプレートも適用する
+        const LaunchTemplate::Compiled launch = browserInfo.profiles.value(sanitizedProfile).launch;
+        QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+        for (auto it = launch.env.begin(); it != launch.env.end(); ++it) {
+            env.insert(it.key(), it.value());
         }
+        
+        QProcess process;
+        process.setProgram(browserInfo.executable);
+        process.setArguments(launch.args + QStringList{"--no-startup-window"});
+        process.setProcessEnvironment(env);
+        return process.startDetached(pid);
+    }
+    
+    case Constants::BrowserType::Firefox: {
+        // 実行ファイルの実体があるディレクトリ（/usr/bin/firefox -> /usr/lib/firefox）を先読み
+        const QString installDir = QFileInfo(QFileInfo(browserInfo.executable).canonicalFilePath()).absolutePath();
+        const QStringList files = {
+            installDir + "/libxul.so",
+            installDir + "/omni.ja",
+            installDir + "/browser/omni.ja",
+            installDir + "/firefox",
+            installDir + "/firefox-bin",
+        };
+        QThreadPool::globalInstance()->start([files]() {
+            for (const QString& file : files) {
+                const int fd = ::open(QFile::encodeName(file).constData(), O_RDONLY | O_CLOEXEC);
+                if (fd >= 0) {
+                    ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+                    ::close(fd);
+                }
+            }
+        });
+        return true;
     }
     
+    default:
+        return false;
+    }
+}
+
+QString BrowserDetector::findExecutable(const QString& name, DetectionArena& arena) const
+{
+    const std::pmr::string file = arena.utf8(name);
+    std::pmr::string candidate = arena.string();
+    auto check = [&candidate](std::initializer_list<std::string_view> parts) {
+        candidate.clear();
+        for (std::string_view part : parts) {
+            candidate.append(part);
+        }
+        return DetectionArena::isExecutableFile(candidate);
+    };
+
+    // まずPATH内をチェック（相対パスの要素は作業ディレクトリに依存するため無視する）
+    const QByteArray pathVariable = qgetenv("PATH");
+    std::string_view remaining(pathVariable.constData(), static_cast<size_t>(pathVariable.size()));
+    while (!remaining.empty()) {
+        const size_t colon = remaining.find(':');
+        std::string_view dir = remaining.substr(0, colon);
+        remaining = colon == std::string_view::npos ? std::string_view() : remaining.substr(colon + 1);
+        while (dir.size() > 1 && dir.back() == '/') {
+            dir.remove_suffix(1);
+        }
+        if (dir.empty() || dir.front() != '/') {
+            continue;
+        }
+        if (check({dir, dir.size() > 1 ? "/" : "", file})) {
+            return DetectionArena::toQString(candidate);
+        }
+    }
+
+    // 一般的なインストール先をチェック
+    if (check({"/usr/bin/", file}) || check({"/usr/local/bin/", file}) || check({"/opt/", file, "/", file}) ||
+        check({arena.utf8(QDir::homePath()), "/.local/bin/", file})) {
+        return DetectionArena::toQString(candidate);
+    }
+
     return QString();
 }
 
-QString BrowserDetector::findExecutableFromList(const QStringList& names) const
+QString BrowserDetector::findExecutableFromList(const QStringList& names, DetectionArena& arena) const
 {
     // リスト内の各名前を順番に試し、最初に見つかったものを返す
     for (const QString& name : names) {
-        QString exec = findExecutable(name);
+        QString exec = findExecutable(name, arena);
         if (!exec.isEmpty()) {
             return exec;
         }
@@ -308,164 +994,156 @@ QString BrowserDetector::getChromeProfilePath(const QString& browserName) const
     return QDir::homePath() + "/.config/" + browserName;
 }
 
-QMap<QString, BrowserDetector::ProfileInfo> BrowserDetector::getFirefoxProfiles()
+QMap<QString, BrowserDetector::ProfileInfo> BrowserDetector::getFirefoxProfiles(DetectionArena& arena,
+                                                                               const std::stop_token& stop)
 {
     QMap<QString, ProfileInfo> profiles;
-    
-    QString profilesPath = getFirefoxProfilePath();
-    QString iniPath = profilesPath + "/" + Constants::FIREFOX_CONFIG;
-    
-    if (!QFile::exists(iniPath)) {
-        qDebug() << "Firefox profiles.ini not found at" << iniPath;
+
+    const std::pmr::string profilesPath = arena.utf8(getFirefoxProfilePath());
+    if (!parseFirefoxIni(profilesPath, profiles, arena)) {
+        qDebug() << "Firefox profiles.ini not found in" << profilesPath.c_str();
         return profiles;
     }
-    
-    parseFirefoxIni(iniPath, profiles);
-    
+
     // 各プロファイルの最終使用日時を取得
+    static const QString browserName = QStringLiteral("firefox");
     for (auto& profile : profiles) {
-        QString profileFullPath = profilesPath + "/" + profile.path;
-        profile.lastUsed = getProfileLastUsed("firefox", profileFullPath);
-        emit profileDetected("firefox", profile.name);
+        if (stop.stop_requested()) {
+            break;
+        }
+        profile.lastUsed = getProfileLastUsed(browserName, arena.join({profilesPath, "/", arena.utf8(profile.path)}),
+                                              arena);
+        emit profileDetected(browserName, profile.name);
     }
-    
+
     return profiles;
 }
 
-void BrowserDetector::parseFirefoxIni(const QString& iniPath, QMap<QString, ProfileInfo>& profiles)
+bool BrowserDetector::parseFirefoxIni(const std::pmr::string& profilesPath, QMap<QString, ProfileInfo>& profiles,
+                                      DetectionArena& arena, const QString& onlyProfile)
 {
-    QSettings settings(iniPath, QSettings::IniFormat);
-    
-    // Firefoxは[Profile0], [Profile1]などのセクションを使用
-    QStringList groups = settings.childGroups();
-    
-    for (const QString& group : groups) {
-        if (!group.startsWith("Profile")) {
+    std::pmr::string contents = arena.string();
+    if (!DetectionArena::readFile(arena.join({profilesPath, "/", Constants::FIREFOX_CONFIG}), &contents)) {
+        return false;
+    }
+
+    std::pmr::vector<DetectionArena::FirefoxEntry> entries(arena.resource());
+    DetectionArena::parseProfilesIni(contents, &entries);
+
+    const std::pmr::string only = arena.utf8(onlyProfile);
+    for (const DetectionArena::FirefoxEntry& entry : entries) {
+        if (!only.empty() && entry.name != only) {
             continue;
         }
-        
-        settings.beginGroup(group);
-        
-        QString name = settings.value("Name").toString();
-        QString path = settings.value("Path").toString();
-        bool isDefault = settings.value("Default", false).toBool();
-        
-        if (!name.isEmpty() && !path.isEmpty()) {
-            ProfileInfo info(name, path);
-            info.isDefault = isDefault;
-            profiles[name] = info;
+        ProfileInfo info(DetectionArena::toQString(entry.name), DetectionArena::toQString(entry.path));
+        info.isDefault = entry.isDefault;
+        profiles[info.name] = info;
+        if (KBP_TRACE_ENABLED(profile_parsed)) {
+            const std::pmr::string name = arena.join({entry.name});
+            const std::pmr::string path = arena.join({entry.path});
+            KBP_TRACE(profile_parsed, "firefox", name.c_str(), path.c_str());
         }
-        
-        settings.endGroup();
     }
+    return true;
 }
 
-QMap<QString, BrowserDetector::ProfileInfo> BrowserDetector::getChromeProfiles(const QString& browserName)
+QMap<QString, BrowserDetector::ProfileInfo> BrowserDetector::getChromeProfiles(const QString& browserName,
+                                                                              DetectionArena& arena,
+                                                                              const std::stop_token& stop)
 {
     QMap<QString, ProfileInfo> profiles;
-    
-    QString configPath = getChromeProfilePath(browserName);
-    QString localStatePath = configPath + "/" + Constants::CHROME_CONFIG;
-    
-    if (!QFile::exists(localStatePath)) {
-        qDebug() << browserName << "Local State not found at" << localStatePath;
+
+    const std::pmr::string configPath = arena.utf8(getChromeProfilePath(browserName));
+    if (!parseChromiumLocalState(configPath, profiles, arena)) {
         return profiles;
     }
-    
-    parseChromiumLocalState(localStatePath, configPath, profiles);
-    
+
     // Get last used times
     for (auto& profile : profiles) {
-        QString profileFullPath = configPath + "/" + profile.path;
-        profile.lastUsed = getProfileLastUsed(browserName, profileFullPath);
+        if (stop.stop_requested()) {
+            break;
+        }
+        profile.lastUsed = getProfileLastUsed(browserName, arena.join({configPath, "/", arena.utf8(profile.path)}),
+                                              arena);
         emit profileDetected(browserName, profile.name);
     }
-    
+
     return profiles;
 }
 
-void BrowserDetector::parseChromiumLocalState(const QString& localStatePath, 
-                                            const QString& configDir,
-                                            QMap<QString, ProfileInfo>& profiles)
+bool BrowserDetector::parseChromiumLocalState(const std::pmr::string& configDir,
+                                              QMap<QString, ProfileInfo>& profiles,
+                                              DetectionArena& arena,
+                                              const QString& onlyProfile)
 {
-    QFile file(localStatePath);
-    if (!file.open(QIODevice::ReadOnly)) {
-        qDebug() << "Cannot open Local State file:" << localStatePath;
-        return;
+    std::pmr::string contents = arena.string();
+    if (!DetectionArena::readFile(arena.join({configDir, "/", Constants::CHROME_CONFIG}), &contents)) {
+        qDebug() << "Local State not found in" << configDir.c_str();
+        return false;
     }
-    
-    QByteArray data = file.readAll();
-    file.close();
-    
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    if (!doc.isObject()) {
+
+    std::pmr::vector<DetectionArena::ChromiumEntry> entries(arena.resource());
+    if (!arena.parseLocalState(contents, &entries)) {
         qDebug() << "Invalid JSON in Local State file";
-        return;
+        return false;
     }
-    
-    QJsonObject root = doc.object();
-    QJsonObject profileObj = root["profile"].toObject();
-    QJsonObject infoCache = profileObj["info_cache"].toObject();
-    
+
     // Always add Default profile
-    ProfileInfo defaultProfile("Default", "Default");
-    defaultProfile.displayName = "Default";
-    profiles["Default"] = defaultProfile;
-    
+    const std::pmr::string only = arena.utf8(onlyProfile);
+    if (only.empty() || only == "Default") {
+        ProfileInfo defaultProfile(QStringLiteral("Default"), QStringLiteral("Default"));
+        profiles[defaultProfile.name] = defaultProfile;
+    }
+
     // Parse other profiles
-    for (auto it = infoCache.begin(); it != infoCache.end(); ++it) {
-        QString profileDir = it.key();
-        QJsonObject info = it.value().toObject();
-        
-        QString name = info["name"].toString();
-        if (name.isEmpty()) {
-            name = profileDir;
+    std::pmr::string profilePath = arena.string();
+    for (const DetectionArena::ChromiumEntry& entry : entries) {
+        if (!only.empty() && entry.directory != only) {
+            continue;
         }
-        
-        ProfileInfo profile(name, profileDir);
-        profile.displayName = name;
-        
-        // Check if this profile exists
-        QString profilePath = configDir + "/" + profileDir;
-        if (QDir(profilePath).exists()) {
-            profiles[profileDir] = profile;
+
+        // Check if this profile exists（存在しないエントリは QString にしない）
+        profilePath.assign(configDir).append("/").append(entry.directory);
+        if (!DetectionArena::isDirectory(profilePath)) {
+            continue;
+        }
+
+        const QString profileDir = DetectionArena::toQString(entry.directory);
+        ProfileInfo profile(entry.name.empty() ? profileDir : DetectionArena::toQString(entry.name), profileDir);
+        profile.avatarPath = chromiumAvatarPath(configDir, entry, arena);
+        profiles[profileDir] = profile;
+        if (KBP_TRACE_ENABLED(profile_parsed)) {
+            const std::pmr::string browser = arena.join({fileName(configDir)});
+            const std::pmr::string directory = arena.join({entry.directory});
+            KBP_TRACE(profile_parsed, browser.c_str(), directory.c_str(), profilePath.c_str());
         }
     }
+    return true;
 }
 
-QDateTime BrowserDetector::getProfileLastUsed(const QString& browserPath, const QString& profilePath)
+QDateTime BrowserDetector::getProfileLastUsed(const QString& browserName, const std::pmr::string& profilePath,
+                                              DetectionArena& arena) const
 {
     // For Firefox, check times.json
-    if (browserPath == "firefox") {
-        QString timesPath = profilePath + "/times.json";
-        if (QFile::exists(timesPath)) {
-            QFile file(timesPath);
-            if (file.open(QIODevice::ReadOnly)) {
-                QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-                file.close();
-                
-                if (doc.isObject()) {
-                    QJsonObject times = doc.object();
-                    qint64 firstUse = static_cast<qint64>(times["firstUse"].toDouble() / 1000); // Convert from ms to s
-                    if (firstUse > 0) {
-                        return QDateTime::fromSecsSinceEpoch(firstUse);
-                    }
-                }
+    if (browserName == QLatin1String("firefox")) {
+        std::pmr::string contents = arena.string();
+        if (DetectionArena::readFile(arena.join({profilePath, "/times.json"}), &contents)) {
+            const auto firstUse = static_cast<qint64>(arena.parseFirstUse(contents) / 1000); // Convert from ms to s
+            if (firstUse > 0) {
+                return QDateTime::fromSecsSinceEpoch(firstUse);
             }
         }
     }
-    
+
     // For Chrome/Chromium, check Preferences file
-    else if (browserPath == "chrome" || browserPath == "chromium") {
-        QString prefsPath = profilePath + "/Preferences";
-        if (QFile::exists(prefsPath)) {
-            // Just use file modification time for now
-            QFileInfo info(prefsPath);
-            return info.lastModified();
+    else if (browserName == QLatin1String("chrome") || browserName == QLatin1String("chromium")) {
+        // Just use file modification time for now
+        const QDateTime modified = DetectionArena::lastModified(arena.join({profilePath, "/Preferences"}));
+        if (modified.isValid()) {
+            return modified;
         }
     }
-    
+
     // Fallback: use directory modification time
-    QFileInfo dirInfo(profilePath);
-    return dirInfo.lastModified();
+    return DetectionArena::lastModified(profilePath);
 }
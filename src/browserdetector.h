@@ -13,10 +13,21 @@
 #include <QObject>
 #include <QString>
 #include <QMap>
+#include <QList>
 #include <QDateTime>
+#include <QSet>
+#include <QThreadPool>
+#include <functional>
 #include <memory>
+#include <memory_resource>
+#include <stop_token>
+#include <string>
 
 #include "constants.h"
+#include "launchtoken.h"
+#include "launchtemplate.h"
+
+class DetectionArena;
 
 /**
  * @class BrowserDetector
@@ -46,6 +57,8 @@ public:
         QString displayName;   ///< 表示用のプロファイル名
         QDateTime lastUsed;    ///< 最後に使用された日時
         bool isDefault;        ///< デフォルトプロファイルかどうか
+        QString avatarPath;    ///< アバター画像の絶対パス（Chromiumのみ。存在は読み込み時に確認）
+        LaunchTemplate::Compiled launch; ///< 展開済みの起動引数と環境変数（URLを除く）
         
         ProfileInfo() : isDefault(false) {}
         
@@ -53,6 +66,19 @@ public:
             : name(n), path(p), displayName(n), isDefault(false) {}
     };
 
+    /**
+     * @struct ContainerInfo
+     * @brief Firefoxのコンテナ（containers.json の identity）の情報
+     */
+    struct ContainerInfo {
+        int userContextId;     ///< コンテナID（userContextId）
+        QString name;          ///< コンテナ名（組み込みコンテナは英語名）
+        QString color;         ///< 色（"blue", "orange" など）
+        QString icon;          ///< アイコン名（"fingerprint", "briefcase" など）
+
+        ContainerInfo() : userContextId(0) {}
+    };
+
     /**
      * @struct BrowserInfo
      * @brief ブラウザの情報を格納する構造体
@@ -70,8 +96,24 @@ public:
             : name(n), executable(e), type(t) {}
     };
 
+    /**
+     * @brief ブラウザ1つの検出の前に呼び出される関数（テスト用）
+     * @param browserId 検出するブラウザID
+     * @param stop 検出の中断要求
+     */
+    using ProbeHook = std::function<void(const QString& browserId, const std::stop_token& stop)>;
+
+    /**
+     * @brief アリーナを使わずにプロファイルを読み込む関数（テスト用）
+     * @param browserName 設定ディレクトリの名前（"firefox", "google-chrome", "chromium"）
+     * @param stop 検出の中断要求
+     * @return プロファイル名をキーとするマップ
+     */
+    using ProfileReader = std::function<QMap<QString, ProfileInfo>(const QString& browserName,
+                                                                   const std::stop_token& stop)>;
+
     explicit BrowserDetector(QObject* parent = nullptr);
-    ~BrowserDetector() override = default;
+    ~BrowserDetector() override;
 
     // コピーコンストラクタと代入演算子を削除
     BrowserDetector(const BrowserDetector&) = delete;
@@ -87,6 +129,62 @@ public:
      * @note 結果は5秒間キャッシュされます
      */
     QMap<QString, BrowserInfo> detectBrowsers();
+
+    /**
+     * @brief ブラウザごとの検出をワーカースレッドで開始
+     * @note 全ブラウザの検出が終わると、GUIスレッドで結果をキャッシュに反映して
+     *       detectionFinished() を発行します。実行中の検出は破棄して最初からやり直します
+     */
+    void startDetection();
+
+    /**
+     * @brief 実行中の検出を中断
+     * @note 実行中の検出は中断要求を受けて早期に終了し、結果は破棄されます。
+     *       detectionFinished() は発行されません
+     */
+    void cancelDetection();
+
+    /**
+     * @brief 検出の実行中かどうか
+     */
+    bool isDetecting() const { return m_detectionsPending > 0; }
+
+    /**
+     * @brief 起動前に1つのプロファイルを確認（全体の検出を待たない）
+     * @param browser ブラウザID
+     * @param profile プロファイルID
+     * @return true: 起動可能（キャッシュに含まれる）
+     * @note このセッションで検出済みのブラウザはキャッシュをそのまま使用し、
+     *       スナップショット由来の情報は実行ファイルとプロファイルディレクトリのみを確認します。
+     *       どちらでもない場合は、全体を列挙せずにそのプロファイルだけを検出します
+     *       （コマンドラインなど一覧を表示しない起動に使用）
+     */
+    bool resolveProfile(const QString& browser, const QString& profile);
+
+    /**
+     * @brief 検出結果のスナップショットの保存先を設定
+     * @param path JSONファイルのパス（空の場合は保存しない）
+     */
+    void setSnapshotPath(const QString& path) { m_snapshotPath = path; }
+
+    /**
+     * @brief 前回の検出結果をスナップショットから読み込む
+     * @return true: 1つ以上のブラウザを読み込んだ
+     * @note 読み込んだ情報は未確認として扱われ、detectBrowsers() のキャッシュにはなりません
+     */
+    bool loadSnapshot();
+
+    /**
+     * @brief 検出の前に呼び出される関数を設定（テストで遅いファイルシステムを模擬する）
+     * @param hook ブラウザごとの検出の開始時に呼び出される関数
+     */
+    void setProbeHook(ProbeHook hook) { m_probeHook = std::move(hook); }
+
+    /**
+     * @brief プロファイルの読み込みを差し替える（テストでアリーナ導入前の実装と確保回数を比較する）
+     * @param reader getFirefoxProfiles() / getChromeProfiles() の代わりに呼び出される関数
+     */
+    void setProfileReader(ProfileReader reader) { m_profileReader = std::move(reader); }
     
     /**
      * @brief 指定されたブラウザがインストールされているかチェック
@@ -101,15 +199,98 @@ public:
      * @return アイコンファイルのパス（ブラウザが見つからない場合は空文字列）
      */
     QString getBrowserIcon(const QString& browserName) const;
+
+    /**
+     * @brief 指定されたプロファイルのブラウザが起動中かどうかを確認
+     * @param browser ブラウザID
+     * @param profile プロファイルID
+     * @return true: 起動中, false: 未起動または不明
+     * @note Firefoxはプロファイル内の "lock"、Chrome/Chromiumはユーザーデータ
+     *       ディレクトリの "SingletonLock" シンボリックリンクの所有PIDを確認します
+     */
+    bool isProfileRunning(const QString& browser, const QString& profile) const;
+
+    /**
+     * @brief ブラウザのデスクトップファイルID（xdg-activationのapp_id）を取得
+     * @param browser ブラウザID
+     * @return "firefox", "google-chrome", "chromium"（不明な場合は空文字列）
+     */
+    static QString desktopFileId(const QString& browser);
+
+    /**
+     * @brief 検出済みのブラウザ情報を取得（再検出は行わない）
+     * @return ブラウザIDからBrowserInfoへのマップ（未検出の場合は空）
+     */
+    QMap<QString, BrowserInfo> cachedBrowsers() const { return m_cachedBrowsers; }
+
+    /**
+     * @brief ブラウザのユーザーデータディレクトリを取得
+     * @param browser ブラウザID
+     * @return Firefox: ~/.mozilla/firefox, Chrome/Chromium: ~/.config/<名前>
+     */
+    QString userDataDirectory(const QString& browser) const;
+
+    /**
+     * @brief プロファイルディレクトリの絶対パスを取得
+     * @param browser ブラウザID
+     * @param profile プロファイルID
+     * @return 絶対パス（検出済みでない場合は空文字列）
+     */
+    QString profileDirectory(const QString& browser, const QString& profile) const;
     
+    /**
+     * @brief Firefoxプロファイルのコンテナ一覧を読み込む
+     * @param browser ブラウザID
+     * @param profile プロファイルID
+     * @return 公開コンテナのリスト（Firefox以外・ファイルがない場合は空）
+     * @note プロファイル内の containers.json を都度読み込みます。
+     *       一覧の展開時にのみ呼び出してください
+     */
+    QList<ContainerInfo> detectContainers(const QString& browser, const QString& profile) const;
+
+    /**
+     * @brief containers.json の内容を解析
+     * @param json ファイルの内容
+     * @return 公開コンテナのリスト（内部用の非公開 identity は除外）
+     */
+    static QList<ContainerInfo> parseContainers(const QByteArray& json);
+
+    /**
+     * @brief コンテナでURLを開くための ext+container: URLを作成
+     * @param container コンテナ名
+     * @param url 開くURL（検証済み）
+     * @return "ext+container:name=<コンテナ名>&url=<URL>"（各値はパーセントエンコード）
+     */
+    static QString containerUrl(const QString& container, const QString& url);
+
     /**
      * @brief 指定されたプロファイルでブラウザを起動
      * @param browser ブラウザID
      * @param profile プロファイルID
      * @param url 開くURL（セキュリティのため検証されます）
+     * @param container Firefoxのコンテナ名（空の場合はコンテナを使用しない）
      * @return true: 起動成功, false: 起動失敗
+     * @note プロファイルが既に起動中の場合は、まずブラウザのリモートプロトコルで
+     *       URLを渡し、失敗した場合のみ実行ファイルを起動します。
+     *       コンテナを指定した場合、URLは ext+container: スキームで渡され、
+     *       起動中のインスタンス内のコンテナタブとして開かれます
+     */
+    bool launchBrowser(const QString& browser, const QString& profile, const QString& url,
+                       const QString& container = QString());
+
+    /**
+     * @brief URLを開かずにブラウザを先行起動（ウォームアップ）
+     * @param browser ブラウザID
+     * @param profile プロファイルID
+     * @param pid 起動したプロセスのPID（プロセスを起動しなかった場合は0）
+     * @return true: ウォームアップを開始した, false: 失敗
+     * @note Chrome/Chromiumは "--no-startup-window" でウィンドウなしのインスタンスを起動し、
+     *       後続の起動要求はそのインスタンスに引き渡されます。
+     *       Firefoxにはウィンドウなしで起動してURLを受け取れるモードがないため
+     *       （"--headless" のインスタンスはプロファイルを占有し、URLが不可視のまま開かれる）、
+     *       代わりに実行ファイルと主要ライブラリをページキャッシュへ先読みします
      */
-    bool launchBrowser(const QString& browser, const QString& profile, const QString& url);
+    bool warmUpBrowser(const QString& browser, const QString& profile, qint64* pid);
 
     // セキュリティ検証メソッド
     /**
@@ -133,6 +314,13 @@ public:
      * @return サニタイズされたURL
      */
     static QString sanitizeUrl(const QString& url);
+
+    /**
+     * @brief コマンドラインのURLにスキームを補完
+     * @param url コマンドラインで渡されたURL
+     * @return スキームのない場合は "https://"（"www." で始まらなければ "https://www."）を付けたURL
+     */
+    static QString completeUrlScheme(const QString& url);
     
     /**
      * @brief プロファイル名をサニタイズ（危険な文字を除去）
@@ -153,6 +341,20 @@ public:
      */
     void setEnabledOverrides(const QMap<QString, bool>& overrides) { m_enabledOverrides = overrides; }
 
+    /**
+     * @brief 次の起動で使用するアクティベーショントークンを設定
+     * @param token ピッカーのアクティベーションコンテキストから取得したトークン
+     * @note トークンは次の launchBrowser() で環境変数とリモートプロトコルに渡され、破棄されます
+     */
+    void setActivationToken(const LaunchToken& token) { m_activationToken = token; }
+
+    /**
+     * @brief YAMLの起動テンプレートを設定
+     * @param templates "browser" または "browser/profile" -> 検証済みのテンプレート
+     * @note 次回の detectBrowsers() で各プロファイルの起動引数に展開されます
+     */
+    void setLaunchTemplates(const QMap<QString, LaunchTemplate>& templates) { m_launchTemplates = templates; }
+
 signals:
     /**
      * @brief ブラウザが検出されたときに発行されるシグナル
@@ -166,6 +368,11 @@ signals:
      * @param profileName 検出されたプロファイル名
      */
     void profileDetected(const QString& browserName, const QString& profileName);
+
+    /**
+     * @brief startDetection() による検出が完了したときに発行されるシグナル
+     */
+    void detectionFinished();
     
     /**
      * @brief ブラウザの起動に失敗したときに発行されるシグナル
@@ -176,38 +383,80 @@ signals:
 private:
     /**
      * @brief Firefoxのプロファイル一覧を取得
+     * @param arena 検出のアリーナ
+     * @param stop 検出の中断要求
      * @return プロファイルIDからProfileInfoへのマップ
      */
-    QMap<QString, ProfileInfo> getFirefoxProfiles();
+    QMap<QString, ProfileInfo> getFirefoxProfiles(DetectionArena& arena, const std::stop_token& stop = {});
     
     /**
      * @brief Chrome/Chromiumのプロファイル一覧を取得
      * @param browserName ブラウザ名（"google-chrome" または "chromium"）
+     * @param arena 検出のアリーナ
+     * @param stop 検出の中断要求
      * @return プロファイルIDからProfileInfoへのマップ
      */
-    QMap<QString, ProfileInfo> getChromeProfiles(const QString& browserName);
+    QMap<QString, ProfileInfo> getChromeProfiles(const QString& browserName, DetectionArena& arena,
+                                                 const std::stop_token& stop = {});
+
+    /**
+     * @brief ブラウザ1つを検出
+     * @param browserId ブラウザID
+     * @param stop 検出の中断要求
+     * @return ブラウザ情報（見つからない・無効化・中断された場合は実行ファイルが空）
+     * @note ワーカースレッドから呼び出されるため、メンバーは読み取りのみ行う
+     * @note 作業データは1回の呼び出しごとの DetectionArena に確保し、結果のみを QString / QMap にする
+     */
+    BrowserInfo probeBrowser(const QString& browserId, const std::stop_token& stop = {});
+
+    /**
+     * @brief 実行ファイルのみを解決したブラウザ情報を作成（プロファイルは読まない）
+     * @param browserId ブラウザID
+     * @param arena 検出のアリーナ
+     * @return ブラウザ情報（実行ファイルが見つからない場合は空）
+     */
+    BrowserInfo browserSkeleton(const QString& browserId, DetectionArena& arena) const;
+
+    /**
+     * @brief 1つのプロファイルだけを検出してキャッシュに反映
+     * @param browser ブラウザID
+     * @param profile プロファイルID
+     * @return true: 起動可能
+     * @note 実行ファイルを1つ解決し、プロファイル一覧から対象のエントリのみを取り出して
+     *       そのディレクトリを確認します。最終使用日時など一覧表示用の情報は取得しません
+     */
+    bool lookupProfile(const QString& browser, const QString& profile);
+
+    /**
+     * @brief 検出結果をスナップショットに保存
+     */
+    void saveSnapshot() const;
     
     /**
      * @brief 指定された名前の実行ファイルを検索
      * @param name 実行ファイル名
+     * @param arena 候補のパスを組み立てるアリーナ
      * @return 実行ファイルのフルパス（見つからない場合は空文字列）
      */
-    QString findExecutable(const QString& name) const;
+    QString findExecutable(const QString& name, DetectionArena& arena) const;
     
     /**
      * @brief 複数の実行ファイル名のリストから最初に見つかったものを検索
      * @param names 実行ファイル名のリスト
+     * @param arena 候補のパスを組み立てるアリーナ
      * @return 実行ファイルのフルパス（見つからない場合は空文字列）
      */
-    QString findExecutableFromList(const QStringList& names) const;
+    QString findExecutableFromList(const QStringList& names, DetectionArena& arena) const;
     
     /**
      * @brief プロファイルの最終使用日時を取得
-     * @param browserPath ブラウザのパス
-     * @param profilePath プロファイルのパス
+     * @param browserName ブラウザ名
+     * @param profilePath プロファイルのパス（UTF-8）
+     * @param arena 検出のアリーナ
      * @return 最終使用日時
      */
-    QDateTime getProfileLastUsed(const QString& browserPath, const QString& profilePath);
+    QDateTime getProfileLastUsed(const QString& browserName, const std::pmr::string& profilePath,
+                                 DetectionArena& arena) const;
     
     /**
      * @brief Firefoxのプロファイルディレクトリを取得
@@ -221,30 +470,77 @@ private:
      * @return プロファイルディレクトリのパス
      */
     QString getChromeProfilePath(const QString& browserName) const;
+
+    /**
+     * @brief ロック用シンボリックリンクの所有プロセスが生存しているか確認
+     * @param linkPath シンボリックリンクのパス
+     * @param separator ホスト名とPIDの区切り文字列（Firefox: ":+", Chromium: "-"）
+     * @return true: このホスト上で所有プロセスが生存している
+     */
+    static bool isLockOwnerAlive(const QString& linkPath, const QString& separator);
+
+    /**
+     * @brief 各プロファイルの起動引数プレフィックスを展開
+     * @param browserId ブラウザID
+     * @param browserInfo 展開先のブラウザ情報
+     */
+    void compileLaunchTemplates(const QString& browserId, BrowserInfo& browserInfo) const;
+
+    /**
+     * @brief 起動中のブラウザにリモートプロトコルでURLを渡す
+     * @param browser ブラウザID
+     * @param profile 検証済みのプロファイルID
+     * @param url 検証済みのURL
+     * @param token 起動中のブラウザに渡すアクティベーショントークン
+     * @return true: ブラウザがURLを受け取った, false: execにフォールバックすべき
+     * @note Firefox: D-Busリモーティング, Chrome/Chromium: SingletonSocket。
+     *       GUIスレッドで呼ばれるため、応答は Constants::REMOTE_OPEN_TIMEOUT_MS までしか待たない
+     */
+    bool openInRunningBrowser(const QString& browser, const QString& profile, const QString& url,
+                              const LaunchToken& token) const;
     
     // プロファイル解析ヘルパー
     /**
      * @brief Firefoxのprofiles.iniファイルを解析
-     * @param iniPath profiles.iniのパス
+     * @param profilesPath profiles.iniのあるディレクトリ（UTF-8）
      * @param profiles 結果を格納するマップ
+     * @param arena 検出のアリーナ
+     * @param onlyProfile 指定した場合はこのプロファイルのみを取り出す
+     * @return false: profiles.ini を読めない
      */
-    void parseFirefoxIni(const QString& iniPath, QMap<QString, ProfileInfo>& profiles);
+    bool parseFirefoxIni(const std::pmr::string& profilesPath, QMap<QString, ProfileInfo>& profiles,
+                         DetectionArena& arena, const QString& onlyProfile = QString());
     
     /**
      * @brief Chrome/Chromiumの"Local State"ファイルを解析
-     * @param localStatePath "Local State"ファイルのパス
-     * @param configDir 設定ディレクトリ
+     * @param configDir 設定ディレクトリ（UTF-8）
      * @param profiles 結果を格納するマップ
+     * @param arena 検出のアリーナ
+     * @param onlyProfile 指定した場合はこのプロファイルのみを取り出す
+     * @return false: Local State を読めない、またはJSONとして不正
      */
-    void parseChromiumLocalState(const QString& localStatePath, 
-                                const QString& configDir,
-                                QMap<QString, ProfileInfo>& profiles);
+    bool parseChromiumLocalState(const std::pmr::string& configDir,
+                                 QMap<QString, ProfileInfo>& profiles,
+                                 DetectionArena& arena,
+                                 const QString& onlyProfile = QString());
     
     // 検出結果のキャッシュ
     mutable QMap<QString, BrowserInfo> m_cachedBrowsers;  ///< 検出されたブラウザ情報のキャッシュ
     mutable QDateTime m_lastDetection;                    ///< 最後に検出を実行した日時
     QMap<QString, QString> m_execOverrides;               ///< 実行ファイルパスの上書き
     QMap<QString, bool> m_enabledOverrides;               ///< 有効/無効の上書き
+    LaunchToken m_activationToken;                        ///< 次の起動で渡すアクティベーショントークン
+    QMap<QString, LaunchTemplate> m_launchTemplates;      ///< 起動テンプレート
+
+    // 非同期の検出
+    QSet<QString> m_verifiedBrowsers;                     ///< このセッションで検出済みのブラウザ
+    QMap<QString, BrowserInfo> m_pendingBrowsers;         ///< 実行中の検出で見つかったブラウザ
+    int m_detectionsPending;                              ///< 完了待ちのブラウザ数
+    std::stop_source m_detectionStop;                     ///< 実行中の検出の中断要求
+    ProbeHook m_probeHook;                                ///< 検出前の呼び出し（テスト用）
+    ProfileReader m_profileReader;                        ///< プロファイルの読み込みの差し替え（テスト用）
+    QString m_snapshotPath;                               ///< スナップショットの保存先
+    QThreadPool m_detectionPool;                          ///< 検出用のワーカー（ブラウザごとに並列）
 };
 
 #endif // BROWSERDETECTOR_H
@@ -8,6 +8,7 @@
 
 #include "configmanager.h"
 #include "constants.h"
+#include "tracepoints.h"
 
 #include <KConfig>
 #include <KConfigGroup>
@@ -17,16 +18,28 @@
 #include <QFileInfo>
 #include <QTextStream>
 #include <QSaveFile>
+#include <QDateTime>
+#include <QElapsedTimer>
 
 ConfigManager::ConfigManager(QObject* parent)
     : QObject(parent)
     , m_config(std::make_unique<KConfig>("kde-browser-pickerrc"))
 {
+    QElapsedTimer traceTimer;
+    if (KBP_TRACE_ENABLED(config_load)) {
+        traceTimer.start();
+    }
+
     // 設定ファイルの整合性を確認し、必要に応じて初期化
     ensureConfigValid();
 
     // YAML上書きの読み込み（存在すれば）
     loadYamlOverrides();
+
+    KBP_TRACE(config_load, qUtf8Printable(m_config->name()),
+              static_cast<int>(m_browserExecOverrides.size() + m_browserEnabledOverrides.size() +
+                               m_launchTemplates.size()),
+              traceTimer.nsecsElapsed() / 1000);
 }
 
 ConfigManager::~ConfigManager() = default;
@@ -71,6 +84,31 @@ void ConfigManager::setShowTrayIcon(bool show)
     emit configChanged();
 }
 
+bool ConfigManager::dnsPrefetch() const
+{
+    return generalGroup().readEntry(Constants::CONFIG_KEY_DNS_PREFETCH, true);
+}
+
+void ConfigManager::setDnsPrefetch(bool enabled)
+{
+    generalGroup().writeEntry(Constants::CONFIG_KEY_DNS_PREFETCH, enabled);
+    sync();
+    emit configChanged();
+}
+
+int ConfigManager::idleReclaimSeconds() const
+{
+    return qMax(generalGroup().readEntry(Constants::CONFIG_KEY_IDLE_RECLAIM_SECONDS,
+                                         Constants::DEFAULT_IDLE_RECLAIM_SECONDS), 0);
+}
+
+void ConfigManager::setIdleReclaimSeconds(int seconds)
+{
+    generalGroup().writeEntry(Constants::CONFIG_KEY_IDLE_RECLAIM_SECONDS, qMax(seconds, 0));
+    sync();
+    emit configChanged();
+}
+
 QByteArray ConfigManager::windowGeometry() const
 {
     return generalGroup().readEntry(Constants::CONFIG_KEY_WINDOW_GEOMETRY, QByteArray());
@@ -145,7 +183,12 @@ void ConfigManager::setLastUsed(const QString& browser, const QString& profile)
 
 void ConfigManager::sync()
 {
+    QElapsedTimer traceTimer;
+    if (KBP_TRACE_ENABLED(config_sync)) {
+        traceTimer.start();
+    }
     m_config->sync();
+    KBP_TRACE(config_sync, traceTimer.nsecsElapsed() / 1000);
 }
 
 bool ConfigManager::hasKey(const QString& group, const QString& key) const
@@ -176,6 +219,118 @@ bool ConfigManager::isBrowserEnabledOverride(const QString& browser) const
     return true; // 未指定は有効扱い
 }
 
+MemoryPressure::Policy ConfigManager::memoryPressurePolicy() const
+{
+    return m_memoryPressurePolicy;
+}
+
+bool ConfigManager::speculativeEnabled() const
+{
+    return m_speculativeEnabled;
+}
+
+Constants::SpeculativeCancelPolicy ConfigManager::speculativeCancelPolicy() const
+{
+    return m_speculativeCancelPolicy;
+}
+
+QMap<QString, LaunchTemplate> ConfigManager::launchTemplates() const
+{
+    return m_launchTemplates;
+}
+
+QStringList ConfigManager::yamlLayers() const
+{
+    return m_yamlLayers;
+}
+
+QList<YamlConfig::Diagnostic> ConfigManager::yamlDiagnostics() const
+{
+    return m_yamlDiagnostics;
+}
+
+void ConfigManager::recordLaunch(const QString& browser, const QString& profile, const QString& host)
+{
+    // "最後に使用したブラウザを記憶"設定がオフの場合は履歴も残さない
+    if (!rememberLastUsed()) {
+        return;
+    }
+    
+    const QString target = browser + "/" + profile;
+    
+    // 起動回数と最終起動日時（frecency計算用）
+    KConfigGroup stats = launchStatsGroup();
+    QList<qint64> entry = stats.readEntry(target, QList<qint64>());
+    const qint64 count = entry.size() == 2 ? entry[0] : 0;
+    stats.writeEntry(target, QList<qint64>{count + 1, QDateTime::currentSecsSinceEpoch()});
+    
+    // ホストごとの最後の起動先
+    if (!host.isEmpty()) {
+        hostHistoryGroup().writeEntry(host.toLower(), target);
+    }
+    
+    sync();
+}
+
+QPair<QString, QString> ConfigManager::getLastUsedForHost(const QString& host) const
+{
+    if (host.isEmpty()) {
+        return qMakePair(QString(), QString());
+    }
+    
+    const QString target = hostHistoryGroup().readEntry(host.toLower(), QString());
+    const int slash = target.indexOf('/');
+    if (slash <= 0) {
+        return qMakePair(QString(), QString());
+    }
+    return qMakePair(target.left(slash), target.mid(slash + 1));
+}
+
+double ConfigManager::frecencyScore(const QString& browser, const QString& profile) const
+{
+    const QList<qint64> entry = launchStatsGroup().readEntry(browser + "/" + profile, QList<qint64>());
+    if (entry.size() != 2 || entry[0] <= 0) {
+        return 0.0;
+    }
+    
+    // Firefoxのfrecencyと同様に、最終使用からの経過日数で重み付けする
+    const qint64 days = (QDateTime::currentSecsSinceEpoch() - entry[1]) / 86400;
+    double weight = 10.0;
+    if (days < 4) weight = 100.0;
+    else if (days < 14) weight = 70.0;
+    else if (days < 31) weight = 50.0;
+    else if (days < 90) weight = 30.0;
+    
+    return static_cast<double>(entry[0]) * weight;
+}
+
+void ConfigManager::recordSpeculativeResult(const QString& result)
+{
+    KConfigGroup group = m_config->group(Constants::CONFIG_GROUP_SPECULATIVE);
+    group.writeEntry(result, group.readEntry(result, 0) + 1);
+    sync();
+}
+
+QMap<QString, int> ConfigManager::speculativeStats() const
+{
+    const KConfigGroup group = m_config->group(Constants::CONFIG_GROUP_SPECULATIVE);
+    QMap<QString, int> stats;
+    for (const char* key : {"Hits", "Misses", "Cancels"}) {
+        stats.insert(key, group.readEntry(key, 0));
+    }
+    return stats;
+}
+
+KConfigGroup ConfigManager::launchStatsGroup() const
+{
+    return m_config->group(Constants::CONFIG_GROUP_LAUNCH_STATS);
+}
+
+KConfigGroup ConfigManager::hostHistoryGroup() const
+{
+    return m_config->group(Constants::CONFIG_GROUP_HOST_HISTORY);
+}
+
 KConfigGroup ConfigManager::generalGroup() const
 {
     return m_config->group(Constants::CONFIG_GROUP_GENERAL);
@@ -236,145 +391,25 @@ void ConfigManager::migrateOldConfig()
     }
 }
 
-// 簡易YAMLローダー: 以下の最小構文を想定
-// browsers:
-//   firefox: /opt/firefox/firefox
-//   chrome: /usr/bin/google-chrome-stable
-//   chromium: /usr/local/bin/chromium
-// もしくはネスト形式:
-//   firefox:
-//     path: /opt/firefox/firefox
 void ConfigManager::loadYamlOverrides()
 {
-    m_browserExecOverrides.clear();
-    m_browserEnabledOverrides.clear();
+    const YamlConfig yaml = YamlConfig::load();
 
-    // 参照YAMLパスを決定
-    QByteArray envPath = qgetenv(Constants::YAML_ENV_PATH);
-    QString yamlPath;
-    if (!envPath.isEmpty()) {
-        yamlPath = QString::fromUtf8(envPath);
-    } else {
-        const QString cfgDir = QDir::homePath() + "/.config";
-        const QString yaml1 = cfgDir + "/" + Constants::YAML_CONFIG_FILENAME_YAML;
-        const QString yaml2 = cfgDir + "/" + Constants::YAML_CONFIG_FILENAME_YML;
-        if (QFile::exists(yaml1)) yamlPath = yaml1;
-        else if (QFile::exists(yaml2)) yamlPath = yaml2;
-    }
-
-    if (yamlPath.isEmpty()) {
-        return; // YAMLなし
-    }
-
-    QFile f(yamlPath);
-    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qWarning() << "Failed to open YAML config:" << yamlPath;
-        return;
-    }
-
-    QTextStream in(&f);
-    in.setCodec("UTF-8");
-
-    auto isExecutableFile = [](const QString& p) -> bool {
-        QFileInfo info(p);
-        return !p.isEmpty() && info.exists() && info.isFile() && info.isExecutable();
-    };
-    auto cleanValue = [](QString v) -> QString {
-        v = v.trimmed();
-        if ((v.startsWith('"') && v.endsWith('"')) || (v.startsWith('\'') && v.endsWith('\''))) {
-            v = v.mid(1, v.size() - 2);
-        }
-        return v.trimmed();
-    };
-    auto parseBool = [](const QString& v, bool& ok) -> bool {
-        QString s = v.trimmed().toLower();
-        ok = true;
-        if (s == "true" || s == "yes" || s == "on" || s == "1") return true;
-        if (s == "false" || s == "no" || s == "off" || s == "0") return false;
-        ok = false;
-        return true;
-    };
-
-    bool inBrowsers = false;
-    int baseIndent = -1;
-    QString currentKey;
-    int currentKeyIndent = -1;
-
-    while (!in.atEnd()) {
-        QString line = in.readLine();
-        QString trimmed = line.trimmed();
-        if (trimmed.isEmpty() || trimmed.startsWith('#')) {
-            continue;
-        }
-
-        int indent = 0;
-        while (indent < line.size() && line[indent] == ' ') ++indent;
-
-        if (!inBrowsers) {
-            if (trimmed == "browsers:") {
-                inBrowsers = true;
-                baseIndent = indent;
-                currentKey.clear();
-                currentKeyIndent = -1;
-            }
-            continue;
-        }
-
-        if (indent <= baseIndent) {
-            // browsers ブロック終了
-            inBrowsers = false;
-            currentKey.clear();
-            currentKeyIndent = -1;
-            continue;
-        }
-
-        if (indent == baseIndent + 2) {
-            // 新しいブラウザキー
-            int cpos = line.indexOf(':', indent);
-            if (cpos <= indent) continue;
-            QString key = line.mid(indent, cpos - indent).trimmed();
-            QString rest = line.mid(cpos + 1).trimmed();
-
-            if (key == "firefox" || key == "chrome" || key == "chromium") {
-                if (!rest.isEmpty()) {
-                    QString path = cleanValue(rest);
-                    if (isExecutableFile(path)) {
-                        m_browserExecOverrides.insert(key, path);
-                    }
-                    currentKey.clear();
-                    currentKeyIndent = -1;
-                } else {
-                    currentKey = key;
-                    currentKeyIndent = indent;
-                }
-            } else {
-                currentKey.clear();
-                currentKeyIndent = -1;
-            }
-            continue;
-        }
-
-        if (!currentKey.isEmpty() && indent >= baseIndent + 4) {
-            int cpos = line.indexOf(':', indent);
-            if (cpos > indent) {
-                QString subKey = line.mid(indent, cpos - indent).trimmed();
-                QString subRest = line.mid(cpos + 1).trimmed();
-                if (subKey == "path" && !subRest.isEmpty()) {
-                    QString path = cleanValue(subRest);
-                    if (isExecutableFile(path)) {
-                        m_browserExecOverrides.insert(currentKey, path);
-                    }
-                } else if (subKey == "enabled" && !subRest.isEmpty()) {
-                    bool okb = false;
-                    bool val = parseBool(cleanValue(subRest), okb);
-                    if (okb) {
-                        m_browserEnabledOverrides.insert(currentKey, val);
-                    }
-                }
-            }
-            continue;
+    // 実行パスはキャッシュに関係なく、その時点で実行可能なものだけを使用
+    m_browserExecOverrides.clear();
+    for (auto it = yaml.executableOverrides.cbegin(); it != yaml.executableOverrides.cend(); ++it) {
+        const QFileInfo info(it.value());
+        if (info.isFile() && info.isExecutable()) {
+            m_browserExecOverrides.insert(it.key(), it.value());
         }
     }
+    m_browserEnabledOverrides = yaml.enabledOverrides;
+    m_memoryPressurePolicy = yaml.memoryPressurePolicy;
+    m_speculativeEnabled = yaml.speculativeEnabled;
+    m_speculativeCancelPolicy = yaml.speculativeCancelPolicy;
+    m_launchTemplates = yaml.launchTemplates;
+    m_yamlLayers = yaml.layers;
+    m_yamlDiagnostics = yaml.diagnostics;
 }
 
 bool ConfigManager::deployDefaults(bool overwriteYaml)
@@ -407,6 +442,8 @@ bool ConfigManager::deployDefaults(bool overwriteYaml)
             out << "# KDE Browser Picker YAML configuration\n";
             out << "# Override executable paths only if needed.\n";
             out << "# Supported keys under 'browsers': firefox, chrome, chromium\n";
+            out << "# Layers (later ones win): /etc/xdg/kde-browser-picker.yaml, this file,\n";
+            out << "# then $KDE_BROWSER_PICKER_YAML. Check them with --check-config.\n";
             out << "#\n";
             out << "# Example (inline):\n";
             out << "# browsers:\n";
@@ -419,6 +456,32 @@ bool ConfigManager::deployDefaults(bool overwriteYaml)
             out << "#   firefox:\n";
             out << "#     path: /opt/firefox/firefox\n";
             out << "#     enabled: true\n";
+            out << "#\n";
+            out << "# Memory pressure (PSI): above the threshold, prefer profiles whose\n";
+            out << "# browser is already running instead of cold-starting another one.\n";
+            out << "# memory_pressure:\n";
+            out << "#   enabled: true\n";
+            out << "#   threshold: 10      # percent, 0-100\n";
+            out << "#   metric: some       # some | full\n";
+            out << "#   window: avg10      # avg10 | avg60 | avg300\n";
+            out << "#\n";
+            out << "# Speculative warm-start: pre-launch the predicted profile's browser\n";
+            out << "# while the picker is open (opt-in).\n";
+            out << "# speculative:\n";
+            out << "#   enabled: false\n";
+            out << "#   on_cancel: keep    # keep | close the pre-launched browser\n";
+            out << "#\n";
+            out << "# Launch templates: extra options and environment per browser or profile.\n";
+            out << "# Placeholders: {url} (whole argument only), {profile}, {dir}\n";
+            out << "# launch:\n";
+            out << "#   chrome:\n";
+            out << "#     args: [--process-per-site]\n";
+            out << "#   \"chrome/Profile 1\":\n";
+            out << "#     args:\n";
+            out << "#       - --disk-cache-dir=/dev/shm/chrome-cache/{profile}\n";
+            out << "#   firefox:\n";
+            out << "#     env:\n";
+            out << "#       MOZ_ENABLE_WAYLAND: 1\n";
             if (f.commit()) {
                 changed = true;
             }
@@ -15,6 +15,11 @@
 #include <memory>
 #include <QMap>
 
+#include "memorypressure.h"
+#include "launchtemplate.h"
+#include "yamlconfig.h"
+#include "constants.h"
+
 // Forward declarations
 class KConfig;
 class KConfigGroup;
@@ -82,7 +87,31 @@ public:
      * @param show true: 表示する, false: 表示しない
      */
     void setShowTrayIcon(bool show);
-    
+
+    /**
+     * @brief ピッカーの表示中にURLのホスト名を先に解決するかどうかを取得
+     * @return true: 解決する（既定）, false: 解決しない
+     */
+    bool dnsPrefetch() const;
+
+    /**
+     * @brief ピッカーの表示中にURLのホスト名を先に解決するかどうかを設定
+     * @param enabled true: 解決する, false: 解決しない
+     */
+    void setDnsPrefetch(bool enabled);
+
+    /**
+     * @brief 非表示のまま常駐しているピッカーがメモリを解放するまでの秒数を取得
+     * @return 秒数（0: 解放しない）
+     */
+    int idleReclaimSeconds() const;
+
+    /**
+     * @brief 非表示のまま常駐しているピッカーがメモリを解放するまでの秒数を設定
+     * @param seconds 秒数（0: 解放しない）
+     */
+    void setIdleReclaimSeconds(int seconds);
+
     /**
      * @brief ウィンドウのジオメトリ（位置とサイズ）を取得
      * @return Qtのジオメトリデータ（QByteArray形式）
@@ -198,6 +227,72 @@ public:
      */
     bool isBrowserEnabledOverride(const QString& browser) const;
 
+    /**
+     * @brief YAMLで指定されたメモリ逼迫判定のポリシーを取得
+     * @return 判定ポリシー（未指定の項目はデフォルト値）
+     */
+    MemoryPressure::Policy memoryPressurePolicy() const;
+
+    /**
+     * @brief 予測したプロファイルの先行起動が有効かどうか（YAMLで指定、既定は無効）
+     */
+    bool speculativeEnabled() const;
+
+    /**
+     * @brief キャンセル時に先行起動したブラウザをどう扱うか（YAMLで指定）
+     */
+    Constants::SpeculativeCancelPolicy speculativeCancelPolicy() const;
+
+    /**
+     * @brief YAMLで指定された起動テンプレートを取得
+     * @return "browser" または "browser/profile" -> 検証済みのテンプレート
+     */
+    QMap<QString, LaunchTemplate> launchTemplates() const;
+
+    /**
+     * @brief 読み込んだYAML設定ファイル（優先度の低い順）
+     */
+    QStringList yamlLayers() const;
+
+    /**
+     * @brief YAML設定の検証エラー（位置付き）
+     */
+    QList<YamlConfig::Diagnostic> yamlDiagnostics() const;
+
+    // 起動履歴
+    /**
+     * @brief 起動を記録（起動回数・最終起動日時・ホストごとの起動先）
+     * @param browser ブラウザID
+     * @param profile プロファイルID
+     * @param host 開いたURLのホスト（空の場合はホスト履歴を更新しない）
+     */
+    void recordLaunch(const QString& browser, const QString& profile, const QString& host);
+
+    /**
+     * @brief 指定されたホストを最後に開いたブラウザとプロファイルを取得
+     * @param host ホスト名
+     * @return ブラウザIDとプロファイルIDのペア（履歴がなければ空）
+     */
+    QPair<QString, QString> getLastUsedForHost(const QString& host) const;
+
+    /**
+     * @brief プロファイルのfrecency（頻度×最近度）スコアを取得
+     * @return スコア（起動履歴がなければ0）
+     */
+    double frecencyScore(const QString& browser, const QString& profile) const;
+
+    /**
+     * @brief 先行起動の結果を記録
+     * @param result "Hits" / "Misses" / "Cancels"
+     */
+    void recordSpeculativeResult(const QString& result);
+
+    /**
+     * @brief 先行起動の的中・外れ・キャンセル回数を取得
+     * @return "Hits" / "Misses" / "Cancels" -> 回数
+     */
+    QMap<QString, int> speculativeStats() const;
+
     /**
      * @brief デフォルト設定ファイルを展開（生成）
      * ~/.config/kde-browser-pickerrc に初期値を書き、
@@ -245,6 +340,16 @@ private:
      */
     KConfigGroup profileGroup(const QString& browser, const QString& profile) const;
     
+    /**
+     * @brief 起動回数・最終起動日時の設定グループを取得
+     */
+    KConfigGroup launchStatsGroup() const;
+    
+    /**
+     * @brief ホストごとの起動先の設定グループを取得
+     */
+    KConfigGroup hostHistoryGroup() const;
+    
     // 設定ファイルの検証
     /**
      * @brief 設定ファイルの整合性を確認し、必要に応じて初期化
@@ -256,11 +361,19 @@ private:
      */
     void migrateOldConfig();
 
-    // YAML設定の読み込み
+    /**
+     * @brief YAML設定の読み込み（全ての層を結合したキャッシュを使用）
+     */
     void loadYamlOverrides();
 
     QMap<QString, QString> m_browserExecOverrides; ///< YAML上書き
     QMap<QString, bool> m_browserEnabledOverrides; ///< YAML有効/無効上書き
+    MemoryPressure::Policy m_memoryPressurePolicy; ///< YAMLメモリ逼迫判定ポリシー
+    bool m_speculativeEnabled = false;             ///< YAML先行起動の有効/無効
+    Constants::SpeculativeCancelPolicy m_speculativeCancelPolicy = Constants::SpeculativeCancelPolicy::Keep; ///< YAMLキャンセル時の扱い
+    QMap<QString, LaunchTemplate> m_launchTemplates; ///< YAML起動テンプレート
+    QStringList m_yamlLayers;                      ///< 読み込んだYAML設定ファイル
+    QList<YamlConfig::Diagnostic> m_yamlDiagnostics; ///< YAML検証エラー
 };
 
 #endif // CONFIGMANAGER_H
@@ -0,0 +1,116 @@
+/**
+ * @file countdown.cpp
+ * @brief Countdownクラスの実装
+ */
+
+#include "countdown.h"
+
+#include <QTimer>
+
+Countdown::Countdown(QObject* parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+    , m_pausedRemainingMs(-1)
+    , m_running(false)
+    , m_shownSeconds(0)
+{
+    // 表示の更新は数十ミリ秒ずれても構わないため、他のタイマーとまとめて起床できる種類にする
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::CoarseTimer);
+    connect(m_timer, &QTimer::timeout, this, &Countdown::onTimer);
+}
+
+void Countdown::start(int seconds)
+{
+    m_pausedRemainingMs = -1;
+    if (seconds <= 0) {
+        stop();
+        return;
+    }
+
+    m_deadline.setRemainingTime(qint64(seconds) * 1000);
+    m_running = true;
+    m_shownSeconds = seconds;
+    emit tick(seconds);
+    schedule();
+}
+
+void Countdown::stop()
+{
+    m_timer->stop();
+    m_running = false;
+    m_pausedRemainingMs = -1;
+}
+
+void Countdown::pause()
+{
+    if (!m_running) {
+        return;
+    }
+    m_pausedRemainingMs = qMax<qint64>(m_deadline.remainingTime(), 0);
+    m_running = false;
+    m_timer->stop();
+}
+
+void Countdown::resume()
+{
+    if (m_pausedRemainingMs < 0) {
+        return;
+    }
+    m_deadline.setRemainingTime(m_pausedRemainingMs);
+    m_pausedRemainingMs = -1;
+    m_running = true;
+    m_shownSeconds = remainingSeconds();
+    emit tick(m_shownSeconds);
+    schedule();
+}
+
+bool Countdown::isActive() const
+{
+    return m_running;
+}
+
+int Countdown::remainingSeconds() const
+{
+    qint64 remaining = m_pausedRemainingMs;
+    if (remaining < 0) {
+        if (!m_running) {
+            return 0;
+        }
+        remaining = qMax<qint64>(m_deadline.remainingTime(), 0);
+    }
+    return static_cast<int>((remaining + 999) / 1000);
+}
+
+void Countdown::schedule()
+{
+    const qint64 remaining = m_deadline.remainingTime();
+    if (remaining <= 0) {
+        m_timer->stop();
+        m_running = false;
+        emit expired();
+        return;
+    }
+
+    // 残り秒数（切り上げ）の表示が変わるのは、残り時間が1000の倍数を下回るとき
+    const qint64 untilNextSecond = remaining % 1000;
+    m_timer->start(static_cast<int>(untilNextSecond == 0 ? 1000 : untilNextSecond));
+}
+
+void Countdown::onTimer()
+{
+    // CoarseTimer は早めに満了することがあるため、期限は常に単調時計で判定する
+    if (m_deadline.hasExpired()) {
+        m_running = false;
+        emit expired();
+        return;
+    }
+
+    // 早めに満了した場合は表示が変わらないため通知しない
+    const int seconds = remainingSeconds();
+    if (seconds != m_shownSeconds) {
+        m_shownSeconds = seconds;
+        emit tick(seconds);
+    }
+    schedule();
+}
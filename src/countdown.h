@@ -0,0 +1,99 @@
+/**
+ * @file countdown.h
+ * @brief 単調時計の期限から描画する自動選択のカウントダウン
+ *
+ * 1秒周期のタイマーで残り秒数を減算する代わりに、1つの期限（QDeadlineTimer）を保持し、
+ * 表示が変わる次の秒の境界だけタイマーを設定します。一時停止中はタイマーを持たないため、
+ * ウィンドウを隠している間やトレイに常駐している間にCPUを起こしません。
+ */
+
+#ifndef COUNTDOWN_H
+#define COUNTDOWN_H
+
+#include <QDeadlineTimer>
+#include <QObject>
+
+class QTimer;
+
+/**
+ * @class Countdown
+ * @brief 期限までの残り秒数の通知
+ */
+class Countdown : public QObject {
+    Q_OBJECT
+
+public:
+    explicit Countdown(QObject* parent = nullptr);
+    ~Countdown() override = default;
+
+    // コピーコンストラクタと代入演算子を削除
+    Countdown(const Countdown&) = delete;
+    Countdown& operator=(const Countdown&) = delete;
+
+    /**
+     * @brief カウントダウンを開始
+     * @param seconds 期限までの秒数（0以下の場合は停止）
+     */
+    void start(int seconds);
+
+    /**
+     * @brief カウントダウンを停止（一時停止中の残り時間も破棄）
+     */
+    void stop();
+
+    /**
+     * @brief 残り時間を保持してタイマーを止める
+     */
+    void pause();
+
+    /**
+     * @brief pause() で保持した残り時間から再開
+     */
+    void resume();
+
+    /**
+     * @brief 実行中かどうか（一時停止中は false）
+     */
+    bool isActive() const;
+
+    /**
+     * @brief 一時停止中かどうか
+     */
+    bool isPaused() const { return m_pausedRemainingMs >= 0; }
+
+    /**
+     * @brief 表示用の残り秒数（切り上げ。停止中は 0）
+     */
+    int remainingSeconds() const;
+
+signals:
+    /**
+     * @brief 表示する残り秒数が変わった（開始・再開時も通知）
+     * @param remainingSeconds 残り秒数
+     */
+    void tick(int remainingSeconds);
+
+    /**
+     * @brief 期限に達した
+     */
+    void expired();
+
+private:
+    /**
+     * @brief 表示が変わる次の秒の境界（または期限）にタイマーを設定
+     */
+    void schedule();
+
+    /**
+     * @brief タイマー満了時の処理
+     */
+    void onTimer();
+
+    QTimer* m_timer;                 ///< 次の秒の境界までの単発タイマー
+    QDeadlineTimer m_deadline;       ///< 自動選択の期限（単調時計）
+    qint64 m_pausedRemainingMs;      ///< 一時停止中の残り時間（-1: 一時停止していない）
+    bool m_running;                  ///< 実行中（期限・一時停止・停止で false）
+    int m_shownSeconds;              ///< 最後に通知した残り秒数
+};
+
+#endif // COUNTDOWN_H
@@ -0,0 +1,578 @@
+/**
+ * @file detectionarena.cpp
+ * @brief DetectionArenaクラスの実装
+ */
+
+#include "detectionarena.h"
+
+#include <QChar>
+
+#include <cerrno>
+#include <charconv>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+/// JSONの入れ子の上限（不正なファイルで再帰が深くなりすぎないように）
+constexpr int MAX_JSON_DEPTH = 512;
+
+/**
+ * @brief コードポイントをUTF-8で書き込む
+ * @return 書き込んだ次の位置
+ */
+char* encodeUtf8(char32_t c, char* out)
+{
+    if (c < 0x80) {
+        *out++ = static_cast<char>(c);
+    } else if (c < 0x800) {
+        *out++ = static_cast<char>(0xC0 | (c >> 6));
+        *out++ = static_cast<char>(0x80 | (c & 0x3F));
+    } else if (c < 0x10000) {
+        *out++ = static_cast<char>(0xE0 | (c >> 12));
+        *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (c & 0x3F));
+    } else {
+        *out++ = static_cast<char>(0xF0 | (c >> 18));
+        *out++ = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+        *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (c & 0x3F));
+    }
+    return out;
+}
+
+std::string_view trimmed(std::string_view text)
+{
+    constexpr std::string_view whitespace = " \t\r";
+    const size_t begin = text.find_first_not_of(whitespace);
+    if (begin == std::string_view::npos) {
+        return std::string_view();
+    }
+    return text.substr(begin, text.find_last_not_of(whitespace) - begin + 1);
+}
+
+/**
+ * @brief QVariant(QString).toBool() と同じ規則で真偽値に変換
+ * @note 空・"0"・"false"（大文字小文字を区別しない）のみ偽
+ */
+bool iniBool(std::string_view value)
+{
+    if (value.empty() || value == "0") {
+        return false;
+    }
+    constexpr std::string_view falseText = "false";
+    if (value.size() != falseText.size()) {
+        return true;
+    }
+    for (size_t i = 0; i < value.size(); ++i) {
+        if ((value[i] | 0x20) != falseText[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @class JsonScanner
+ * @brief 必要なキーだけを取り出すためのJSONの走査
+ *
+ * 木を作らずに先頭から読み進め、不要な値は構文だけを確認して読み飛ばします。
+ * 文字列はエスケープを含む場合のみアリーナ上に展開します。
+ */
+class JsonScanner {
+public:
+    JsonScanner(std::string_view text, std::pmr::memory_resource* resource)
+        : m_text(text), m_resource(resource) {}
+
+    /// 次の空白以外の文字（終端では '\0'）
+    char peek()
+    {
+        skipWhitespace();
+        return m_pos < m_text.size() ? m_text[m_pos] : '\0';
+    }
+
+    /// 空白以外に何も残っていないか
+    bool atEnd()
+    {
+        skipWhitespace();
+        return m_pos == m_text.size();
+    }
+
+    /**
+     * @brief オブジェクトのメンバーを順に処理
+     * @param member キーを受け取り、値を読み進める関数（false: 不正）
+     */
+    template <typename Member>
+    bool object(Member&& member)
+    {
+        if (!consume('{')) {
+            return false;
+        }
+        if (consume('}')) {
+            return true;
+        }
+        do {
+            std::string_view key;
+            if (!string(&key) || !consume(':') || !member(key)) {
+                return false;
+            }
+        } while (consume(','));
+        return consume('}');
+    }
+
+    /**
+     * @brief 文字列を読む
+     * @param out 展開した文字列（エスケープがなければ入力へのビュー）
+     */
+    bool string(std::string_view* out)
+    {
+        if (!consume('"')) {
+            return false;
+        }
+        const size_t begin = m_pos;
+        bool escaped = false;
+        while (m_pos < m_text.size() && m_text[m_pos] != '"') {
+            const auto c = static_cast<unsigned char>(m_text[m_pos]);
+            if (c < 0x20) {
+                return false;
+            }
+            if (c == '\\') {
+                escaped = true;
+                ++m_pos;
+            }
+            ++m_pos;
+        }
+        if (m_pos >= m_text.size()) {
+            return false;
+        }
+        const std::string_view raw = m_text.substr(begin, m_pos - begin);
+        ++m_pos;
+
+        if (!escaped) {
+            *out = raw;
+            return true;
+        }
+        // 展開後の長さはエスケープ前を超えない
+        auto* buffer = static_cast<char*>(m_resource->allocate(raw.size(), 1));
+        char* end = unescape(raw, buffer);
+        if (!end) {
+            return false;
+        }
+        *out = std::string_view(buffer, static_cast<size_t>(end - buffer));
+        return true;
+    }
+
+    /// 文字列なら読み、それ以外は読み飛ばす（QJsonValue::toString() と同じく空のまま）
+    bool stringValue(std::string_view* out)
+    {
+        return peek() == '"' ? string(out) : skipValue();
+    }
+
+    /// 真偽値なら読み、それ以外は読み飛ばす（QJsonValue::toBool(default) と同じく既定値のまま）
+    bool boolValue(bool* out)
+    {
+        if (literal("true")) {
+            *out = true;
+            return true;
+        }
+        if (literal("false")) {
+            *out = false;
+            return true;
+        }
+        return skipValue();
+    }
+
+    /// 数値なら読み、それ以外は読み飛ばす（QJsonValue::toDouble() と同じく 0 のまま）
+    bool numberValue(double* out)
+    {
+        const char c = peek();
+        return (c == '-' || (c >= '0' && c <= '9')) ? number(out) : skipValue();
+    }
+
+    /// 値を読み飛ばす（構文は確認する）
+    bool skipValue(int depth = 0)
+    {
+        if (depth > MAX_JSON_DEPTH) {
+            return false;
+        }
+        switch (peek()) {
+        case '{':
+            return object([this, depth](std::string_view) { return skipValue(depth + 1); });
+        case '[':
+            consume('[');
+            if (consume(']')) {
+                return true;
+            }
+            do {
+                if (!skipValue(depth + 1)) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume(']');
+        case '"': {
+            std::string_view ignored;
+            return string(&ignored);
+        }
+        case 't':
+            return literal("true");
+        case 'f':
+            return literal("false");
+        case 'n':
+            return literal("null");
+        default: {
+            double ignored = 0.0;
+            return number(&ignored);
+        }
+        }
+    }
+
+private:
+    void skipWhitespace()
+    {
+        while (m_pos < m_text.size() &&
+               (m_text[m_pos] == ' ' || m_text[m_pos] == '\t' || m_text[m_pos] == '\n' || m_text[m_pos] == '\r')) {
+            ++m_pos;
+        }
+    }
+
+    bool consume(char c)
+    {
+        if (peek() != c) {
+            return false;
+        }
+        ++m_pos;
+        return true;
+    }
+
+    bool literal(std::string_view word)
+    {
+        skipWhitespace();
+        if (m_text.substr(m_pos, word.size()) != word) {
+            return false;
+        }
+        m_pos += word.size();
+        return true;
+    }
+
+    bool digits()
+    {
+        const size_t begin = m_pos;
+        while (m_pos < m_text.size() && m_text[m_pos] >= '0' && m_text[m_pos] <= '9') {
+            ++m_pos;
+        }
+        return m_pos > begin;
+    }
+
+    bool number(double* out)
+    {
+        skipWhitespace();
+        const size_t begin = m_pos;
+        if (m_pos < m_text.size() && m_text[m_pos] == '-') {
+            ++m_pos;
+        }
+        if (!digits()) {
+            return false;
+        }
+        if (m_pos < m_text.size() && m_text[m_pos] == '.') {
+            ++m_pos;
+            if (!digits()) {
+                return false;
+            }
+        }
+        if (m_pos < m_text.size() && (m_text[m_pos] == 'e' || m_text[m_pos] == 'E')) {
+            ++m_pos;
+            if (m_pos < m_text.size() && (m_text[m_pos] == '+' || m_text[m_pos] == '-')) {
+                ++m_pos;
+            }
+            if (!digits()) {
+                return false;
+            }
+        }
+        const char* first = m_text.data() + begin;
+        const char* last = m_text.data() + m_pos;
+        const auto result = std::from_chars(first, last, *out);
+        return result.ec == std::errc() || result.ec == std::errc::result_out_of_range;
+    }
+
+    static int hexValue(char c)
+    {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    /// "\uXXXX" の XXXX を読む（-1: 不正）
+    static int hex4(std::string_view raw, size_t pos)
+    {
+        if (pos + 4 > raw.size()) {
+            return -1;
+        }
+        int value = 0;
+        for (size_t i = pos; i < pos + 4; ++i) {
+            const int digit = hexValue(raw[i]);
+            if (digit < 0) {
+                return -1;
+            }
+            value = value * 16 + digit;
+        }
+        return value;
+    }
+
+    /**
+     * @brief エスケープを展開
+     * @return 書き込んだ次の位置（不正なエスケープの場合は nullptr）
+     */
+    static char* unescape(std::string_view raw, char* out)
+    {
+        for (size_t i = 0; i < raw.size(); ++i) {
+            if (raw[i] != '\\') {
+                *out++ = raw[i];
+                continue;
+            }
+            if (++i >= raw.size()) {
+                return nullptr;
+            }
+            switch (raw[i]) {
+            case '"': *out++ = '"'; break;
+            case '\\': *out++ = '\\'; break;
+            case '/': *out++ = '/'; break;
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u': {
+                const int unit = hex4(raw, i + 1);
+                if (unit < 0) {
+                    return nullptr;
+                }
+                i += 4;
+                char32_t c = static_cast<char32_t>(unit);
+                if (QChar::isHighSurrogate(c)) {
+                    // 続く "\uDC00-\uDFFF" と組にする
+                    const int low = (i + 2 < raw.size() && raw[i + 1] == '\\' && raw[i + 2] == 'u')
+                        ? hex4(raw, i + 3) : -1;
+                    if (low >= 0 && QChar::isLowSurrogate(static_cast<char32_t>(low))) {
+                        c = QChar::surrogateToUcs4(static_cast<char16_t>(unit), static_cast<char16_t>(low));
+                        i += 6;
+                    } else {
+                        c = QChar::ReplacementCharacter;
+                    }
+                } else if (QChar::isSurrogate(c)) {
+                    c = QChar::ReplacementCharacter;
+                }
+                out = encodeUtf8(c, out);
+                break;
+            }
+            default:
+                return nullptr;
+            }
+        }
+        return out;
+    }
+
+    std::string_view m_text;
+    size_t m_pos = 0;
+    std::pmr::memory_resource* m_resource;
+};
+
+} // namespace
+
+DetectionArena::DetectionArena()
+    : m_resource(m_buffer, sizeof(m_buffer), std::pmr::new_delete_resource())
+{
+}
+
+std::pmr::string DetectionArena::join(std::initializer_list<std::string_view> parts)
+{
+    size_t length = 0;
+    for (std::string_view part : parts) {
+        length += part.size();
+    }
+    std::pmr::string result(&m_resource);
+    result.reserve(length);
+    for (std::string_view part : parts) {
+        result.append(part);
+    }
+    return result;
+}
+
+std::pmr::string DetectionArena::utf8(QStringView text)
+{
+    std::pmr::string result(&m_resource);
+    // UTF-16の1単位はUTF-8で最大3バイト（サロゲートペアは2単位で4バイト）
+    result.resize(static_cast<size_t>(text.size()) * 3);
+    char* out = result.data();
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        char32_t c = text[i].unicode();
+        if (QChar::isHighSurrogate(c) && i + 1 < text.size() && text[i + 1].isLowSurrogate()) {
+            c = QChar::surrogateToUcs4(text[i].unicode(), text[i + 1].unicode());
+            ++i;
+        } else if (QChar::isSurrogate(c)) {
+            c = QChar::ReplacementCharacter;
+        }
+        out = encodeUtf8(c, out);
+    }
+    result.resize(static_cast<size_t>(out - result.data()));
+    return result;
+}
+
+bool DetectionArena::readFile(const std::pmr::string& path, std::pmr::string* contents)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+
+    // 読み込み中にファイルが伸びた場合に備えて1バイト多く確保し、終端まで読む
+    contents->resize(static_cast<size_t>(st.st_size) + 1);
+    size_t total = 0;
+    for (;;) {
+        if (total == contents->size()) {
+            contents->resize(contents->size() * 2);
+        }
+        const ssize_t n = ::read(fd, contents->data() + total, contents->size() - total);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            ::close(fd);
+            contents->resize(total);
+            return n == 0;
+        }
+        total += static_cast<size_t>(n);
+    }
+}
+
+bool DetectionArena::exists(const std::pmr::string& path)
+{
+    struct stat st;
+    return ::stat(path.c_str(), &st) == 0;
+}
+
+bool DetectionArena::isDirectory(const std::pmr::string& path)
+{
+    struct stat st;
+    return ::stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool DetectionArena::isExecutableFile(const std::pmr::string& path)
+{
+    struct stat st;
+    return ::stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode) && ::access(path.c_str(), X_OK) == 0;
+}
+
+QDateTime DetectionArena::lastModified(const std::pmr::string& path)
+{
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        return QDateTime();
+    }
+    return QDateTime::fromMSecsSinceEpoch(static_cast<qint64>(st.st_mtim.tv_sec) * 1000 +
+                                          st.st_mtim.tv_nsec / 1000000);
+}
+
+void DetectionArena::parseProfilesIni(std::string_view text, std::pmr::vector<FirefoxEntry>* entries)
+{
+    FirefoxEntry current;
+    bool inProfile = false;
+    auto flush = [&]() {
+        if (inProfile && !current.name.empty() && !current.path.empty()) {
+            entries->push_back(current);
+        }
+        current = FirefoxEntry();
+    };
+
+    while (!text.empty()) {
+        const size_t newline = text.find('\n');
+        const std::string_view line = trimmed(text.substr(0, newline));
+        text = newline == std::string_view::npos ? std::string_view() : text.substr(newline + 1);
+        if (line.empty() || line.front() == ';' || line.front() == '#') {
+            continue;
+        }
+
+        // Firefoxは[Profile0], [Profile1]などのセクションを使用
+        if (line.front() == '[') {
+            flush();
+            const std::string_view section = line.substr(1, line.find(']') - 1);
+            inProfile = section.substr(0, 7) == "Profile";
+            continue;
+        }
+        if (!inProfile) {
+            continue;
+        }
+
+        const size_t equals = line.find('=');
+        if (equals == std::string_view::npos) {
+            continue;
+        }
+        const std::string_view key = trimmed(line.substr(0, equals));
+        std::string_view value = trimmed(line.substr(equals + 1));
+        if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+            value = value.substr(1, value.size() - 2);
+        }
+        if (key == "Name") {
+            current.name = value;
+        } else if (key == "Path") {
+            current.path = value;
+        } else if (key == "Default") {
+            current.isDefault = iniBool(value);
+        }
+    }
+    flush();
+}
+
+bool DetectionArena::parseLocalState(std::string_view json, std::pmr::vector<ChromiumEntry>* entries)
+{
+    JsonScanner scanner(json, &m_resource);
+    if (scanner.peek() != '{') {
+        return false;
+    }
+
+    // profile.info_cache の各エントリから表示名とアバターだけを取り出す
+    auto readEntry = [&](std::string_view directory) {
+        ChromiumEntry entry;
+        entry.directory = directory;
+        const bool valid = scanner.peek() != '{'
+            ? scanner.skipValue()
+            : scanner.object([&](std::string_view field) {
+                  if (field == "name") return scanner.stringValue(&entry.name);
+                  if (field == "gaia_picture_file_name") return scanner.stringValue(&entry.gaiaPicture);
+                  if (field == "avatar_icon") return scanner.stringValue(&entry.avatarIcon);
+                  if (field == "use_gaia_picture") return scanner.boolValue(&entry.useGaiaPicture);
+                  return scanner.skipValue(1);
+              });
+        entries->push_back(entry);
+        return valid;
+    };
+    auto readProfile = [&](std::string_view key) {
+        if (key != "info_cache" || scanner.peek() != '{') {
+            return scanner.skipValue(1);
+        }
+        return scanner.object(readEntry);
+    };
+    const bool valid = scanner.object([&](std::string_view key) {
+        if (key != "profile" || scanner.peek() != '{') {
+            return scanner.skipValue();
+        }
+        return scanner.object(readProfile);
+    });
+    return valid && scanner.atEnd();
+}
+
+double DetectionArena::parseFirstUse(std::string_view json)
+{
+    JsonScanner scanner(json, &m_resource);
+    double firstUse = 0.0;
+    const bool valid = scanner.peek() == '{' && scanner.object([&](std::string_view key) {
+        return key == "firstUse" ? scanner.numberValue(&firstUse) : scanner.skipValue();
+    });
+    return valid && scanner.atEnd() ? firstUse : 0.0;
+}
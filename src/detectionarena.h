@@ -0,0 +1,153 @@
+/**
+ * @file detectionarena.h
+ * @brief 検出1回分の作業領域（アリーナ）と、その上で動く読み取り専用のパーサー
+ *
+ * 検出中に作られるパスの連結・読み込んだファイルの内容・解析途中の文字列は、
+ * 検出が終われば不要になります。これらを std::pmr::monotonic_buffer_resource に確保し、
+ * 検出の終了時にまとめて破棄します。長く保持する QString / QMap に変換するのは
+ * 最終結果（ProfileInfo のフィールド）だけです。
+ *
+ * 作業用の文字列はUTF-8（ディスク上の profiles.ini・Local State とシステムコールの引数の形式）
+ * のまま扱い、UTF-16への変換は結果を作るときに一度だけ行います。
+ */
+
+#ifndef DETECTIONARENA_H
+#define DETECTIONARENA_H
+
+#include <QDateTime>
+#include <QString>
+#include <QStringView>
+
+#include <cstddef>
+#include <initializer_list>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class DetectionArena
+ * @brief 検出1回分のアリーナ
+ *
+ * 最初の INITIAL_BYTES はオブジェクト内のバッファ（検出するスレッドのスタック上）から確保し、
+ * 足りなくなった場合のみヒープからブロックを追加します。
+ * 返される std::string_view はアリーナが破棄されるまで有効です。
+ *
+ * @note スレッドセーフではありません。検出するスレッドごとに作成してください
+ */
+class DetectionArena {
+public:
+    /// オブジェクト内のバッファのサイズ（典型的な profiles.ini とパスの連結が収まる大きさ）
+    static constexpr std::size_t INITIAL_BYTES = 16 * 1024;
+
+    /**
+     * @struct FirefoxEntry
+     * @brief profiles.ini の [Profile*] セクション
+     */
+    struct FirefoxEntry {
+        std::string_view name;      ///< Name
+        std::string_view path;      ///< Path（profiles.ini からの相対パス）
+        bool isDefault = false;     ///< Default
+    };
+
+    /**
+     * @struct ChromiumEntry
+     * @brief Local State の profile.info_cache のエントリ
+     */
+    struct ChromiumEntry {
+        std::string_view directory;     ///< プロファイルディレクトリ名（キー）
+        std::string_view name;          ///< name
+        std::string_view gaiaPicture;   ///< gaia_picture_file_name
+        std::string_view avatarIcon;    ///< avatar_icon
+        bool useGaiaPicture = true;     ///< use_gaia_picture（真偽値でない場合は true）
+    };
+
+    DetectionArena();
+
+    // アリーナ上のビューを返すため、コピー・ムーブは禁止
+    DetectionArena(const DetectionArena&) = delete;
+    DetectionArena& operator=(const DetectionArena&) = delete;
+
+    /**
+     * @brief 確保に使うメモリリソース（std::pmr コンテナ用）
+     */
+    std::pmr::memory_resource* resource() { return &m_resource; }
+
+    /**
+     * @brief 空の文字列をアリーナ上に作成
+     */
+    std::pmr::string string() { return std::pmr::string(&m_resource); }
+
+    /**
+     * @brief 文字列を連結してアリーナ上に作成
+     * @param parts 連結する部分（区切り文字は呼び出し側で含める）
+     */
+    std::pmr::string join(std::initializer_list<std::string_view> parts);
+
+    /**
+     * @brief UTF-16の文字列をUTF-8に変換してアリーナ上に作成
+     * @note QString::toUtf8() と異なりヒープに確保しない
+     */
+    std::pmr::string utf8(QStringView text);
+
+    /**
+     * @brief ファイル全体を読み込む
+     * @param path ファイルのパス
+     * @param contents 読み込み先（再利用するバッファ。内容は置き換えられる）
+     * @return true: 読み込んだ
+     */
+    static bool readFile(const std::pmr::string& path, std::pmr::string* contents);
+
+    /// パスが存在するか
+    static bool exists(const std::pmr::string& path);
+
+    /// パスがディレクトリか（シンボリックリンクは辿る）
+    static bool isDirectory(const std::pmr::string& path);
+
+    /// パスが実行可能な通常ファイルか
+    static bool isExecutableFile(const std::pmr::string& path);
+
+    /**
+     * @brief 更新日時を取得
+     * @return 更新日時（存在しない場合は無効な値）
+     */
+    static QDateTime lastModified(const std::pmr::string& path);
+
+    /**
+     * @brief profiles.ini を解析
+     * @param text ファイルの内容
+     * @param entries [Profile*] セクションのうち Name と Path を持つもの（出現順）
+     * @note 値はUTF-8として扱い、前後の空白と囲みの二重引用符を取り除きます
+     */
+    static void parseProfilesIni(std::string_view text, std::pmr::vector<FirefoxEntry>* entries);
+
+    /**
+     * @brief Local State を解析
+     * @param json ファイルの内容
+     * @param entries profile.info_cache のエントリ（出現順）
+     * @return false: JSONとして不正（ルートがオブジェクトでない場合を含む）
+     * @note エスケープを含む文字列のみアリーナ上に展開し、それ以外は json へのビューを返します
+     */
+    bool parseLocalState(std::string_view json, std::pmr::vector<ChromiumEntry>* entries);
+
+    /**
+     * @brief Firefoxの times.json から firstUse を取得
+     * @param json ファイルの内容
+     * @return firstUse（ミリ秒。不正・欠落の場合は 0）
+     */
+    double parseFirstUse(std::string_view json);
+
+    /**
+     * @brief ビューを QString に変換（結果を作るときに使う）
+     */
+    static QString toQString(std::string_view text)
+    {
+        return QString::fromUtf8(text.data(), static_cast<int>(text.size()));
+    }
+
+private:
+    alignas(std::max_align_t) std::byte m_buffer[INITIAL_BYTES];  ///< 最初に使うバッファ
+    std::pmr::monotonic_buffer_resource m_resource;                ///< 検出の終了時にまとめて破棄する
+};
+
+#endif // DETECTIONARENA_H
@@ -0,0 +1,193 @@
+/**
+ * @file dnsprefetch.cpp
+ * @brief DnsPrefetcherクラスの実装
+ */
+
+#include "dnsprefetch.h"
+
+#include <QByteArray>
+#include <QDebug>
+#include <QMetaObject>
+#include <QUrl>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <signal.h>
+
+namespace {
+
+/// getaddrinfo_a() に渡す1件分の要求（完了するまで glibc が参照する）
+struct Request {
+    gaicb control{};
+    addrinfo hints{};
+    QByteArray name;                                  ///< ar_name の実体（ACE形式）
+    QString host;                                     ///< 通知するホスト名
+    quint64 generation = 0;                           ///< 開始時の世代
+    std::shared_ptr<DnsPrefetcher::Shared> shared;    ///< 所有者の破棄後も状態を保つ
+};
+
+} // namespace
+
+struct DnsPrefetcher::Shared {
+    std::mutex mutex;
+    DnsPrefetcher* owner = nullptr;     ///< 通知先（破棄後は nullptr）
+    quint64 generation = 0;             ///< cancel() のたびに進め、それ以前の結果を捨てる
+    std::vector<Request*> pending;      ///< 完了していない要求
+    std::atomic<int> issued{0};
+    std::atomic<int> completed{0};
+    std::atomic<int> cancelled{0};
+};
+
+namespace {
+
+// glibc が作るスレッドで呼ばれる（GUIスレッドには QueuedConnection で戻す）
+void onLookupFinished(sigval value)
+{
+    auto* request = static_cast<Request*>(value.sival_ptr);
+    const bool resolved = gai_error(&request->control) == 0 && request->control.ar_result != nullptr;
+    if (request->control.ar_result) {
+        freeaddrinfo(request->control.ar_result);
+    }
+
+    const std::shared_ptr<DnsPrefetcher::Shared> shared = std::move(request->shared);
+    {
+        const std::lock_guard<std::mutex> lock(shared->mutex);
+        auto& pending = shared->pending;
+        pending.erase(std::remove(pending.begin(), pending.end(), request), pending.end());
+        shared->completed.fetch_add(1, std::memory_order_relaxed);
+
+        DnsPrefetcher* owner = shared->owner;
+        if (owner && request->generation == shared->generation) {
+            QMetaObject::invokeMethod(
+                owner, [owner, host = request->host, resolved]() { emit owner->finished(host, resolved); },
+                Qt::QueuedConnection);
+        }
+    }
+    delete request;
+}
+
+} // namespace
+
+DnsPrefetcher::DnsPrefetcher(QObject* parent)
+    : QObject(parent)
+    , m_shared(std::make_shared<Shared>())
+{
+    m_shared->owner = this;
+}
+
+DnsPrefetcher::~DnsPrefetcher()
+{
+    cancel();
+
+    // 実行中の要求は完了時に通知側で解放する
+    const std::lock_guard<std::mutex> lock(m_shared->mutex);
+    m_shared->owner = nullptr;
+}
+
+QString DnsPrefetcher::hostToResolve(const QString& url)
+{
+    const QUrl parsed(url);
+    const QString scheme = parsed.scheme();
+    if (scheme != QLatin1String("http") && scheme != QLatin1String("https")) {
+        return QString();
+    }
+
+    const QString host = parsed.host();
+    if (host.isEmpty()) {
+        return QString();
+    }
+
+    // IPアドレスはそのまま使われるので解決しない
+    const QByteArray latin1 = host.toLatin1();
+    unsigned char address[sizeof(in6_addr)];
+    if (inet_pton(AF_INET, latin1.constData(), address) == 1 || inet_pton(AF_INET6, latin1.constData(), address) == 1) {
+        return QString();
+    }
+
+    return host;
+}
+
+bool DnsPrefetcher::prefetch(const QString& url)
+{
+    const QString host = hostToResolve(url);
+    if (host.isEmpty() || host == m_host) {
+        return false;
+    }
+
+    const QByteArray name = QUrl::toAce(host);
+    if (name.isEmpty()) {
+        return false;
+    }
+
+    // 前のURLの解決はもう要らない
+    cancel();
+
+    auto* request = new Request;
+    request->name = name;
+    request->host = host;
+    request->shared = m_shared;
+    request->hints.ai_family = AF_UNSPEC;
+    request->hints.ai_socktype = SOCK_STREAM;
+    request->control.ar_name = request->name.constData();
+    request->control.ar_request = &request->hints;
+
+    sigevent notification{};
+    notification.sigev_notify = SIGEV_THREAD;
+    notification.sigev_notify_function = onLookupFinished;
+    notification.sigev_value.sival_ptr = request;
+
+    // 通知はロックを待つので、pending に入る前に解放されることはない
+    const std::lock_guard<std::mutex> lock(m_shared->mutex);
+    request->generation = m_shared->generation;
+    gaicb* list[] = {&request->control};
+    const int result = getaddrinfo_a(GAI_NOWAIT, list, 1, &notification);
+    if (result != 0) {
+        qDebug() << "DNS prefetch for" << host << "failed to start:" << gai_strerror(result);
+        delete request;
+        return false;
+    }
+
+    m_shared->pending.push_back(request);
+    m_shared->issued.fetch_add(1, std::memory_order_relaxed);
+    m_host = host;
+    return true;
+}
+
+void DnsPrefetcher::cancel()
+{
+    const std::lock_guard<std::mutex> lock(m_shared->mutex);
+    ++m_shared->generation;
+    m_host.clear();
+
+    auto& pending = m_shared->pending;
+    for (auto it = pending.begin(); it != pending.end();) {
+        // 開始前の要求は取り消され、通知は呼ばれない。実行中のものは完了を待たずに結果を捨てる
+        if (gai_cancel(&(*it)->control) == EAI_CANCELED) {
+            delete *it;
+            it = pending.erase(it);
+            m_shared->cancelled.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            ++it;
+        }
+    }
+}
+
+int DnsPrefetcher::issued() const
+{
+    return m_shared->issued.load(std::memory_order_relaxed);
+}
+
+int DnsPrefetcher::completed() const
+{
+    return m_shared->completed.load(std::memory_order_relaxed);
+}
+
+int DnsPrefetcher::cancelled() const
+{
+    return m_shared->cancelled.load(std::memory_order_relaxed);
+}
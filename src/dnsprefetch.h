@@ -0,0 +1,83 @@
+/**
+ * @file dnsprefetch.h
+ * @brief ピッカーの表示中に開くURLのホスト名を先に解決する
+ *
+ * どのプロファイルが選ばれても、ブラウザの最初のリクエストはホスト名の解決から始まります。
+ * ピッカーが開いた時点で getaddrinfo_a() による非同期の解決を始めておくと、
+ * systemd-resolved や nscd のキャッシュに結果が入り、その待ち時間がクリック後の経路から外れます。
+ *
+ * @note 結果はシステムのリゾルバのキャッシュを温めるだけで、このクラスは保持しません。
+ *       ブラウザが独自のリゾルバ（DNS over HTTPS など）を使う場合は効果がありません
+ */
+
+#ifndef DNSPREFETCH_H
+#define DNSPREFETCH_H
+
+#include <QObject>
+#include <QString>
+
+#include <memory>
+
+/**
+ * @class DnsPrefetcher
+ * @brief ホスト名の非同期の先行解決
+ *
+ * 解決は glibc のワーカースレッドで行われ、完了はGUIスレッドで finished() として通知されます。
+ * cancel() 以降に完了した解決は通知しません（開始前のものは取り消し、実行中のものは結果を捨てる）。
+ */
+class DnsPrefetcher : public QObject {
+    Q_OBJECT
+
+public:
+    explicit DnsPrefetcher(QObject* parent = nullptr);
+    ~DnsPrefetcher() override;
+
+    // コピーコンストラクタと代入演算子を削除
+    DnsPrefetcher(const DnsPrefetcher&) = delete;
+    DnsPrefetcher& operator=(const DnsPrefetcher&) = delete;
+
+    /**
+     * @brief 解決するホスト名を取得
+     * @param url 開くURL
+     * @return ホスト名（http/https 以外・IPアドレス・ホストなしの場合は空）
+     */
+    static QString hostToResolve(const QString& url);
+
+    /**
+     * @brief URLのホスト名の解決を開始
+     * @param url 開くURL
+     * @return true: 解決を開始した, false: 対象外、または同じホストを解決済み・解決中
+     * @note 別のホストの解決が残っている場合は先に cancel() します
+     */
+    bool prefetch(const QString& url);
+
+    /**
+     * @brief 残っている解決を取り消す（ピッカーを閉じたときに呼び出す）
+     */
+    void cancel();
+
+    /// 開始した解決の数
+    int issued() const;
+
+    /// 完了した解決の数（失敗・結果を捨てたものを含む）
+    int completed() const;
+
+    /// 開始前に取り消した解決の数
+    int cancelled() const;
+
+    struct Shared;
+
+signals:
+    /**
+     * @brief 解決が完了したときに発行されるシグナル
+     * @param host ホスト名
+     * @param resolved true: アドレスが得られた
+     */
+    void finished(const QString& host, bool resolved);
+
+private:
+    std::shared_ptr<Shared> m_shared;   ///< 通知スレッドと共有する状態
+    QString m_host;                     ///< 解決済み・解決中のホスト名
+};
+
+#endif // DNSPREFETCH_H
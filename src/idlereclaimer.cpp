@@ -0,0 +1,137 @@
+/**
+ * @file idlereclaimer.cpp
+ * @brief IdleReclaimerクラスの実装
+ */
+
+#include "idlereclaimer.h"
+
+#include <QFile>
+#include <QTimer>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace {
+
+/// "Key:   1234 kB" の行の値（KiB）
+qint64 fieldValue(const QByteArray& line)
+{
+    QByteArray value = line.mid(line.indexOf(':') + 1).trimmed();
+    if (value.endsWith(" kB")) {
+        value.chop(3);
+    }
+    bool ok = false;
+    const qint64 kib = value.trimmed().toLongLong(&ok);
+    return ok ? kib : -1;
+}
+
+QByteArray readProcFile(const char* path)
+{
+    // /proc のファイルはサイズが 0 と報告されるため、readAll() で最後まで読む
+    QFile file(QString::fromLatin1(path));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+} // namespace
+
+IdleReclaimer::IdleReclaimer(QObject* parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+    , m_delaySeconds(0)
+    , m_reclaimed(false)
+{
+    // 解放は数秒ずれても構わないため、最も粗いタイマーにして他の起床とまとめる
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::VeryCoarseTimer);
+    connect(m_timer, &QTimer::timeout, this, &IdleReclaimer::reclaimNow);
+}
+
+void IdleReclaimer::setDelay(int seconds)
+{
+    m_delaySeconds = qMax(seconds, 0);
+    if (m_timer->isActive()) {
+        m_timer->stop();
+        arm();
+    }
+}
+
+int IdleReclaimer::delay() const
+{
+    return m_delaySeconds;
+}
+
+void IdleReclaimer::arm()
+{
+    if (m_delaySeconds <= 0 || m_reclaimed) {
+        return;
+    }
+    m_timer->start(m_delaySeconds * 1000);
+}
+
+bool IdleReclaimer::disarm()
+{
+    m_timer->stop();
+    const bool reclaimed = m_reclaimed;
+    m_reclaimed = false;
+    return reclaimed;
+}
+
+bool IdleReclaimer::isArmed() const
+{
+    return m_timer->isActive();
+}
+
+bool IdleReclaimer::isReclaimed() const
+{
+    return m_reclaimed;
+}
+
+void IdleReclaimer::reclaimNow()
+{
+    m_timer->stop();
+    m_before = sample();
+
+    // 所有者が破棄してから、空いたヒープを返す
+    emit reclaimRequested();
+    trimHeap();
+
+    m_after = sample();
+    m_reclaimed = true;
+}
+
+bool IdleReclaimer::trimHeap()
+{
+#if defined(__GLIBC__)
+    return malloc_trim(0) != 0;
+#else
+    return false;
+#endif
+}
+
+IdleReclaimer::MemoryUsage IdleReclaimer::sample()
+{
+    const MemoryUsage usage = parse(readProcFile("/proc/self/smaps_rollup"));
+    if (usage.rss >= 0) {
+        return usage;
+    }
+
+    // smaps_rollup のないカーネル（4.14 より前）では RSS のみ
+    return parse(readProcFile("/proc/self/status"));
+}
+
+IdleReclaimer::MemoryUsage IdleReclaimer::parse(const QByteArray& data)
+{
+    MemoryUsage usage;
+    for (const QByteArray& line : data.split('\n')) {
+        if (line.startsWith("Rss:") || line.startsWith("VmRSS:")) {
+            usage.rss = fieldValue(line);
+        } else if (line.startsWith("Pss:")) {
+            usage.pss = fieldValue(line);
+        }
+    }
+    return usage;
+}
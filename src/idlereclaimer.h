@@ -0,0 +1,121 @@
+/**
+ * @file idlereclaimer.h
+ * @brief 非表示のまま常駐しているピッカーのメモリの解放
+ *
+ * トレイ常駐やピッカーの再利用では、デコード済みのアイコン・プロファイル項目のウィジェット・
+ * 読み込んだコンテナなどが、次に表示されるまで使われないまま残ります。
+ * 非表示になってから一定時間が経つと reclaimRequested() で所有者に破棄を求め、
+ * 続けて malloc_trim() で空いたヒープをカーネルに返します。
+ * 所有者はプロファイル一覧（検出結果のスナップショット）だけを残し、次の表示時に作り直します。
+ */
+
+#ifndef IDLERECLAIMER_H
+#define IDLERECLAIMER_H
+
+#include <QByteArray>
+#include <QObject>
+
+class QTimer;
+
+/**
+ * @class IdleReclaimer
+ * @brief 非表示の時間に応じたメモリ解放のポリシー
+ */
+class IdleReclaimer : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @struct MemoryUsage
+     * @brief プロセスのメモリ使用量（KiB、取得できない場合は -1）
+     */
+    struct MemoryUsage {
+        qint64 rss = -1;     ///< 常駐セットサイズ
+        qint64 pss = -1;     ///< 共有ページを按分したサイズ
+    };
+
+    explicit IdleReclaimer(QObject* parent = nullptr);
+    ~IdleReclaimer() override = default;
+
+    // コピーコンストラクタと代入演算子を削除
+    IdleReclaimer(const IdleReclaimer&) = delete;
+    IdleReclaimer& operator=(const IdleReclaimer&) = delete;
+
+    /**
+     * @brief 非表示になってから解放するまでの秒数を設定
+     * @param seconds 秒数（0以下の場合は解放しない）
+     * @note 待機中に変更した場合は、変更した時点から数え直します
+     */
+    void setDelay(int seconds);
+
+    /**
+     * @brief 非表示になってから解放するまでの秒数
+     */
+    int delay() const;
+
+    /**
+     * @brief 非表示になったときに呼び出す（解放までの待機を開始）
+     */
+    void arm();
+
+    /**
+     * @brief 表示されたときに呼び出す（待機を止め、解放済みの状態を戻す）
+     * @return true: 前回の表示以降に解放した（所有者は破棄したものを作り直す）
+     */
+    bool disarm();
+
+    /**
+     * @brief 解放までの待機中かどうか
+     */
+    bool isArmed() const;
+
+    /**
+     * @brief 前回の表示以降に解放したかどうか
+     */
+    bool isReclaimed() const;
+
+    /**
+     * @brief 直ちに解放する（reclaimRequested() の後に trimHeap()）
+     */
+    void reclaimNow();
+
+    /**
+     * @brief 直前の解放の前後のメモリ使用量
+     */
+    MemoryUsage usageBefore() const { return m_before; }
+    MemoryUsage usageAfter() const { return m_after; }
+
+    /**
+     * @brief 空いたヒープをカーネルに返す（glibc の malloc_trim）
+     * @return true: 返したページがある
+     */
+    static bool trimHeap();
+
+    /**
+     * @brief 自プロセスのメモリ使用量を取得
+     * @return /proc/self/smaps_rollup（なければ /proc/self/status の VmRSS）の値
+     */
+    static MemoryUsage sample();
+
+    /**
+     * @brief smaps_rollup / status 形式のテキストを解析
+     * @param data "Rss:", "Pss:" または "VmRSS:" の行を含むテキスト
+     * @return 解析結果（見つからない値は -1）
+     */
+    static MemoryUsage parse(const QByteArray& data);
+
+signals:
+    /**
+     * @brief 破棄を求めるシグナル（所有者は直接接続で破棄する）
+     */
+    void reclaimRequested();
+
+private:
+    QTimer* m_timer;            ///< 解放までの単発タイマー
+    int m_delaySeconds;         ///< 解放までの秒数
+    bool m_reclaimed;           ///< 前回の表示以降に解放したか
+    MemoryUsage m_before;       ///< 直前の解放前の使用量
+    MemoryUsage m_after;        ///< 直前の解放後の使用量
+};
+
+#endif // IDLERECLAIMER_H
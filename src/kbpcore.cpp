@@ -0,0 +1,256 @@
+/**
+ * @file kbpcore.cpp
+ * @brief コアライブラリのC APIの実装
+ *
+ * ConfigManager と ProfileManager を不透明なコンテキストに包み、
+ * 結果をUTF-8で呼び出し側のバッファに書き込みます。
+ */
+
+#include "kbp.h"
+#include "browserdetector.h"
+#include "configmanager.h"
+#include "profilemanager.h"
+
+
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+
+struct kbp_context {
+    kbp_allocator allocator;                          ///< このコンテキストを確保した関数
+    std::unique_ptr<ConfigManager> configManager;
+    std::unique_ptr<ProfileManager> profileManager;   ///< configManager より先に破棄する
+};
+
+namespace {
+
+void* defaultAllocate(size_t size, size_t /*alignment*/, void* /*userData*/)
+{
+    // malloc() は基本型のアラインメントを満たす（kbp_context はそれ以上を要求しない）
+    return std::malloc(size);
+}
+
+void defaultDeallocate(void* pointer, void* /*userData*/)
+{
+    std::free(pointer);
+}
+
+/**
+ * @brief UTF-8の文字列をバッファに書き込む
+ * @param text 書き込む文字列
+ * @param buffer 書き込み先
+ * @param size バッファのバイト数（終端のNULを含む）
+ * @param truncate true: 収まらない場合は文字の境界で切り詰める, false: 書き込まずに失敗する
+ * @return true: 書き込んだ
+ */
+bool copyString(const QString& text, char* buffer, size_t size, bool truncate)
+{
+    const QByteArray utf8 = text.toUtf8();
+    auto length = static_cast<size_t>(utf8.size());
+    if (length >= size) {
+        if (!truncate) {
+            return false;
+        }
+        // 継続バイトの途中で切らない
+        length = size - 1;
+        while (length > 0 && (static_cast<unsigned char>(utf8[static_cast<int>(length)]) & 0xC0) == 0x80) {
+            --length;
+        }
+    }
+    std::memcpy(buffer, utf8.constData(), length);
+    buffer[length] = '\0';
+    return true;
+}
+
+/**
+ * @brief 入力のURLを起動時と同じ規則で検証
+ * @return 正規化したURL（不正な場合は空）
+ * @note コマンドラインと同じくスキームを補ってから検証する。補う前に "-" で始まる入力は
+ *       ブラウザのスイッチとして argv に渡らないよう拒否する
+ */
+QString validatedUrl(const char* url)
+{
+    if (!url) {
+        return QString();
+    }
+    const QString sanitized = BrowserDetector::sanitizeUrl(QString::fromUtf8(url));
+    if (sanitized.startsWith(QLatin1Char('-'))) {
+        return QString();
+    }
+    const QString completed = BrowserDetector::completeUrlScheme(sanitized);
+    return BrowserDetector::isValidUrl(completed) ? completed : QString();
+}
+
+/**
+ * @brief URLを開くプロファイルを決定
+ * @note ピッカー・--explain と同じ ProfileManager::resolveTarget()
+ */
+bool resolveTarget(const kbp_context* context, const QString& url, ProfileManager::ProfileEntry* entry,
+                   kbp_reason* reason)
+{
+    bool fromHost = false;
+    *entry = context->profileManager->resolveTarget(url, &fromHost);
+    *reason = fromHost ? KBP_REASON_HOST : KBP_REASON_DEFAULT;
+    return !entry->browser.isEmpty();
+}
+
+} // namespace
+
+extern "C" {
+
+kbp_status kbp_open(int api_version, const kbp_allocator* allocator, kbp_context** out)
+{
+    if (!out) {
+        return KBP_ERROR_INVALID_ARGUMENT;
+    }
+    *out = nullptr;
+    if (api_version != KBP_API_VERSION) {
+        return KBP_ERROR_VERSION_MISMATCH;
+    }
+    if (allocator && (!allocator->allocate || !allocator->deallocate)) {
+        return KBP_ERROR_INVALID_ARGUMENT;
+    }
+
+    const kbp_allocator effective = allocator ? *allocator
+                                              : kbp_allocator{defaultAllocate, defaultDeallocate, nullptr};
+    void* memory = effective.allocate(sizeof(kbp_context), alignof(kbp_context), effective.user_data);
+    if (!memory) {
+        return KBP_ERROR_OUT_OF_MEMORY;
+    }
+
+    auto* context = new (memory) kbp_context{effective, std::make_unique<ConfigManager>(), nullptr};
+    context->profileManager = std::make_unique<ProfileManager>(context->configManager.get());
+
+    // イベントループがなくても完結するよう、バックグラウンドの検出ではなく同期的に検出する
+    context->profileManager->refreshProfiles();
+
+    *out = context;
+    return KBP_OK;
+}
+
+void kbp_close(kbp_context* context)
+{
+    if (!context) {
+        return;
+    }
+    const kbp_allocator allocator = context->allocator;
+    context->~kbp_context();
+    allocator.deallocate(context, allocator.user_data);
+}
+
+kbp_status kbp_refresh(kbp_context* context)
+{
+    if (!context) {
+        return KBP_ERROR_INVALID_ARGUMENT;
+    }
+    context->profileManager->refreshProfiles();
+    return KBP_OK;
+}
+
+kbp_status kbp_resolve(kbp_context* context, const char* url, kbp_target* target)
+{
+    if (!context || !target) {
+        return KBP_ERROR_INVALID_ARGUMENT;
+    }
+    const QString validated = validatedUrl(url);
+    if (validated.isEmpty()) {
+        return KBP_ERROR_INVALID_URL;
+    }
+
+    ProfileManager::ProfileEntry entry;
+    kbp_reason reason = KBP_REASON_DEFAULT;
+    if (!resolveTarget(context, validated, &entry, &reason)) {
+        return KBP_ERROR_NOT_FOUND;
+    }
+    if (!copyString(entry.browser, target->browser, sizeof(target->browser), false) ||
+        !copyString(entry.profileId, target->profile_id, sizeof(target->profile_id), false)) {
+        return KBP_ERROR_NOT_FOUND;
+    }
+    target->reason = reason;
+    return KBP_OK;
+}
+
+kbp_status kbp_list_profiles(kbp_context* context, kbp_profile* profiles, size_t capacity, size_t* count)
+{
+    if (!context || !count || (capacity > 0 && !profiles)) {
+        return KBP_ERROR_INVALID_ARGUMENT;
+    }
+
+    size_t total = 0;
+    for (const auto& entry : context->profileManager->getAllProfiles()) {
+        kbp_profile profile;
+        if (!copyString(entry.browser, profile.browser, sizeof(profile.browser), false) ||
+            !copyString(entry.profileId, profile.profile_id, sizeof(profile.profile_id), false)) {
+            continue;
+        }
+        copyString(entry.profileDisplayName, profile.display_name, sizeof(profile.display_name), true);
+        profile.is_enabled = entry.isEnabled ? 1 : 0;
+        profile.is_default = entry.isDefault ? 1 : 0;
+
+        if (total < capacity) {
+            profiles[total] = profile;
+        }
+        ++total;
+    }
+
+    *count = total;
+    return total > capacity ? KBP_ERROR_BUFFER_TOO_SMALL : KBP_OK;
+}
+
+kbp_status kbp_launch(kbp_context* context, const char* browser, const char* profile_id, const char* url)
+{
+    if (!context || (browser && !profile_id)) {
+        return KBP_ERROR_INVALID_ARGUMENT;
+    }
+    const QString validated = validatedUrl(url);
+    if (validated.isEmpty()) {
+        return KBP_ERROR_INVALID_URL;
+    }
+
+    QString browserId;
+    QString profileId;
+    if (browser) {
+        browserId = QString::fromUtf8(browser);
+        profileId = QString::fromUtf8(profile_id);
+        if (!context->profileManager->hasProfile(browserId, profileId)) {
+            return KBP_ERROR_NOT_FOUND;
+        }
+    } else {
+        ProfileManager::ProfileEntry entry;
+        kbp_reason reason = KBP_REASON_DEFAULT;
+        if (!resolveTarget(context, validated, &entry, &reason)) {
+            return KBP_ERROR_NOT_FOUND;
+        }
+        browserId = entry.browser;
+        profileId = entry.profileId;
+    }
+
+    return context->profileManager->launchProfile(browserId, profileId, validated) ? KBP_OK
+                                                                                   : KBP_ERROR_LAUNCH_FAILED;
+}
+
+const char* kbp_status_string(kbp_status status)
+{
+    switch (status) {
+    case KBP_OK:
+        return "success";
+    case KBP_ERROR_INVALID_ARGUMENT:
+        return "invalid argument";
+    case KBP_ERROR_VERSION_MISMATCH:
+        return "unsupported API version";
+    case KBP_ERROR_OUT_OF_MEMORY:
+        return "out of memory";
+    case KBP_ERROR_INVALID_URL:
+        return "invalid URL";
+    case KBP_ERROR_NOT_FOUND:
+        return "no matching profile";
+    case KBP_ERROR_BUFFER_TOO_SMALL:
+        return "buffer too small";
+    case KBP_ERROR_LAUNCH_FAILED:
+        return "failed to launch the browser";
+    }
+    return "unknown error";
+}
+
+} // extern "C"
@@ -8,18 +8,25 @@
  */
 
 #include "kdeintegration.h"
+#include "profilemanager.h"
+#include "browserdetector.h"
+#include "constants.h"
 
 #include <QSystemTrayIcon>
 #include <QMenu>
 #include <QAction>
 #include <QApplication>
+#include <QClipboard>
 #include <QIcon>
 #include <QDebug>
 #include <QProcess>
 #include <QStandardPaths>
 #include <QFile>
 #include <QTextStream>
+#include <QRegularExpression>
+#include <QUrl>
 
+#include <KGlobalAccel>
 #include <KNotification>
 #include <KLocalizedString>
 
@@ -27,6 +34,9 @@ KDEIntegration::KDEIntegration(QObject* parent)
     : QObject(parent)
     , m_trayIcon(nullptr)
     , m_trayMenu(nullptr)
+    , m_clipboardMenu(nullptr)
+    , m_profileManager(nullptr)
+    , m_globalShortcutAction(nullptr)
 {
     createTrayIcon();
 }
@@ -53,13 +63,88 @@ bool KDEIntegration::isTrayIconVisible() const
     return m_trayIcon && m_trayIcon->isVisible();
 }
 
+void KDEIntegration::setProfileManager(ProfileManager* profileManager)
+{
+    if (m_profileManager) {
+        disconnect(m_profileManager, nullptr, this, nullptr);
+    }
+    
+    m_profileManager = profileManager;
+    if (m_profileManager) {
+        // frecencyは起動のたびに変わるため、起動後にも作り直す
+        connect(m_profileManager, &ProfileManager::profilesRefreshed, this, &KDEIntegration::updateTrayMenu);
+        // メニューからの起動では選ばれたアクションの通知中なので、アクションを消す作り直しは後で行う
+        connect(m_profileManager, &ProfileManager::profileLaunched, this, &KDEIntegration::updateTrayMenu,
+                Qt::QueuedConnection);
+        connect(m_profileManager, &ProfileManager::profileSettingsChanged, this, &KDEIntegration::updateTrayMenu);
+        // 常駐しているので、起動のために中断した検出は起動後に続ける（完了でメニューも作り直す）
+        connect(m_profileManager, &ProfileManager::profileLaunched, this, [this]() {
+            m_profileManager->resumeInterruptedDetection();
+        });
+    }
+    
+    updateTrayMenu();
+}
+
 void KDEIntegration::updateTrayMenu()
 {
     if (!m_trayMenu) {
         createTrayMenu();
     }
     
-    // 必要に応じてメニュー項目を更新
+    QList<ProfileManager::ProfileEntry> recent;
+    if (m_profileManager) {
+        recent = m_profileManager->recentProfiles(Constants::TRAY_QUICK_LAUNCH_COUNT);
+    }
+    
+    // サブメニューのアクションはサブメニューが所有するため、clear() では削除されない
+    m_trayMenu->clear();
+    m_clipboardMenu->clear();
+    
+    for (const ProfileManager::ProfileEntry& entry : recent) {
+        const QIcon icon = entry.iconPath.isEmpty() ? QIcon::fromTheme("web-browser") : QIcon(entry.iconPath);
+        const QString label = tr("%1 (%2)").arg(entry.profileDisplayName, entry.browserDisplayName);
+        
+        QAction* launchAction = m_trayMenu->addAction(icon, label);
+        launchAction->setData(QStringList{"launch", entry.browser, entry.profileId});
+        
+        QAction* clipboardAction = m_clipboardMenu->addAction(icon, label);
+        clipboardAction->setData(QStringList{"clipboard", entry.browser, entry.profileId});
+    }
+    
+    if (!recent.isEmpty()) {
+        m_trayMenu->addSeparator();
+        m_trayMenu->addMenu(m_clipboardMenu);
+        m_clipboardMenu->setEnabled(!m_clipboardUrl.isEmpty());
+        m_trayMenu->addSeparator();
+    }
+    
+    QAction* settingsAction = m_trayMenu->addAction(QIcon::fromTheme("configure"), 
+                                                   tr("設定(&S)"));
+    settingsAction->setData("settings");
+    
+    m_trayMenu->addSeparator();
+    
+    QAction* quitAction = m_trayMenu->addAction(QIcon::fromTheme("application-exit"), 
+                                               tr("終了(&Q)"));
+    quitAction->setData("quit");
+}
+
+QString KDEIntegration::urlFromClipboardText(const QString& text)
+{
+    // 1行のURLのみを対象にする（文章の一部を誤って開かない）
+    static const QRegularExpression whitespace(R"(\s)");
+    const QString trimmed = text.trimmed();
+    if (trimmed.isEmpty() || trimmed.contains(whitespace)) {
+        return QString();
+    }
+    
+    const QUrl url(trimmed, QUrl::StrictMode);
+    const QString scheme = url.scheme().toLower();
+    if (!url.isValid() || url.host().isEmpty() || (scheme != "http" && scheme != "https")) {
+        return QString();
+    }
+    return trimmed;
 }
 
 void KDEIntegration::showNotification(const QString& title, 
@@ -91,6 +176,21 @@ void KDEIntegration::showNotification(const QString& title,
     notification->sendEvent();
 }
 
+QString KDEIntegration::launcherPath()
+{
+    // AppImage: マウント先のパスは起動ごとに変わるため、展開済みのコピーを起動する
+    // ランチャー（キャッシュモード）または AppImage 自体を登録する
+    const QString launcher = qEnvironmentVariable("KBP_APPIMAGE_LAUNCHER");
+    if (!launcher.isEmpty()) {
+        return launcher;
+    }
+    const QString appImage = qEnvironmentVariable("APPIMAGE");
+    if (!appImage.isEmpty()) {
+        return appImage;
+    }
+    return QCoreApplication::applicationFilePath();
+}
+
 bool KDEIntegration::registerAsDefaultBrowser()
 {
     // ユーザーのアプリケーションディレクトリにデスクトップファイルを作成
@@ -110,7 +210,7 @@ bool KDEIntegration::registerAsDefaultBrowser()
     stream << "Name=KDE Browser Picker\n";
     stream << "GenericName=Browser Profile Selector\n";
     stream << "Comment=Select browser and profile for opening links\n";
-    stream << "Exec=" << QCoreApplication::applicationFilePath() << " %u\n";
+    stream << "Exec=" << launcherPath() << " %u\n";
     stream << "Icon=web-browser\n";
     stream << "Terminal=false\n";
     stream << "Categories=Network;WebBrowser;\n";
@@ -138,13 +238,62 @@ bool KDEIntegration::isRegisteredAsDefaultBrowser()
 
 void KDEIntegration::registerGlobalShortcuts()
 {
-    // TODO: Implement KDE global shortcuts using KGlobalAccel
-    // This would allow users to trigger the browser picker with a global hotkey
+    if (m_globalShortcutAction) {
+        return;
+    }
+    
+    // kglobalaccel はコンポーネント名とアクションの objectName で識別する
+    m_globalShortcutAction = new QAction(tr("クリップボードのURLをピッカーで開く"), this);
+    m_globalShortcutAction->setObjectName(Constants::GLOBAL_SHORTCUT_ACTION);
+    m_globalShortcutAction->setProperty("componentName", Constants::GLOBAL_SHORTCUT_COMPONENT);
+    m_globalShortcutAction->setProperty("componentDisplayName", tr("KDE Browser Picker"));
+    connect(m_globalShortcutAction, &QAction::triggered, this, &KDEIntegration::routeClipboardUrl);
+    
+    KGlobalAccel::setGlobalShortcut(m_globalShortcutAction, QKeySequence(Constants::GLOBAL_SHORTCUT_DEFAULT));
 }
 
 void KDEIntegration::unregisterGlobalShortcuts()
 {
-    // TODO: Unregister global shortcuts
+    if (!m_globalShortcutAction) {
+        return;
+    }
+    
+    KGlobalAccel::self()->removeAllShortcuts(m_globalShortcutAction);
+    delete m_globalShortcutAction;
+    m_globalShortcutAction = nullptr;
+}
+
+QString KDEIntegration::clipboardOrSelectionUrl()
+{
+    const QClipboard* clipboard = QGuiApplication::clipboard();
+    if (!clipboard) {
+        return QString();
+    }
+    
+    QList<QClipboard::Mode> modes = {QClipboard::Clipboard};
+    if (clipboard->supportsSelection()) {
+        modes << QClipboard::Selection;
+    }
+    
+    // 起動時と同じ検証を通るものだけを返す
+    for (const QClipboard::Mode mode : modes) {
+        const QString url = urlFromClipboardText(clipboard->text(mode));
+        if (!url.isEmpty() && BrowserDetector::isValidUrl(BrowserDetector::sanitizeUrl(url))) {
+            return url;
+        }
+    }
+    return QString();
+}
+
+void KDEIntegration::routeClipboardUrl()
+{
+    const QString url = clipboardOrSelectionUrl();
+    if (url.isEmpty()) {
+        showNotification(tr("KDE Browser Picker"), tr("クリップボードと選択範囲にURLがありません。"));
+        return;
+    }
+    
+    emit urlRequested(url);
 }
 
 void KDEIntegration::onTrayActivated(QSystemTrayIcon::ActivationReason reason)
@@ -162,6 +311,41 @@ void KDEIntegration::onTrayMenuTriggered(QAction* action)
         emit openSettingsRequested();
     } else if (command == "quit") {
         emit quitRequested();
+    } else {
+        const QStringList target = action->data().toStringList();
+        if (target.size() == 3 && target[0] == "launch") {
+            quickLaunch(target[1], target[2], QString());
+        } else if (target.size() == 3 && target[0] == "clipboard" && !m_clipboardUrl.isEmpty()) {
+            quickLaunch(target[1], target[2], m_clipboardUrl);
+        }
+    }
+}
+
+void KDEIntegration::quickLaunch(const QString& browser, const QString& profileId, const QString& url)
+{
+    if (!m_profileManager) {
+        return;
+    }
+    
+    // ピッカーを作らずに起動する（URLがなければブラウザの新しいページを開く）
+    QString target = url;
+    if (target.isEmpty()) {
+        target = browser == "firefox" ? Constants::FIREFOX_NEW_WINDOW_URL : Constants::CHROME_NEW_WINDOW_URL;
+    }
+    
+    if (!m_profileManager->launchProfile(browser, profileId, target)) {
+        showNotification(tr("KDE Browser Picker"), tr("ブラウザの起動に失敗しました。"), "dialog-error");
+    }
+}
+
+void KDEIntegration::onClipboardChanged()
+{
+    const QClipboard* clipboard = QGuiApplication::clipboard();
+    m_clipboardUrl = clipboard ? urlFromClipboardText(clipboard->text()) : QString();
+    
+    if (m_clipboardMenu) {
+        m_clipboardMenu->setEnabled(!m_clipboardUrl.isEmpty());
+        m_clipboardMenu->setToolTip(m_clipboardUrl);
     }
 }
 
@@ -185,22 +369,23 @@ void KDEIntegration::createTrayIcon()
             
     createTrayMenu();
     m_trayIcon->setContextMenu(m_trayMenu);
+    
+    // クリップボードは変更時にのみ確認し、メニューを開く時点では読み込まない
+    if (QClipboard* clipboard = QGuiApplication::clipboard()) {
+        connect(clipboard, &QClipboard::dataChanged, this, &KDEIntegration::onClipboardChanged);
+        onClipboardChanged();
+    }
 }
 
 void KDEIntegration::createTrayMenu()
 {
     m_trayMenu = new QMenu();
+    m_clipboardMenu = new QMenu(tr("クリップボードのURLを開く(&O)"), m_trayMenu);
+    m_clipboardMenu->setIcon(QIcon::fromTheme("edit-paste"));
     
-    QAction* settingsAction = m_trayMenu->addAction(QIcon::fromTheme("configure"), 
-                                                   tr("設定(&S)"));
-    settingsAction->setData("settings");
-    
-    m_trayMenu->addSeparator();
-    
-    QAction* quitAction = m_trayMenu->addAction(QIcon::fromTheme("application-exit"), 
-                                               tr("終了(&Q)"));
-    quitAction->setData("quit");
-    
+    // サブメニューの項目もこのシグナルで通知される
     connect(m_trayMenu, &QMenu::triggered,
             this, &KDEIntegration::onTrayMenuTriggered);
+    
+    updateTrayMenu();
 }
\ No newline at end of file
@@ -18,6 +18,7 @@
 class QMenu;
 class QAction;
 class KNotification;
+class ProfileManager;
 
 /**
  * @class KDEIntegration
@@ -49,10 +50,25 @@ public:
      */
     bool isTrayIconVisible() const;
     
+    /**
+     * @brief トレイのクイック起動に使用するプロファイル管理を設定
+     * @param profileManager プロファイル管理（非所有、nullptrで解除）
+     * @note プロファイルの更新・起動のたびにメニューを作り直すため、メニューを開く時点では計算しません
+     */
+    void setProfileManager(ProfileManager* profileManager);
+
     /**
      * @brief トレイメニューを更新
+     * @note よく使うプロファイルと「クリップボードのURLを開く」の項目を作り直します
      */
     void updateTrayMenu();
+
+    /**
+     * @brief クリップボードのテキストから開くURLを取り出す
+     * @param text クリップボードのテキスト
+     * @return http/https のURL（URLでない場合は空）
+     */
+    static QString urlFromClipboardText(const QString& text);
     
     // 通知
     /**
@@ -77,17 +93,39 @@ public:
      * @return true: 登録済み, false: 未登録
      */
     static bool isRegisteredAsDefaultBrowser();
+
+    /**
+     * @brief デスクトップファイルの Exec に使用する実行パス
+     * @return AppImageのランチャー、AppImage自体、または実行ファイルのパス
+     */
+    static QString launcherPath();
     
     // KDEグローバルショートカット
     /**
      * @brief グローバルショートカットを登録
+     * @note KGlobalAccel に「クリップボードのURLを開く」を登録します（既定は Meta+Alt+B）。
+     *       ユーザーがシステム設定で変更したキーは kglobalaccel 側の値が優先されます
      */
     void registerGlobalShortcuts();
     
     /**
      * @brief グローバルショートカットを解除
+     * @note kglobalaccel に保存されたキーの割り当ても削除します
      */
     void unregisterGlobalShortcuts();
+
+    /**
+     * @brief クリップボード、次いで選択範囲（プライマリセレクション）から開くURLを取り出す
+     * @return ピッカーで開けるURL（どちらにもない場合は空）
+     */
+    static QString clipboardOrSelectionUrl();
+
+public slots:
+    /**
+     * @brief クリップボードまたは選択範囲のURLを urlRequested() で通知
+     * @note URLがない場合は通知を表示します。グローバルショートカットから呼び出されます
+     */
+    void routeClipboardUrl();
     
 signals:
     /**
@@ -105,6 +143,12 @@ signals:
      */
     void quitRequested();
 
+    /**
+     * @brief URLをピッカーで開く要求時に発行されるシグナル
+     * @param url 検証済みのURL
+     */
+    void urlRequested(const QString& url);
+
 private slots:
     /**
      * @brief トレイアイコンがアクティベートされたときの処理
@@ -123,6 +167,11 @@ private slots:
      */
     void onNotificationActivated();
 
+    /**
+     * @brief クリップボードが変更されたときの処理
+     */
+    void onClipboardChanged();
+
 private:
     /**
      * @brief トレイアイコンを作成
@@ -133,9 +182,21 @@ private:
      * @brief トレイメニューを作成
      */
     void createTrayMenu();
+
+    /**
+     * @brief クイック起動の項目を選択されたプロファイルで起動
+     * @param browser ブラウザID
+     * @param profileId プロファイルID
+     * @param url 開くURL（空の場合はブラウザの新しいページ）
+     */
+    void quickLaunch(const QString& browser, const QString& profileId, const QString& url);
     
     QSystemTrayIcon* m_trayIcon;                       ///< システムトレイアイコン
     QMenu* m_trayMenu;                                 ///< トレイメニュー
+    QMenu* m_clipboardMenu;                            ///< 「クリップボードのURLを開く」サブメニュー
+    ProfileManager* m_profileManager;                  ///< クイック起動のプロファイル管理（非所有）
+    QString m_clipboardUrl;                            ///< クリップボードのURL（変更時に更新）
+    QAction* m_globalShortcutAction;                   ///< グローバルショートカットのアクション
     
     // アクティブな通知の追跡
     QList<KNotification*> m_activeNotifications;       ///< 現在表示中の通知リスト
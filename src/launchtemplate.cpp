@@ -0,0 +1,157 @@
+/**
+ * @file launchtemplate.cpp
+ * @brief LaunchTemplateクラスの実装
+ */
+
+#include "launchtemplate.h"
+
+#include <QRegularExpression>
+
+namespace {
+
+constexpr auto PLACEHOLDER_URL = "{url}";
+constexpr auto PLACEHOLDER_PROFILE = "{profile}";
+constexpr auto PLACEHOLDER_DIR = "{dir}";
+
+/**
+ * @brief 起動先のプロファイルを変更するオプションかどうか
+ */
+bool isProfileSelectingOption(const QString& arg)
+{
+    static const QStringList options = {
+        "-P", "-p", "-profile", "--profile", "-ProfileManager", "--ProfileManager",
+        "--profile-directory", "--user-data-dir",
+    };
+    const QString name = arg.section('=', 0, 0);
+    return options.contains(name);
+}
+
+/**
+ * @brief 未知のプレースホルダーが含まれていないか確認
+ * @param text 対象の文字列
+ * @param allowed 使用可能なプレースホルダー
+ */
+bool hasOnlyKnownPlaceholders(const QString& text, const QStringList& allowed, QString* unknown)
+{
+    static const QRegularExpression placeholder(R"(\{[^{}]*\})");
+    auto it = placeholder.globalMatch(text);
+    while (it.hasNext()) {
+        const QString found = it.next().captured(0);
+        if (!allowed.contains(found)) {
+            if (unknown) *unknown = found;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+QStringList LaunchTemplate::Compiled::argumentsFor(const QString& url) const
+{
+    QStringList result = args;
+    if (urlIndex >= 0 && urlIndex <= result.size()) {
+        result.insert(urlIndex, url);
+    } else {
+        result.append(url);
+    }
+    return result;
+}
+
+void LaunchTemplate::append(const LaunchTemplate& other)
+{
+    args += other.args;
+    for (auto it = other.env.begin(); it != other.env.end(); ++it) {
+        env.insert(it.key(), it.value());
+    }
+}
+
+bool LaunchTemplate::validateArgument(const QString& arg, QString* error)
+{
+    auto fail = [error](const QString& message) {
+        if (error) *error = message;
+        return false;
+    };
+
+    if (arg == PLACEHOLDER_URL) {
+        return true;
+    }
+    if (arg.contains(QChar('\0')) || arg.contains('\n')) {
+        return fail("control characters are not allowed");
+    }
+    if (!arg.startsWith('-') || arg == "-" || arg == "--") {
+        // 位置引数（追加のURLやファイル）は許可しない
+        return fail("only options starting with '-' are allowed");
+    }
+    if (arg.contains(PLACEHOLDER_URL)) {
+        return fail("{url} must be a whole argument");
+    }
+    if (isProfileSelectingOption(arg)) {
+        return fail("options that select the profile are set by the picker");
+    }
+
+    QString unknown;
+    if (!hasOnlyKnownPlaceholders(arg, {PLACEHOLDER_PROFILE, PLACEHOLDER_DIR}, &unknown)) {
+        return fail("unknown placeholder " + unknown);
+    }
+    return true;
+}
+
+bool LaunchTemplate::validateEnvironment(const QString& name, const QString& value, QString* error)
+{
+    auto fail = [error](const QString& message) {
+        if (error) *error = message;
+        return false;
+    };
+
+    static const QRegularExpression validName(R"(^[A-Za-z_][A-Za-z0-9_]*$)");
+    if (!validName.match(name).hasMatch()) {
+        return fail("invalid variable name");
+    }
+    // 動的リンカへの注入は許可しない
+    if (name.startsWith("LD_")) {
+        return fail("LD_* variables are not allowed");
+    }
+    if (value.contains(QChar('\0')) || value.contains('\n')) {
+        return fail("control characters are not allowed");
+    }
+
+    QString unknown;
+    if (!hasOnlyKnownPlaceholders(value, {PLACEHOLDER_PROFILE, PLACEHOLDER_DIR}, &unknown)) {
+        return fail("unknown placeholder " + unknown);
+    }
+    return true;
+}
+
+LaunchTemplate::Compiled LaunchTemplate::compile(const QStringList& baseArgs, const QString& profile,
+                                                 const QString& dir) const
+{
+    auto expand = [&](QString text) {
+        text.replace(PLACEHOLDER_PROFILE, profile);
+        text.replace(PLACEHOLDER_DIR, dir);
+        return text;
+    };
+
+    Compiled compiled;
+    compiled.args = baseArgs;
+    for (const QString& arg : args) {
+        if (arg == PLACEHOLDER_URL) {
+            if (compiled.urlIndex < 0) {
+                compiled.urlIndex = compiled.args.size();
+            }
+            continue;
+        }
+        compiled.args.append(expand(arg));
+    }
+
+    for (auto it = env.begin(); it != env.end(); ++it) {
+        compiled.env.insert(it.key(), expand(it.value()));
+    }
+
+    return compiled;
+}
+
+QString LaunchTemplate::key(const QString& browser, const QString& profile)
+{
+    return profile.isEmpty() ? browser : browser + "/" + profile;
+}
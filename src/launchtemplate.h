@@ -0,0 +1,97 @@
+/**
+ * @file launchtemplate.h
+ * @brief プロファイルごとの起動引数・環境変数テンプレート
+ *
+ * YAMLの launch セクションで定義された引数と環境変数を検証し、
+ * プロファイルの検出時に起動用の引数プレフィックスへ展開します。
+ * 起動時にはURLを追加するだけで済むため、起動パスでの文字列処理は発生しません。
+ */
+
+#ifndef LAUNCHTEMPLATE_H
+#define LAUNCHTEMPLATE_H
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @class LaunchTemplate
+ * @brief 起動テンプレート（プレースホルダー付きの引数と環境変数）
+ *
+ * 使用できるプレースホルダー:
+ * - {url}: 開くURL（引数全体としてのみ、1回まで。省略時は末尾に追加）
+ * - {profile}: プロファイルID
+ * - {dir}: プロファイルディレクトリの絶対パス
+ *
+ * @note 既存のインジェクション対策を保つため、引数はオプション（"-" で始まる）に
+ *       限定し、起動先のプロファイルを変更するオプションや LD_* などの
+ *       環境変数は拒否します
+ */
+class LaunchTemplate {
+public:
+    /**
+     * @struct Compiled
+     * @brief プロファイルに展開済みの起動設定
+     */
+    struct Compiled {
+        QStringList args;               ///< 引数プレフィックス（URLを除く）
+        int urlIndex;                   ///< URLを挿入する位置（-1: 末尾に追加）
+        QMap<QString, QString> env;     ///< 追加する環境変数
+
+        Compiled() : urlIndex(-1) {}
+
+        /**
+         * @brief URLを挿入した最終的な引数を作成
+         * @param url 検証済みのURL
+         */
+        QStringList argumentsFor(const QString& url) const;
+    };
+
+    QStringList args;                   ///< 引数（プレースホルダーを含む）
+    QMap<QString, QString> env;         ///< 環境変数（プレースホルダーを含む）
+
+    bool isEmpty() const { return args.isEmpty() && env.isEmpty(); }
+
+    /**
+     * @brief 別のテンプレートを後ろに結合（ブラウザ全体 → プロファイル固有の順）
+     * @param other 結合するテンプレート（環境変数は上書き）
+     */
+    void append(const LaunchTemplate& other);
+
+    /**
+     * @brief 引数1つを検証
+     * @param arg 引数
+     * @param error エラー内容の格納先（nullptr可）
+     * @return true: 使用可能
+     */
+    static bool validateArgument(const QString& arg, QString* error = nullptr);
+
+    /**
+     * @brief 環境変数1つを検証
+     * @param name 変数名
+     * @param value 値
+     * @param error エラー内容の格納先（nullptr可）
+     * @return true: 使用可能
+     */
+    static bool validateEnvironment(const QString& name, const QString& value, QString* error = nullptr);
+
+    /**
+     * @brief プロファイルに展開
+     * @param baseArgs ブラウザがプロファイルを選択するための引数（"-P name" など）
+     * @param profile プロファイルID
+     * @param dir プロファイルディレクトリの絶対パス
+     * @return 展開済みの起動設定
+     * @note 検証済みのテンプレートに対してのみ呼び出すこと
+     */
+    Compiled compile(const QStringList& baseArgs, const QString& profile, const QString& dir) const;
+
+    /**
+     * @brief テンプレートのキーを作成
+     * @param browser ブラウザID
+     * @param profile プロファイルID（空の場合はブラウザ全体）
+     * @return "browser" または "browser/profile"
+     */
+    static QString key(const QString& browser, const QString& profile = QString());
+};
+
+#endif // LAUNCHTEMPLATE_H
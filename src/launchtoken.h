@@ -0,0 +1,53 @@
+/**
+ * @file launchtoken.h
+ * @brief 起動するブラウザに渡すアクティベーショントークン
+ *
+ * トークンの取得（ActivationToken）はアプリケーション側で行い、
+ * コアライブラリの BrowserDetector は受け取ったトークンを起動時に渡すだけです。
+ *
+ * - Wayland: xdg-activation-v1 のトークン（XDG_ACTIVATION_TOKEN）
+ * - X11: 起動通知ID（DESKTOP_STARTUP_ID）
+ */
+
+#ifndef LAUNCHTOKEN_H
+#define LAUNCHTOKEN_H
+
+#include <QProcessEnvironment>
+#include <QString>
+
+/**
+ * @struct LaunchToken
+ * @brief ブラウザに渡すトークン
+ */
+struct LaunchToken {
+    QString xdgActivationToken;   ///< Wayland用（XDG_ACTIVATION_TOKEN）
+    QString startupId;            ///< X11用（DESKTOP_STARTUP_ID）
+
+    bool isEmpty() const { return xdgActivationToken.isEmpty() && startupId.isEmpty(); }
+
+    /**
+     * @brief リモートプロトコルで渡すトークン（Wayland優先）
+     */
+    QString remoteToken() const { return xdgActivationToken.isEmpty() ? startupId : xdgActivationToken; }
+
+    /**
+     * @brief 起動するプロセスの環境変数に設定
+     * @param env 設定先の環境
+     * @note 該当するトークンがない変数は削除し、ピッカーが受け取った古い値を引き継がない
+     */
+    void applyTo(QProcessEnvironment& env) const
+    {
+        if (xdgActivationToken.isEmpty()) {
+            env.remove("XDG_ACTIVATION_TOKEN");
+        } else {
+            env.insert("XDG_ACTIVATION_TOKEN", xdgActivationToken);
+        }
+        if (startupId.isEmpty()) {
+            env.remove("DESKTOP_STARTUP_ID");
+        } else {
+            env.insert("DESKTOP_STARTUP_ID", startupId);
+        }
+    }
+};
+
+#endif // LAUNCHTOKEN_H
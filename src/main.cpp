@@ -9,18 +9,101 @@
 
 #include <QApplication>
 #include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QIcon>
 #include <QDebug>
+#include <QJsonDocument>
+#include <QSystemTrayIcon>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QWidget>
 #include <KLocalizedString>
 #include <KAboutData>
 
+#include <memory>
+
 #include "mainwindow.h"
 #include "kdeintegration.h"
 #include "configmanager.h"
+#include "yamlconfig.h"
+#include "profilemanager.h"
+#include "browserdetector.h"
+#include "activationtoken.h"
+#include "perfbundle.h"
+#include "pickerqueue.h"
+#include "routeexplain.h"
+#include "remoteclient.h"
+#include "remotelistener.h"
+#include "ui/settingsdialog.h"
 #include "version.h"
 
+/**
+ * @brief ピッカーの作成からプロファイル一覧の表示までを計測（--replay-perf-bundle 用）
+ * @param url 表示するURL
+ * @return 作成・表示・一覧の表示完了までの時間とプロファイル数
+ */
+static QJsonObject measurePicker(const QString& url)
+{
+    QElapsedTimer timer;
+    timer.start();
+    auto window = std::make_unique<MainWindow>(url);
+    const qint64 constructed = timer.nsecsElapsed();
+    window->show();
+    QCoreApplication::processEvents();
+    const qint64 shown = timer.nsecsElapsed();
+
+    // 一覧は非同期に追加されるため、項目数が300ms変わらなくなった時点を完了とする
+    auto countItems = [&window]() {
+        int count = 0;
+        for (const QWidget* widget : window->findChildren<QWidget*>()) {
+            if (widget->inherits("ProfileItem") && widget->isVisible()) {
+                ++count;
+            }
+        }
+        return count;
+    };
+    int count = countItems();
+    qint64 listed = timer.nsecsElapsed();
+    QElapsedTimer stable;
+    stable.start();
+    while (stable.elapsed() < 300 && timer.elapsed() < 10000) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+        const int current = countItems();
+        if (current != count) {
+            count = current;
+            listed = timer.nsecsElapsed();
+            stable.restart();
+        }
+    }
+
+    QJsonObject result;
+    result["construct_us"] = constructed / 1000;
+    result["shown_us"] = shown / 1000;
+    result["listed_us"] = listed / 1000;
+    result["profiles"] = count;
+    return result;
+}
+
 int main(int argc, char *argv[])
 {
+    // QtはXDG_ACTIVATION_TOKEN を自身のウィンドウに使用して削除するため、先に保存する
+    ActivationToken::captureInherited();
+
+    // リモートホストのクライアントはQtを初期化せずに送信して終了する（起動時間を往復時間より短く保つ）
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--remote-client") == 0) {
+            return RemoteClient::main(argc, argv);
+        }
+    }
+
+    // バンドルの再現はディスプレイのない環境でも計測できるようにする
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--replay-perf-bundle") == 0 && !qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+    }
+    
     QApplication app(argc, argv);
     
     // KDEローカライゼーションの設定
@@ -72,6 +155,44 @@ int main(int argc, char *argv[])
     QCommandLineOption forceOption("force",
                                    i18n("Force overwrite when used with --init-defaults"));
     parser.addOption(forceOption);
+    QCommandLineOption checkConfigOption("check-config",
+                                         i18n("Validate the layered YAML configuration and report errors"));
+    parser.addOption(checkConfigOption);
+    QCommandLineOption explainOption("explain",
+                                     i18n("Show how the URL would be routed, stage by stage with timings, without launching"),
+                                     "url");
+    parser.addOption(explainOption);
+    QCommandLineOption jsonOption("json",
+                                  i18n("Print the --explain output as JSON"));
+    parser.addOption(jsonOption);
+    QCommandLineOption exportBundleOption("export-perf-bundle",
+                                          i18n("Write an anonymized performance bundle (profile layout, config, timings) to this directory"),
+                                          "dir");
+    parser.addOption(exportBundleOption);
+    QCommandLineOption replayBundleOption("replay-perf-bundle",
+                                          i18n("Recreate a performance bundle in a temporary home and compare the timings"),
+                                          "dir");
+    parser.addOption(replayBundleOption);
+
+    QCommandLineOption trayOption("tray",
+                                  i18n("Stay in the system tray with quick-launch entries for the most used profiles"));
+    parser.addOption(trayOption);
+
+    QCommandLineOption remoteListenOption("remote-listen",
+                                          i18n("Stay resident and open URLs sent from remote hosts with --remote-client over a socket forwarded with ssh -R"));
+    parser.addOption(remoteListenOption);
+    QCommandLineOption remoteClientOption("remote-client",
+                                          i18n("Send the URLs to the picker on the local desktop through the forwarded socket (run on the remote host)"));
+    parser.addOption(remoteClientOption);
+
+    QCommandLineOption browserOption("browser",
+                                     i18n("Open the URL in this browser without showing the picker (firefox, chrome, chromium)"),
+                                     "browser");
+    parser.addOption(browserOption);
+    QCommandLineOption profileOption("profile",
+                                     i18n("Profile ID to use with --browser"),
+                                     "profile");
+    parser.addOption(profileOption);
     
     // コマンドラインを処理
     parser.process(app);
@@ -97,21 +218,137 @@ int main(int argc, char *argv[])
         }
         return 0;
     }
+
+    if (parser.isSet(checkConfigOption)) {
+        // キャッシュを使わずに全ての層を読み直す（エラーは読み込み時に出力される）
+        const YamlConfig yaml = YamlConfig::load(QString());
+        for (const QString& layer : yaml.layers) {
+            qInfo().noquote() << "Loaded" << layer;
+        }
+        if (!yaml.diagnostics.isEmpty()) {
+            qCritical() << yaml.diagnostics.size() << "error(s) in the YAML configuration";
+            return 1;
+        }
+        qInfo() << "YAML configuration is valid";
+        return 0;
+    }
+
+    if (parser.isSet(explainOption)) {
+        const RouteExplain::Report report = RouteExplain::explain(parser.value(explainOption));
+        QTextStream out(stdout);
+        if (parser.isSet(jsonOption)) {
+            out << QJsonDocument(RouteExplain::toJson(report)).toJson();
+        } else {
+            out << RouteExplain::toText(report);
+        }
+        return report.browser.isEmpty() ? 1 : 0;
+    }
+
+    if (parser.isSet(exportBundleOption)) {
+        QString error;
+        if (!PerfBundle::exportTo(parser.value(exportBundleOption), &error)) {
+            qCritical().noquote() << error;
+            return 1;
+        }
+        qInfo().noquote() << "Performance bundle written to" << parser.value(exportBundleOption);
+        return 0;
+    }
+
+    if (parser.isSet(replayBundleOption)) {
+        const QString bundleDir = parser.value(replayBundleOption);
+        QTemporaryDir root;
+        QString error;
+        if (!root.isValid() || !PerfBundle::materialize(bundleDir, root.path(), &error)) {
+            qCritical().noquote() << (error.isEmpty() ? QString("cannot create a temporary directory") : error);
+            return 1;
+        }
+
+        // 1回目はスナップショットのないコールド起動、2回目は保存されたスナップショットを使う
+        QJsonObject replayed = PerfBundle::measureStartup();
+        replayed["picker_cold"] = measurePicker("https://example.com/");
+        replayed["picker_warm"] = measurePicker("https://example.com/");
+
+        QFile trace(bundleDir + "/trace.json");
+        const QJsonObject recorded = trace.open(QIODevice::ReadOnly)
+            ? QJsonDocument::fromJson(trace.readAll()).object() : QJsonObject();
+        QTextStream(stdout) << PerfBundle::report(recorded, replayed);
+
+        QFile out(bundleDir + "/replay.json");
+        if (out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            out.write(QJsonDocument(replayed).toJson());
+        }
+        return 0;
+    }
+    
+    if (parser.isSet(trayOption) || parser.isSet(remoteListenOption)) {
+        const bool tray = parser.isSet(trayOption);
+        if (tray && !QSystemTrayIcon::isSystemTrayAvailable()) {
+            qCritical() << "No system tray available";
+            return 1;
+        }
+        app.setQuitOnLastWindowClosed(false);
+
+        // メニューの項目はプロファイルの更新時に作り、選択時はピッカーを作らずに起動する
+        ConfigManager config;
+        ProfileManager profiles(&config);
+        KDEIntegration integration;
+        integration.setProfileManager(&profiles);
+
+        QObject::connect(&integration, &KDEIntegration::quitRequested, &app, &QCoreApplication::quit);
+        QObject::connect(&integration, &KDEIntegration::openSettingsRequested, &app, [&config]() {
+            SettingsDialog dialog(&config);
+            dialog.exec();
+        });
+        // ピッカーは先に作っておき、アイコンのクリックとグローバルショートカットでは
+        // URLを差し替えて表示するだけにする（一覧の作成と検出は済んでいる）。
+        // メニューと同じ設定とプロファイル一覧を使い、検出を開始する
+        MainWindow picker(&config, &profiles);
+        // 表示中に届いたURLは上書きせず、ピッカーが閉じられてから順に表示する
+        PickerQueue queue;
+        QObject::connect(&queue, &PickerQueue::showRequested, &app, [&picker](const QString& url) {
+            picker.setUrl(url);
+            picker.show();
+            picker.raise();
+            picker.activateWindow();
+        });
+        QObject::connect(&picker, &QDialog::finished, &queue, &PickerQueue::pickerClosed);
+        QObject::connect(&integration, &KDEIntegration::urlRequested, &queue, &PickerQueue::enqueue);
+        QObject::connect(&integration, &KDEIntegration::trayActivated,
+                         &integration, &KDEIntegration::routeClipboardUrl);
+
+        // ssh -R で転送されたソケットから届いたURLも同じピッカーで開く
+        std::unique_ptr<RemoteListener> remoteListener;
+        if (parser.isSet(remoteListenOption)) {
+            QString error;
+            const QString socketPath = QString::fromStdString(RemoteClient::defaultSocketPath());
+            const QByteArray token =
+                RemoteListener::loadOrCreateToken(QString::fromStdString(RemoteClient::defaultTokenPath()), &error);
+            if (token.isEmpty()) {
+                qCritical().noquote() << error;
+                return 1;
+            }
+            remoteListener = std::make_unique<RemoteListener>(token);
+            if (!remoteListener->listen(socketPath, &error)) {
+                qCritical().noquote() << error;
+                return 1;
+            }
+            QObject::connect(remoteListener.get(), &RemoteListener::urlReceived, &queue, &PickerQueue::enqueue);
+            qInfo().noquote() << "Listening for remote links on" << socketPath;
+        }
+
+        if (tray) {
+            integration.registerGlobalShortcuts();
+            integration.setTrayIconVisible(true);
+        }
+        return app.exec();
+    }
     
     // コマンドラインからURLを取得
     QString url;
     QStringList args = parser.positionalArguments();
     if (!args.isEmpty()) {
-        url = args.first();
-        
         // URLにスキームがあることを確認
-        if (!url.contains("://")) {
-            if (url.startsWith("www.")) {
-                url = "https://" + url;
-            } else {
-                url = "https://www." + url;
-            }
-        }
+        url = BrowserDetector::completeUrlScheme(args.first());
     }
     
     // 設定ダイアログが要求された場合の処理
@@ -125,6 +362,23 @@ int main(int argc, char *argv[])
     if (url.isEmpty()) {
         parser.showHelp(1);
     }
+
+    // ブラウザとプロファイルが指定された場合は、一覧を作らずにそのプロファイルだけを確認して起動
+    if (parser.isSet(browserOption) || parser.isSet(profileOption)) {
+        if (!parser.isSet(browserOption) || !parser.isSet(profileOption)) {
+            qCritical() << "--browser and --profile must be used together";
+            return 1;
+        }
+
+        ConfigManager config;
+        ProfileManager profiles(&config);
+        profiles.browserDetector()->setActivationToken(ActivationToken::inherited());
+        if (!profiles.launchProfile(parser.value(browserOption), parser.value(profileOption), url)) {
+            qCritical() << "Failed to launch" << parser.value(browserOption) << parser.value(profileOption);
+            return 1;
+        }
+        return 0;
+    }
     
     // メインウィンドウの作成と表示
     MainWindow window(url);
@@ -10,27 +10,56 @@
 #include "ui_mainwindow.h"
 #include "profilemanager.h"
 #include "configmanager.h"
+#include "speculativelauncher.h"
+#include "activationtoken.h"
+#include "avatarloader.h"
+#include "countdown.h"
+#include "dnsprefetch.h"
+#include "idlereclaimer.h"
 #include "ui/profileitem.h"
 #include "constants.h"
+#include "tracepoints.h"
 
+#include <QElapsedTimer>
 #include <QKeyEvent>
 #include <QShortcut>
 #include <QDebug>
 #include <QUrl>
 #include <QMessageBox>
+#include <QPixmapCache>
 
 MainWindow::MainWindow(const QString& url, QWidget* parent)
+    : MainWindow(nullptr, nullptr, url, parent)
+{
+}
+
+MainWindow::MainWindow(ConfigManager* configManager, ProfileManager* profileManager, const QString& url,
+                       QWidget* parent)
     : QDialog(parent)
     , m_ui(std::make_unique<Ui::MainWindow>())
-    , m_profileManager(nullptr)
-    , m_configManager(std::make_unique<ConfigManager>(this))
+    , m_configManager(configManager)
+    , m_profileManager(profileManager)
+    , m_processScanner(new ProcessScanner(this))
+    , m_avatarLoader(new AvatarLoader(QString(), this))
+    , m_speculativeLauncher(nullptr)
+    , m_activationToken(new ActivationToken(this))
+    , m_dnsPrefetcher(new DnsPrefetcher(this))
+    , m_idleReclaimer(new IdleReclaimer(this))
     , m_url(url)
     , m_selectedItem(nullptr)
 {
     m_ui->setupUi(this);
     
-    // ConfigManagerの後にProfileManagerを初期化
-    m_profileManager = std::make_unique<ProfileManager>(m_configManager.get(), this);
+    // 共有されない場合は自分で作成（ConfigManagerの後にProfileManagerを初期化）
+    if (!m_configManager) {
+        m_ownedConfigManager = std::make_unique<ConfigManager>(this);
+        m_configManager = m_ownedConfigManager.get();
+    }
+    if (!m_profileManager) {
+        m_ownedProfileManager = std::make_unique<ProfileManager>(m_configManager, this);
+        m_profileManager = m_ownedProfileManager.get();
+    }
+    m_speculativeLauncher = new SpeculativeLauncher(m_profileManager, m_configManager, this);
     
     setupUI();
     setupShortcuts();
@@ -40,34 +69,67 @@ MainWindow::MainWindow(const QString& url, QWidget* parent)
     connect(m_ui->cancelButton, &QPushButton::clicked, this, &MainWindow::onCancelClicked);
     connect(m_ui->settingsButton, &QPushButton::clicked, this, &MainWindow::onSettingsClicked);
     
-    connect(m_profileManager.get(), &ProfileManager::profilesRefreshed,
+    connect(m_profileManager, &ProfileManager::profilesRefreshed,
             this, &MainWindow::onProfilesRefreshed);
-    connect(m_configManager.get(), &ConfigManager::configChanged,
+    connect(m_configManager, &ConfigManager::configChanged,
             this, &MainWindow::onConfigChanged);
+    connect(m_processScanner, &ProcessScanner::usageUpdated,
+            this, &MainWindow::onResourceUsageUpdated);
+    connect(m_avatarLoader, &AvatarLoader::avatarLoaded,
+            this, &MainWindow::onAvatarLoaded);
             
-    // タイマーの設定
-    m_timeoutTimer = new QTimer(this);
-    m_timeoutTimer->setSingleShot(true);
-    connect(m_timeoutTimer, &QTimer::timeout, this, &MainWindow::onTimeout);
+    // カウントダウンの設定（表示が変わる秒の境界でのみ起床する）
+    m_countdown = new Countdown(this);
+    connect(m_countdown, &Countdown::tick, this, &MainWindow::updateTimeoutLabel);
+    connect(m_countdown, &Countdown::expired, this, &MainWindow::onTimeout);
     
-    m_tickTimer = new QTimer(this);
-    m_tickTimer->setInterval(1000); // 1秒ごとに更新
-    connect(m_tickTimer, &QTimer::timeout, this, &MainWindow::onTimeoutTick);
+    // A resident picker drops its rows and caches after staying hidden for a while
+    m_idleReclaimer->setDelay(m_configManager->idleReclaimSeconds());
+    connect(m_idleReclaimer, &IdleReclaimer::reclaimRequested, this, &MainWindow::releaseIdleMemory);
+    m_idleReclaimer->arm();
     
     // プロファイルの読み込み
     loadProfiles();
     
-    // 設定されていればタイムアウトを開始
-    m_remainingSeconds = m_configManager->defaultTimeout();
-    if (m_remainingSeconds > 0) {
-        m_timeoutTimer->start(m_remainingSeconds * 1000);
-        m_tickTimer->start();
-        updateTimeoutLabel();
+    // 設定されていればタイムアウトを開始（URLなしで先に作る場合は setUrl() で開始）
+    m_timeoutSeconds = m_configManager->defaultTimeout();
+    if (!m_url.isEmpty()) {
+        m_countdown->start(m_timeoutSeconds);
+        if (m_configManager->dnsPrefetch()) {
+            m_dnsPrefetcher->prefetch(m_url);
+        }
     }
 }
 
 MainWindow::~MainWindow() = default;
 
+void MainWindow::setUrl(const QString& url)
+{
+    m_url = url;
+    m_ui->urlDisplayLabel->setText(truncateUrl(m_url));
+    m_ui->urlDisplayLabel->setToolTip(m_url);
+    m_ui->searchLineEdit->clear();
+    
+    // A reused picker predicts and counts down again for the new URL
+    m_speculativeLauncher->reset();
+    m_countdown->start(m_timeoutSeconds);
+    if (!isVisible()) {
+        m_countdown->pause();
+    }
+
+    // Resolve the host while the user is still choosing (cancels the previous URL's lookup)
+    if (m_configManager->dnsPrefetch()) {
+        m_dnsPrefetcher->prefetch(m_url);
+    }
+}
+
+void MainWindow::reject()
+{
+    m_speculativeLauncher->cancel();
+    m_dnsPrefetcher->cancel();
+    QDialog::reject();
+}
+
 void MainWindow::keyPressEvent(QKeyEvent* event)
 {
     // 検索フィールドにフォーカスがあり、空でない場合は数字キー処理をスキップ
@@ -121,6 +183,13 @@ void MainWindow::keyPressEvent(QKeyEvent* event)
         return;
     }
     
+    // Right/Left to expand/collapse the selected profile's containers
+    if ((event->key() == Qt::Key_Right || event->key() == Qt::Key_Left) && !searchHasFocus &&
+        m_selectedItem && m_selectedItem->isExpandable()) {
+        m_selectedItem->setExpanded(event->key() == Qt::Key_Right);
+        return;
+    }
+    
     // Handle Enter key
     if (event->key() == Qt::Key_Return || event->key() == Qt::Key_Enter) {
         if (m_selectedItem && m_ui->openButton->isEnabled()) {
@@ -150,17 +219,48 @@ void MainWindow::showEvent(QShowEvent* event)
     QDialog::showEvent(event);
     restoreWindowGeometry();
     
+    // Rows dropped while hidden are rebuilt from the profile list before the first paint
+    if (m_idleReclaimer->disarm()) {
+        QElapsedTimer rebuild;
+        rebuild.start();
+        onProfilesRefreshed();
+        if (rebuild.elapsed() > Constants::FIRST_PAINT_BUDGET_MS) {
+            qWarning() << "Rebuilding the profile rows took" << rebuild.elapsed() << "ms";
+        }
+    }
+    
+    // A pick made during the last detection cut it short; finish it for this showing
+    m_profileManager->resumeInterruptedDetection();
+    
     // Focus on first profile if available
     if (!m_profileItems.isEmpty()) {
         selectProfile(m_profileItems.first());
     }
     
+    // Refresh resource usage of running instances off the GUI thread
+    m_processScanner->requestScan();
+    
+    // Pre-launch the predicted profile's browser (opt-in, once per picker)
+    m_speculativeLauncher->start(m_url);
+    
     // Raise and activate the window
     raise();
     activateWindow();
     
     // Set focus to search line edit
     m_ui->searchLineEdit->setFocus();
+    
+    // Continue the countdown paused while the window was hidden
+    m_countdown->resume();
+}
+
+void MainWindow::hideEvent(QHideEvent* event)
+{
+    QDialog::hideEvent(event);
+    
+    // No timer is kept while hidden, so the picker stays idle
+    m_countdown->pause();
+    m_idleReclaimer->arm();
 }
 
 void MainWindow::onProfileClicked()
@@ -189,6 +289,59 @@ void MainWindow::onProfileSettingsClicked()
     }
 }
 
+void MainWindow::onProfileExpandToggled(bool expanded)
+{
+    ProfileItem* item = qobject_cast<ProfileItem*>(sender());
+    if (!item) {
+        return;
+    }
+    
+    if (!expanded) {
+        const auto children = m_containerItems.take(item);
+        for (ProfileItem* child : children) {
+            if (m_selectedItem == child) {
+                selectProfile(item);
+            }
+            m_profileItems.removeOne(child);
+            m_ui->profilesLayout->removeWidget(child);
+            child->deleteLater();
+        }
+        return;
+    }
+    
+    // containers.json is only read when the profile is expanded
+    const auto containers = m_profileManager->containersForProfile(item->browser(), item->profileId());
+    if (containers.isEmpty()) {
+        item->setExpandable(false);
+        item->setExpanded(false);
+        return;
+    }
+    
+    const auto profile = m_profileManager->getProfile(item->browser(), item->profileId());
+    int layoutIndex = m_ui->profilesLayout->indexOf(item) + 1;
+    int listIndex = m_profileItems.indexOf(item) + 1;
+    
+    QList<ProfileItem*> children;
+    for (const auto& container : containers) {
+        ProfileItem* child = new ProfileItem(this);
+        child->setProfileData(profile.browser,
+                              profile.profileId,
+                              profile.profileDisplayName,
+                              profile.iconPath,
+                              profile.lastUsed,
+                              false);
+        child->setContainer(container.name, container.color);
+        
+        connect(child, &ProfileItem::clicked, this, &MainWindow::onProfileClicked);
+        connect(child, &ProfileItem::doubleClicked, this, &MainWindow::onProfileDoubleClicked);
+        
+        m_ui->profilesLayout->insertWidget(layoutIndex++, child);
+        m_profileItems.insert(listIndex++, child);
+        children.append(child);
+    }
+    m_containerItems.insert(item, children);
+}
+
 void MainWindow::onSettingsClicked()
 {
     // TODO: Show main settings dialog
@@ -207,35 +360,42 @@ void MainWindow::onCancelClicked()
 
 void MainWindow::onTimeout()
 {
-    // Auto-select default profile
-    auto defaultProfile = m_profileManager->getDefaultProfile();
+    // Auto-select the profile that last opened this host, otherwise the default profile
+    auto defaultProfile = m_profileManager->resolveTarget(m_url);
     if (!defaultProfile.browser.isEmpty()) {
-        m_profileManager->launchProfile(defaultProfile, m_url);
-        accept();
+        launchWithActivation(defaultProfile.browser, defaultProfile.profileId, QString(), false);
+    } else if (m_profileManager->isRefreshing()) {
+        // First start without a snapshot: decide once detection has finished
+        auto connection = std::make_shared<QMetaObject::Connection>();
+        *connection = connect(m_profileManager, &ProfileManager::profilesRefreshed, this,
+                              [this, connection]() {
+            disconnect(*connection);
+            onTimeout();
+        });
     } else {
         // No default profile, just close
         reject();
     }
 }
 
-void MainWindow::onTimeoutTick()
-{
-    m_remainingSeconds--;
-    updateTimeoutLabel();
-    
-    if (m_remainingSeconds <= 0) {
-        m_tickTimer->stop();
-    }
-}
-
 void MainWindow::onProfilesRefreshed()
 {
+    // Detection finishing while the rows are released rebuilds them on the next show instead
+    if (m_idleReclaimer->isReclaimed() && !isVisible()) {
+        return;
+    }
+    
+    // Background detection refreshes the rows again; keep what the user had selected
+    const QString selectedBrowser = m_selectedItem ? m_selectedItem->browser() : QString();
+    const QString selectedProfileId = m_selectedItem ? m_selectedItem->profileId() : QString();
+    
     // Clear existing items
     for (ProfileItem* item : m_profileItems) {
         m_ui->profilesLayout->removeWidget(item);
         item->deleteLater();
     }
     m_profileItems.clear();
+    m_containerItems.clear();
     m_selectedItem = nullptr;
     
     // Get enabled profiles
@@ -252,6 +412,16 @@ void MainWindow::onProfilesRefreshed()
                            profile.lastUsed,
                            profile.isDefault);
                            
+        item->setColdStartWarning(profile.coldStartWarning);
+        item->setExpandable(profile.supportsContainers);
+        
+        // Avatars are decoded off the GUI thread; the browser icon shows until then
+        if (!profile.avatarPath.isEmpty()) {
+            item->setAvatarPath(profile.avatarPath);
+            item->setAvatar(m_avatarLoader->cached(profile.avatarPath));
+            m_avatarLoader->request(profile.avatarPath);
+        }
+                           
         if (shortcutNumber <= 9) {
             item->setShortcutNumber(shortcutNumber++);
         }
@@ -259,48 +429,126 @@ void MainWindow::onProfilesRefreshed()
         connect(item, &ProfileItem::clicked, this, &MainWindow::onProfileClicked);
         connect(item, &ProfileItem::doubleClicked, this, &MainWindow::onProfileDoubleClicked);
         connect(item, &ProfileItem::settingsClicked, this, &MainWindow::onProfileSettingsClicked);
+        connect(item, &ProfileItem::expandToggled, this, &MainWindow::onProfileExpandToggled);
         
         m_ui->profilesLayout->addWidget(item);
         m_profileItems.append(item);
     }
     
-    // Add stretch at the end
+    // Add stretch at the end (replacing the one from the previous refresh)
+    for (int i = m_ui->profilesLayout->count() - 1; i >= 0; --i) {
+        if (m_ui->profilesLayout->itemAt(i)->spacerItem()) {
+            delete m_ui->profilesLayout->takeAt(i);
+        }
+    }
     m_ui->profilesLayout->addStretch();
     
-    // Select default profile
-    auto defaultProfile = m_profileManager->getDefaultProfile();
+    // Resource usage is filled in once the background scan completes
+    m_processScanner->setTargets(m_profileManager->processScanTargets());
+    if (isVisible()) {
+        m_processScanner->requestScan();
+    }
+    
+    // Re-apply the search filter to the new rows
+    if (!m_ui->searchLineEdit->text().isEmpty()) {
+        onSearchTextChanged(m_ui->searchLineEdit->text());
+    }
+    
+    // Restore the selection, otherwise select the profile the timeout would open
+    if (!selectedBrowser.isEmpty()) {
+        for (ProfileItem* item : m_profileItems) {
+            if (item->browser() == selectedBrowser && item->profileId() == selectedProfileId &&
+                item->container().isEmpty() && !item->isHidden()) {
+                selectProfile(item, false);
+                return;
+            }
+        }
+    }
+    
+    auto defaultProfile = m_profileManager->resolveTarget(m_url);
     if (!defaultProfile.browser.isEmpty()) {
         for (ProfileItem* item : m_profileItems) {
             if (item->browser() == defaultProfile.browser && 
                 item->profileId() == defaultProfile.profileId) {
-                selectProfile(item);
+                selectProfile(item, false);
                 break;
             }
         }
     } else if (!m_profileItems.isEmpty()) {
-        selectProfile(m_profileItems.first());
+        selectProfile(m_profileItems.first(), false);
+    }
+}
+
+void MainWindow::onAvatarLoaded(const QString& path, const QImage& image)
+{
+    for (ProfileItem* item : m_profileItems) {
+        if (item->container().isEmpty() && item->avatarPath() == path) {
+            item->setAvatar(image);
+        }
+    }
+}
+
+void MainWindow::onResourceUsageUpdated(const ProcessScanner::UsageMap& usage)
+{
+    for (ProfileItem* item : m_profileItems) {
+        if (!item->container().isEmpty()) {
+            // Containers share the process tree of their profile
+            continue;
+        }
+        
+        const QString profileKey = ProcessScanner::usageKey(item->browser(), item->profileId());
+        const QString instanceKey = ProcessScanner::usageKey(item->browser(), QString());
+        
+        if (usage.contains(profileKey)) {
+            const auto& u = usage[profileKey];
+            item->setResourceUsage(ProcessScanner::formatUsage(u),
+                                   tr("%n process(es) running with this profile", "", u.processCount));
+        } else if (usage.contains(instanceKey)) {
+            // Chrome/Chromium instance shared by all of its profiles
+            const auto& u = usage[instanceKey];
+            item->setResourceUsage(ProcessScanner::formatUsage(u),
+                                   tr("Shared by all profiles of the running instance (%n process(es))", "",
+                                      u.processCount));
+        } else {
+            item->setResourceUsage(QString());
+        }
     }
 }
 
 void MainWindow::onConfigChanged()
 {
+    m_idleReclaimer->setDelay(m_configManager->idleReclaimSeconds());
+    
     // Update timeout
     int newTimeout = m_configManager->defaultTimeout();
-    if (newTimeout != m_remainingSeconds) {
-        m_remainingSeconds = newTimeout;
+    if (newTimeout != m_timeoutSeconds) {
+        m_timeoutSeconds = newTimeout;
+        m_countdown->start(m_timeoutSeconds);
         
-        if (m_remainingSeconds > 0) {
-            m_timeoutTimer->start(m_remainingSeconds * 1000);
-            m_tickTimer->start();
-        } else {
-            m_timeoutTimer->stop();
-            m_tickTimer->stop();
+        if (m_timeoutSeconds <= 0) {
+            updateTimeoutLabel(0);
+        } else if (!isVisible()) {
+            m_countdown->pause();
         }
-        
-        updateTimeoutLabel();
     }
 }
 
+void MainWindow::releaseIdleMemory()
+{
+    // Only the profile list (and the detector's snapshot) is kept; everything else is rebuilt lazily
+    for (ProfileItem* item : m_profileItems) {
+        m_ui->profilesLayout->removeWidget(item);
+        delete item;
+    }
+    QList<ProfileItem*>().swap(m_profileItems);
+    m_containerItems = QHash<ProfileItem*, QList<ProfileItem*>>();
+    m_selectedItem = nullptr;
+    
+    m_avatarLoader->clearCache();
+    m_profileManager->releaseCaches();
+    QPixmapCache::clear();
+}
+
 void MainWindow::setupUI()
 {
     // Set window properties
@@ -335,19 +583,24 @@ void MainWindow::setupShortcuts()
 
 void MainWindow::loadProfiles()
 {
-    m_profileManager->refreshProfiles();
+    // Rows come from the last snapshot right away; detection replaces them when it finishes
+    m_profileManager->startRefresh();
 }
 
 void MainWindow::selectProfileByNumber(int number)
 {
-    if (number > 0 && number <= m_profileItems.size()) {
-        selectProfile(m_profileItems[number - 1]);
-        // Also open it immediately
-        openSelectedProfile();
+    // Container rows have no number, so look the item up instead of indexing
+    for (ProfileItem* item : m_profileItems) {
+        if (item->shortcutNumber() == number) {
+            selectProfile(item);
+            // Also open it immediately
+            openSelectedProfile();
+            return;
+        }
     }
 }
 
-void MainWindow::selectProfile(ProfileItem* item)
+void MainWindow::selectProfile(ProfileItem* item, bool userInitiated)
 {
     if (m_selectedItem == item) {
         return;
@@ -361,14 +614,18 @@ void MainWindow::selectProfile(ProfileItem* item)
     // Select new
     m_selectedItem = item;
     if (m_selectedItem) {
+        KBP_TRACE(profile_selected, qUtf8Printable(item->browser()), qUtf8Printable(item->profileId()),
+                  userInitiated ? 1 : 0);
         m_selectedItem->setSelected(true);
-        m_selectedItem->setFocus();
         m_ui->openButton->setEnabled(true);
         
-        // Stop timeout when user selects a profile
-        m_timeoutTimer->stop();
-        m_tickTimer->stop();
-        m_ui->timeoutLabel->hide();
+        if (userInitiated) {
+            m_selectedItem->setFocus();
+            
+            // Stop timeout when user selects a profile
+            m_countdown->stop();
+            m_ui->timeoutLabel->hide();
+        }
     } else {
         m_ui->openButton->setEnabled(false);
     }
@@ -380,24 +637,41 @@ void MainWindow::openSelectedProfile()
         return;
     }
     
-    bool success = m_profileManager->launchProfile(
-        m_selectedItem->browser(),
-        m_selectedItem->profileId(),
-        m_url
-    );
-    
-    if (success) {
-        accept();
-    } else {
-        QMessageBox::critical(this, tr("エラー"), 
-                            tr("ブラウザの起動に失敗しました。"));
+    launchWithActivation(m_selectedItem->browser(),
+                         m_selectedItem->profileId(),
+                         m_selectedItem->container(),
+                         true);
+}
+
+void MainWindow::launchWithActivation(const QString& browser, const QString& profileId,
+                                      const QString& container, bool reportErrors)
+{
+    if (m_activationToken->isPending()) {
+        return;
     }
+    
+    // The token must come from this window's activation context, right after the user input
+    m_activationToken->request(windowHandle(), BrowserDetector::desktopFileId(browser),
+                               [this, browser, profileId, container, reportErrors](const ActivationToken::Token& token) {
+        m_profileManager->browserDetector()->setActivationToken(token);
+        // The warmed-up process may be the one receiving this URL, so decide its fate before launching
+        m_speculativeLauncher->confirm(browser, profileId);
+        const bool success = m_profileManager->launchProfile(browser, profileId, m_url, container);
+        m_speculativeLauncher->launchFinished(success);
+        
+        if (success || !reportErrors) {
+            accept();
+        } else {
+            QMessageBox::critical(this, tr("エラー"), 
+                                tr("ブラウザの起動に失敗しました。"));
+        }
+    });
 }
 
-void MainWindow::updateTimeoutLabel()
+void MainWindow::updateTimeoutLabel(int remainingSeconds)
 {
-    if (m_remainingSeconds > 0) {
-        m_ui->timeoutLabel->setText(tr("自動選択: %1秒").arg(m_remainingSeconds));
+    if (remainingSeconds > 0) {
+        m_ui->timeoutLabel->setText(tr("自動選択: %1秒").arg(remainingSeconds));
         m_ui->timeoutLabel->show();
     } else {
         m_ui->timeoutLabel->hide();
@@ -438,15 +712,24 @@ QString MainWindow::truncateUrl(const QString& url) const
 
 void MainWindow::onSearchTextChanged(const QString& text)
 {
+    QElapsedTimer traceTimer;
+    if (KBP_TRACE_ENABLED(search_filter)) {
+        traceTimer.start();
+    }
+
     const QString searchText = text.trimmed().toLower();
     
     // Filter profile items based on search text
+    int visibleCount = 0;
     for (ProfileItem* item : m_profileItems) {
         bool visible = searchText.isEmpty() || 
                       item->browser().toLower().contains(searchText) ||
-                      item->profileName().toLower().contains(searchText);
+                      item->profileName().toLower().contains(searchText) ||
+                      item->container().toLower().contains(searchText);
         item->setVisible(visible);
+        visibleCount += visible ? 1 : 0;
     }
+    KBP_TRACE(search_filter, qUtf8Printable(searchText), visibleCount, traceTimer.nsecsElapsed() / 1000);
     
     // If current selection is hidden, select the first visible item
     if (m_selectedItem && !m_selectedItem->isVisible()) {
@@ -11,9 +11,12 @@
 #define MAINWINDOW_H
 
 #include <QDialog>
-#include <QTimer>
+#include <QHash>
+#include <QImage>
 #include <memory>
 
+#include "processscanner.h"
+
 // Forward declarations
 namespace Ui {
     class MainWindow;
@@ -21,6 +24,12 @@ namespace Ui {
 class ProfileManager;
 class ConfigManager;
 class ProfileItem;
+class SpeculativeLauncher;
+class ActivationToken;
+class AvatarLoader;
+class Countdown;
+class DnsPrefetcher;
+class IdleReclaimer;
 
 /**
  * @class MainWindow
@@ -41,12 +50,38 @@ class MainWindow : public QDialog {
 
 public:
     explicit MainWindow(const QString& url = "", QWidget* parent = nullptr);
+
+    /**
+     * @brief 常駐プロセスの設定とプロファイル一覧を共有するピッカーを作成
+     * @param configManager 共有する設定（ピッカーより長く存在すること）
+     * @param profileManager configManager を使う共有のプロファイル管理（ピッカーより長く存在すること）
+     * @param url 開くURL
+     * @param parent 親ウィジェット
+     * @note トレイのメニューと同じ検出結果・起動履歴を使い、検出も1回で済みます
+     */
+    MainWindow(ConfigManager* configManager, ProfileManager* profileManager, const QString& url = "",
+               QWidget* parent = nullptr);
     ~MainWindow() override;
 
     // コピーコンストラクタと代入演算子を削除
     MainWindow(const MainWindow&) = delete;
     MainWindow& operator=(const MainWindow&) = delete;
 
+    /**
+     * @brief 開くURLを変更（作成済みのピッカーの再利用）
+     * @param url 開くURL
+     * @note 検索をクリアし、カウントダウンと先行起動の予測をやり直します。
+     *       非表示の間はカウントダウンを一時停止したままにします
+     */
+    void setUrl(const QString& url);
+
+public slots:
+    /**
+     * @brief ダイアログのキャンセル
+     * @note 先行起動したブラウザをポリシーに従って処理してから閉じる
+     */
+    void reject() override;
+
 protected:
     /**
      * @brief キープレスイベントの処理
@@ -65,9 +100,16 @@ protected:
     /**
      * @brief ウィンドウ表示イベントの処理
      * @param event 表示イベント
-     * @note タイムアウトタイマーの開始
+     * @note 一時停止していたカウントダウンを再開し、非表示の間に破棄した一覧を作り直す
      */
     void showEvent(QShowEvent* event) override;
+    
+    /**
+     * @brief ウィンドウ非表示イベントの処理
+     * @param event 非表示イベント
+     * @note 非表示の間はカウントダウンを一時停止（タイマーを持たない）し、メモリ解放までの待機を開始
+     */
+    void hideEvent(QHideEvent* event) override;
 
 private slots:
     /**
@@ -86,6 +128,13 @@ private slots:
      */
     void onProfileSettingsClicked();
     
+    /**
+     * @brief プロファイルのコンテナ一覧が展開・折りたたまれたときの処理
+     * @param expanded true: 展開
+     * @note 展開時に初めて containers.json を読み込みます
+     */
+    void onProfileExpandToggled(bool expanded);
+    
     /**
      * @brief 設定ボタンがクリックされたときの処理
      */
@@ -107,11 +156,6 @@ private slots:
      */
     void onTimeout();
     
-    /**
-     * @brief タイムアウトカウントダウンの更新処理
-     */
-    void onTimeoutTick();
-    
     /**
      * @brief プロファイル一覧が更新されたときの処理
      */
@@ -127,6 +171,26 @@ private slots:
      * @param text 検索テキスト
      */
     void onSearchTextChanged(const QString& text);
+    
+    /**
+     * @brief 起動中インスタンスのリソース使用量が更新されたときの処理
+     * @param usage プロファイルごとの集計結果
+     */
+    void onResourceUsageUpdated(const ProcessScanner::UsageMap& usage);
+    
+    /**
+     * @brief プロファイルのアバター画像が読み込まれたときの処理
+     * @param path 画像ファイルのパス
+     * @param image 縮小済みの画像
+     */
+    void onAvatarLoaded(const QString& path, const QImage& image);
+    
+    /**
+     * @brief 非表示のまま一定時間が経ったときの処理
+     * @note 項目のウィジェット・アバター画像・コンテナ・アイコンのキャッシュを破棄し、
+     *       プロファイル一覧だけを残します（次の表示時に作り直す）
+     */
+    void releaseIdleMemory();
 
 private:
     /**
@@ -153,18 +217,30 @@ private:
     /**
      * @brief プロファイルアイテムの選択
      * @param item 選択するプロファイルアイテム
+     * @param userInitiated true: ユーザー操作による選択（フォーカスを移し、タイムアウトを停止）
      */
-    void selectProfile(ProfileItem* item);
+    void selectProfile(ProfileItem* item, bool userInitiated = true);
     
     /**
      * @brief 選択されたプロファイルでブラウザを起動
      */
     void openSelectedProfile();
     
+    /**
+     * @brief アクティベーショントークンを取得してからブラウザを起動
+     * @param browser ブラウザID
+     * @param profileId プロファイルID
+     * @param container Firefoxのコンテナ名（空の場合はコンテナを使用しない）
+     * @param reportErrors true: 起動失敗時にダイアログを表示して閉じない
+     */
+    void launchWithActivation(const QString& browser, const QString& profileId,
+                              const QString& container, bool reportErrors);
+    
     /**
      * @brief タイムアウトラベルの更新
+     * @param remainingSeconds 残り秒数（0以下の場合は非表示）
      */
-    void updateTimeoutLabel();
+    void updateTimeoutLabel(int remainingSeconds);
     
     /**
      * @brief ウィンドウの位置とサイズを保存
@@ -184,16 +260,24 @@ private:
     QString truncateUrl(const QString& url) const;
     
     std::unique_ptr<Ui::MainWindow> m_ui;                ///< UIフォーム
-    std::unique_ptr<ProfileManager> m_profileManager;    ///< プロファイル管理オブジェクト
-    std::unique_ptr<ConfigManager> m_configManager;      ///< 設定管理オブジェクト
+    std::unique_ptr<ConfigManager> m_ownedConfigManager;   ///< 共有しない場合に作成した設定管理オブジェクト
+    std::unique_ptr<ProfileManager> m_ownedProfileManager; ///< 共有しない場合に作成したプロファイル管理オブジェクト
+    ConfigManager* m_configManager;                      ///< 設定管理オブジェクト
+    ProfileManager* m_profileManager;                    ///< プロファイル管理オブジェクト
+    ProcessScanner* m_processScanner;                    ///< リソース使用量スキャナ
+    AvatarLoader* m_avatarLoader;                        ///< アバター画像の非同期読み込み
+    SpeculativeLauncher* m_speculativeLauncher;          ///< 予測プロファイルの先行起動
+    ActivationToken* m_activationToken;                  ///< 起動するブラウザへのトークンの取得
+    DnsPrefetcher* m_dnsPrefetcher;                      ///< URLのホスト名の先行解決
+    IdleReclaimer* m_idleReclaimer;                      ///< 非表示のまま常駐しているときのメモリ解放
     
     QString m_url;                                       ///< 開くURL
-    QTimer* m_timeoutTimer;                              ///< タイムアウトタイマー
-    QTimer* m_tickTimer;                                 ///< カウントダウン更新タイマー
-    int m_remainingSeconds;                              ///< 残り秒数
+    Countdown* m_countdown;                              ///< 自動選択までのカウントダウン
+    int m_timeoutSeconds;                                ///< 設定されたタイムアウト秒数
     
     QList<ProfileItem*> m_profileItems;                  ///< プロファイルアイテムのリスト
     ProfileItem* m_selectedItem;                         ///< 現在選択されているアイテム
+    QHash<ProfileItem*, QList<ProfileItem*>> m_containerItems; ///< 展開中のプロファイルとそのコンテナ項目
 };
 
 #endif // MAINWINDOW_H
\ No newline at end of file
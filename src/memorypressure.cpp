@@ -0,0 +1,149 @@
+/**
+ * @file memorypressure.cpp
+ * @brief MemoryPressureクラスの実装
+ *
+ * /proc/pressure/memory の "some"/"full" 行を解析し、
+ * 設定されたしきい値と比較します。
+ */
+
+#include "memorypressure.h"
+#include "constants.h"
+
+#include <QFile>
+#include <QList>
+
+MemoryPressure::Policy::Policy()
+    : enabled(true)
+    , threshold(Constants::DEFAULT_MEMORY_PRESSURE_THRESHOLD)
+    , metric(Metric::Some)
+    , window(Window::Avg10)
+{
+}
+
+MemoryPressure::Sample::Sample()
+    : valid(false)
+    , some{0.0, 0.0, 0.0}
+    , full{0.0, 0.0, 0.0}
+{
+}
+
+double MemoryPressure::Sample::value(Metric metric, Window window) const
+{
+    const int idx = static_cast<int>(window);
+    return metric == Metric::Full ? full[idx] : some[idx];
+}
+
+MemoryPressure::MemoryPressure(Source source)
+    : m_source(std::move(source))
+{
+}
+
+void MemoryPressure::setSource(Source source)
+{
+    m_source = std::move(source);
+}
+
+MemoryPressure::Sample MemoryPressure::sample() const
+{
+    return parse(m_source ? m_source() : readProcPressure());
+}
+
+bool MemoryPressure::isUnderPressure(const Policy& policy) const
+{
+    if (!policy.enabled) {
+        return false;
+    }
+
+    const Sample s = sample();
+    if (!s.valid) {
+        // PSI非対応（古いカーネルやコンテナ）の場合は逼迫していないものとして扱う
+        return false;
+    }
+
+    return s.value(policy.metric, policy.window) > policy.threshold;
+}
+
+MemoryPressure::Sample MemoryPressure::parse(const QByteArray& data)
+{
+    Sample result;
+    bool seenSome = false;
+
+    // 形式: "some avg10=0.00 avg60=0.00 avg300=0.00 total=0"
+    const QList<QByteArray> lines = data.split('\n');
+    for (const QByteArray& line : lines) {
+        const QList<QByteArray> fields = line.simplified().split(' ');
+        if (fields.size() < 4) {
+            continue;
+        }
+
+        double* target = nullptr;
+        if (fields[0] == "some") {
+            target = result.some;
+            seenSome = true;
+        } else if (fields[0] == "full") {
+            target = result.full;
+        } else {
+            continue;
+        }
+
+        for (int i = 1; i < fields.size(); ++i) {
+            const int eq = fields[i].indexOf('=');
+            if (eq <= 0) {
+                continue;
+            }
+            const QByteArray key = fields[i].left(eq);
+            bool ok = false;
+            const double value = fields[i].mid(eq + 1).toDouble(&ok);
+            if (!ok) {
+                continue;
+            }
+            if (key == "avg10") target[0] = value;
+            else if (key == "avg60") target[1] = value;
+            else if (key == "avg300") target[2] = value;
+        }
+    }
+
+    result.valid = seenSome;
+    return result;
+}
+
+QByteArray MemoryPressure::readProcPressure()
+{
+    QFile file(Constants::MEMORY_PRESSURE_PATH);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+bool MemoryPressure::parseMetric(const QString& text, Metric& metric)
+{
+    const QString s = text.trimmed().toLower();
+    if (s == "some") {
+        metric = Metric::Some;
+        return true;
+    }
+    if (s == "full") {
+        metric = Metric::Full;
+        return true;
+    }
+    return false;
+}
+
+bool MemoryPressure::parseWindow(const QString& text, Window& window)
+{
+    const QString s = text.trimmed().toLower();
+    if (s == "avg10") {
+        window = Window::Avg10;
+        return true;
+    }
+    if (s == "avg60") {
+        window = Window::Avg60;
+        return true;
+    }
+    if (s == "avg300") {
+        window = Window::Avg300;
+        return true;
+    }
+    return false;
+}
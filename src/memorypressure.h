@@ -0,0 +1,128 @@
+/**
+ * @file memorypressure.h
+ * @brief PSI（Pressure Stall Information）によるメモリ逼迫度の取得
+ *
+ * /proc/pressure/memory を読み取り、システムがメモリ逼迫状態にあるかを判定します。
+ * 逼迫時には未起動のブラウザプロファイルをコールドスタートさせないよう、
+ * ProfileManagerが起動済みのプロファイルを優先するために使用します。
+ */
+
+#ifndef MEMORYPRESSURE_H
+#define MEMORYPRESSURE_H
+
+#include <QByteArray>
+#include <QString>
+#include <functional>
+
+/**
+ * @class MemoryPressure
+ * @brief メモリ逼迫度の読み取りと判定
+ *
+ * PSIの読み取り元は差し替え可能で、ユニットテストでは固定の文字列を返す
+ * ソースを注入して判定ロジックを検証できます。
+ */
+class MemoryPressure {
+public:
+    /**
+     * @brief 判定に使用するPSIの行
+     */
+    enum class Metric {
+        Some,   ///< 一部のタスクが停止している時間の割合
+        Full    ///< 全てのタスクが停止している時間の割合
+    };
+
+    /**
+     * @brief 判定に使用する平均化ウィンドウ
+     */
+    enum class Window {
+        Avg10,
+        Avg60,
+        Avg300
+    };
+
+    /**
+     * @struct Policy
+     * @brief 逼迫判定のしきい値設定（YAMLから読み込み）
+     */
+    struct Policy {
+        bool enabled;        ///< 判定を行うかどうか
+        double threshold;    ///< しきい値（%）。これを超えると逼迫とみなす
+        Metric metric;       ///< 使用する行
+        Window window;       ///< 使用する平均化ウィンドウ
+
+        Policy();
+    };
+
+    /**
+     * @struct Sample
+     * @brief PSIの1回分の読み取り結果
+     */
+    struct Sample {
+        bool valid;          ///< 読み取りと解析に成功したか
+        double some[3];      ///< some行の avg10/avg60/avg300
+        double full[3];      ///< full行の avg10/avg60/avg300
+
+        Sample();
+
+        /**
+         * @brief 指定された行とウィンドウの値を取得
+         */
+        double value(Metric metric, Window window) const;
+    };
+
+    /// PSIの内容を返す関数（テストで差し替え可能）
+    using Source = std::function<QByteArray()>;
+
+    /**
+     * @brief コンストラクタ
+     * @param source PSIの読み取り元（省略時は /proc/pressure/memory）
+     */
+    explicit MemoryPressure(Source source = Source());
+
+    /**
+     * @brief 読み取り元を差し替え
+     * @param source 新しい読み取り元（空の場合は /proc/pressure/memory）
+     */
+    void setSource(Source source);
+
+    /**
+     * @brief 現在のPSIを読み取る
+     * @return 読み取り結果（PSI非対応カーネルではvalid=false）
+     */
+    Sample sample() const;
+
+    /**
+     * @brief ポリシーに従って逼迫状態かどうかを判定
+     * @param policy 判定ポリシー
+     * @return true: 逼迫している, false: 逼迫していない・判定不能
+     */
+    bool isUnderPressure(const Policy& policy) const;
+
+    /**
+     * @brief PSIテキストを解析
+     * @param data /proc/pressure/memory 形式のテキスト
+     * @return 解析結果
+     */
+    static Sample parse(const QByteArray& data);
+
+    /**
+     * @brief /proc/pressure/memory を読み取る
+     * @return ファイルの内容（読み取れない場合は空）
+     */
+    static QByteArray readProcPressure();
+
+    /**
+     * @brief YAMLの文字列表現から行を取得（"some" / "full"）
+     */
+    static bool parseMetric(const QString& text, Metric& metric);
+
+    /**
+     * @brief YAMLの文字列表現からウィンドウを取得（"avg10" / "avg60" / "avg300"）
+     */
+    static bool parseWindow(const QString& text, Window& window);
+
+private:
+    Source m_source;  ///< PSIの読み取り元
+};
+
+#endif // MEMORYPRESSURE_H
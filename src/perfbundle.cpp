@@ -0,0 +1,814 @@
+/**
+ * @file perfbundle.cpp
+ * @brief PerfBundleクラスの実装
+ */
+
+#include "perfbundle.h"
+#include "browserdetector.h"
+#include "configmanager.h"
+#include "yamlconfig.h"
+#include "constants.h"
+#include "version.h"
+
+#include <KConfig>
+#include <KConfigGroup>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMessageAuthenticationCode>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QSet>
+#include <QStandardPaths>
+#include <QSysInfo>
+#include <QTextStream>
+
+#include <algorithm>
+#include <functional>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr auto MANIFEST_FILE = "manifest.json";
+constexpr auto TRACE_FILE = "trace.json";
+constexpr auto HOME_DIR = "home";
+constexpr auto CONFIG_DIR = "config";
+constexpr auto RC_FILE = "kde-browser-pickerrc";
+constexpr auto HOME_PLACEHOLDER = "@HOME@";
+
+/// 匿名化しても検出に影響しない（個人情報を含まない）Local State の値
+const QStringList& structuralJsonKeys()
+{
+    static const QStringList keys = {"avatar_icon", "gaia_picture_file_name"};
+    return keys;
+}
+
+bool fail(QString* error, const QString& message)
+{
+    if (error) *error = message;
+    return false;
+}
+
+QByteArray readFile(const QString& path, bool* ok = nullptr)
+{
+    QFile file(path);
+    const bool opened = file.open(QIODevice::ReadOnly);
+    if (ok) *ok = opened;
+    return opened ? file.readAll() : QByteArray();
+}
+
+bool writeFile(const QString& path, const QByteArray& contents)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(contents) == contents.size();
+}
+
+/**
+ * @brief パスの親（シンボリックリンクを解決した最も近い既存のディレクトリ）が dir の中にあるか
+ * @param canonicalDir シンボリックリンクを解決したディレクトリ
+ */
+bool parentStaysUnder(const QString& path, const QString& canonicalDir)
+{
+    QString parent = QFileInfo(path).absolutePath();
+    while (!QFileInfo::exists(parent)) {
+        parent = QFileInfo(parent).absolutePath();
+    }
+    const QString canonical = QFileInfo(parent).canonicalFilePath();
+    return canonical == canonicalDir || canonical.startsWith(canonicalDir + "/");
+}
+
+/**
+ * @brief dir の外に書き込まないようにファイルを作成
+ *
+ * 親が dir の外へ解決される場合と、パスそのものがシンボリックリンクの場合（O_NOFOLLOW）は失敗します。
+ * @param size 内容の後ろをスパースに伸ばしたファイルのサイズ（内容より短い場合は内容の長さ）
+ */
+bool writeFileUnder(const QString& path, const QString& canonicalDir, const QByteArray& contents, qint64 size = 0)
+{
+    if (!parentStaysUnder(path, canonicalDir) || !QDir().mkpath(QFileInfo(path).absolutePath())) {
+        return false;
+    }
+    const int fd = ::open(QFile::encodeName(path).constData(), O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC,
+                          0644);
+    if (fd < 0) {
+        return false;
+    }
+    const bool ok = ::write(fd, contents.constData(), contents.size()) == contents.size() &&
+                    ::ftruncate(fd, std::max<qint64>(size, contents.size())) == 0;
+    ::close(fd);
+    return ok;
+}
+
+/**
+ * @brief ホームディレクトリからの相対パス（ホームの外の場合は空）
+ */
+QString relativeToHome(const QString& path)
+{
+    const QString home = QDir::homePath();
+    return path.startsWith(home + "/") ? path.mid(home.size() + 1) : QString();
+}
+
+/**
+ * @brief ホームディレクトリを "~" に置き換えた表示用のパス
+ */
+QString displayPath(const QString& path)
+{
+    const QString home = QDir::homePath();
+    if (path == home) return "~";
+    return path.startsWith(home + "/") ? "~" + path.mid(home.size()) : path;
+}
+
+/**
+ * @brief パスのあるファイルシステムの種類（NFSなどの遅いホームの判別用）
+ */
+QString fileSystemName(const QString& path)
+{
+    struct statfs fs;
+    if (::statfs(QFile::encodeName(path).constData(), &fs) != 0) {
+        return QString();
+    }
+    switch (static_cast<unsigned long>(fs.f_type)) {
+    case 0xEF53: return "ext4";
+    case 0x9123683E: return "btrfs";
+    case 0x58465342: return "xfs";
+    case 0x2FC12FC1: return "zfs";
+    case 0x01021994: return "tmpfs";
+    case 0x794C7630: return "overlayfs";
+    case 0x6969: return "nfs";
+    case 0xFF534D42: return "cifs";
+    case 0xFE534D42: return "smb2";
+    case 0x65735546: return "fuse";
+    case 0x5346544E: return "ntfs";
+    default: return QString("0x%1").arg(static_cast<unsigned long>(fs.f_type), 0, 16);
+    }
+}
+
+/**
+ * @class Sanitizer
+ * @brief バンドルに含めるファイルの匿名化
+ */
+class Sanitizer {
+public:
+    explicit Sanitizer(const QByteArray& key) : m_key(key) {}
+
+    QString name(const QString& text) const { return PerfBundle::anonymize(text, m_key); }
+
+    /// Firefoxのプロファイルディレクトリのパス（各要素を匿名化）
+    QString firefoxPath(const QString& path) const {
+        QStringList parts = path.split('/');
+        for (QString& part : parts) {
+            if (!part.isEmpty() && part != "." && part != "..") {
+                part = name(part);
+            }
+        }
+        return parts.join('/');
+    }
+
+    /// "browser/profile" 形式の値（Firefoxのプロファイル名のみ匿名化）
+    QString target(const QString& value) const {
+        return value.startsWith("firefox/") ? "firefox/" + name(value.mid(8)) : value;
+    }
+
+    /// ホームディレクトリのパスを "@HOME@" に置き換え
+    QByteArray homePaths(const QByteArray& contents) const {
+        const QByteArray home = QFile::encodeName(QDir::homePath());
+        if (home.size() <= 1) {
+            return contents;
+        }
+        QByteArray result = contents;
+        return result.replace(home, HOME_PLACEHOLDER);
+    }
+
+    /// profiles.ini / installs.ini
+    QByteArray firefoxIni(const QByteArray& contents) const {
+        QStringList lines = QString::fromUtf8(contents).split('\n');
+        for (QString& line : lines) {
+            const int eq = line.indexOf('=');
+            if (eq <= 0 || line.startsWith('[')) {
+                continue;
+            }
+            const QString key = line.left(eq).trimmed();
+            QString value = line.mid(eq + 1);
+            const bool cr = value.endsWith('\r');
+            if (cr) value.chop(1);
+            if (key == "Name") {
+                value = name(value);
+            } else if ((key == "Path" || key == "Default") && value != "0" && value != "1") {
+                value = firefoxPath(value);
+            }
+            line = line.left(eq + 1) + value + (cr ? "\r" : "");
+        }
+        return lines.join('\n').toUtf8();
+    }
+
+    /// Local State（構造はそのままに、名前などの文字列を匿名化）
+    QByteArray localState(const QByteArray& contents) const {
+        const QJsonDocument doc = QJsonDocument::fromJson(contents);
+        if (!doc.isObject()) {
+            return QByteArray();
+        }
+        return QJsonDocument(json(doc.object(), QString()).toObject()).toJson(QJsonDocument::Compact);
+    }
+
+    /// kde-browser-pickerrc（プロファイル名・表示名・ホスト名）
+    QByteArray rc(const QByteArray& contents) const {
+        QStringList lines = QString::fromUtf8(contents).split('\n');
+
+        // [LastUsed] の Profile はブラウザがFirefoxの場合のみ匿名化する
+        QString group;
+        QString lastUsedBrowser;
+        for (const QString& line : lines) {
+            if (line.startsWith('[') && line.endsWith(']')) {
+                group = line.mid(1, line.size() - 2);
+            } else if (group == Constants::CONFIG_GROUP_LAST_USED && line.startsWith("Browser=")) {
+                lastUsedBrowser = line.mid(8).trimmed();
+            }
+        }
+
+        const QString firefoxGroup = QString(Constants::CONFIG_GROUP_BROWSERS) + "/firefox/";
+        group.clear();
+        for (QString& line : lines) {
+            if (line.startsWith('[') && line.endsWith(']')) {
+                group = line.mid(1, line.size() - 2);
+                if (group.startsWith(firefoxGroup)) {
+                    line = "[" + firefoxGroup + name(group.mid(firefoxGroup.size())) + "]";
+                }
+                continue;
+            }
+            const int eq = line.indexOf('=');
+            if (eq <= 0) {
+                continue;
+            }
+            QString key = line.left(eq);
+            QString value = line.mid(eq + 1);
+            if (group == Constants::CONFIG_GROUP_LAUNCH_STATS) {
+                key = target(key);
+            } else if (group == Constants::CONFIG_GROUP_HOST_HISTORY) {
+                key = name(key);
+                value = target(value);
+            } else if (group == Constants::CONFIG_GROUP_LAST_USED && key == "Profile" &&
+                       lastUsedBrowser == "firefox") {
+                value = name(value);
+            } else if (group.startsWith(QString(Constants::CONFIG_GROUP_BROWSERS) + "/") && key == "DisplayName") {
+                value = name(value);
+            }
+            line = key + "=" + value;
+        }
+        return homePaths(lines.join('\n').toUtf8());
+    }
+
+    /// YAMLの層（ホームディレクトリと launch のFirefoxプロファイル名）
+    QByteArray yaml(const QByteArray& contents) const {
+        static const QRegularExpression firefoxTarget(R"(^(\s+)(["']?)firefox/(.+)\2:(\s*(#.*)?)$)");
+        QStringList lines = QString::fromUtf8(contents).split('\n');
+        for (QString& line : lines) {
+            const QRegularExpressionMatch match = firefoxTarget.match(line);
+            if (match.hasMatch()) {
+                line = match.captured(1) + match.captured(2) + "firefox/" + name(match.captured(3)) +
+                       match.captured(2) + ":" + match.captured(4);
+            }
+        }
+        return homePaths(lines.join('\n').toUtf8());
+    }
+
+private:
+    QJsonValue json(const QJsonValue& value, const QString& key) const {
+        if (value.isObject()) {
+            QJsonObject result;
+            const QJsonObject object = value.toObject();
+            for (auto it = object.begin(); it != object.end(); ++it) {
+                // メールアドレスをキーにしたアカウント情報など
+                const QString newKey = it.key().contains('@') ? name(it.key()) : it.key();
+                result.insert(newKey, json(it.value(), it.key()));
+            }
+            return result;
+        }
+        if (value.isArray()) {
+            QJsonArray result;
+            for (const QJsonValue& item : value.toArray()) {
+                result.append(json(item, key));
+            }
+            return result;
+        }
+        if (value.isString()) {
+            static const QRegularExpression digits("^[0-9]*$");
+            const QString text = value.toString();
+            if (structuralJsonKeys().contains(key) || text.startsWith("chrome://") ||
+                digits.match(text).hasMatch()) {
+                return text;
+            }
+            return name(text);
+        }
+        return value;
+    }
+
+    QByteArray m_key;
+};
+
+/**
+ * @brief ディレクトリ直下の一覧（種類・サイズ・更新日時）を追加
+ * @param absDir 対象のディレクトリ
+ * @param relDir バンドル内でのホームからの相対パス
+ * @param mapName 名前の匿名化（nullptrの場合はそのまま）
+ */
+void listDirectory(const QString& absDir, const QString& relDir, const Sanitizer& sanitizer,
+                   const std::function<QString(const QString&)>& mapName, QJsonArray& entries)
+{
+    auto addEntry = [&](const QString& absPath, const QString& relPath) {
+        struct stat st;
+        if (::lstat(QFile::encodeName(absPath).constData(), &st) != 0) {
+            return;
+        }
+        QJsonObject entry;
+        entry["path"] = relPath;
+        if (S_ISDIR(st.st_mode)) {
+            entry["type"] = "d";
+        } else if (S_ISLNK(st.st_mode)) {
+            // ロックのリンク先にはホスト名とPIDが含まれる
+            entry["type"] = "l";
+            entry["target"] = sanitizer.name(QFileInfo(absPath).symLinkTarget().section('/', -1));
+        } else if (S_ISREG(st.st_mode)) {
+            entry["type"] = "f";
+            entry["size"] = static_cast<double>(st.st_size);
+        } else {
+            return;
+        }
+        entry["mtime"] = static_cast<double>(st.st_mtim.tv_sec);
+        entry["mtime_nsec"] = static_cast<int>(st.st_mtim.tv_nsec);
+        entries.append(entry);
+    };
+
+    addEntry(absDir, relDir);
+    const QStringList names = QDir(absDir).entryList(QDir::AllEntries | QDir::Hidden | QDir::System |
+                                                     QDir::NoDotAndDotDot, QDir::Name);
+    for (const QString& name : names) {
+        addEntry(absDir + "/" + name, relDir + "/" + (mapName ? mapName(name) : name));
+    }
+}
+
+/**
+ * @brief 中央値（計測結果の表示用）
+ */
+qint64 median(QList<qint64> values)
+{
+    if (values.isEmpty()) {
+        return -1;
+    }
+    std::sort(values.begin(), values.end());
+    return values.at(values.size() / 2);
+}
+
+} // namespace
+
+QString PerfBundle::anonymize(const QString& text, const QByteArray& key)
+{
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+    QString result;
+    result.reserve(text.size());
+    for (int block = 0; result.size() < text.size(); ++block) {
+        const QByteArray digest = QMessageAuthenticationCode::hash(
+            text.toUtf8() + '\0' + QByteArray::number(block), key, QCryptographicHash::Sha256);
+        for (const char byte : digest) {
+            if (result.size() == text.size()) {
+                break;
+            }
+            result += QLatin1Char(alphabet[static_cast<uchar>(byte) % 36]);
+        }
+    }
+    return result;
+}
+
+QJsonObject PerfBundle::measureStartup()
+{
+    QJsonObject trace;
+    QElapsedTimer timer;
+
+    // キャッシュを使わない解析時間と、通常の起動と同じ（キャッシュを使う）読み込み時間
+    timer.start();
+    const YamlConfig yaml = YamlConfig::load(QString());
+    trace["yaml_parse_us"] = timer.nsecsElapsed() / 1000;
+    trace["yaml_layers"] = static_cast<int>(yaml.layers.size());
+
+    timer.restart();
+    ConfigManager config;
+    trace["config_load_us"] = timer.nsecsElapsed() / 1000;
+
+    {
+        BrowserDetector detector;
+        detector.setSnapshotPath(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) +
+                                 "/kde-browser-picker/profiles.json");
+        timer.restart();
+        trace["snapshot_present"] = detector.loadSnapshot();
+        trace["snapshot_load_us"] = timer.nsecsElapsed() / 1000;
+    }
+
+    // 1回目はページキャッシュが冷えた状態に近く、以降は温まった状態
+    QJsonArray runs;
+    for (int run = 0; run < DETECTION_RUNS; ++run) {
+        BrowserDetector detector;
+        detector.setExecutableOverrides(config.browserExecutableOverrides());
+        detector.setEnabledOverrides(config.browserEnabledOverrides());
+        detector.setLaunchTemplates(config.launchTemplates());
+
+        QElapsedTimer clock;
+        QList<QPair<QString, qint64>> starts;
+        detector.setProbeHook([&clock, &starts](const QString& browserId, const std::stop_token&) {
+            starts << qMakePair(browserId, clock.nsecsElapsed());
+        });
+        clock.start();
+        const QMap<QString, BrowserDetector::BrowserInfo> browsers = detector.detectBrowsers();
+        const qint64 total = clock.nsecsElapsed();
+
+        QJsonObject perBrowser;
+        for (int i = 0; i < starts.size(); ++i) {
+            const qint64 end = i + 1 < starts.size() ? starts[i + 1].second : total;
+            QJsonObject browser;
+            browser["us"] = (end - starts[i].second) / 1000;
+            browser["profiles"] = static_cast<int>(browsers.value(starts[i].first).profiles.size());
+            perBrowser[starts[i].first] = browser;
+        }
+        QJsonObject result;
+        result["total_us"] = total / 1000;
+        result["browsers"] = perBrowser;
+        runs.append(result);
+    }
+    trace["detection"] = runs;
+    return trace;
+}
+
+bool PerfBundle::exportTo(const QString& dir, QString* error)
+{
+    QDir out(dir);
+    if (out.exists() && !out.entryList(QDir::AllEntries | QDir::Hidden | QDir::NoDotAndDotDot).isEmpty()) {
+        return fail(error, "output directory is not empty: " + dir);
+    }
+    if (!QDir().mkpath(dir)) {
+        return fail(error, "cannot create " + dir);
+    }
+
+    // 鍵はバンドルに保存しない
+    QByteArray key(32, Qt::Uninitialized);
+    QRandomGenerator::system()->fillRange(reinterpret_cast<quint32*>(key.data()), key.size() / 4);
+    const Sanitizer sanitizer(key);
+
+    const QJsonObject trace = measureStartup();
+
+    ConfigManager config;
+    BrowserDetector detector;
+    detector.setExecutableOverrides(config.browserExecutableOverrides());
+    detector.setEnabledOverrides(config.browserEnabledOverrides());
+    const QMap<QString, BrowserDetector::BrowserInfo> browsers = detector.detectBrowsers();
+
+    const QString homeOut = dir + "/" + HOME_DIR;
+    QJsonArray entries;
+    QJsonObject dataDirs;
+    bool ok = false;
+
+    // Firefox: profiles.ini と installs.ini、各プロファイルの times.json
+    const QString firefoxDir = detector.userDataDirectory("firefox");
+    const QString firefoxRel = relativeToHome(firefoxDir);
+    if (!firefoxRel.isEmpty() && QFileInfo(firefoxDir).isDir()) {
+        QStringList profilePaths;
+        QSet<QString> profileDirNames;
+        const QByteArray ini = readFile(firefoxDir + "/" + Constants::FIREFOX_CONFIG, &ok);
+        if (ok) {
+            static const QRegularExpression pathLine(R"(^Path=(.*?)\r?$)", QRegularExpression::MultilineOption);
+            auto it = pathLine.globalMatch(QString::fromUtf8(ini));
+            while (it.hasNext()) {
+                const QString path = it.next().captured(1);
+                profilePaths << path;
+                profileDirNames.insert(path.section('/', 0, 0));
+            }
+            writeFile(homeOut + "/" + firefoxRel + "/" + Constants::FIREFOX_CONFIG, sanitizer.firefoxIni(ini));
+        }
+        const QByteArray installs = readFile(firefoxDir + "/installs.ini", &ok);
+        if (ok) {
+            writeFile(homeOut + "/" + firefoxRel + "/installs.ini", sanitizer.firefoxIni(installs));
+        }
+
+        listDirectory(firefoxDir, firefoxRel, sanitizer, [&](const QString& name) {
+            return profileDirNames.contains(name) ? sanitizer.name(name) : name;
+        }, entries);
+        for (const QString& path : profilePaths) {
+            const QString profileRel = firefoxRel + "/" + sanitizer.firefoxPath(path);
+            listDirectory(firefoxDir + "/" + path, profileRel, sanitizer, nullptr, entries);
+            const QByteArray times = readFile(firefoxDir + "/" + path + "/times.json", &ok);
+            if (ok) {
+                writeFile(homeOut + "/" + profileRel + "/times.json", times);
+            }
+        }
+        dataDirs["firefox"] = QJsonObject{{"path", displayPath(firefoxDir)},
+                                          {"filesystem", fileSystemName(firefoxDir)}};
+    }
+
+    // Chrome / Chromium: Local State と各プロファイルディレクトリ
+    for (const QString& browserId : {QString("chrome"), QString("chromium")}) {
+        const QString dataDir = detector.userDataDirectory(browserId);
+        const QString rel = relativeToHome(dataDir);
+        const QByteArray localState = readFile(dataDir + "/" + Constants::CHROME_CONFIG, &ok);
+        if (rel.isEmpty() || !ok) {
+            continue;
+        }
+        writeFile(homeOut + "/" + rel + "/" + Constants::CHROME_CONFIG, sanitizer.localState(localState));
+
+        listDirectory(dataDir, rel, sanitizer, nullptr, entries);
+        QStringList profileDirs = {"Default"};
+        const QJsonObject infoCache = QJsonDocument::fromJson(localState).object()
+                                          .value("profile").toObject().value("info_cache").toObject();
+        for (auto it = infoCache.begin(); it != infoCache.end(); ++it) {
+            if (!profileDirs.contains(it.key()) && BrowserDetector::isValidProfileName(it.key())) {
+                profileDirs << it.key();
+            }
+        }
+        for (const QString& profileDir : profileDirs) {
+            if (QFileInfo(dataDir + "/" + profileDir).isDir()) {
+                listDirectory(dataDir + "/" + profileDir, rel + "/" + profileDir, sanitizer, nullptr, entries);
+            }
+        }
+        dataDirs[browserId] = QJsonObject{{"path", displayPath(dataDir)}, {"filesystem", fileSystemName(dataDir)}};
+    }
+
+    // rc と YAMLの各層
+    QJsonObject configFiles;
+    const QString rcPath = QStandardPaths::locate(QStandardPaths::GenericConfigLocation, RC_FILE);
+    const QByteArray rc = readFile(rcPath, &ok);
+    if (!rcPath.isEmpty() && ok) {
+        writeFile(dir + "/" + CONFIG_DIR + "/" + RC_FILE, sanitizer.rc(rc));
+        configFiles["rc"] = QString(CONFIG_DIR) + "/" + RC_FILE;
+    }
+
+    const QList<QStringList> layers = YamlConfig::layerCandidates();
+    const bool hasEnvLayer = qEnvironmentVariableIsSet(Constants::YAML_ENV_PATH) &&
+                             !qEnvironmentVariable(Constants::YAML_ENV_PATH).isEmpty();
+    const int userLayer = layers.size() - (hasEnvLayer ? 2 : 1);
+    QJsonArray yamlLayers;
+    for (int i = 0; i < layers.size(); ++i) {
+        for (const QString& path : layers[i]) {
+            const QByteArray contents = readFile(path, &ok);
+            if (!ok) {
+                continue;
+            }
+            const QString file = QString("%1/layer-%2-%3").arg(CONFIG_DIR).arg(i).arg(QFileInfo(path).fileName());
+            writeFile(dir + "/" + file, sanitizer.yaml(contents));
+            QJsonObject layer;
+            layer["kind"] = i < userLayer ? "system" : (i == userLayer ? "user" : "env");
+            layer["original"] = displayPath(path);
+            layer["file"] = file;
+            yamlLayers.append(layer);
+            break;
+        }
+    }
+    configFiles["yaml"] = yamlLayers;
+
+    // 環境変数から決まるパスと、検出された実行ファイル
+    QJsonObject environment;
+    for (const char* name : {"HOME", "XDG_CONFIG_HOME", "XDG_CONFIG_DIRS", "XDG_CACHE_HOME", "XDG_DATA_HOME",
+                             "XDG_DATA_DIRS", "XDG_RUNTIME_DIR", "XDG_CURRENT_DESKTOP", "XDG_SESSION_TYPE",
+                             Constants::YAML_ENV_PATH}) {
+        if (qEnvironmentVariableIsSet(name)) {
+            environment[name] = displayPath(qEnvironmentVariable(name));
+        }
+    }
+    environment["home_filesystem"] = fileSystemName(QDir::homePath());
+    environment["cache_dir"] = displayPath(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation));
+    environment["cache_filesystem"] =
+        fileSystemName(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation));
+
+    QJsonObject executables;
+    for (auto it = browsers.cbegin(); it != browsers.cend(); ++it) {
+        executables[it.key()] = displayPath(it->executable);
+    }
+
+    QJsonObject system;
+    system["kernel"] = QSysInfo::kernelVersion();
+    system["os"] = QSysInfo::prettyProductName();
+    system["cpu"] = QSysInfo::currentCpuArchitecture();
+    system["qt"] = QString(qVersion());
+    system["version"] = KDE_BROWSER_PICKER_VERSION_STRING;
+
+    QJsonObject manifest;
+    manifest["format"] = FORMAT_VERSION;
+    manifest["created"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    manifest["system"] = system;
+    manifest["environment"] = environment;
+    manifest["data_dirs"] = dataDirs;
+    manifest["executables"] = executables;
+    manifest["config"] = configFiles;
+    manifest["entries"] = entries;
+
+    if (!writeFile(dir + "/" + MANIFEST_FILE, QJsonDocument(manifest).toJson()) ||
+        !writeFile(dir + "/" + TRACE_FILE, QJsonDocument(trace).toJson())) {
+        return fail(error, "cannot write to " + dir);
+    }
+    return true;
+}
+
+bool PerfBundle::materialize(const QString& bundleDir, const QString& root, QString* error)
+{
+    bool ok = false;
+    const QJsonObject manifest = QJsonDocument::fromJson(readFile(bundleDir + "/" + MANIFEST_FILE, &ok)).object();
+    if (!ok || manifest.value("format").toInt() != FORMAT_VERSION) {
+        return fail(error, "not a performance bundle (or unsupported format): " + bundleDir);
+    }
+
+    const QString home = root + "/" + HOME_DIR;
+    if (!QDir().mkpath(home)) {
+        return fail(error, "cannot create " + home);
+    }
+
+    // ディレクトリ一覧を再現（親が先になるよう並べ替え、ファイルは元のサイズのスパースファイル）。
+    // シンボリックリンクは再現先の中を指す同じディレクトリの名前だけを受け付け、
+    // 書き込みがリンクを辿らないよう最後に作成する
+    const QString canonicalHome = QFileInfo(home).canonicalFilePath();
+    QList<QJsonObject> entries;
+    for (const QJsonValue& value : manifest.value("entries").toArray()) {
+        const QJsonObject entry = value.toObject();
+        const QString path = entry.value("path").toString();
+        if (path.isEmpty() || path.startsWith('/') || path.split('/').contains("..")) {
+            continue;
+        }
+        const QString target = entry.value("target").toString();
+        if (entry.value("type").toString() == "l" &&
+            (target.isEmpty() || target.contains('/') || target == "." || target == "..")) {
+            continue;
+        }
+        entries << entry;
+    }
+    std::sort(entries.begin(), entries.end(), [](const QJsonObject& a, const QJsonObject& b) {
+        return a.value("path").toString() < b.value("path").toString();
+    });
+    for (const QJsonObject& entry : entries) {
+        const QString path = home + "/" + entry.value("path").toString();
+        const QString type = entry.value("type").toString();
+        if (!parentStaysUnder(path, canonicalHome)) {
+            continue;
+        }
+        if (type == "d") {
+            QDir().mkpath(path);
+        } else if (type == "f") {
+            writeFileUnder(path, canonicalHome, QByteArray(), static_cast<qint64>(entry.value("size").toDouble()));
+        }
+    }
+
+    // 検出が内容を読むファイル
+    const QString homeIn = bundleDir + "/" + HOME_DIR;
+    QDirIterator files(homeIn, QDir::Files | QDir::Hidden | QDir::NoSymLinks, QDirIterator::Subdirectories);
+    while (files.hasNext()) {
+        const QString source = files.next();
+        if (!writeFileUnder(home + source.mid(homeIn.size()), canonicalHome, readFile(source))) {
+            return fail(error, "cannot write " + home + source.mid(homeIn.size()));
+        }
+    }
+
+    // シンボリックリンク（ファイルをすべて書き込んだ後）
+    for (const QJsonObject& entry : entries) {
+        const QString path = home + "/" + entry.value("path").toString();
+        if (entry.value("type").toString() == "l" && parentStaysUnder(path, canonicalHome)) {
+            QDir().mkpath(QFileInfo(path).absolutePath());
+            QFile::link(entry.value("target").toString(), path);
+        }
+    }
+
+    // 更新日時（子を作成すると親の更新日時が変わるため、深い方から設定する）
+    for (auto it = entries.crbegin(); it != entries.crend(); ++it) {
+        struct timespec times[2];
+        times[0].tv_sec = times[1].tv_sec = static_cast<time_t>(it->value("mtime").toDouble());
+        times[0].tv_nsec = times[1].tv_nsec = it->value("mtime_nsec").toInt();
+        ::utimensat(AT_FDCWD, QFile::encodeName(home + "/" + it->value("path").toString()).constData(),
+                    times, AT_SYMLINK_NOFOLLOW);
+    }
+
+    const QByteArray homeBytes = QFile::encodeName(home);
+    auto restoreHome = [&homeBytes](QByteArray contents) {
+        return contents.replace(HOME_PLACEHOLDER, homeBytes);
+    };
+
+    // rc（自動選択で計測中にスタブが起動しないよう、タイムアウトを無効にする）
+    const QJsonObject configFiles = manifest.value("config").toObject();
+    const QString configHome = home + "/.config";
+    const QString rcOut = configHome + "/" + RC_FILE;
+    const QString rcIn = configFiles.value("rc").toString();
+    if (!rcIn.isEmpty()) {
+        writeFileUnder(rcOut, canonicalHome, restoreHome(readFile(bundleDir + "/" + rcIn)));
+    }
+    {
+        KConfig rc(rcOut, KConfig::SimpleConfig);
+        rc.group(Constants::CONFIG_GROUP_GENERAL).writeEntry(Constants::CONFIG_KEY_DEFAULT_TIMEOUT, 0);
+        rc.sync();
+    }
+
+    // YAMLの各層（再現する環境の /etc/xdg は読み込まない）
+    QStringList systemDirs;
+    QByteArray envLayer;
+    int index = 0;
+    for (const QJsonValue& value : configFiles.value("yaml").toArray()) {
+        const QJsonObject layer = value.toObject();
+        const QString kind = layer.value("kind").toString();
+        const QString original = QFileInfo(layer.value("original").toString()).fileName();
+        const QByteArray contents = restoreHome(readFile(bundleDir + "/" + layer.value("file").toString()));
+        if (kind == "system") {
+            const QString systemDir = QString("%1/xdg/%2").arg(root).arg(index++);
+            writeFile(systemDir + "/" + original, contents);
+            systemDirs.prepend(systemDir);
+        } else if (kind == "user") {
+            writeFileUnder(configHome + "/" + original, canonicalHome, contents);
+        } else {
+            envLayer = contents;
+        }
+    }
+    if (systemDirs.isEmpty()) {
+        systemDirs << root + "/xdg/none";
+    }
+
+    // ブラウザはスタブに置き換え、採取した環境で検出されなかったブラウザは無効にする
+    const QJsonObject executables = manifest.value("executables").toObject();
+    QString overrides = "\n# performance bundle replay\nbrowsers:\n";
+    for (const QString& browserId : {QString("firefox"), QString("chrome"), QString("chromium")}) {
+        overrides += "  " + browserId + ":\n";
+        if (executables.contains(browserId)) {
+            const QString stub = root + "/bin/" + browserId;
+            if (!writeFile(stub, "#!/bin/sh\nexit 0\n")) {
+                return fail(error, "cannot write " + stub);
+            }
+            QFile::setPermissions(stub, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+            overrides += "    path: \"" + stub + "\"\n";
+        } else {
+            overrides += "    enabled: false\n";
+        }
+    }
+    overrides += "speculative:\n  enabled: false\n";
+    const QString envYaml = root + "/replay.yaml";
+    if (!writeFile(envYaml, envLayer + overrides.toUtf8())) {
+        return fail(error, "cannot write " + envYaml);
+    }
+
+    qputenv("HOME", homeBytes);
+    qputenv("XDG_CONFIG_HOME", QFile::encodeName(configHome));
+    qputenv("XDG_CACHE_HOME", QFile::encodeName(root + "/cache"));
+    qputenv("XDG_DATA_HOME", QFile::encodeName(home + "/.local/share"));
+    qputenv("XDG_CONFIG_DIRS", QFile::encodeName(systemDirs.join(':')));
+    qputenv(Constants::YAML_ENV_PATH, QFile::encodeName(envYaml));
+    return true;
+}
+
+QString PerfBundle::report(const QJsonObject& recorded, const QJsonObject& replayed)
+{
+    QString text;
+    QTextStream out(&text);
+    auto row = [&out](const QString& label, const QJsonValue& a, const QJsonValue& b) {
+        auto cell = [](const QJsonValue& v) {
+            return v.isUndefined() || v.isNull() ? QString("-") : QString::number(v.toDouble(), 'f', 0);
+        };
+        out << qSetFieldWidth(28) << Qt::left << label << qSetFieldWidth(12) << Qt::right
+            << cell(a) << cell(b) << qSetFieldWidth(0) << "\n";
+    };
+
+    out << qSetFieldWidth(28) << Qt::left << "" << qSetFieldWidth(12) << Qt::right
+        << "bundle" << "replay" << qSetFieldWidth(0) << "\n";
+    row("yaml parse (us)", recorded.value("yaml_parse_us"), replayed.value("yaml_parse_us"));
+    row("config load (us)", recorded.value("config_load_us"), replayed.value("config_load_us"));
+    row("snapshot load (us)", recorded.value("snapshot_load_us"), replayed.value("snapshot_load_us"));
+
+    // 検出は1回目（コールド）と2回目以降の中央値（ウォーム）を比較する
+    auto detection = [](const QJsonObject& trace, const QString& browser, bool cold) -> QJsonValue {
+        const QJsonArray runs = trace.value("detection").toArray();
+        QList<qint64> values;
+        for (int i = cold ? 0 : 1; i < (cold ? qMin(1, int(runs.size())) : int(runs.size())); ++i) {
+            const QJsonObject run = runs.at(i).toObject();
+            const QJsonValue value = browser.isEmpty()
+                ? run.value("total_us") : run.value("browsers").toObject().value(browser).toObject().value("us");
+            if (!value.isUndefined()) {
+                values << static_cast<qint64>(value.toDouble());
+            }
+        }
+        return values.isEmpty() ? QJsonValue() : QJsonValue(static_cast<double>(median(values)));
+    };
+    for (const bool cold : {true, false}) {
+        const QString phase = cold ? "cold" : "warm";
+        for (const QString& browser : {QString(), QString("firefox"), QString("chrome"), QString("chromium")}) {
+            const QString label = QString("detect %1 %2 (us)").arg(browser.isEmpty() ? "total" : browser, phase);
+            row(label, detection(recorded, browser, cold), detection(replayed, browser, cold));
+        }
+    }
+
+    for (const QString& picker : {QString("picker_cold"), QString("picker_warm")}) {
+        const QJsonObject result = replayed.value(picker).toObject();
+        if (result.isEmpty()) {
+            continue;
+        }
+        row(picker + " construct (us)", QJsonValue(), result.value("construct_us"));
+        row(picker + " shown (us)", QJsonValue(), result.value("shown_us"));
+        row(picker + " listed (us)", QJsonValue(), result.value("listed_us"));
+    }
+    return text;
+}
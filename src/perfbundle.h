@@ -0,0 +1,76 @@
+/**
+ * @file perfbundle.h
+ * @brief 検出の入力を匿名化して保存・再現する性能調査用バンドル
+ *
+ * 「ピッカーが遅い」という報告を手元で再現するため、検出が読み込むファイル
+ * （profiles.ini、installs.ini、Local State、プロファイルディレクトリの一覧と更新日時）、
+ * YAMLとrcの設定、環境変数から決まるパス、および起動時間の計測結果を1つのディレクトリに保存します。
+ *
+ * バンドルの構成:
+ * - manifest.json: 環境（パス・ファイルシステム・実行ファイル）とディレクトリ一覧
+ * - trace.json: 採取した環境での起動時間の計測結果
+ * - home/: 検出が内容を読むファイル（匿名化済み）
+ * - config/: rc と YAML の各層（ホームディレクトリは "@HOME@" に置換）
+ *
+ * プロファイル名・表示名・ホスト名などは、バンドルごとの乱数を鍵としたハッシュで
+ * 同じ長さの文字列に置き換えます。鍵は保存しないため、元の名前は復元できません。
+ */
+
+#ifndef PERFBUNDLE_H
+#define PERFBUNDLE_H
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+
+/**
+ * @class PerfBundle
+ * @brief 性能調査用バンドルの作成と再現
+ */
+class PerfBundle {
+public:
+    static constexpr int FORMAT_VERSION = 1;   ///< manifest.json の形式のバージョン
+    static constexpr int DETECTION_RUNS = 3;   ///< 計測する検出の回数（1回目はコールド）
+
+    /**
+     * @brief 現在の環境からバンドルを作成
+     * @param dir 出力先のディレクトリ（存在しない場合は作成、空である必要がある）
+     * @param error エラー内容の格納先（nullptr可）
+     * @return true: 成功
+     */
+    static bool exportTo(const QString& dir, QString* error = nullptr);
+
+    /**
+     * @brief バンドルの内容から偽のホームを作成し、環境変数をそこへ向ける
+     * @param bundleDir バンドルのディレクトリ
+     * @param root 偽のホームなどを作成するディレクトリ
+     * @param error エラー内容の格納先（nullptr可）
+     * @return true: 成功
+     * @note HOME、XDG_*、KDE_BROWSER_PICKER_YAML を変更します。ブラウザの実行ファイルは
+     *       何もしないスタブに置き換え、自動選択と先行起動は無効にします
+     */
+    static bool materialize(const QString& bundleDir, const QString& root, QString* error = nullptr);
+
+    /**
+     * @brief 現在の環境で設定の読み込みと検出の時間を計測
+     * @return trace.json と同じ形式の計測結果
+     */
+    static QJsonObject measureStartup();
+
+    /**
+     * @brief 文字列を同じ長さの推測できない文字列に置き換え
+     * @param text 元の文字列
+     * @param key バンドルごとの鍵
+     * @return 英小文字と数字からなる文字列（同じ鍵と文字列からは常に同じ結果）
+     */
+    static QString anonymize(const QString& text, const QByteArray& key);
+
+    /**
+     * @brief 採取した環境と再現した環境の計測結果を並べた表
+     * @param recorded バンドルの trace.json
+     * @param replayed 再現した環境での計測結果
+     */
+    static QString report(const QJsonObject& recorded, const QJsonObject& replayed);
+};
+
+#endif // PERFBUNDLE_H
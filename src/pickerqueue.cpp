@@ -0,0 +1,37 @@
+/**
+ * @file pickerqueue.cpp
+ * @brief PickerQueueクラスの実装
+ */
+
+#include "pickerqueue.h"
+
+PickerQueue::PickerQueue(QObject* parent)
+    : QObject(parent)
+{
+}
+
+void PickerQueue::enqueue(const QString& url)
+{
+    if (url == m_current || m_pending.contains(url)) {
+        return;
+    }
+    m_pending.append(url);
+    if (m_current.isEmpty()) {
+        showNext();
+    }
+}
+
+void PickerQueue::pickerClosed()
+{
+    m_current.clear();
+    showNext();
+}
+
+void PickerQueue::showNext()
+{
+    if (m_pending.isEmpty()) {
+        return;
+    }
+    m_current = m_pending.takeFirst();
+    emit showRequested(m_current);
+}
@@ -0,0 +1,69 @@
+/**
+ * @file pickerqueue.h
+ * @brief 常駐中のピッカーに表示するURLの順番待ち
+ *
+ * 常駐モードではピッカーを1つだけ作って再利用するため、表示中に次のURLが届くと
+ * setUrl() で上書きされてしまいます。届いたURLはここで順番に並べ、
+ * ピッカーが閉じられるたびに次のURLを表示させます。
+ */
+
+#ifndef PICKERQUEUE_H
+#define PICKERQUEUE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @class PickerQueue
+ * @brief ピッカーに表示するURLのキュー
+ */
+class PickerQueue : public QObject {
+    Q_OBJECT
+
+public:
+    explicit PickerQueue(QObject* parent = nullptr);
+    ~PickerQueue() override = default;
+
+    // コピーコンストラクタと代入演算子を削除
+    PickerQueue(const PickerQueue&) = delete;
+    PickerQueue& operator=(const PickerQueue&) = delete;
+
+    /**
+     * @brief 表示するURLを追加
+     * @param url 開くURL
+     * @note ピッカーが閉じていればすぐに showRequested() を発行し、表示中なら閉じられるまで待ちます。
+     *       表示中または待機中のURLと同じURLは追加しません
+     */
+    void enqueue(const QString& url);
+
+    /**
+     * @brief ピッカーが閉じられたときに呼び出す（待機中のURLがあれば次を表示）
+     */
+    void pickerClosed();
+
+    /**
+     * @brief 表示中のURL（ピッカーが閉じている場合は空）
+     */
+    QString current() const { return m_current; }
+
+    /**
+     * @brief 表示を待っているURL
+     */
+    QStringList pending() const { return m_pending; }
+
+signals:
+    /**
+     * @brief ピッカーにURLを表示させるシグナル
+     * @param url 開くURL
+     */
+    void showRequested(const QString& url);
+
+private:
+    void showNext();
+
+    QString m_current;       ///< 表示中のURL
+    QStringList m_pending;   ///< 表示を待っているURL（届いた順）
+};
+
+#endif // PICKERQUEUE_H
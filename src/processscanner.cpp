@@ -0,0 +1,391 @@
+/**
+ * @file processscanner.cpp
+ * @brief ProcessScannerクラスの実装
+ *
+ * 1000以上のプロセスがあるマシンでも数ミリ秒で終わるよう、
+ * 必要な /proc ファイルだけをPOSIX APIで直接読み取ります。
+ */
+
+#include "processscanner.h"
+
+#include <QFileInfo>
+#include <QMetaObject>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+/// /proc/<pid>/stat から取得する最小限の情報
+struct ProcEntry {
+    int pid = 0;
+    int ppid = 0;
+    std::string comm;
+    unsigned long long ticks = 0;   // utime + stime
+};
+
+/// 小さな /proc ファイルを丸ごと読み取る（上限付き）
+bool readProcFile(const std::string& path, std::string& out, size_t limit)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    out.clear();
+    char buf[4096];
+    while (out.size() < limit) {
+        const ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n <= 0) {
+            break;
+        }
+        out.append(buf, static_cast<size_t>(n));
+    }
+    ::close(fd);
+    return true;
+}
+
+/// "pid (comm) S ppid ..." 形式を解析。commは空白や括弧を含み得るため最後の ')' で区切る
+bool parseStat(const std::string& data, ProcEntry& entry)
+{
+    const size_t open = data.find('(');
+    const size_t close = data.rfind(')');
+    if (open == std::string::npos || close == std::string::npos || close < open) {
+        return false;
+    }
+    entry.comm = data.substr(open + 1, close - open - 1);
+
+    // ')' の後のフィールド: 0=state 1=ppid ... 11=utime 12=stime
+    int field = 0;
+    const char* p = data.c_str() + close + 1;
+    unsigned long long utime = 0;
+    while (*p && field <= 12) {
+        while (*p == ' ') ++p;
+        const char* start = p;
+        while (*p && *p != ' ') ++p;
+        if (field == 1) {
+            entry.ppid = std::atoi(start);
+        } else if (field == 11) {
+            utime = std::strtoull(start, nullptr, 10);
+        } else if (field == 12) {
+            entry.ticks = utime + std::strtoull(start, nullptr, 10);
+        }
+        ++field;
+    }
+    return field > 12;
+}
+
+/// NUL区切りのcmdlineを引数リストに分割
+std::vector<std::string> splitCmdline(const std::string& data)
+{
+    std::vector<std::string> args;
+    size_t start = 0;
+    while (start < data.size()) {
+        size_t end = data.find('\0', start);
+        if (end == std::string::npos) end = data.size();
+        args.emplace_back(data, start, end - start);
+        start = end + 1;
+    }
+    return args;
+}
+
+/// smaps_rollup の "Pss:" 行（kB）
+qint64 parsePssKiB(const std::string& data)
+{
+    const char* line = std::strstr(data.c_str(), "\nPss:");
+    if (!line) {
+        return 0;
+    }
+    return std::strtoll(line + 5, nullptr, 10);
+}
+
+std::string baseName(const std::string& path)
+{
+    const size_t slash = path.rfind('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+/// カーネルのcomm（最大15文字）に切り詰める
+std::string commOf(const std::string& name)
+{
+    return name.substr(0, 15);
+}
+
+/// "--key=value" または "--key value" 形式の値を取得
+bool findArg(const std::vector<std::string>& args, std::initializer_list<const char*> keys, std::string& value)
+{
+    for (size_t i = 1; i < args.size(); ++i) {
+        for (const char* key : keys) {
+            const size_t len = std::strlen(key);
+            if (args[i].compare(0, len, key) != 0) {
+                continue;
+            }
+            if (args[i].size() > len && args[i][len] == '=') {
+                value = args[i].substr(len + 1);
+                return true;
+            }
+            if (args[i].size() == len && i + 1 < args.size()) {
+                value = args[i + 1];
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool hasArgPrefix(const std::vector<std::string>& args, const char* prefix)
+{
+    const size_t len = std::strlen(prefix);
+    for (size_t i = 1; i < args.size(); ++i) {
+        if (args[i].compare(0, len, prefix) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool isChromiumFamily(Constants::BrowserType type)
+{
+    return type == Constants::BrowserType::Chrome || type == Constants::BrowserType::Chromium;
+}
+
+} // namespace
+
+ProcessScanner::ProcessScanner(QObject* parent)
+    : QObject(parent)
+    , m_scanInFlight(false)
+    , m_generation(0)
+    , m_procRoot(QStringLiteral("/proc"))
+{
+    m_pool.setMaxThreadCount(1);
+}
+
+ProcessScanner::~ProcessScanner()
+{
+    // 走査中のタスクが this を参照するため完了を待つ
+    m_pool.waitForDone();
+}
+
+void ProcessScanner::setTargets(const QList<Target>& targets)
+{
+    m_targets = targets;
+    m_cache.clear();
+    m_cacheAge.invalidate();
+    // 走査中の結果は古い対象のものなので、次の要求で新しい対象を走査する
+    ++m_generation;
+    m_scanInFlight = false;
+}
+
+void ProcessScanner::requestScan()
+{
+    if (m_cacheAge.isValid() && m_cacheAge.elapsed() < Constants::TELEMETRY_CACHE_MS) {
+        const UsageMap cached = m_cache;
+        QMetaObject::invokeMethod(this, [this, cached]() { emit usageUpdated(cached); },
+                                  Qt::QueuedConnection);
+        return;
+    }
+
+    if (m_scanInFlight || m_targets.isEmpty()) {
+        return;
+    }
+
+    m_scanInFlight = true;
+    const QList<Target> targets = m_targets;
+    const quint64 generation = m_generation;
+    const QString procRoot = m_procRoot;
+    m_pool.start([this, targets, generation, procRoot]() {
+        const UsageMap result = scan(targets, procRoot);
+        QMetaObject::invokeMethod(this, [this, result, generation]() {
+            if (generation != m_generation) {
+                return;
+            }
+            m_scanInFlight = false;
+            m_cache = result;
+            m_cacheAge.start();
+            emit usageUpdated(result);
+        }, Qt::QueuedConnection);
+    });
+}
+
+ProcessScanner::UsageMap ProcessScanner::lastUsage() const
+{
+    return m_cache;
+}
+
+ProcessScanner::UsageMap ProcessScanner::scan(const QList<Target>& targets, const QString& procRoot)
+{
+    UsageMap result;
+    if (targets.isEmpty()) {
+        return result;
+    }
+
+    // ルート候補となるプロセスのcomm
+    std::unordered_set<std::string> firefoxComms = {"firefox", "firefox-bin", "firefox-esr"};
+    std::unordered_set<std::string> chromiumComms = {"chrome", "chromium", "chromium-browse"};
+    for (const Target& t : targets) {
+        const std::string comm = commOf(baseName(t.executable.toStdString()));
+        if (t.type == Constants::BrowserType::Firefox) firefoxComms.insert(comm);
+        else if (isChromiumFamily(t.type)) chromiumComms.insert(comm);
+    }
+
+    const std::string root = procRoot.toStdString();
+    DIR* dir = ::opendir(root.c_str());
+    if (!dir) {
+        return result;
+    }
+
+    // 1. 全プロセスの stat のみを読む
+    std::unordered_map<int, ProcEntry> procs;
+    std::unordered_map<int, std::vector<int>> children;
+    std::vector<int> candidates;
+    std::string buf;
+    buf.reserve(4096);
+    while (dirent* ent = ::readdir(dir)) {
+        if (ent->d_name[0] < '1' || ent->d_name[0] > '9') {
+            continue;
+        }
+        ProcEntry entry;
+        entry.pid = std::atoi(ent->d_name);
+        if (!readProcFile(root + "/" + ent->d_name + "/stat", buf, 1024) || !parseStat(buf, entry)) {
+            continue;
+        }
+        children[entry.ppid].push_back(entry.pid);
+        if (firefoxComms.count(entry.comm) || chromiumComms.count(entry.comm)) {
+            candidates.push_back(entry.pid);
+        }
+        procs.emplace(entry.pid, std::move(entry));
+    }
+    ::closedir(dir);
+
+    // 2. 候補の cmdline のみを読み、ルートプロセスとプロファイルを特定
+    std::unordered_map<int, QString> roots;  // pid -> usageKey
+    for (int pid : candidates) {
+        const ProcEntry& proc = procs[pid];
+        // 親も同じブラウザのプロセスなら子プロセス（ルートではない）
+        auto parent = procs.find(proc.ppid);
+        if (parent != procs.end() && parent->second.comm == proc.comm) {
+            continue;
+        }
+        if (!readProcFile(root + "/" + std::to_string(pid) + "/cmdline", buf, 65536)) {
+            continue;
+        }
+        const std::vector<std::string> args = splitCmdline(buf);
+        if (args.empty()) {
+            continue;
+        }
+
+        const bool isFirefox = firefoxComms.count(proc.comm) > 0;
+        QString key;
+        if (isFirefox) {
+            if (hasArgPrefix(args, "-contentproc")) {
+                continue;
+            }
+            std::string value;
+            const bool byName = findArg(args, {"-P", "--P", "-p"}, value);
+            const bool byPath = !byName && findArg(args, {"--profile", "-profile"}, value);
+            for (const Target& t : targets) {
+                if (t.type != Constants::BrowserType::Firefox) continue;
+                const bool match = byName ? t.profileId == QString::fromStdString(value)
+                                 : byPath ? QFileInfo(t.profilePath).canonicalFilePath()
+                                                == QFileInfo(QString::fromStdString(value)).canonicalFilePath()
+                                 : t.isDefault;
+                if (match) {
+                    key = usageKey(t.browser, t.profileId);
+                    break;
+                }
+            }
+        } else {
+            if (hasArgPrefix(args, "--type=")) {
+                continue;
+            }
+            std::string dataDir;
+            std::string profileDir;
+            const bool hasDataDir = findArg(args, {"--user-data-dir"}, dataDir);
+            const bool hasProfileDir = findArg(args, {"--profile-directory"}, profileDir);
+            const bool looksChromium = args[0].find("chromium") != std::string::npos;
+            for (const Target& t : targets) {
+                if (!isChromiumFamily(t.type)) continue;
+                const bool sameInstance = hasDataDir
+                    ? QFileInfo(QString::fromStdString(dataDir)).canonicalFilePath()
+                          == QFileInfo(t.dataDir).canonicalFilePath()
+                    : (t.type == Constants::BrowserType::Chromium) == looksChromium;
+                if (!sameInstance) continue;
+                if (hasProfileDir) {
+                    if (t.profilePath != QString::fromStdString(profileDir)) continue;
+                    key = usageKey(t.browser, t.profileId);
+                } else {
+                    key = usageKey(t.browser, QString());
+                }
+                break;
+            }
+        }
+
+        if (!key.isEmpty()) {
+            roots.emplace(pid, key);
+        }
+    }
+
+    // 3. ルートの子孫のみ smaps_rollup を読み集計
+    static const long ticksPerSecond = ::sysconf(_SC_CLK_TCK);
+    for (const auto& [rootPid, key] : roots) {
+        Usage& usage = result[key];
+        std::vector<int> stack = {rootPid};
+        while (!stack.empty()) {
+            const int pid = stack.back();
+            stack.pop_back();
+
+            const ProcEntry& proc = procs[pid];
+            usage.processCount++;
+            usage.cpuMs += static_cast<qint64>(proc.ticks * 1000 / static_cast<unsigned long long>(ticksPerSecond));
+            if (readProcFile(root + "/" + std::to_string(pid) + "/smaps_rollup", buf, 4096)) {
+                usage.pssKiB += parsePssKiB(buf);
+            }
+
+            auto it = children.find(pid);
+            if (it != children.end()) {
+                stack.insert(stack.end(), it->second.begin(), it->second.end());
+            }
+        }
+    }
+
+    return result;
+}
+
+QString ProcessScanner::usageKey(const QString& browser, const QString& profileId)
+{
+    return browser + QLatin1Char('/') + profileId;
+}
+
+QString ProcessScanner::formatUsage(const Usage& usage)
+{
+    if (usage.processCount == 0) {
+        return QString();
+    }
+
+    QString memory;
+    if (usage.pssKiB >= 1024 * 1024) {
+        memory = QString::number(static_cast<double>(usage.pssKiB) / (1024.0 * 1024.0), 'f', 1) + " GB";
+    } else {
+        memory = QString::number(usage.pssKiB / 1024) + " MB";
+    }
+
+    const qint64 seconds = usage.cpuMs / 1000;
+    QString cpu;
+    if (seconds >= 3600) {
+        cpu = QString::number(seconds / 3600) + "h";
+    } else if (seconds >= 60) {
+        cpu = QString::number(seconds / 60) + "m";
+    } else {
+        cpu = QString::number(seconds) + "s";
+    }
+
+    return memory + QString::fromUtf8(" · ") + cpu + " CPU";
+}
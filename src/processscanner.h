@@ -0,0 +1,139 @@
+/**
+ * @file processscanner.h
+ * @brief 起動中のブラウザインスタンスのリソース使用量の取得
+ *
+ * /proc を走査してブラウザのプロセスをプロファイルごとにグループ化し、
+ * プロセスツリー全体のPSS（smaps_rollup）とCPU時間を集計します。
+ * 走査はGUIスレッド外で行い、結果は短時間キャッシュされます。
+ */
+
+#ifndef PROCESSSCANNER_H
+#define PROCESSSCANNER_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QThreadPool>
+
+#include "constants.h"
+
+/**
+ * @class ProcessScanner
+ * @brief ブラウザプロセスのリソース使用量スキャナ
+ *
+ * 走査の手順:
+ * 1. 全プロセスの /proc/<pid>/stat のみを読み、comm・親PID・CPU時間を取得
+ * 2. commがブラウザ実行ファイル名に一致するプロセスのみ cmdline を読み、
+ *    "-P" / "--profile" / "--profile-directory" / "--user-data-dir" からルートを特定
+ * 3. ルートの子孫プロセスのみ smaps_rollup を読み、PSSを合計
+ *
+ * @note Chrome/Chromiumは1つのインスタンスで複数プロファイルを扱うため、
+ *       "--profile-directory" のないインスタンスはブラウザ単位（profileIdが空）で集計されます
+ */
+class ProcessScanner : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @struct Target
+     * @brief 集計対象のプロファイル
+     */
+    struct Target {
+        QString browser;                ///< ブラウザID
+        QString profileId;              ///< プロファイルID
+        QString profilePath;            ///< プロファイルディレクトリ（Firefoxは絶対パス、Chromiumはディレクトリ名）
+        QString dataDir;                ///< Chrome/Chromiumのユーザーデータディレクトリ
+        QString executable;             ///< 実行ファイルのパス
+        Constants::BrowserType type;    ///< ブラウザの種類
+        bool isDefault;                 ///< デフォルトプロファイルかどうか
+
+        Target() : type(Constants::BrowserType::Unknown), isDefault(false) {}
+    };
+
+    /**
+     * @struct Usage
+     * @brief プロファイル（またはインスタンス）ごとの集計結果
+     */
+    struct Usage {
+        qint64 pssKiB;       ///< PSSの合計（KiB）
+        qint64 cpuMs;        ///< CPU時間の合計（ミリ秒、user+system）
+        int processCount;    ///< プロセス数
+
+        Usage() : pssKiB(0), cpuMs(0), processCount(0) {}
+    };
+
+    /// キー: usageKey(browser, profileId)
+    using UsageMap = QHash<QString, Usage>;
+
+    explicit ProcessScanner(QObject* parent = nullptr);
+    ~ProcessScanner() override;
+
+    // コピーコンストラクタと代入演算子を削除
+    ProcessScanner(const ProcessScanner&) = delete;
+    ProcessScanner& operator=(const ProcessScanner&) = delete;
+
+    /**
+     * @brief 集計対象を設定
+     * @param targets 対象のプロファイルリスト
+     * @note 対象が変わるとキャッシュは破棄され、走査中の結果も通知せずに捨てられます
+     */
+    void setTargets(const QList<Target>& targets);
+
+    /**
+     * @brief requestScan() が走査するprocファイルシステムのルートを設定（テスト用）
+     * @param procRoot ルートのパス（既定: "/proc"）
+     */
+    void setProcRoot(const QString& procRoot) { m_procRoot = procRoot; }
+
+    /**
+     * @brief 非同期に走査を要求
+     * @note キャッシュが有効な間は走査せずにキャッシュを通知します。
+     *       結果は常にGUIスレッドで usageUpdated() として通知されます
+     */
+    void requestScan();
+
+    /**
+     * @brief 直近の集計結果を取得
+     */
+    UsageMap lastUsage() const;
+
+    /**
+     * @brief 同期的に走査（テスト・ワーカースレッド用）
+     * @param targets 対象のプロファイルリスト
+     * @param procRoot procファイルシステムのルート（テストでは偽のディレクトリ）
+     * @return 集計結果
+     */
+    static UsageMap scan(const QList<Target>& targets, const QString& procRoot = QStringLiteral("/proc"));
+
+    /**
+     * @brief 集計結果のキーを作成
+     * @param browser ブラウザID
+     * @param profileId プロファイルID（インスタンス単位の場合は空）
+     */
+    static QString usageKey(const QString& browser, const QString& profileId);
+
+    /**
+     * @brief 行に表示する簡潔な文字列に整形（例: "1.2 GB · 3m CPU"）
+     */
+    static QString formatUsage(const Usage& usage);
+
+signals:
+    /**
+     * @brief 集計結果が更新されたときに発行されるシグナル
+     * @param usage 集計結果
+     */
+    void usageUpdated(const ProcessScanner::UsageMap& usage);
+
+private:
+    QList<Target> m_targets;         ///< 集計対象
+    UsageMap m_cache;                ///< 直近の集計結果
+    QElapsedTimer m_cacheAge;        ///< キャッシュの経過時間
+    bool m_scanInFlight;             ///< 現在の対象の走査中かどうか
+    quint64 m_generation;            ///< 対象の世代（setTargets() ごとに増やし、古い走査の結果を捨てる）
+    QString m_procRoot;              ///< 走査するprocファイルシステムのルート
+    QThreadPool m_pool;              ///< 走査用のワーカー（1スレッド）
+};
+
+#endif // PROCESSSCANNER_H
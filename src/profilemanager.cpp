@@ -11,6 +11,8 @@
 #include "configmanager.h"
 
 #include <QDebug>
+#include <QStandardPaths>
+#include <QUrl>
 #include <algorithm>
 
 ProfileManager::ProfileManager(ConfigManager* configManager, QObject* parent)
@@ -21,12 +23,19 @@ ProfileManager::ProfileManager(ConfigManager* configManager, QObject* parent)
     // YAMLによる実行パス上書きを反映
     m_browserDetector->setExecutableOverrides(m_configManager->browserExecutableOverrides());
     m_browserDetector->setEnabledOverrides(m_configManager->browserEnabledOverrides());
+    m_browserDetector->setLaunchTemplates(m_configManager->launchTemplates());
+
+    // 次回の起動時に検出を待たずに一覧を表示するための前回の検出結果
+    m_browserDetector->setSnapshotPath(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) +
+                                       "/kde-browser-picker/profiles.json");
 
     // ブラウザ検出シグナルの接続
     connect(m_browserDetector.get(), &BrowserDetector::browserDetected,
             this, &ProfileManager::onBrowserDetected);
     connect(m_browserDetector.get(), &BrowserDetector::launchError,
             this, &ProfileManager::onLaunchError);
+    connect(m_browserDetector.get(), &BrowserDetector::detectionFinished,
+            this, &ProfileManager::onDetectionFinished);
             
     // 設定管理シグナルの接続
     connect(m_configManager, &ConfigManager::profileSettingsChanged,
@@ -34,11 +43,47 @@ ProfileManager::ProfileManager(ConfigManager* configManager, QObject* parent)
 }
 
 void ProfileManager::refreshProfiles()
+{
+    // 全てのブラウザとそのプロファイルを検出
+    m_detectionInterrupted = false;
+    rebuildProfiles(m_browserDetector->detectBrowsers());
+}
+
+void ProfileManager::startRefresh()
+{
+    // 前回の検出結果があれば即座に表示し、検出の完了後に置き換える
+    if (m_browserDetector->loadSnapshot()) {
+        rebuildProfiles(m_browserDetector->cachedBrowsers());
+    }
+    m_detectionInterrupted = false;
+    m_browserDetector->startDetection();
+}
+
+bool ProfileManager::isRefreshing() const
+{
+    return m_browserDetector->isDetecting();
+}
+
+bool ProfileManager::resumeInterruptedDetection()
+{
+    if (!m_detectionInterrupted || m_browserDetector->isDetecting()) {
+        return false;
+    }
+    m_detectionInterrupted = false;
+    m_browserDetector->startDetection();
+    return true;
+}
+
+void ProfileManager::onDetectionFinished()
+{
+    rebuildProfiles(m_browserDetector->cachedBrowsers());
+}
+
+void ProfileManager::rebuildProfiles(const QMap<QString, BrowserDetector::BrowserInfo>& browsers)
 {
     m_profiles.clear();
     
-    // 全てのブラウザとそのプロファイルを検出
-    auto browsers = m_browserDetector->detectBrowsers();
+    const bool underPressure = isUnderMemoryPressure();
     
     for (auto it = browsers.begin(); it != browsers.end(); ++it) {
         const QString& browserId = it.key();
@@ -55,8 +100,12 @@ void ProfileManager::refreshProfiles()
             entry.profileId = profileId;
             entry.profileDisplayName = profileInfo.displayName;
             entry.iconPath = browserInfo.iconPath;
+            entry.avatarPath = profileInfo.avatarPath;
             entry.lastUsed = profileInfo.lastUsed;
             entry.isDefault = profileInfo.isDefault;
+            entry.isRunning = m_browserDetector->isProfileRunning(browserId, profileId);
+            entry.coldStartWarning = underPressure && !entry.isRunning;
+            entry.supportsContainers = browserInfo.type == Constants::BrowserType::Firefox;
             
             // 設定から設定情報を読み込み
             updateProfileFromConfig(entry);
@@ -124,38 +173,220 @@ bool ProfileManager::hasProfile(const QString& browser, const QString& profileId
 }
 
 ProfileManager::ProfileEntry ProfileManager::getDefaultProfile() const
+{
+    QList<ProfileEntry> profiles = m_profiles;
+    const bool underPressure = isUnderMemoryPressure();
+    if (underPressure) {
+        // タイムアウト時点の起動状態を反映する
+        for (ProfileEntry& entry : profiles) {
+            entry.isRunning = m_browserDetector->isProfileRunning(entry.browser, entry.profileId);
+        }
+    }
+    
+    return selectDefaultProfile(profiles, m_configManager->getLastUsed(), underPressure);
+}
+
+ProfileManager::ProfileEntry ProfileManager::resolveTarget(const QString& url, bool* fromHost) const
+{
+    if (fromHost) {
+        *fromHost = false;
+    }
+
+    const auto hostTarget = m_configManager->getLastUsedForHost(QUrl(url).host());
+    if (!hostTarget.first.isEmpty()) {
+        for (const ProfileEntry& entry : m_profiles) {
+            if (entry.isEnabled && entry.browser == hostTarget.first && entry.profileId == hostTarget.second) {
+                if (fromHost) {
+                    *fromHost = true;
+                }
+                return entry;
+            }
+        }
+    }
+
+    return getDefaultProfile();
+}
+
+QList<ProfileManager::ProfileEntry> ProfileManager::recentProfiles(int count) const
+{
+    QList<ProfileEntry> recent = selectRecentProfiles(m_profiles, [this](const ProfileEntry& entry) {
+        return m_configManager->frecencyScore(entry.browser, entry.profileId);
+    }, count);
+    
+    if (recent.isEmpty() && count > 0) {
+        const ProfileEntry fallback = getDefaultProfile();
+        if (!fallback.browser.isEmpty()) {
+            recent.append(fallback);
+        }
+    }
+    return recent;
+}
+
+QList<ProfileManager::ProfileEntry> ProfileManager::selectRecentProfiles(
+    const QList<ProfileEntry>& profiles, const std::function<double(const ProfileEntry&)>& score, int count)
+{
+    QList<QPair<double, ProfileEntry>> scored;
+    for (const ProfileEntry& entry : profiles) {
+        const double value = entry.isEnabled ? score(entry) : 0.0;
+        if (value > 0.0) {
+            scored.append(qMakePair(value, entry));
+        }
+    }
+    
+    // 安定ソートで一覧の順を保つ
+    std::stable_sort(scored.begin(), scored.end(), [](const auto& a, const auto& b) {
+        if (a.first != b.first) {
+            return a.first > b.first;
+        }
+        return a.second.lastUsed > b.second.lastUsed;
+    });
+    
+    QList<ProfileEntry> result;
+    for (int i = 0; i < scored.size() && i < count; ++i) {
+        result.append(scored[i].second);
+    }
+    return result;
+}
+
+ProfileManager::ProfileEntry ProfileManager::selectDefaultProfile(const QList<ProfileEntry>& profiles,
+                                                                  const QPair<QString, QString>& lastUsed,
+                                                                  bool underPressure)
 {
     // First, check if we have a last used profile
-    QPair<QString, QString> lastUsed = m_configManager->getLastUsed();
+    const ProfileEntry* lastUsedEntry = nullptr;
     if (!lastUsed.first.isEmpty() && !lastUsed.second.isEmpty()) {
-        ProfileEntry entry = getProfile(lastUsed.first, lastUsed.second);
-        if (!entry.browser.isEmpty() && entry.isEnabled) {
-            return entry;
+        for (const ProfileEntry& entry : profiles) {
+            if (entry.isEnabled && entry.browser == lastUsed.first && entry.profileId == lastUsed.second) {
+                lastUsedEntry = &entry;
+                break;
+            }
+        }
+    }
+    
+    if (underPressure && !(lastUsedEntry && lastUsedEntry->isRunning)) {
+        // メモリ逼迫中: コールドスタートを避けるため起動済みのプロファイルを優先
+        // 最後に使用したブラウザと同じブラウザのものを先に探す
+        if (lastUsedEntry) {
+            for (const ProfileEntry& entry : profiles) {
+                if (entry.isEnabled && entry.isRunning && entry.browser == lastUsedEntry->browser) {
+                    return entry;
+                }
+            }
         }
+        for (const ProfileEntry& entry : profiles) {
+            if (entry.isEnabled && entry.isRunning) {
+                return entry;
+            }
+        }
+        // 起動済みのものがなければ通常の選択に戻る
+    }
+    
+    if (lastUsedEntry) {
+        return *lastUsedEntry;
     }
     
     // Otherwise, return the first enabled profile
-    QList<ProfileEntry> enabled = getAllProfiles(true);
-    if (!enabled.isEmpty()) {
-        return enabled.first();
+    for (const ProfileEntry& entry : profiles) {
+        if (entry.isEnabled) {
+            return entry;
+        }
     }
     
     // No enabled profiles
     return ProfileEntry();
 }
 
+QList<BrowserDetector::ContainerInfo> ProfileManager::containersForProfile(const QString& browser,
+                                                                          const QString& profileId)
+{
+    auto it = std::find_if(m_profiles.begin(), m_profiles.end(),
+                          [&](const ProfileEntry& entry) {
+                              return entry.browser == browser && entry.profileId == profileId;
+                          });
+    
+    if (it == m_profiles.end() || !it->supportsContainers) {
+        return {};
+    }
+    
+    if (!it->containersLoaded) {
+        it->containers = m_browserDetector->detectContainers(browser, profileId);
+        it->containersLoaded = true;
+    }
+    
+    return it->containers;
+}
+
+void ProfileManager::releaseCaches()
+{
+    for (ProfileEntry& entry : m_profiles) {
+        if (entry.containersLoaded) {
+            entry.containers = QList<BrowserDetector::ContainerInfo>();
+            entry.containersLoaded = false;
+        }
+    }
+}
+
+bool ProfileManager::isUnderMemoryPressure() const
+{
+    return m_memoryPressure.isUnderPressure(m_configManager->memoryPressurePolicy());
+}
+
+void ProfileManager::setMemoryPressureSource(MemoryPressure::Source source)
+{
+    m_memoryPressure.setSource(std::move(source));
+}
+
+QList<ProcessScanner::Target> ProfileManager::processScanTargets() const
+{
+    QList<ProcessScanner::Target> targets;
+    
+    const auto browsers = m_browserDetector->cachedBrowsers();
+    for (auto it = browsers.begin(); it != browsers.end(); ++it) {
+        for (auto profIt = it->profiles.begin(); profIt != it->profiles.end(); ++profIt) {
+            ProcessScanner::Target target;
+            target.browser = it.key();
+            target.profileId = profIt.key();
+            target.executable = it->executable;
+            target.type = it->type;
+            target.isDefault = profIt->isDefault;
+            target.dataDir = m_browserDetector->userDataDirectory(it.key());
+            target.profilePath = it->type == Constants::BrowserType::Firefox
+                ? m_browserDetector->profileDirectory(it.key(), profIt.key())
+                : profIt->path;
+            targets.append(target);
+        }
+    }
+    
+    return targets;
+}
+
 bool ProfileManager::launchProfile(const ProfileEntry& profile, const QString& url)
 {
     return launchProfile(profile.browser, profile.profileId, url);
 }
 
-bool ProfileManager::launchProfile(const QString& browser, const QString& profileId, const QString& url)
+bool ProfileManager::launchProfile(const QString& browser, const QString& profileId, const QString& url,
+                                   const QString& container)
 {
-    bool success = m_browserDetector->launchBrowser(browser, profileId, url);
+    // 検出中の選択は残りの検出を待たず、選択されたプロファイルだけを確認して起動する
+    const bool wasDetecting = m_browserDetector->isDetecting();
+    m_browserDetector->cancelDetection();
+    m_browserDetector->resolveProfile(browser, profileId);
+    
+    bool success = m_browserDetector->launchBrowser(browser, profileId, url, container);
+    
+    if (!success && wasDetecting) {
+        // ピッカーは開いたままなので一覧の更新を続ける
+        m_browserDetector->startDetection();
+    }
     
     if (success) {
+        // 一覧は中断時点のまま。プロセスが残る場合は resumeInterruptedDetection() で続ける
+        m_detectionInterrupted = m_detectionInterrupted || wasDetecting;
+        
         // Update last used
         m_configManager->setLastUsed(browser, profileId);
+        m_configManager->recordLaunch(browser, profileId, QUrl(url).host());
         emit profileLaunched(browser, profileId);
     }
     
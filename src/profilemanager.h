@@ -13,9 +13,12 @@
 #include <QObject>
 #include <QString>
 #include <QList>
+#include <functional>
 #include <memory>
 
 #include "browserdetector.h"
+#include "memorypressure.h"
+#include "processscanner.h"
 
 // Forward declarations
 class ConfigManager;
@@ -51,14 +54,24 @@ public:
         QString profileId;            ///< プロファイルID
         QString profileDisplayName;   ///< プロファイルの表示名（カスタマイズ可能）
         QString iconPath;             ///< アイコンファイルのパス
+        QString avatarPath;           ///< プロファイルのアバター画像のパス（非同期に読み込む）
         QDateTime lastUsed;           ///< 最終使用日時
         bool isEnabled;               ///< 有効/無効状態
         bool isDefault;               ///< デフォルトプロファイルかどうか
+        bool isRunning;               ///< ブラウザが起動中かどうか
+        bool coldStartWarning;        ///< メモリ逼迫中にコールドスタートが必要かどうか
+        bool supportsContainers;      ///< コンテナをサブターゲットとして持てるか（Firefox）
+        bool containersLoaded;        ///< containers を読み込み済みか
+        QList<BrowserDetector::ContainerInfo> containers; ///< コンテナ（展開時に遅延読み込み）
         int order;                    ///< 表示順序
         
         ProfileEntry() 
             : isEnabled(true)
             , isDefault(false)
+            , isRunning(false)
+            , coldStartWarning(false)
+            , supportsContainers(false)
+            , containersLoaded(false)
             , order(999) {}
             
         /**
@@ -89,6 +102,26 @@ public:
      * @brief システムからプロファイル情報を再検出
      */
     void refreshProfiles();
+
+    /**
+     * @brief プロファイルの再検出をバックグラウンドで開始
+     * @note 前回の検出結果（スナップショット）があれば先に profilesRefreshed() で通知し、
+     *       検出の完了後に最新の一覧で再度通知します
+     */
+    void startRefresh();
+
+    /**
+     * @brief バックグラウンドの検出が実行中かどうか
+     */
+    bool isRefreshing() const;
+
+    /**
+     * @brief 起動のために中断したバックグラウンドの検出を再開
+     * @return true: 中断していた検出を開始し直した
+     * @note 検出中の launchProfile() は残りの検出を中断します。起動後もプロセスが残る
+     *       常駐のピッカーやトレイは、一覧を次に使う前に呼び出して検出を完了させます
+     */
+    bool resumeInterruptedDetection();
     
     // プロファイルの取得
     /**
@@ -125,8 +158,86 @@ public:
     /**
      * @brief デフォルトプロファイルを取得
      * @return 最後に使用されたまたは最初の有効なプロファイル
+     * @note メモリ逼迫時は起動済みのブラウザのプロファイルを優先します
      */
     ProfileEntry getDefaultProfile() const;
+
+    /**
+     * @brief URLを開くプロファイルを決定
+     * @param url 開くURL
+     * @param fromHost ホストの履歴で決まった場合に true を設定（nullptr可）
+     * @return 前回このホストを開いた有効なプロファイル、なければ getDefaultProfile()
+     *         （有効なプロファイルがなければ空のエントリ）
+     * @note ピッカーの初期選択とタイムアウト時の自動選択、--explain、C API が共通で使用します
+     */
+    ProfileEntry resolveTarget(const QString& url, bool* fromHost = nullptr) const;
+
+    /**
+     * @brief デフォルトプロファイルの選択ロジック
+     * @param profiles ソート済みのプロファイルリスト
+     * @param lastUsed 最後に使用したブラウザとプロファイルのペア
+     * @param underPressure メモリ逼迫中かどうか
+     * @return 選択されたプロファイル（有効なものがなければ空のエントリ）
+     * @note 逼迫中は、最後に使用したプロファイルが未起動であれば、
+     *       同じブラウザ、次いで任意の起動済みプロファイルを優先します
+     */
+    static ProfileEntry selectDefaultProfile(const QList<ProfileEntry>& profiles,
+                                             const QPair<QString, QString>& lastUsed,
+                                             bool underPressure);
+
+    /**
+     * @brief よく使うプロファイルを取得（トレイのクイック起動用）
+     * @param count 最大件数
+     * @return frecencyの高い順の有効なプロファイル
+     * @note 起動履歴がない場合はデフォルトプロファイルのみを返します
+     */
+    QList<ProfileEntry> recentProfiles(int count) const;
+
+    /**
+     * @brief よく使うプロファイルの選択ロジック
+     * @param profiles ソート済みのプロファイルリスト
+     * @param score プロファイルのfrecencyスコア
+     * @param count 最大件数
+     * @return スコアが正の有効なプロファイル（高い順、同点は最終使用日時の新しい順、次いで一覧の順）
+     */
+    static QList<ProfileEntry> selectRecentProfiles(const QList<ProfileEntry>& profiles,
+                                                    const std::function<double(const ProfileEntry&)>& score,
+                                                    int count);
+
+    /**
+     * @brief プロファイルのコンテナ（サブターゲット）を取得
+     * @param browser ブラウザID
+     * @param profileId プロファイルID
+     * @return コンテナのリスト
+     * @note 初回呼び出し時に containers.json を読み込み、以降はキャッシュを返します。
+     *       refreshProfiles() でキャッシュは破棄されます
+     */
+    QList<BrowserDetector::ContainerInfo> containersForProfile(const QString& browser,
+                                                               const QString& profileId);
+
+    /**
+     * @brief 読み込み済みのコンテナを破棄（非表示のまま常駐しているときのメモリ解放用）
+     * @note プロファイル一覧は残し、コンテナは次に展開したときに読み直します
+     */
+    void releaseCaches();
+
+    /**
+     * @brief 現在メモリ逼迫中かどうかを判定
+     * @return true: YAMLのしきい値を超えている
+     */
+    bool isUnderMemoryPressure() const;
+
+    /**
+     * @brief PSIの読み取り元を差し替え（テスト用）
+     * @param source PSIテキストを返す関数（空の場合は /proc/pressure/memory）
+     */
+    void setMemoryPressureSource(MemoryPressure::Source source);
+
+    /**
+     * @brief リソース使用量の集計対象を作成
+     * @return 検出済みの全プロファイルの集計対象
+     */
+    QList<ProcessScanner::Target> processScanTargets() const;
     
     // プロファイルの起動
     /**
@@ -142,9 +253,13 @@ public:
      * @param browser ブラウザID
      * @param profileId プロファイルID
      * @param url 開くURL
+     * @param container Firefoxのコンテナ名（空の場合はコンテナを使用しない）
      * @return true: 起動成功, false: 起動失敗
+     * @note バックグラウンドの検出中に呼び出された場合は検出を中断し、
+     *       このプロファイルのみを確認して直ちに起動します
      */
-    bool launchProfile(const QString& browser, const QString& profileId, const QString& url);
+    bool launchProfile(const QString& browser, const QString& profileId, const QString& url,
+                       const QString& container = QString());
     
     // プロファイル設定の更新
     /**
@@ -231,7 +346,18 @@ private slots:
      */
     void onLaunchError(const QString& error);
 
+    /**
+     * @brief バックグラウンドの検出が完了したときの処理
+     */
+    void onDetectionFinished();
+
 private:
+    /**
+     * @brief 検出結果からプロファイルエントリを作り直す
+     * @param browsers ブラウザIDからBrowserInfoへのマップ
+     */
+    void rebuildProfiles(const QMap<QString, BrowserDetector::BrowserInfo>& browsers);
+    
     /**
      * @brief 設定からプロファイル情報を更新
      * @param entry 更新するプロファイルエントリ
@@ -247,8 +373,11 @@ private:
     std::unique_ptr<BrowserDetector> m_browserDetector;  ///< ブラウザ検出オブジェクト
     ConfigManager* m_configManager;                      ///< 設定管理オブジェクト（非所有）
     
+    MemoryPressure m_memoryPressure;                     ///< メモリ逼迫度の読み取り
+    
     QList<ProfileEntry> m_profiles;                      ///< プロファイルエントリのリスト
     mutable QDateTime m_lastRefresh;                     ///< 最後に更新した日時
+    bool m_detectionInterrupted = false;                 ///< 起動のために検出を中断したまま
 };
 
 #endif // PROFILEMANAGER_H
\ No newline at end of file
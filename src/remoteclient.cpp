@@ -0,0 +1,339 @@
+/**
+ * @file remoteclient.cpp
+ * @brief RemoteClientクラスの実装
+ */
+
+#include "remoteclient.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int REPLY_TIMEOUT_MS = 10000;
+
+std::string environment(const char* name)
+{
+    const char* value = std::getenv(name);
+    return value ? std::string(value) : std::string();
+}
+
+std::string_view trimmed(std::string_view text)
+{
+    const auto first = text.find_first_not_of(" \t\r\n");
+    if (first == std::string_view::npos) {
+        return std::string_view();
+    }
+    const auto last = text.find_last_not_of(" \t\r\n");
+    return text.substr(first, last - first + 1);
+}
+
+/**
+ * @brief EINTRを考慮して全データを送信（切断時に SIGPIPE を発生させない）
+ */
+bool sendAll(int fd, const char* data, size_t size)
+{
+    while (size > 0) {
+        const ssize_t sent = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+std::string statusText(RemoteProtocol::Status status)
+{
+    switch (status) {
+    case RemoteProtocol::Status::Accepted:
+        return "accepted";
+    case RemoteProtocol::Status::Rejected:
+        return "rejected";
+    case RemoteProtocol::Status::Unauthorized:
+        return "unauthorized";
+    case RemoteProtocol::Status::ProtocolError:
+        break;
+    }
+    return "protocol error";
+}
+
+void printUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " --remote-client [--socket PATH] [--token-file PATH] [URL...]\n"
+              << "Sends URLs to the picker on the local desktop through a socket forwarded with ssh -R.\n"
+              << "URLs are read from standard input (one per line) when none are given.\n"
+              << "Default socket: " << RemoteClient::defaultSocketPath() << "\n"
+              << "Default token file: " << RemoteClient::defaultTokenPath() << "\n";
+}
+
+} // namespace
+
+std::string RemoteClient::defaultSocketPath()
+{
+    const std::string overridden = environment("KBP_REMOTE_SOCKET");
+    if (!overridden.empty()) {
+        return overridden;
+    }
+    const std::string runtimeDir = environment("XDG_RUNTIME_DIR");
+    if (!runtimeDir.empty()) {
+        return runtimeDir + "/kde-browser-picker-remote.sock";
+    }
+    return "/tmp/kde-browser-picker-remote-" + std::to_string(::getuid()) + ".sock";
+}
+
+std::string RemoteClient::defaultTokenPath()
+{
+    const std::string overridden = environment("KBP_REMOTE_TOKEN_FILE");
+    if (!overridden.empty()) {
+        return overridden;
+    }
+    std::string configDir = environment("XDG_CONFIG_HOME");
+    if (configDir.empty()) {
+        configDir = environment("HOME") + "/.config";
+    }
+    return configDir + "/kde-browser-picker/remote-token";
+}
+
+bool RemoteClient::readToken(const std::string& path, std::string* token, std::string* error)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        *error = "cannot open token file " + path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    // ssh の鍵と同じく、所有者以外が読めるトークンは使わない
+    struct stat info {};
+    if (::fstat(fd, &info) < 0 || (info.st_mode & (S_IRWXG | S_IRWXO)) != 0) {
+        ::close(fd);
+        *error = "token file " + path + " must be readable by its owner only (chmod 600)";
+        return false;
+    }
+
+    std::string contents;
+    char buffer[512];
+    ssize_t n;
+    while ((n = ::read(fd, buffer, sizeof(buffer))) != 0) {
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ::close(fd);
+            *error = "cannot read token file " + path + ": " + std::strerror(errno);
+            return false;
+        }
+        contents.append(buffer, static_cast<size_t>(n));
+        if (contents.size() > RemoteProtocol::MAX_PAYLOAD) {
+            break;
+        }
+    }
+    ::close(fd);
+
+    *token = std::string(trimmed(contents));
+    if (token->empty() || token->size() + RemoteProtocol::MAGIC.size() > RemoteProtocol::MAX_PAYLOAD) {
+        *error = "token file " + path + " is empty or too large";
+        return false;
+    }
+    return true;
+}
+
+int RemoteClient::connectTo(const std::string& path, std::string* error)
+{
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        *error = "socket path is too long: " + path;
+        return -1;
+    }
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        *error = std::string("socket: ") + std::strerror(errno);
+        return -1;
+    }
+
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.data(), path.size());
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        *error = "cannot connect to " + path + ": " + std::strerror(errno) +
+                 " (is the picker running with --remote-listen and the socket forwarded with ssh -R?)";
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool RemoteClient::exchange(int fd, std::string_view token, const std::vector<std::string>& urls,
+                            std::vector<Reply>* replies, int timeoutMs, std::string* error)
+{
+    using namespace RemoteProtocol;
+
+    if (urls.empty() || urls.size() > static_cast<size_t>(MAX_URLS_PER_CONNECTION)) {
+        *error = "between 1 and " + std::to_string(MAX_URLS_PER_CONNECTION) + " URLs can be sent at once";
+        return false;
+    }
+
+    // 認証と全てのURLを1回で書き込む（往復は1回）
+    std::string request;
+    std::string hello(MAGIC);
+    hello.append(token);
+    bool framed = appendFrame(&request, FrameType::Hello, hello);
+    for (const std::string& url : urls) {
+        framed = framed && appendFrame(&request, FrameType::Url, url);
+    }
+    if (!framed) {
+        *error = "URL or token is too long";
+        return false;
+    }
+    if (!sendAll(fd, request.data(), request.size())) {
+        *error = std::string("send: ") + std::strerror(errno);
+        return false;
+    }
+
+    replies->clear();
+    FrameReader reader;
+    pollfd pfd{fd, POLLIN, 0};
+    char buffer[4096];
+    while (replies->size() < urls.size()) {
+        FrameType type;
+        std::string payload;
+        const FrameReader::Result result = reader.next(&type, &payload);
+        if (result == FrameReader::Result::Invalid || (result == FrameReader::Result::Frame &&
+                                                        (type != FrameType::Reply || payload.empty()))) {
+            *error = "unexpected reply from the picker";
+            return false;
+        }
+        if (result == FrameReader::Result::Frame) {
+            Reply reply;
+            reply.status = static_cast<Status>(static_cast<unsigned char>(payload[0]));
+            reply.message = payload.substr(1);
+            if (reply.status == Status::Unauthorized || reply.status == Status::ProtocolError) {
+                *error = statusText(reply.status) + (reply.message.empty() ? "" : ": " + reply.message);
+                return false;
+            }
+            replies->push_back(std::move(reply));
+            continue;
+        }
+
+        const int ready = ::poll(&pfd, 1, timeoutMs);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready <= 0) {
+            *error = "timed out waiting for the picker";
+            return false;
+        }
+        const ssize_t n = ::read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            *error = "the picker closed the connection";
+            return false;
+        }
+        reader.append(buffer, static_cast<size_t>(n));
+    }
+    return true;
+}
+
+int RemoteClient::main(int argc, char** argv)
+{
+    std::string socketPath = defaultSocketPath();
+    std::string tokenPath = defaultTokenPath();
+    std::vector<std::string> urls;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--remote-client") {
+            continue;
+        }
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if ((arg == "--socket" || arg == "--token-file") && i + 1 < argc) {
+            (arg == "--socket" ? socketPath : tokenPath) = argv[++i];
+            continue;
+        }
+        if (arg.substr(0, 9) == "--socket=") {
+            socketPath = std::string(arg.substr(9));
+            continue;
+        }
+        if (arg.substr(0, 13) == "--token-file=") {
+            tokenPath = std::string(arg.substr(13));
+            continue;
+        }
+        if (arg.substr(0, 2) == "--") {
+            printUsage(argv[0]);
+            return 2;
+        }
+        urls.emplace_back(arg);
+    }
+
+    if (urls.empty()) {
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            const std::string_view url = trimmed(line);
+            if (!url.empty()) {
+                urls.emplace_back(url);
+            }
+        }
+    }
+    if (urls.empty()) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    std::string token;
+    std::string error;
+    if (!readToken(tokenPath, &token, &error)) {
+        std::cerr << "kde-browser-picker: " << error << "\n";
+        return 1;
+    }
+
+    // 上限を超える分は接続を分けて送る
+    int status = 0;
+    for (size_t first = 0; first < urls.size(); first += RemoteProtocol::MAX_URLS_PER_CONNECTION) {
+        const size_t last = std::min(urls.size(), first + RemoteProtocol::MAX_URLS_PER_CONNECTION);
+        const std::vector<std::string> batch(urls.begin() + static_cast<std::ptrdiff_t>(first),
+                                             urls.begin() + static_cast<std::ptrdiff_t>(last));
+
+        const int fd = connectTo(socketPath, &error);
+        if (fd < 0) {
+            std::cerr << "kde-browser-picker: " << error << "\n";
+            return 1;
+        }
+        std::vector<Reply> replies;
+        const bool exchanged = exchange(fd, token, batch, &replies, REPLY_TIMEOUT_MS, &error);
+        ::close(fd);
+        if (!exchanged) {
+            std::cerr << "kde-browser-picker: " << error << "\n";
+            return 1;
+        }
+
+        for (size_t i = 0; i < replies.size(); ++i) {
+            if (replies[i].status != RemoteProtocol::Status::Accepted) {
+                std::cerr << "kde-browser-picker: " << batch[i] << ": " << statusText(replies[i].status)
+                          << (replies[i].message.empty() ? "" : " (" + replies[i].message + ")") << "\n";
+                status = 1;
+            }
+        }
+    }
+    return status;
+}
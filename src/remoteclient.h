@@ -0,0 +1,90 @@
+/**
+ * @file remoteclient.h
+ * @brief リモートホストから転送ソケット経由でURLを送るクライアント
+ *
+ * `kde-browser-picker --remote-client URL...`（または単体の kbp-remote-client）として、
+ * `ssh -R` で転送されたUnixソケットにURLを送り、ローカルのピッカーで開かせます。
+ * リモートのビルドホストにはQt/KDEがないことが多く、起動時間が往復時間を上回らないよう、
+ * このクライアントは標準ライブラリとPOSIXのみで実装し、QApplication より前に実行します。
+ */
+
+#ifndef REMOTECLIENT_H
+#define REMOTECLIENT_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "remoteprotocol.h"
+
+/**
+ * @class RemoteClient
+ * @brief 転送ソケットのクライアント
+ *
+ * どのメソッドも失敗時は false / -1 を返し、理由を error に格納します。
+ */
+class RemoteClient {
+public:
+    /**
+     * @struct Reply
+     * @brief URL 1件分の結果
+     */
+    struct Reply {
+        RemoteProtocol::Status status = RemoteProtocol::Status::ProtocolError;
+        std::string message;   ///< 拒否の理由（受け付けた場合は空）
+    };
+
+    /**
+     * @brief 既定のソケットのパス
+     * @return $KBP_REMOTE_SOCKET、なければ $XDG_RUNTIME_DIR/kde-browser-picker-remote.sock
+     *         （$XDG_RUNTIME_DIR がない場合は /tmp/kde-browser-picker-remote-<uid>.sock）
+     * @note ローカルのリスナーとリモートのクライアントで同じ規則を使うため、
+     *       `ssh -R <このパス>:<このパス>` で転送できます
+     */
+    static std::string defaultSocketPath();
+
+    /**
+     * @brief 既定の認証トークンファイルのパス
+     * @return $KBP_REMOTE_TOKEN_FILE、なければ ${XDG_CONFIG_HOME:-~/.config}/kde-browser-picker/remote-token
+     */
+    static std::string defaultTokenPath();
+
+    /**
+     * @brief 認証トークンを読み込む
+     * @param path トークンファイル
+     * @param token 読み込んだトークン（前後の空白を除く）
+     * @param error 失敗の理由
+     * @return false: 読めない・空・所有者以外が読める
+     */
+    static bool readToken(const std::string& path, std::string* token, std::string* error);
+
+    /**
+     * @brief ソケットに接続
+     * @return 接続したソケット（失敗時は -1）
+     */
+    static int connectTo(const std::string& path, std::string* error);
+
+    /**
+     * @brief 認証とURLを1回で送り、URLごとの結果を受け取る
+     * @param fd 接続済みのソケット（socketpair も可）
+     * @param token 認証トークン
+     * @param urls 送るURL（最大 MAX_URLS_PER_CONNECTION 件）
+     * @param replies 結果の格納先（URLと同じ順）
+     * @param timeoutMs 結果を待つ最大時間（ミリ秒）
+     * @param error 失敗の理由
+     * @return false: 送受信の失敗・認証の拒否・タイムアウト
+     */
+    static bool exchange(int fd, std::string_view token, const std::vector<std::string>& urls,
+                         std::vector<Reply>* replies, int timeoutMs, std::string* error);
+
+    /**
+     * @brief --remote-client のエントリポイント
+     * @param argc main() の引数
+     * @param argv main() の引数（[--socket パス] [--token-file パス] [URL...]）
+     * @return 0: 全てのURLを受け付けた, 1: 拒否・エラーがあった, 2: 使い方の誤り
+     * @note URLを省略した場合は標準入力から1行1件で読み込みます
+     */
+    static int main(int argc, char** argv);
+};
+
+#endif // REMOTECLIENT_H
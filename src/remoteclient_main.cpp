@@ -0,0 +1,13 @@
+/**
+ * @file remoteclient_main.cpp
+ * @brief kbp-remote-client のエントリポイント
+ *
+ * `kde-browser-picker --remote-client` と同じ動作をQtに依存せずに行います。
+ */
+
+#include "remoteclient.h"
+
+int main(int argc, char** argv)
+{
+    return RemoteClient::main(argc, argv);
+}
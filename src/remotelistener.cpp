@@ -0,0 +1,343 @@
+/**
+ * @file remotelistener.cpp
+ * @brief RemoteListenerクラスの実装
+ */
+
+#include "remotelistener.h"
+#include "browserdetector.h"
+#include "remoteprotocol.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <QSocketNotifier>
+#include <QStringList>
+#include <QUrl>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+/// 同時に処理する接続の上限
+constexpr int MAX_CONNECTIONS = 16;
+
+/// 作成するトークンの乱数のバイト数
+constexpr int TOKEN_BYTES = 32;
+
+/**
+ * @brief トークンの比較（一致した長さで時間が変わらないようにする）
+ */
+bool tokensEqual(std::string_view received, const QByteArray& expected)
+{
+    if (received.size() != static_cast<size_t>(expected.size())) {
+        return false;
+    }
+    unsigned char difference = 0;
+    for (size_t i = 0; i < received.size(); ++i) {
+        difference |= static_cast<unsigned char>(received[i] ^ expected[static_cast<int>(i)]);
+    }
+    return difference == 0;
+}
+
+/**
+ * @brief 所有者以外の権限があるかどうか
+ */
+bool accessibleByOthers(const QFileInfo& info)
+{
+    const QFileDevice::Permissions others = QFileDevice::ReadGroup | QFileDevice::WriteGroup |
+                                            QFileDevice::ExeGroup | QFileDevice::ReadOther |
+                                            QFileDevice::WriteOther | QFileDevice::ExeOther;
+    return (info.permissions() & others) != 0;
+}
+
+} // namespace
+
+struct RemoteListener::Connection {
+    QSocketNotifier* notifier = nullptr;   ///< 受信の通知
+    RemoteProtocol::FrameReader reader;    ///< 受信途中のフレーム
+    bool authenticated = false;            ///< Hello を照合済みか
+    int urls = 0;                          ///< 受け取ったURLの数
+};
+
+RemoteListener::RemoteListener(const QByteArray& token, QObject* parent)
+    : QObject(parent)
+    , m_token(token)
+    , m_listenFd(-1)
+    , m_listenNotifier(nullptr)
+{
+}
+
+RemoteListener::~RemoteListener()
+{
+    const auto fds = m_connections.keys();
+    for (int fd : fds) {
+        closeConnection(fd);
+    }
+    if (m_listenFd >= 0) {
+        ::close(m_listenFd);
+        ::unlink(QFile::encodeName(m_socketPath).constData());
+    }
+}
+
+bool RemoteListener::listen(const QString& path, QString* error)
+{
+    const QByteArray socketPath = QFile::encodeName(path);
+    sockaddr_un addr{};
+    if (static_cast<size_t>(socketPath.size()) >= sizeof(addr.sun_path)) {
+        *error = QString("socket path is too long: %1").arg(path);
+        return false;
+    }
+
+    // 前回の残骸のソケットだけを置き換える（通常のファイルは消さない）
+    struct stat existing {};
+    if (::lstat(socketPath.constData(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            *error = QString("%1 exists and is not a socket").arg(path);
+            return false;
+        }
+        ::unlink(socketPath.constData());
+    }
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        *error = QString("socket: %1").arg(QString::fromLocal8Bit(std::strerror(errno)));
+        return false;
+    }
+
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, socketPath.constData(), static_cast<size_t>(socketPath.size()));
+
+    // bind() で作られるソケットファイルを最初から所有者のみに限定する
+    const mode_t previousMask = ::umask(0177);
+    const bool bound = ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    const int bindError = errno;
+    ::umask(previousMask);
+    if (!bound || ::listen(fd, MAX_CONNECTIONS) < 0) {
+        *error = QString("cannot listen on %1: %2").arg(path, QString::fromLocal8Bit(std::strerror(bound ? errno : bindError)));
+        ::close(fd);
+        return false;
+    }
+
+    m_listenFd = fd;
+    m_socketPath = path;
+    m_listenNotifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(m_listenNotifier, &QSocketNotifier::activated, this, [this]() { onListenReady(); });
+    return true;
+}
+
+void RemoteListener::adopt(int fd)
+{
+    if (m_connections.size() >= MAX_CONNECTIONS) {
+        ::close(fd);
+        return;
+    }
+
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    auto connection = std::make_shared<Connection>();
+    connection->notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(connection->notifier, &QSocketNotifier::activated, this, [this, fd]() { onConnectionReady(fd); });
+    m_connections.insert(fd, connection);
+}
+
+int RemoteListener::connectionCount() const
+{
+    return static_cast<int>(m_connections.size());
+}
+
+void RemoteListener::onListenReady()
+{
+    for (;;) {
+        const int fd = ::accept4(m_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+
+        // 転送した sshd は自分のユーザーで動いている。他のユーザーからの接続は受けない
+        ucred peer{};
+        socklen_t length = sizeof(peer);
+        if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &peer, &length) < 0 || peer.uid != ::getuid()) {
+            qDebug() << "Remote link: rejected a connection from uid" << peer.uid;
+            ::close(fd);
+            continue;
+        }
+        adopt(fd);
+    }
+}
+
+void RemoteListener::onConnectionReady(int fd)
+{
+    using namespace RemoteProtocol;
+
+    const std::shared_ptr<Connection> connection = m_connections.value(fd);
+    if (!connection) {
+        return;
+    }
+
+    char buffer[4096];
+    bool closed = false;
+    for (;;) {
+        const ssize_t n = ::read(fd, buffer, sizeof(buffer));
+        if (n > 0) {
+            connection->reader.append(buffer, static_cast<size_t>(n));
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        closed = n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+        break;
+    }
+
+    // 応答はまとめて1回で書き込む
+    std::string replies;
+    bool failed = false;
+    QStringList received;
+    FrameType type;
+    std::string payload;
+    for (;;) {
+        const FrameReader::Result result = connection->reader.next(&type, &payload);
+        if (result == FrameReader::Result::NeedMore) {
+            break;
+        }
+        if (result == FrameReader::Result::Invalid) {
+            appendReply(&replies, Status::ProtocolError, "frame too large");
+            failed = true;
+            break;
+        }
+
+        if (!connection->authenticated) {
+            const std::string_view hello(payload);
+            if (type != FrameType::Hello || hello.substr(0, MAGIC.size()) != MAGIC) {
+                appendReply(&replies, Status::ProtocolError, "expected a KBP1 hello");
+                failed = true;
+                break;
+            }
+            if (!tokensEqual(hello.substr(MAGIC.size()), m_token)) {
+                appendReply(&replies, Status::Unauthorized, "token does not match");
+                failed = true;
+                break;
+            }
+            connection->authenticated = true;
+            continue;
+        }
+
+        if (type != FrameType::Url || ++connection->urls > MAX_URLS_PER_CONNECTION) {
+            appendReply(&replies, Status::ProtocolError, "unexpected frame");
+            failed = true;
+            break;
+        }
+
+        QString reason;
+        const QString url = validateUrl(QString::fromStdString(payload), &reason);
+        if (url.isEmpty()) {
+            appendReply(&replies, Status::Rejected, reason.toStdString());
+            continue;
+        }
+        appendReply(&replies, Status::Accepted, std::string_view());
+        received.append(url);
+    }
+
+    if (!replies.empty()) {
+        // 応答は小さいので送信バッファに収まる。収まらない相手は切断する
+        const ssize_t sent = ::send(fd, replies.data(), replies.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+        failed = failed || sent != static_cast<ssize_t>(replies.size());
+    }
+    if (failed || closed || connection->reader.pending() > HEADER_SIZE + MAX_PAYLOAD) {
+        closeConnection(fd);
+    }
+
+    // 通常のピッカー・振り分けに渡す（応答の送信後）
+    for (const QString& url : received) {
+        emit urlReceived(url);
+    }
+}
+
+void RemoteListener::closeConnection(int fd)
+{
+    const std::shared_ptr<Connection> connection = m_connections.take(fd);
+    if (!connection) {
+        return;
+    }
+    // 通知の処理中に呼ばれるため、通知オブジェクトは後で破棄する
+    connection->notifier->setEnabled(false);
+    connection->notifier->deleteLater();
+    ::close(fd);
+}
+
+QString RemoteListener::validateUrl(const QString& url, QString* reason)
+{
+    const QString sanitized = BrowserDetector::sanitizeUrl(url);
+    for (const QChar ch : sanitized) {
+        if (ch.unicode() < 0x20 || ch.unicode() == 0x7f) {
+            *reason = QStringLiteral("control characters in the URL");
+            return QString();
+        }
+    }
+
+    const QString completed = BrowserDetector::completeUrlScheme(sanitized);
+    if (!BrowserDetector::isValidUrl(completed)) {
+        *reason = QStringLiteral("not a valid URL");
+        return QString();
+    }
+
+    // リモートホストのパスはこのデスクトップでは意味がない（ローカルのファイルを開かせない）
+    if (QUrl(completed).scheme().compare(QLatin1String("file"), Qt::CaseInsensitive) == 0) {
+        *reason = QStringLiteral("file URLs refer to the remote host");
+        return QString();
+    }
+    return completed;
+}
+
+QByteArray RemoteListener::loadOrCreateToken(const QString& path, QString* error)
+{
+    QFile file(path);
+    const QFileInfo info(path);
+    if (info.exists()) {
+        if (accessibleByOthers(info)) {
+            *error = QString("token file %1 must be readable by its owner only (chmod 600)").arg(path);
+            return QByteArray();
+        }
+        if (!file.open(QIODevice::ReadOnly)) {
+            *error = QString("cannot read token file %1: %2").arg(path, file.errorString());
+            return QByteArray();
+        }
+        const QByteArray token = file.read(RemoteProtocol::MAX_PAYLOAD).trimmed();
+        if (token.isEmpty()) {
+            *error = QString("token file %1 is empty").arg(path);
+        }
+        return token;
+    }
+
+    if (!QDir().mkpath(info.absolutePath())) {
+        *error = QString("cannot create %1").arg(info.absolutePath());
+        return QByteArray();
+    }
+
+    // 書き込む前に権限を絞る
+    if (!file.open(QIODevice::WriteOnly | QIODevice::NewOnly) ||
+        !file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner)) {
+        *error = QString("cannot create token file %1: %2").arg(path, file.errorString());
+        return QByteArray();
+    }
+    quint32 random[TOKEN_BYTES / sizeof(quint32)];
+    QRandomGenerator::system()->fillRange(random);
+    const QByteArray token = QByteArray(reinterpret_cast<const char*>(random), TOKEN_BYTES).toHex();
+    if (file.write(token + '\n') != token.size() + 1) {
+        *error = QString("cannot write token file %1: %2").arg(path, file.errorString());
+        return QByteArray();
+    }
+    return token;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file remotelistener.h
+ * @brief 転送ソケットでリモートホストからのURLを受け付けるリスナー
+ *
+ * `kde-browser-picker --remote-listen` で常駐したピッカーが、`ssh -R` で転送される
+ * Unixソケットを待ち受けます。受け取ったURLは起動時と同じ検証（sanitizeUrl / isValidUrl）を通し、
+ * urlReceived() で通常のピッカーに渡します。フレーム形式は remoteprotocol.h を参照してください。
+ */
+
+#ifndef REMOTELISTENER_H
+#define REMOTELISTENER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QString>
+
+#include <memory>
+
+class QSocketNotifier;
+
+/**
+ * @class RemoteListener
+ * @brief 転送ソケットのサーバー
+ *
+ * 待ち受けと各接続は GUI スレッドの QSocketNotifier で処理します（ブロックしない）。
+ * 接続ごとに最初のフレームで認証トークンを照合し、一致しない場合は切断します。
+ */
+class RemoteListener : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief コンストラクタ
+     * @param token 認証トークン（loadOrCreateToken() で読み込む）
+     * @param parent 親オブジェクト
+     */
+    explicit RemoteListener(const QByteArray& token, QObject* parent = nullptr);
+    ~RemoteListener() override;
+
+    // コピーコンストラクタと代入演算子を削除
+    RemoteListener(const RemoteListener&) = delete;
+    RemoteListener& operator=(const RemoteListener&) = delete;
+
+    /**
+     * @brief Unixソケットで待ち受けを開始
+     * @param path ソケットのパス（既存のソケットファイルは置き換える）
+     * @param error 失敗の理由
+     * @return true: 待ち受けを開始した
+     * @note ソケットは所有者のみが接続できる権限（0600）で作成します
+     */
+    bool listen(const QString& path, QString* error);
+
+    /**
+     * @brief 接続済みのソケットを受け付ける（socketpair によるテスト用）
+     * @param fd ソケット（所有権を引き取る）
+     */
+    void adopt(int fd);
+
+    /**
+     * @brief 処理中の接続の数
+     */
+    int connectionCount() const;
+
+    /**
+     * @brief 受け取ったURLを検証
+     * @param url 受け取ったURL
+     * @param reason 拒否の理由の格納先
+     * @return 開くURL（拒否する場合は空）
+     * @note file: のURLはリモートホストのファイルを指すため拒否します
+     */
+    static QString validateUrl(const QString& url, QString* reason);
+
+    /**
+     * @brief 認証トークンを読み込む（なければ作成する）
+     * @param path トークンファイル
+     * @param error 失敗の理由
+     * @return トークン（失敗した場合は空）
+     * @note 作成するトークンは32バイトの乱数の16進表記で、ファイルの権限は0600です。
+     *       所有者以外が読めるファイルは使いません
+     */
+    static QByteArray loadOrCreateToken(const QString& path, QString* error);
+
+signals:
+    /**
+     * @brief 検証を通ったURLを受け取ったときに発行されるシグナル
+     * @param url 開くURL
+     */
+    void urlReceived(const QString& url);
+
+private:
+    struct Connection;
+
+    void onListenReady();
+    void onConnectionReady(int fd);
+    void closeConnection(int fd);
+
+    QByteArray m_token;                                  ///< 認証トークン
+    int m_listenFd;                                      ///< 待ち受けソケット（-1: なし）
+    QString m_socketPath;                                ///< 待ち受けソケットのパス
+    QSocketNotifier* m_listenNotifier;                   ///< 待ち受けソケットの通知
+    QHash<int, std::shared_ptr<Connection>> m_connections; ///< ソケット -> 接続の状態
+};
+
+#endif // REMOTELISTENER_H
@@ -0,0 +1,202 @@
+/**
+ * @file remoteopen.cpp
+ * @brief RemoteOpenクラスの実装
+ */
+
+#include "remoteopen.h"
+
+#include <QDBusConnection>
+#include <QDBusError>
+#include <QDBusMessage>
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+/// SingletonSocket プロトコルのトークン（Chromium process_singleton_posix.cc）
+constexpr char CHROMIUM_START_TOKEN[] = "START";
+constexpr char CHROMIUM_ACK_TOKEN[] = "ACK";
+constexpr char CHROMIUM_SHUTDOWN_TOKEN[] = "SHUTDOWN";
+
+/**
+ * @brief EINTRを考慮して全データを書き込む
+ */
+bool writeAll(int fd, const char* data, size_t size)
+{
+    while (size > 0) {
+        const ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+} // namespace
+
+QByteArray RemoteOpen::buildChromiumMessage(const QString& workingDir, const QStringList& argv)
+{
+    QByteArray message(CHROMIUM_START_TOKEN);
+    message.append('\0');
+    message.append(QFile::encodeName(workingDir));
+    for (const QString& arg : argv) {
+        message.append('\0');
+        message.append(arg.toUtf8());
+    }
+    return message;
+}
+
+QByteArray RemoteOpen::buildFirefoxCommandLine(const QString& workingDir, const QStringList& argv,
+                                               const QString& startupToken)
+{
+    // [argc][argv0のオフセット][argv1のオフセット]...<cwd>\0<argv0>\0<argv1>\0...
+    // オフセットはバッファ先頭からの位置
+    const int headerSize = static_cast<int>(sizeof(qint32)) * (argv.size() + 1);
+
+    QByteArray strings = QFile::encodeName(workingDir);
+    if (!startupToken.isEmpty()) {
+        strings.append(" STARTUP_TOKEN=");
+        strings.append(startupToken.toUtf8());
+    }
+    strings.append('\0');
+
+    QByteArray header(headerSize, '\0');
+    qToLittleEndian<qint32>(argv.size(), header.data());
+    for (int i = 0; i < argv.size(); ++i) {
+        qToLittleEndian<qint32>(headerSize + strings.size(),
+                                header.data() + sizeof(qint32) * (i + 1));
+        strings.append(argv[i].toUtf8());
+        strings.append('\0');
+    }
+
+    return header + strings;
+}
+
+QString RemoteOpen::firefoxServiceName(const QString& profileName, const QString& appName)
+{
+    // D-Busのバス名に使用できるのは [A-Za-z0-9_] のみのため、Base64の記号を置換する
+    QString encoded = QString::fromLatin1(profileName.toUtf8().toBase64());
+    for (QChar& ch : encoded) {
+        if (!ch.isLetterOrNumber() && ch != '_') {
+            ch = '_';
+        }
+    }
+    return QString("org.mozilla.%1.%2").arg(appName.toLower(), encoded);
+}
+
+RemoteOpen::Result RemoteOpen::openInChromium(const QString& userDataDir, const QStringList& argv,
+                                              int timeoutMs)
+{
+    // SingletonSocket は /tmp 内の実ソケットへのシンボリックリンク
+    const QByteArray socketPath = QFile::encodeName(QFileInfo(userDataDir + "/SingletonSocket").canonicalFilePath());
+    sockaddr_un addr{};
+    if (socketPath.isEmpty()) {
+        return Result::NotRunning;
+    }
+    if (static_cast<size_t>(socketPath.size()) >= sizeof(addr.sun_path)) {
+        return Result::Failed;
+    }
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return Result::Failed;
+    }
+
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, socketPath.constData(), static_cast<size_t>(socketPath.size()));
+
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        const int error = errno;
+        ::close(fd);
+        // 残骸のソケット（ブラウザ終了済み）
+        return (error == ECONNREFUSED || error == ENOENT) ? Result::NotRunning : Result::Failed;
+    }
+
+    const QByteArray message = buildChromiumMessage(QDir::currentPath(), argv);
+    if (!writeAll(fd, message.constData(), static_cast<size_t>(message.size())) ||
+        ::shutdown(fd, SHUT_WR) < 0) {
+        ::close(fd);
+        return Result::Failed;
+    }
+
+    // ACKを待つ（分割して届いても待つのは合計で timeoutMs まで）
+    char buffer[16] = {};
+    size_t received = 0;
+    pollfd pfd{fd, POLLIN, 0};
+    const QDeadlineTimer deadline(timeoutMs);
+    while (received < sizeof(buffer) - 1) {
+        const int ready = ::poll(&pfd, 1, static_cast<int>(deadline.remainingTime()));
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready <= 0) {
+            break;
+        }
+        const ssize_t n = ::read(fd, buffer + received, sizeof(buffer) - 1 - received);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        received += static_cast<size_t>(n);
+    }
+    ::close(fd);
+
+    if (std::strncmp(buffer, CHROMIUM_ACK_TOKEN, sizeof(CHROMIUM_ACK_TOKEN) - 1) == 0) {
+        return Result::Delivered;
+    }
+    if (std::strncmp(buffer, CHROMIUM_SHUTDOWN_TOKEN, sizeof(CHROMIUM_SHUTDOWN_TOKEN) - 1) == 0) {
+        // 相手は終了処理中
+        return Result::NotRunning;
+    }
+    return Result::Failed;
+}
+
+RemoteOpen::Result RemoteOpen::openInFirefox(const QString& profileName, const QStringList& argv,
+                                             const QString& startupToken, int timeoutMs)
+{
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    if (!bus.isConnected()) {
+        return Result::NotRunning;
+    }
+
+    const QString appName = QStringLiteral("firefox");
+    QDBusMessage call = QDBusMessage::createMethodCall(
+        firefoxServiceName(profileName, appName),
+        QString("/org/mozilla/%1/Remote").arg(appName),
+        QString("org.mozilla.%1").arg(appName),
+        "OpenURL");
+    call << buildFirefoxCommandLine(QDir::currentPath(), argv, startupToken);
+
+    const QDBusMessage reply = bus.call(call, QDBus::Block, timeoutMs);
+    if (reply.type() == QDBusMessage::ReplyMessage) {
+        return Result::Delivered;
+    }
+
+    const QString errorName = reply.errorName();
+    if (errorName == QDBusError::errorString(QDBusError::ServiceUnknown) ||
+        errorName == QDBusError::errorString(QDBusError::NameHasNoOwner)) {
+        // X11ビルド等でD-Busリモーティングが無効な場合もここに来る
+        return Result::NotRunning;
+    }
+
+    qDebug() << "Firefox remote open failed:" << errorName << reply.errorMessage();
+    return Result::Failed;
+}
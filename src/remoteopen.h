@@ -0,0 +1,87 @@
+/**
+ * @file remoteopen.h
+ * @brief 起動中のブラウザへのURL受け渡し（リモートオープン）
+ *
+ * 対象のプロファイルが既に起動している場合、ブラウザの実行ファイルを
+ * 再度execしてURLを転送させる代わりに、ブラウザ自身のリモートプロトコルで
+ * 直接URLを渡します。
+ *
+ * - Firefox: D-Busリモーティング（org.mozilla.firefox.<プロファイル名のBase64>）
+ * - Chrome/Chromium: ユーザーデータディレクトリの SingletonSocket プロトコル
+ */
+
+#ifndef REMOTEOPEN_H
+#define REMOTEOPEN_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+#include "constants.h"
+
+/**
+ * @class RemoteOpen
+ * @brief ブラウザのリモートプロトコルのクライアント
+ *
+ * どのメソッドも失敗時は呼び出し側が従来のexecにフォールバックできるよう、
+ * 結果を返すだけで例外やシグナルは使用しません。
+ */
+class RemoteOpen {
+public:
+    /**
+     * @brief 受け渡しの結果
+     */
+    enum class Result {
+        Delivered,    ///< 起動中のブラウザがURLを受け取った
+        NotRunning,   ///< 受け取るインスタンスが存在しない
+        Failed        ///< 通信エラー・タイムアウト・拒否
+    };
+
+    /**
+     * @brief Chromium系ブラウザの SingletonSocket にコマンドラインを送信
+     * @param userDataDir ユーザーデータディレクトリ（SingletonSocket を含む）
+     * @param argv 転送するコマンドライン（argv[0] は実行ファイル）
+     * @param timeoutMs ACKを待つ最大時間（ミリ秒、送信後からの合計）
+     * @return 結果
+     */
+    static Result openInChromium(const QString& userDataDir, const QStringList& argv,
+                                 int timeoutMs = Constants::REMOTE_OPEN_TIMEOUT_MS);
+
+    /**
+     * @brief FirefoxのD-Busリモーティングインターフェースにコマンドラインを送信
+     * @param profileName profiles.ini のプロファイル名
+     * @param argv 転送するコマンドライン（argv[0] は実行ファイル）
+     * @param startupToken アクティベーショントークン（空の場合は付与しない）
+     * @param timeoutMs 応答を待つ最大時間（ミリ秒）
+     * @return 結果
+     */
+    static Result openInFirefox(const QString& profileName, const QStringList& argv,
+                                const QString& startupToken = QString(),
+                                int timeoutMs = Constants::REMOTE_OPEN_TIMEOUT_MS);
+
+    /**
+     * @brief SingletonSocket に送るメッセージを作成
+     * @return "START\0<cwd>\0<argv0>\0<argv1>..."
+     */
+    static QByteArray buildChromiumMessage(const QString& workingDir, const QStringList& argv);
+
+    /**
+     * @brief Firefoxのリモートコマンドラインを作成
+     * @param startupToken アクティベーショントークン（作業ディレクトリの後ろに
+     *        " STARTUP_TOKEN=<token>" として付与され、Firefox側で取り除かれる）
+     * @return [argc][offset...]<cwd>\0<argv0>\0... （int32はリトルエンディアン）
+     */
+    static QByteArray buildFirefoxCommandLine(const QString& workingDir, const QStringList& argv,
+                                              const QString& startupToken = QString());
+
+    /**
+     * @brief プロファイル名からFirefoxのD-Busサービス名を作成
+     * @param profileName プロファイル名
+     * @param appName アプリケーション名（通常は "firefox"）
+     * @return "org.mozilla.<appName>.<Base64(profileName)の記号を'_'に置換>"
+     */
+    static QString firefoxServiceName(const QString& profileName,
+                                      const QString& appName = QStringLiteral("firefox"));
+};
+
+#endif // REMOTEOPEN_H
@@ -0,0 +1,137 @@
+/**
+ * @file remoteprotocol.h
+ * @brief リモートホストからURLを受け取るソケットのフレーム形式
+ *
+ * `ssh -R` で転送したUnixソケット上で、リモートのクライアント（--remote-client / kbp-remote-client）と
+ * ローカルのピッカー（--remote-listen）が交換するフレームを定義します。
+ * クライアントはQtなしでビルドするため、このヘッダーは標準ライブラリのみに依存します。
+ *
+ * フレーム: [ペイロード長 (uint32, ビッグエンディアン)][種別 (1バイト)][ペイロード]
+ *
+ * 1. クライアント → Hello: "KBP1" + 認証トークン
+ * 2. クライアント → Url: URL（UTF-8）を1件ずつ。Hello と続けて1回で書き込む
+ * 3. ピッカー → Reply: [状態 (1バイト)][メッセージ（UTF-8）] を Url ごとに1件
+ *    （Hello が不正な場合は Unauthorized / ProtocolError を1件返して切断）
+ *
+ * 全てを1回の書き込みと1回の読み取りで済ませるため、往復はネットワークの1RTTです。
+ */
+
+#ifndef REMOTEPROTOCOL_H
+#define REMOTEPROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace RemoteProtocol {
+
+/// Hello のペイロードの先頭（プロトコルのバージョンを含む）
+constexpr std::string_view MAGIC = "KBP1";
+
+/// 1フレームのペイロードの上限（URL・トークンとも十分に収まる）
+constexpr std::uint32_t MAX_PAYLOAD = 16 * 1024;
+
+/// ヘッダー（長さ4バイト + 種別1バイト）
+constexpr std::size_t HEADER_SIZE = 5;
+
+/// 1接続で受け付けるURLの上限
+constexpr int MAX_URLS_PER_CONNECTION = 64;
+
+/**
+ * @brief フレームの種別
+ */
+enum class FrameType : std::uint8_t {
+    Hello = 'H',    ///< 認証（MAGIC + トークン）
+    Url = 'U',      ///< 開くURL
+    Reply = 'R'     ///< 結果（Url ごと）
+};
+
+/**
+ * @brief Reply の状態
+ */
+enum class Status : std::uint8_t {
+    Accepted = 0,       ///< ピッカーに渡した
+    Rejected = 1,       ///< URLの検証に失敗した
+    Unauthorized = 2,   ///< トークンが一致しない
+    ProtocolError = 3   ///< フレームが不正
+};
+
+/**
+ * @brief フレームを作成して out に追加
+ * @return false: ペイロードが上限を超えている
+ */
+inline bool appendFrame(std::string* out, FrameType type, std::string_view payload)
+{
+    if (payload.size() > MAX_PAYLOAD) {
+        return false;
+    }
+    const auto length = static_cast<std::uint32_t>(payload.size());
+    out->push_back(static_cast<char>((length >> 24) & 0xff));
+    out->push_back(static_cast<char>((length >> 16) & 0xff));
+    out->push_back(static_cast<char>((length >> 8) & 0xff));
+    out->push_back(static_cast<char>(length & 0xff));
+    out->push_back(static_cast<char>(type));
+    out->append(payload);
+    return true;
+}
+
+/**
+ * @brief Reply フレームを作成して out に追加
+ */
+inline bool appendReply(std::string* out, Status status, std::string_view message)
+{
+    std::string payload(1, static_cast<char>(status));
+    payload.append(message.substr(0, MAX_PAYLOAD - 1));
+    return appendFrame(out, FrameType::Reply, payload);
+}
+
+/**
+ * @brief 受信バッファの先頭から1フレームを取り出す
+ *
+ * 取り出したフレームはバッファから削除されます。
+ */
+class FrameReader {
+public:
+    /**
+     * @brief 取り出しの結果
+     */
+    enum class Result {
+        Frame,      ///< type と payload に格納した
+        NeedMore,   ///< フレームの途中（続きを受信する）
+        Invalid     ///< 長さが上限を超えている（接続を切る）
+    };
+
+    /// 受信したデータを追加
+    void append(const char* data, std::size_t size) { m_buffer.append(data, size); }
+
+    /// 受信済みで取り出していないバイト数
+    std::size_t pending() const { return m_buffer.size(); }
+
+    Result next(FrameType* type, std::string* payload)
+    {
+        if (m_buffer.size() < HEADER_SIZE) {
+            return Result::NeedMore;
+        }
+        const auto* bytes = reinterpret_cast<const unsigned char*>(m_buffer.data());
+        const std::uint32_t length = (std::uint32_t(bytes[0]) << 24) | (std::uint32_t(bytes[1]) << 16) |
+                                     (std::uint32_t(bytes[2]) << 8) | std::uint32_t(bytes[3]);
+        if (length > MAX_PAYLOAD) {
+            return Result::Invalid;
+        }
+        if (m_buffer.size() < HEADER_SIZE + length) {
+            return Result::NeedMore;
+        }
+        *type = static_cast<FrameType>(bytes[4]);
+        payload->assign(m_buffer, HEADER_SIZE, length);
+        m_buffer.erase(0, HEADER_SIZE + length);
+        return Result::Frame;
+    }
+
+private:
+    std::string m_buffer;  ///< 受信済みのデータ
+};
+
+} // namespace RemoteProtocol
+
+#endif // REMOTEPROTOCOL_H
@@ -0,0 +1,255 @@
+/**
+ * @file routeexplain.cpp
+ * @brief RouteExplainクラスの実装
+ */
+
+#include "routeexplain.h"
+#include "browserdetector.h"
+#include "configmanager.h"
+#include "profilemanager.h"
+#include "speculativelauncher.h"
+
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QTextStream>
+#include <QUrl>
+
+namespace {
+
+QString targetName(const QString& browser, const QString& profileId)
+{
+    return browser + "/" + profileId;
+}
+
+/**
+ * @brief デフォルトプロファイルが選ばれた理由
+ * @note 選択自体は ProfileManager::selectDefaultProfile() が行い、ここでは結果に名前を付けるだけ
+ */
+QString defaultReason(const ProfileManager::ProfileEntry& entry, const QPair<QString, QString>& lastUsed,
+                      bool underPressure)
+{
+    if (entry.browser == lastUsed.first && entry.profileId == lastUsed.second) {
+        return "last used";
+    }
+    if (underPressure && entry.isRunning) {
+        return "running instance under memory pressure";
+    }
+    return "first enabled profile";
+}
+
+} // namespace
+
+RouteExplain::Report RouteExplain::explain(const QString& input)
+{
+    Report report;
+    report.input = input;
+
+    QElapsedTimer timer;
+    auto addStage = [&report, &timer](const QString& name, const QString& result,
+                                      const QJsonObject& details = QJsonObject()) {
+        Stage stage;
+        stage.name = name;
+        stage.elapsedNs = timer.nsecsElapsed();
+        stage.result = result;
+        stage.details = details;
+        report.stages.append(stage);
+    };
+
+    // 設定（rc と YAML の各層）
+    timer.start();
+    ConfigManager config;
+    const int timeout = config.defaultTimeout();
+    addStage("config", QString("timeout %1 s, speculative %2").arg(timeout)
+                           .arg(config.speculativeEnabled() ? "on" : "off"),
+             QJsonObject{{"timeout", timeout}, {"speculative", config.speculativeEnabled()},
+                         {"remember_last_used", config.rememberLastUsed()}});
+
+    // 検出（ピッカーのバックグラウンド検出と同じブラウザごとの処理を同期的に実行）
+    timer.restart();
+    ProfileManager profiles(&config);
+    profiles.refreshProfiles();
+    const QList<ProfileManager::ProfileEntry> all = profiles.getAllProfiles();
+    const QList<ProfileManager::ProfileEntry> enabled = profiles.getAllProfiles(true);
+    QJsonArray detected;
+    for (const auto& entry : all) {
+        detected.append(QJsonObject{{"browser", entry.browser}, {"profile", entry.profileId},
+                                    {"enabled", entry.isEnabled}});
+    }
+    addStage("detection", QString("%1 profile(s), %2 enabled").arg(all.size()).arg(enabled.size()),
+             QJsonObject{{"profiles", detected}});
+
+    // 正規化（main() と BrowserDetector::launchBrowser() の順に適用される処理）
+    timer.restart();
+    report.url = BrowserDetector::sanitizeUrl(BrowserDetector::completeUrlScheme(input));
+    addStage("canonicalize", report.url == input ? QString("%1 (unchanged)").arg(report.url) : report.url);
+
+    // 検証
+    timer.restart();
+    const bool valid = BrowserDetector::isValidUrl(report.url);
+    addStage("validate", valid ? "valid" : "rejected", QJsonObject{{"valid", valid}});
+    if (!valid) {
+        report.decision = "rejected: the URL does not pass validation";
+        return report;
+    }
+
+    // ホストの履歴
+    timer.restart();
+    const QString host = QUrl(report.url).host();
+    const auto hostTarget = config.getLastUsedForHost(host);
+    bool hostTargetAvailable = false;
+    for (const auto& entry : enabled) {
+        if (entry.browser == hostTarget.first && entry.profileId == hostTarget.second) {
+            hostTargetAvailable = true;
+            break;
+        }
+    }
+    QString hostResult;
+    if (host.isEmpty()) {
+        hostResult = "no host";
+    } else if (hostTarget.first.isEmpty()) {
+        hostResult = QString("no entry for %1").arg(host);
+    } else {
+        hostResult = QString("%1 -> %2").arg(host, targetName(hostTarget.first, hostTarget.second));
+        if (!hostTargetAvailable) {
+            hostResult += " (not available)";
+        }
+    }
+    QJsonObject hostDetails{{"host", host}};
+    if (!hostTarget.first.isEmpty()) {
+        hostDetails["browser"] = hostTarget.first;
+        hostDetails["profile"] = hostTarget.second;
+        hostDetails["available"] = hostTargetAvailable;
+    }
+    addStage("host_rule", hostResult, hostDetails);
+
+    // frecency
+    timer.restart();
+    QJsonArray scores;
+    const ProfileManager::ProfileEntry* best = nullptr;
+    double bestScore = 0.0;
+    for (const auto& entry : enabled) {
+        const double score = config.frecencyScore(entry.browser, entry.profileId);
+        scores.append(QJsonObject{{"browser", entry.browser}, {"profile", entry.profileId}, {"score", score}});
+        if (score > bestScore) {
+            bestScore = score;
+            best = &entry;
+        }
+    }
+    addStage("frecency", best ? QString("highest %1 (%2)").arg(targetName(best->browser, best->profileId))
+                                    .arg(bestScore, 0, 'f', 1)
+                              : QString("no launch history"),
+             QJsonObject{{"scores", scores}});
+
+    // 先行起動の予測（予測のみで起動はしない）
+    timer.restart();
+    const SpeculativeLauncher launcher(&profiles, &config);
+    const SpeculativeLauncher::Prediction prediction = launcher.predict(report.url);
+    QString predictionResult = prediction.isValid()
+        ? QString("%1 (%2)").arg(targetName(prediction.browser, prediction.profileId), prediction.reason)
+        : QString("none");
+    if (!config.speculativeEnabled()) {
+        predictionResult += ", prelaunch disabled";
+    }
+    QJsonObject predictionDetails{{"enabled", config.speculativeEnabled()}};
+    if (prediction.isValid()) {
+        predictionDetails["browser"] = prediction.browser;
+        predictionDetails["profile"] = prediction.profileId;
+        predictionDetails["reason"] = prediction.reason;
+    }
+    addStage("prediction", predictionResult, predictionDetails);
+
+    // 起動中のプロファイルとメモリ逼迫
+    timer.restart();
+    QJsonArray running;
+    for (const auto& entry : enabled) {
+        if (profiles.browserDetector()->isProfileRunning(entry.browser, entry.profileId)) {
+            running.append(targetName(entry.browser, entry.profileId));
+        }
+    }
+    const bool underPressure = profiles.isUnderMemoryPressure();
+    addStage("running", QString("%1 running, memory pressure %2").arg(running.size())
+                            .arg(underPressure ? "yes" : "no"),
+             QJsonObject{{"running", running}, {"memory_pressure", underPressure}});
+
+    // 起動先（タイムアウト時の自動選択と一覧の初期選択。C API と同じ ProfileManager::resolveTarget()）
+    const QPair<QString, QString> lastUsed = config.getLastUsed();
+    timer.restart();
+    bool fromHost = false;
+    const ProfileManager::ProfileEntry defaultProfile = profiles.resolveTarget(report.url, &fromHost);
+    if (defaultProfile.browser.isEmpty()) {
+        addStage("default", "no enabled profile");
+        report.decision = "no enabled profile: the picker closes on timeout";
+        return report;
+    }
+    const QString reason = fromHost ? QString("host history") : defaultReason(defaultProfile, lastUsed, underPressure);
+    addStage("default", QString("%1 (%2)").arg(targetName(defaultProfile.browser, defaultProfile.profileId), reason),
+             QJsonObject{{"browser", defaultProfile.browser}, {"profile", defaultProfile.profileId},
+                         {"reason", reason}});
+
+    report.browser = defaultProfile.browser;
+    report.profileId = defaultProfile.profileId;
+    report.decision = timeout > 0
+        ? QString("auto-selected after %1 s unless another profile is chosen").arg(timeout)
+        : QString("preselected in the picker; waits for the user");
+    return report;
+}
+
+QString RouteExplain::toText(const Report& report)
+{
+    QString text;
+    QTextStream out(&text);
+    out << "URL: " << report.input << "\n";
+
+    int nameWidth = 0;
+    for (const Stage& stage : report.stages) {
+        nameWidth = qMax(nameWidth, static_cast<int>(stage.name.size()));
+    }
+    qint64 total = 0;
+    for (const Stage& stage : report.stages) {
+        out << "  " << stage.name.leftJustified(nameWidth) << "  "
+            << formatDuration(stage.elapsedNs).rightJustified(10) << "  " << stage.result << "\n";
+        total += stage.elapsedNs;
+    }
+    out << "  " << QString("total").leftJustified(nameWidth) << "  " << formatDuration(total).rightJustified(10)
+        << "\n";
+
+    if (report.browser.isEmpty()) {
+        out << "Target: none (" << report.decision << ")\n";
+    } else {
+        out << "Target: " << targetName(report.browser, report.profileId) << " (" << report.decision << ")\n";
+    }
+    return text;
+}
+
+QJsonObject RouteExplain::toJson(const Report& report)
+{
+    QJsonArray stages;
+    for (const Stage& stage : report.stages) {
+        QJsonObject object = stage.details;
+        object["name"] = stage.name;
+        object["elapsed_ns"] = stage.elapsedNs;
+        object["result"] = stage.result;
+        stages.append(object);
+    }
+
+    QJsonObject json;
+    json["input"] = report.input;
+    json["url"] = report.url;
+    json["stages"] = stages;
+    json["target"] = report.browser.isEmpty()
+        ? QJsonValue()
+        : QJsonValue(QJsonObject{{"browser", report.browser}, {"profile", report.profileId}});
+    json["decision"] = report.decision;
+    return json;
+}
+
+QString RouteExplain::formatDuration(qint64 nanoseconds)
+{
+    if (nanoseconds < 1000) {
+        return QString("%1 ns").arg(nanoseconds);
+    }
+    if (nanoseconds < 1000000) {
+        return QString("%1 µs").arg(static_cast<double>(nanoseconds) / 1e3, 0, 'f', 1);
+    }
+    return QString("%1 ms").arg(static_cast<double>(nanoseconds) / 1e6, 0, 'f', 2);
+}
@@ -0,0 +1,83 @@
+/**
+ * @file routeexplain.h
+ * @brief URLの振り分けの説明（--explain）
+ *
+ * 想定外のプロファイルで開かれた場合や、特定のURLでピッカーが遅い場合の調査用に、
+ * 振り分けの各段階の結果と所要時間を出力します。各段階はピッカーと同じ関数
+ * （BrowserDetector・ConfigManager・ProfileManager・SpeculativeLauncher）を呼び出して計測するため、
+ * 数値は実際の動作を反映します。
+ *
+ * 段階:
+ * - config: 設定（rc と YAML の各層）の読み込み
+ * - detection: ブラウザとプロファイルの検出
+ * - canonicalize: スキームの補完とサニタイズ
+ * - validate: URLの検証
+ * - host_rule: ホストの履歴（前回このホストを開いたプロファイル）
+ * - frecency: 有効なプロファイルごとのfrecencyスコア
+ * - prediction: 先行起動の予測
+ * - running: 起動中のプロファイルとメモリ逼迫
+ * - default: デフォルトプロファイル（自動選択・初期選択の対象）
+ */
+
+#ifndef ROUTEEXPLAIN_H
+#define ROUTEEXPLAIN_H
+
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+
+/**
+ * @class RouteExplain
+ * @brief 振り分けの各段階の計測と出力
+ */
+class RouteExplain {
+public:
+    /**
+     * @struct Stage
+     * @brief 1つの段階の結果
+     */
+    struct Stage {
+        QString name;           ///< 段階名（"canonicalize" など）
+        QString result;         ///< 結果の要約
+        qint64 elapsedNs = 0;   ///< 所要時間（ナノ秒）
+        QJsonObject details;    ///< 詳細（JSONでのみ出力）
+    };
+
+    /**
+     * @struct Report
+     * @brief 説明の全体
+     */
+    struct Report {
+        QString input;          ///< 入力されたURL
+        QString url;            ///< 正規化したURL
+        QList<Stage> stages;    ///< 実行した段階（検証に失敗した場合はそこまで）
+        QString browser;        ///< 最終的な起動先のブラウザID（なしの場合は空）
+        QString profileId;      ///< 最終的な起動先のプロファイルID
+        QString decision;       ///< 起動先の決まり方（自動選択・初期選択・拒否など）
+    };
+
+    /**
+     * @brief URLの振り分けを実行して各段階を計測
+     * @param url コマンドラインで渡されたURL
+     * @return 説明
+     * @note ブラウザの起動・先行起動・設定の書き込みは行いません
+     */
+    static Report explain(const QString& url);
+
+    /**
+     * @brief 段階ごとの表として出力
+     */
+    static QString toText(const Report& report);
+
+    /**
+     * @brief JSONとして出力
+     */
+    static QJsonObject toJson(const Report& report);
+
+    /**
+     * @brief 所要時間を読みやすい単位で表示（ns / µs / ms）
+     */
+    static QString formatDuration(qint64 nanoseconds);
+};
+
+#endif // ROUTEEXPLAIN_H
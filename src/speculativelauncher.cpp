@@ -0,0 +1,146 @@
+/**
+ * @file speculativelauncher.cpp
+ * @brief SpeculativeLauncherクラスの実装
+ */
+
+#include "speculativelauncher.h"
+#include "profilemanager.h"
+#include "configmanager.h"
+#include "constants.h"
+
+#include <QDebug>
+#include <QUrl>
+
+#include <signal.h>
+#include <sys/types.h>
+
+SpeculativeLauncher::SpeculativeLauncher(ProfileManager* profileManager, ConfigManager* configManager,
+                                         QObject* parent)
+    : QObject(parent)
+    , m_profileManager(profileManager)
+    , m_configManager(configManager)
+    , m_prelaunchedPid(0)
+    , m_started(false)
+    , m_finished(false)
+{
+}
+
+SpeculativeLauncher::Prediction SpeculativeLauncher::predict(const QString& url) const
+{
+    Prediction prediction;
+    const auto profiles = m_profileManager->getAllProfiles(true);
+
+    // 1. 前回このホストを開いたプロファイル
+    const auto hostTarget = m_configManager->getLastUsedForHost(QUrl(url).host());
+    for (const auto& entry : profiles) {
+        if (entry.browser == hostTarget.first && entry.profileId == hostTarget.second) {
+            prediction.browser = entry.browser;
+            prediction.profileId = entry.profileId;
+            prediction.reason = "host";
+            return prediction;
+        }
+    }
+
+    // 2. frecencyが突出して高いプロファイル（2位の2倍以上）
+    double best = 0.0;
+    double second = 0.0;
+    const ProfileManager::ProfileEntry* bestEntry = nullptr;
+    for (const auto& entry : profiles) {
+        const double score = m_configManager->frecencyScore(entry.browser, entry.profileId);
+        if (score > best) {
+            second = best;
+            best = score;
+            bestEntry = &entry;
+        } else if (score > second) {
+            second = score;
+        }
+    }
+
+    if (bestEntry && best >= Constants::SPECULATIVE_MIN_FRECENCY && best >= second * 2.0) {
+        prediction.browser = bestEntry->browser;
+        prediction.profileId = bestEntry->profileId;
+        prediction.reason = "frecency";
+    }
+
+    return prediction;
+}
+
+void SpeculativeLauncher::start(const QString& url)
+{
+    if (m_started || !m_configManager->speculativeEnabled()) {
+        return;
+    }
+    m_started = true;
+
+    m_prediction = predict(url);
+    if (!m_prediction.isValid()) {
+        return;
+    }
+
+    BrowserDetector* detector = m_profileManager->browserDetector();
+    if (detector->isProfileRunning(m_prediction.browser, m_prediction.profileId)) {
+        // 既に起動済みならURLの受け渡しだけで済む
+        return;
+    }
+
+    if (detector->warmUpBrowser(m_prediction.browser, m_prediction.profileId, &m_prelaunchedPid)) {
+        qDebug() << "Speculatively warmed up" << m_prediction.browser << m_prediction.profileId
+                 << "(" << m_prediction.reason << ", pid" << m_prelaunchedPid << ")";
+    }
+}
+
+void SpeculativeLauncher::confirm(const QString& browser, const QString& profileId)
+{
+    if (m_finished || !m_prediction.isValid()) {
+        return;
+    }
+    m_finished = true;
+
+    const bool hit = browser == m_prediction.browser && profileId == m_prediction.profileId;
+    m_configManager->recordSpeculativeResult(hit ? "Hits" : "Misses");
+
+    // 別のブラウザを起動する場合、先行起動したプロセスは使われない。
+    // 同じブラウザの別プロファイルは SingletonSocket でこのプロセスにURLが渡されるため終了させない
+    if (browser != m_prediction.browser) {
+        closePrelaunched();
+    }
+}
+
+void SpeculativeLauncher::launchFinished(bool launched)
+{
+    if (!launched) {
+        closePrelaunched();
+    }
+    // 起動に使われたプロセスは、以降のキャンセルやリセットでも終了させない
+    m_prelaunchedPid = 0;
+}
+
+void SpeculativeLauncher::cancel()
+{
+    if (m_finished || !m_prediction.isValid()) {
+        return;
+    }
+    m_finished = true;
+
+    m_configManager->recordSpeculativeResult("Cancels");
+    closePrelaunched();
+}
+
+void SpeculativeLauncher::reset()
+{
+    m_prediction = Prediction();
+    m_prelaunchedPid = 0;
+    m_started = false;
+    m_finished = false;
+}
+
+void SpeculativeLauncher::closePrelaunched()
+{
+    if (m_prelaunchedPid <= 0 ||
+        m_configManager->speculativeCancelPolicy() != Constants::SpeculativeCancelPolicy::Close) {
+        return;
+    }
+
+    ::kill(static_cast<pid_t>(m_prelaunchedPid), SIGTERM);
+    m_prelaunchedPid = 0;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file speculativelauncher.h
+ * @brief 予測したプロファイルのブラウザの先行起動
+ *
+ * ピッカーが起動先を高い確度で予測できる場合（前回と同じホスト、
+ * またはfrecencyが突出して高いプロファイル）に、ウィンドウ表示と同時に
+ * そのブラウザを先行起動し、クリック後のコールドスタート待ちを減らします。
+ */
+
+#ifndef SPECULATIVELAUNCHER_H
+#define SPECULATIVELAUNCHER_H
+
+#include <QObject>
+#include <QString>
+
+class ProfileManager;
+class ConfigManager;
+
+/**
+ * @class SpeculativeLauncher
+ * @brief 先行起動の予測・実行・結果記録
+ *
+ * 予測が当たった場合（ユーザーが同じプロファイルを選択）は "Hits"、
+ * 別のプロファイルが選択された場合は "Misses"、キャンセルされた場合は
+ * "Cancels" としてKConfigに記録します。
+ *
+ * @note YAMLの speculative.enabled が true の場合のみ動作します（オプトイン）
+ */
+class SpeculativeLauncher : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @struct Prediction
+     * @brief 起動先の予測結果
+     */
+    struct Prediction {
+        QString browser;    ///< ブラウザID（予測なしの場合は空）
+        QString profileId;  ///< プロファイルID
+        QString reason;     ///< 予測の根拠（"host" / "frecency"）
+
+        bool isValid() const { return !browser.isEmpty(); }
+    };
+
+    SpeculativeLauncher(ProfileManager* profileManager, ConfigManager* configManager,
+                        QObject* parent = nullptr);
+    ~SpeculativeLauncher() override = default;
+
+    // コピーコンストラクタと代入演算子を削除
+    SpeculativeLauncher(const SpeculativeLauncher&) = delete;
+    SpeculativeLauncher& operator=(const SpeculativeLauncher&) = delete;
+
+    /**
+     * @brief URLに対する起動先を予測
+     * @param url 開くURL
+     * @return 予測結果（確度が低い場合は無効な予測）
+     */
+    Prediction predict(const QString& url) const;
+
+    /**
+     * @brief 予測したプロファイルのブラウザを先行起動
+     * @param url 開くURL
+     * @note 既に起動中の場合は何もしません。1つのピッカーにつき1回のみ
+     */
+    void start(const QString& url);
+
+    /**
+     * @brief ユーザーが起動先を確定したときに呼び出す（起動の前）
+     * @param browser 確定したブラウザID
+     * @param profileId 確定したプロファイルID
+     * @note 別のブラウザが選ばれた場合、先行起動したプロセスは使われないため
+     *       on_cancel: close なら起動の前に終了します。同じブラウザであれば別のプロファイルでも
+     *       先行起動したインスタンスがURLを受け取るため、launchFinished() まで残します
+     */
+    void confirm(const QString& browser, const QString& profileId);
+
+    /**
+     * @brief confirm() した起動の結果を通知
+     * @param launched true: 起動（起動中のブラウザへの受け渡しを含む）に成功した
+     * @note 失敗した場合、先行起動したプロセスはURLを受け取っていないため
+     *       on_cancel: close なら終了します。成功した場合はユーザーのブラウザとして残します
+     */
+    void launchFinished(bool launched);
+
+    /**
+     * @brief ピッカーがキャンセルされたときに呼び出す
+     * @note on_cancel: close の場合は先行起動したプロセスを終了します
+     */
+    void cancel();
+
+    /**
+     * @brief 次のURLのために予測と結果の記録をやり直す
+     * @note 作成済みのピッカーを別のURLで再利用する場合に呼び出します
+     */
+    void reset();
+
+    /**
+     * @brief 現在の予測を取得
+     */
+    Prediction currentPrediction() const { return m_prediction; }
+
+    /**
+     * @brief 先行起動したプロセスのPID（0: なし・終了済み・ブラウザとして引き継いだ）
+     */
+    qint64 prelaunchedPid() const { return m_prelaunchedPid; }
+
+private:
+    /**
+     * @brief 先行起動したプロセスを終了（ポリシーが close の場合）
+     */
+    void closePrelaunched();
+
+    ProfileManager* m_profileManager;  ///< プロファイル管理オブジェクト（非所有）
+    ConfigManager* m_configManager;    ///< 設定管理オブジェクト（非所有）
+
+    Prediction m_prediction;           ///< 現在の予測
+    qint64 m_prelaunchedPid;           ///< 先行起動したプロセスのPID（0: なし）
+    bool m_started;                    ///< start() が呼ばれたか
+    bool m_finished;                   ///< 結果を記録済みか
+};
+
+#endif // SPECULATIVELAUNCHER_H
@@ -0,0 +1,92 @@
+/**
+ * @file tracepoints.h
+ * @brief USDT静的トレースポイント
+ *
+ * CMakeオプション ENABLE_USDT を有効にしてビルドすると、<sys/sdt.h> の静的プローブを
+ * 埋め込みます。再ビルドせずに perf や bpftrace で検出・設定・起動の経路を調査できます。
+ *
+ * @code
+ * perf buildid-cache --add /usr/bin/kde-browser-picker
+ * perf probe 'sdt_kde_browser_picker:*'
+ * perf record -e 'sdt_kde_browser_picker:*' -- kde-browser-picker https://example.com
+ * bpftrace -e 'usdt:/usr/lib/libkbp-core.so.1:kde_browser_picker:detection_end
+ *              { printf("%s %d profiles %d us\n", str(arg0), arg1, arg2); }'
+ * @endcode
+ *
+ * 検出・設定・起動のプローブはコアライブラリ（libkbp-core）に、
+ * search_filter と profile_selected は実行ファイルに含まれます。
+ *
+ * 各プローブにはセマフォがあり、トレーサーが接続していない間は引数
+ * （文字列の変換や時間の計測）を評価しません。ENABLE_USDT が無効な場合は何も生成しません。
+ *
+ * プローブ一覧（プロバイダ: kde_browser_picker）:
+ * - detection_start(browser)
+ * - detection_end(browser, profiles, duration_us)
+ * - profile_parsed(browser, profile, path)
+ * - config_load(path, yaml_overrides, duration_us)
+ * - config_sync(duration_us)
+ * - search_filter(query, visible, duration_us)
+ * - profile_selected(browser, profile, user_initiated)
+ * - launch(browser, profile, method, ok, pid, duration_us)  method: "remote" または "exec"
+ */
+
+#ifndef TRACEPOINTS_H
+#define TRACEPOINTS_H
+
+#ifdef KBP_ENABLE_USDT
+
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+/// プローブのセマフォ（トレーサーが接続すると値が増える）
+#define KBP_TRACE_SEMAPHORE(name) kde_browser_picker_##name##_semaphore
+
+// セマフォは各翻訳単位で weak として定義し、リンク時に1つにまとめる。
+// トレーサーはプローブと同じファイルのセマフォを更新するため、共有ライブラリと
+// 実行ファイルの間では割り込ませない（hidden）
+#define KBP_TRACE_DEFINE(name) \
+    extern "C" __attribute__((weak, used, section(".probes"), visibility("hidden"))) \
+    volatile unsigned short KBP_TRACE_SEMAPHORE(name) = 0
+
+KBP_TRACE_DEFINE(detection_start);
+KBP_TRACE_DEFINE(detection_end);
+KBP_TRACE_DEFINE(profile_parsed);
+KBP_TRACE_DEFINE(config_load);
+KBP_TRACE_DEFINE(config_sync);
+KBP_TRACE_DEFINE(search_filter);
+KBP_TRACE_DEFINE(profile_selected);
+KBP_TRACE_DEFINE(launch);
+
+/**
+ * @brief トレーサーが接続しているか（計測の準備が必要な場合に使用）
+ */
+#define KBP_TRACE_ENABLED(name) __builtin_expect(KBP_TRACE_SEMAPHORE(name) != 0, 0)
+
+/**
+ * @brief プローブを発行（引数はトレーサーの接続中のみ評価される）
+ * @note 文字列は qUtf8Printable() などで const char* として渡す
+ */
+#define KBP_TRACE(name, ...) \
+    do { \
+        if (KBP_TRACE_ENABLED(name)) { \
+            STAP_PROBEV(kde_browser_picker, name, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#else
+
+/// 引数の変数が未使用の警告にならないよう、実行されない分岐で参照するだけの関数
+template <typename... Args>
+inline void kbpTraceUnused(const Args&...) {}
+
+#define KBP_TRACE_ENABLED(name) false
+#define KBP_TRACE(name, ...) \
+    do { \
+        if (false) { \
+            kbpTraceUnused(__VA_ARGS__); \
+        } \
+    } while (0)
+
+#endif // KBP_ENABLE_USDT
+
+#endif // TRACEPOINTS_H
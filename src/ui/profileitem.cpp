@@ -11,9 +11,12 @@
 
 #include <QLabel>
 #include <QPushButton>
+#include <QToolButton>
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QPainter>
+#include <QPainterPath>
+#include <QImage>
 #include <QPaintEvent>
 #include <QStyleOption>
 #include <QPropertyAnimation>
@@ -21,6 +24,8 @@
 #include <QIcon>
 #include <QTimer>
 #include <QFile>
+#include <QMap>
+#include <QColor>
 
 ProfileItem::ProfileItem(QWidget* parent)
     : QWidget(parent)
@@ -28,6 +33,8 @@ ProfileItem::ProfileItem(QWidget* parent)
     , m_selected(false)
     , m_hovered(false)
     , m_pressed(false)
+    , m_expandable(false)
+    , m_expanded(false)
 {
     setupUI();
     setFocusPolicy(Qt::StrongFocus);
@@ -50,10 +57,11 @@ void ProfileItem::setProfileData(const QString& browser,
     // UIを更新
     if (!iconPath.isEmpty() && QFile::exists(iconPath)) {
         QPixmap pixmap(iconPath);
-        m_iconLabel->setPixmap(pixmap.scaled(32, 32, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+        m_browserIcon = pixmap.scaled(32, 32, Qt::KeepAspectRatio, Qt::SmoothTransformation);
     } else {
-        m_iconLabel->setPixmap(QIcon::fromTheme("web-browser").pixmap(32, 32));
+        m_browserIcon = QIcon::fromTheme("web-browser").pixmap(32, 32);
     }
+    m_iconLabel->setPixmap(m_browserIcon);
     
     m_browserLabel->setText(browser);
     
@@ -77,6 +85,99 @@ void ProfileItem::setShortcutNumber(int number)
     }
 }
 
+void ProfileItem::setContainer(const QString& name, const QString& color)
+{
+    // Firefoxのコンテナ色（browser/components/contextualidentity のパレット）
+    static const QMap<QString, QColor> containerColors = {
+        {"blue", QColor("#37adff")},
+        {"turquoise", QColor("#00c79a")},
+        {"green", QColor("#51cd00")},
+        {"yellow", QColor("#ffcb00")},
+        {"orange", QColor("#ff9f00")},
+        {"red", QColor("#ff613d")},
+        {"pink", QColor("#ff4bda")},
+        {"purple", QColor("#af51f5")},
+    };
+    
+    m_container = name;
+    
+    // Color dot instead of the browser icon
+    QPixmap dot(16, 16);
+    dot.fill(Qt::transparent);
+    QPainter painter(&dot);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(containerColors.value(color, palette().windowText().color()));
+    painter.drawEllipse(2, 2, 12, 12);
+    painter.end();
+    m_iconLabel->setFixedSize(16, 16);
+    m_iconLabel->setPixmap(dot);
+    
+    m_browserLabel->setText(name);
+    m_profileLabel->setText(tr("container in %1").arg(m_profileName));
+    m_lastUsedLabel->hide();
+    
+    // Indent under the parent profile
+    m_mainLayout->setContentsMargins(48, 4, 12, 4);
+    setMinimumHeight(36);
+}
+
+void ProfileItem::setAvatar(const QImage& image)
+{
+    if (!m_container.isEmpty()) {
+        return;
+    }
+    if (image.isNull()) {
+        m_iconLabel->setPixmap(m_browserIcon);
+        return;
+    }
+    
+    // Chromiumと同様に円形に切り抜く
+    const qreal dpr = devicePixelRatioF();
+    const int size = qRound(32 * dpr);
+    QPixmap avatar(size, size);
+    avatar.fill(Qt::transparent);
+    QPainter painter(&avatar);
+    painter.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform);
+    QPainterPath clip;
+    clip.addEllipse(0, 0, size, size);
+    painter.setClipPath(clip);
+    const QImage scaled = image.scaled(size, size, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+    painter.drawImage((size - scaled.width()) / 2, (size - scaled.height()) / 2, scaled);
+    painter.end();
+    avatar.setDevicePixelRatio(dpr);
+    m_iconLabel->setPixmap(avatar);
+}
+
+void ProfileItem::setExpandable(bool expandable)
+{
+    m_expandable = expandable;
+    m_expandButton->setVisible(expandable);
+}
+
+void ProfileItem::setExpanded(bool expanded)
+{
+    if (m_expanded == expanded) {
+        return;
+    }
+    
+    m_expanded = expanded;
+    m_expandButton->setArrowType(expanded ? Qt::DownArrow : Qt::RightArrow);
+    emit expandToggled(expanded);
+}
+
+void ProfileItem::setColdStartWarning(bool warn)
+{
+    m_warningLabel->setVisible(warn);
+}
+
+void ProfileItem::setResourceUsage(const QString& text, const QString& toolTip)
+{
+    m_usageLabel->setText(text);
+    m_usageLabel->setToolTip(toolTip);
+    m_usageLabel->setVisible(!text.isEmpty());
+}
+
 void ProfileItem::setSelected(bool selected)
 {
     if (m_selected != selected) {
@@ -230,12 +331,48 @@ void ProfileItem::setupUI()
     
     textLayout->addLayout(topLine);
     
+    QHBoxLayout* bottomLine = new QHBoxLayout();
+    bottomLine->setSpacing(8);
+    
     m_lastUsedLabel = new QLabel(this);
     m_lastUsedLabel->setStyleSheet("QLabel { color: palette(mid); font-size: 9pt; }");
-    textLayout->addWidget(m_lastUsedLabel);
+    bottomLine->addWidget(m_lastUsedLabel);
+    
+    // Resource usage of the running instance (filled in asynchronously)
+    m_usageLabel = new QLabel(this);
+    m_usageLabel->setStyleSheet("QLabel { color: palette(mid); font-size: 9pt; }");
+    m_usageLabel->hide();
+    bottomLine->addWidget(m_usageLabel);
+    bottomLine->addStretch();
+    
+    textLayout->addLayout(bottomLine);
     
     m_mainLayout->addLayout(textLayout, 1);
     
+    // Cold start warning (memory pressure)
+    m_warningLabel = new QLabel(this);
+    m_warningLabel->setFixedSize(16, 16);
+    m_warningLabel->setPixmap(QIcon::fromTheme("dialog-warning").pixmap(16, 16));
+    m_warningLabel->setToolTip(tr("Memory is under pressure and this browser is not running yet; "
+                                  "opening it requires a cold start"));
+    m_warningLabel->hide();
+    m_mainLayout->addWidget(m_warningLabel);
+    
+    // Container list toggle (Firefox profiles)
+    m_expandButton = new QToolButton(this);
+    m_expandButton->setArrowType(Qt::RightArrow);
+    m_expandButton->setAutoRaise(true);
+    m_expandButton->setFixedSize(24, 24);
+    m_expandButton->setToolTip(tr("Show containers"));
+    m_expandButton->setFocusPolicy(Qt::NoFocus);
+    m_expandButton->hide();
+    
+    connect(m_expandButton, &QToolButton::clicked, this, [this]() {
+        setExpanded(!m_expanded);
+    });
+    
+    m_mainLayout->addWidget(m_expandButton);
+    
     // Settings button
     m_settingsButton = new QPushButton(this);
     m_settingsButton->setIcon(QIcon::fromTheme("configure"));
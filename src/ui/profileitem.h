@@ -13,10 +13,13 @@
 
 #include <QWidget>
 #include <QDateTime>
+#include <QPixmap>
 
 // Forward declarations
 class QLabel;
 class QPushButton;
+class QToolButton;
+class QImage;
 class QHBoxLayout;
 
 /**
@@ -61,6 +64,79 @@ public:
      * @param number ショートカット番号（1-9）
      */
     void setShortcutNumber(int number);
+
+    /**
+     * @brief 数字ショートカットを取得
+     * @return ショートカット番号（なしの場合は0）
+     */
+    int shortcutNumber() const { return m_shortcutNumber; }
+
+    /**
+     * @brief この項目をプロファイル内のコンテナ（サブターゲット）として表示
+     * @param name コンテナ名
+     * @param color Firefoxのコンテナ色名（"blue", "orange" など）
+     * @note setProfileData() の後に呼び出します
+     */
+    void setContainer(const QString& name, const QString& color);
+
+    /**
+     * @brief コンテナ名を取得
+     * @return コンテナ名（プロファイル自体の項目の場合は空）
+     */
+    QString container() const { return m_container; }
+
+    /**
+     * @brief アバター画像のパスを設定
+     * @param path 画像ファイルのパス（読み込みは AvatarLoader が行う）
+     */
+    void setAvatarPath(const QString& path) { m_avatarPath = path; }
+
+    /**
+     * @brief アバター画像のパスを取得
+     */
+    QString avatarPath() const { return m_avatarPath; }
+
+    /**
+     * @brief ブラウザアイコンの代わりにアバターを表示
+     * @param image 縮小済みの画像（nullの場合はブラウザアイコンに戻す）
+     */
+    void setAvatar(const QImage& image);
+
+    /**
+     * @brief コンテナ一覧の展開ボタンを表示するか設定
+     * @param expandable true: 展開ボタンを表示
+     */
+    void setExpandable(bool expandable);
+
+    /**
+     * @brief 展開ボタンが有効か取得
+     */
+    bool isExpandable() const { return m_expandable; }
+
+    /**
+     * @brief コンテナ一覧の展開状態を設定
+     * @param expanded true: 展開
+     * @note 状態が変化した場合は expandToggled() を発行します
+     */
+    void setExpanded(bool expanded);
+
+    /**
+     * @brief コンテナ一覧の展開状態を取得
+     */
+    bool isExpanded() const { return m_expanded; }
+
+    /**
+     * @brief コールドスタート警告の表示を設定
+     * @param warn true: メモリ逼迫中で未起動のため警告を表示
+     */
+    void setColdStartWarning(bool warn);
+
+    /**
+     * @brief 起動中インスタンスのリソース使用量を表示
+     * @param text 簡潔な表示文字列（空の場合は非表示）
+     * @param toolTip 詳細なツールチップ
+     */
+    void setResourceUsage(const QString& text, const QString& toolTip = QString());
     
     // 選択状態
     /**
@@ -113,6 +189,12 @@ signals:
      */
     void settingsClicked();
 
+    /**
+     * @brief コンテナ一覧の展開状態が変化したときに発行されるシグナル
+     * @param expanded true: 展開された, false: 折りたたまれた
+     */
+    void expandToggled(bool expanded);
+
 protected:
     /**
      * @brief ペイントイベントの処理
@@ -174,7 +256,10 @@ private:
     QLabel* m_browserLabel;       ///< ブラウザ名
     QLabel* m_profileLabel;       ///< プロファイル名
     QLabel* m_lastUsedLabel;      ///< 最終使用日時
+    QLabel* m_usageLabel;         ///< リソース使用量（メモリ・CPU）
     QLabel* m_shortcutLabel;      ///< ショートカット番号
+    QLabel* m_warningLabel;       ///< コールドスタート警告アイコン
+    QToolButton* m_expandButton;  ///< コンテナ一覧の展開ボタン
     QPushButton* m_settingsButton; ///< 設定ボタン
     QHBoxLayout* m_mainLayout;    ///< メインレイアウト
     
@@ -182,6 +267,9 @@ private:
     QString m_browser;            ///< ブラウザID
     QString m_profileId;          ///< プロファイルID
     QString m_profileName;        ///< プロファイル表示名
+    QString m_container;          ///< コンテナ名（サブターゲットの場合）
+    QString m_avatarPath;         ///< アバター画像のパス
+    QPixmap m_browserIcon;        ///< ブラウザアイコン（アバターがない場合に表示）
     QDateTime m_lastUsed;         ///< 最終使用日時
     bool m_isDefault;             ///< デフォルトプロファイルかどうか
     int m_shortcutNumber;         ///< ショートカット番号
@@ -190,6 +278,8 @@ private:
     bool m_selected;              ///< 選択状態
     bool m_hovered;               ///< ホバー状態
     bool m_pressed;               ///< プレス状態
+    bool m_expandable;            ///< 展開ボタンを表示するか
+    bool m_expanded;              ///< コンテナ一覧の展開状態
 };
 
 #endif // PROFILEITEM_H
\ No newline at end of file
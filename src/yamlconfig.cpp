@@ -0,0 +1,653 @@
+/**
+ * @file yamlconfig.cpp
+ * @brief YamlConfigクラスの実装
+ */
+
+#include "yamlconfig.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+
+#include <sys/stat.h>
+
+namespace {
+
+constexpr quint32 CACHE_MAGIC = 0x4b425059; // "KBPY"
+constexpr quint32 CACHE_VERSION = 1;
+
+/**
+ * @struct SourceStamp
+ * @brief キャッシュのキーとなる設定ファイル1つの状態
+ */
+struct SourceStamp {
+    QString path;
+    bool exists = false;
+    qint64 size = 0;
+    qint64 mtimeNs = 0;
+    QByteArray sha256;  ///< 読み込んだ内容のハッシュ（未読み込みの場合は空）
+};
+
+SourceStamp statSource(const QString& path)
+{
+    SourceStamp stamp;
+    stamp.path = path;
+    struct stat st;
+    if (::stat(QFile::encodeName(path).constData(), &st) == 0 && S_ISREG(st.st_mode)) {
+        stamp.exists = true;
+        stamp.size = st.st_size;
+        stamp.mtimeNs = qint64(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    }
+    return stamp;
+}
+
+/**
+ * @brief キャッシュ作成時の状態と現在の状態を比較
+ * @param cached キャッシュに記録された状態
+ * @param current 現在の状態（一致したファイルのハッシュを引き継ぐ）
+ * @param refresh mtime だけが変わった（キーの更新が必要な）場合に true
+ * @return true: キャッシュを使用できる
+ */
+bool stampsMatch(const QList<SourceStamp>& cached, QList<SourceStamp>& current, bool* refresh)
+{
+    if (cached.size() != current.size()) {
+        return false;
+    }
+    for (int i = 0; i < cached.size(); ++i) {
+        const SourceStamp& before = cached[i];
+        SourceStamp& now = current[i];
+        if (before.path != now.path || before.exists != now.exists) {
+            return false;
+        }
+        if (!now.exists) {
+            continue;
+        }
+        if (before.size != now.size) {
+            return false;
+        }
+        if (before.mtimeNs == now.mtimeNs) {
+            now.sha256 = before.sha256;
+            continue;
+        }
+
+        // 触れただけ（内容が同じ）であればキャッシュを使い続ける
+        QFile file(now.path);
+        if (before.sha256.isEmpty() || !file.open(QIODevice::ReadOnly) ||
+            QCryptographicHash::hash(file.readAll(), QCryptographicHash::Sha256) != before.sha256) {
+            return false;
+        }
+        now.sha256 = before.sha256;
+        *refresh = true;
+    }
+    return true;
+}
+
+void writeConfig(QDataStream& out, const QList<SourceStamp>& stamps, const YamlConfig& config)
+{
+    out << quint32(stamps.size());
+    for (const SourceStamp& stamp : stamps) {
+        out << stamp.path << stamp.exists << stamp.size << stamp.mtimeNs << stamp.sha256;
+    }
+
+    out << config.executableOverrides << config.enabledOverrides;
+    out << config.memoryPressurePolicy.enabled << config.memoryPressurePolicy.threshold
+        << qint32(config.memoryPressurePolicy.metric) << qint32(config.memoryPressurePolicy.window);
+    out << config.speculativeEnabled << qint32(config.speculativeCancelPolicy);
+
+    out << quint32(config.launchTemplates.size());
+    for (auto it = config.launchTemplates.cbegin(); it != config.launchTemplates.cend(); ++it) {
+        out << it.key() << it->args << it->env;
+    }
+
+    out << config.layers;
+    out << quint32(config.diagnostics.size());
+    for (const YamlConfig::Diagnostic& diagnostic : config.diagnostics) {
+        out << diagnostic.file << qint32(diagnostic.line) << qint32(diagnostic.column) << diagnostic.message;
+    }
+}
+
+bool readConfig(QDataStream& in, QList<SourceStamp>& stamps, YamlConfig& config)
+{
+    quint32 count = 0;
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        SourceStamp stamp;
+        in >> stamp.path >> stamp.exists >> stamp.size >> stamp.mtimeNs >> stamp.sha256;
+        stamps << stamp;
+    }
+
+    qint32 metric = 0;
+    qint32 window = 0;
+    qint32 cancelPolicy = 0;
+    in >> config.executableOverrides >> config.enabledOverrides;
+    in >> config.memoryPressurePolicy.enabled >> config.memoryPressurePolicy.threshold >> metric >> window;
+    in >> config.speculativeEnabled >> cancelPolicy;
+    config.memoryPressurePolicy.metric = static_cast<MemoryPressure::Metric>(metric);
+    config.memoryPressurePolicy.window = static_cast<MemoryPressure::Window>(window);
+    config.speculativeCancelPolicy = static_cast<Constants::SpeculativeCancelPolicy>(cancelPolicy);
+
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString key;
+        LaunchTemplate tmpl;
+        in >> key >> tmpl.args >> tmpl.env;
+        config.launchTemplates.insert(key, tmpl);
+    }
+
+    in >> config.layers;
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        YamlConfig::Diagnostic diagnostic;
+        qint32 line = 0;
+        qint32 column = 0;
+        in >> diagnostic.file >> line >> column >> diagnostic.message;
+        diagnostic.line = line;
+        diagnostic.column = column;
+        config.diagnostics << diagnostic;
+    }
+
+    return in.status() == QDataStream::Ok && in.atEnd();
+}
+
+/**
+ * @brief キャッシュファイルを mmap して読み込む
+ */
+bool readCache(const QString& cachePath, QList<SourceStamp>& stamps, YamlConfig& config)
+{
+    QFile file(cachePath);
+    if (!file.open(QIODevice::ReadOnly) || file.size() <= 0) {
+        return false;
+    }
+    uchar* data = file.map(0, file.size());
+    if (!data) {
+        return false;
+    }
+
+    const QByteArray raw = QByteArray::fromRawData(reinterpret_cast<const char*>(data), int(file.size()));
+    QDataStream in(raw);
+    in.setVersion(QDataStream::Qt_5_12);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    const bool ok = magic == CACHE_MAGIC && version == CACHE_VERSION && readConfig(in, stamps, config);
+    file.unmap(data);
+    return ok;
+}
+
+void writeCache(const QString& cachePath, const QList<SourceStamp>& stamps, const YamlConfig& config)
+{
+    QDir().mkpath(QFileInfo(cachePath).absolutePath());
+    QSaveFile file(cachePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << CACHE_MAGIC << CACHE_VERSION;
+    writeConfig(out, stamps, config);
+    file.commit();
+}
+
+/**
+ * @brief 引用符の外にある行末コメント（" #" 以降）を除去
+ */
+QString stripComment(const QString& text)
+{
+    QChar quote;
+    for (int i = 0; i < text.size(); ++i) {
+        const QChar ch = text[i];
+        if (!quote.isNull()) {
+            if (ch == quote) quote = QChar();
+        } else if (ch == '"' || ch == '\'') {
+            quote = ch;
+        } else if (ch == '#' && (i == 0 || text[i - 1].isSpace())) {
+            return text.left(i);
+        }
+    }
+    return text;
+}
+
+QString cleanValue(QString v)
+{
+    v = stripComment(v).trimmed();
+    if (v.size() >= 2 &&
+        ((v.startsWith('"') && v.endsWith('"')) || (v.startsWith('\'') && v.endsWith('\'')))) {
+        v = v.mid(1, v.size() - 2);
+    }
+    return v.trimmed();
+}
+
+bool parseBool(const QString& v, bool& ok)
+{
+    const QString s = v.trimmed().toLower();
+    ok = true;
+    if (s == "true" || s == "yes" || s == "on" || s == "1") return true;
+    if (s == "false" || s == "no" || s == "off" || s == "0") return false;
+    ok = false;
+    return true;
+}
+
+/**
+ * @brief フロー形式のリスト "[a, "b c"]" を要素に分割
+ */
+QStringList parseFlowList(QString v)
+{
+    v = v.trimmed();
+    v = v.mid(1, v.size() - 2);
+    QStringList items;
+    QString current;
+    QChar quote;
+    for (const QChar ch : v) {
+        if (!quote.isNull()) {
+            if (ch == quote) quote = QChar();
+            current += ch;
+        } else if (ch == '"' || ch == '\'') {
+            quote = ch;
+            current += ch;
+        } else if (ch == ',') {
+            items << cleanValue(current);
+            current.clear();
+        } else {
+            current += ch;
+        }
+    }
+    if (!current.trimmed().isEmpty()) items << cleanValue(current);
+    return items;
+}
+
+/**
+ * @brief 位置 from 以降で最初の空白以外の文字の列番号（1始まり）
+ */
+int columnAfter(const QString& line, int from)
+{
+    int i = from;
+    while (i < line.size() && line[i].isSpace()) ++i;
+    return i + 1;
+}
+
+bool isKnownBrowser(const QString& browser)
+{
+    return browser == "firefox" || browser == "chrome" || browser == "chromium";
+}
+
+} // namespace
+
+QString YamlConfig::Diagnostic::toString() const
+{
+    if (line <= 0) {
+        return QString("%1: %2").arg(file, message);
+    }
+    return QString("%1:%2:%3: %4").arg(file).arg(line).arg(column).arg(message);
+}
+
+QList<QStringList> YamlConfig::layerCandidates()
+{
+    QList<QStringList> layers;
+    auto addLayer = [&layers](const QString& dir) {
+        layers << QStringList{dir + "/" + Constants::YAML_CONFIG_FILENAME_YAML,
+                              dir + "/" + Constants::YAML_CONFIG_FILENAME_YML};
+    };
+
+    // システム全体: $XDG_CONFIG_DIRS は先頭が優先されるため、末尾から重ねる
+    QString configDirs = qEnvironmentVariable("XDG_CONFIG_DIRS");
+    if (configDirs.isEmpty()) {
+        configDirs = Constants::YAML_SYSTEM_CONFIG_DIR;
+    }
+    const QStringList systemDirs = configDirs.split(':', Qt::SkipEmptyParts);
+    for (auto it = systemDirs.crbegin(); it != systemDirs.crend(); ++it) {
+        addLayer(*it);
+    }
+
+    // ユーザー
+    addLayer(QDir::homePath() + "/.config");
+
+    // 環境変数による明示パス（最優先）
+    const QString envPath = qEnvironmentVariable(Constants::YAML_ENV_PATH);
+    if (!envPath.isEmpty()) {
+        layers << QStringList{envPath};
+    }
+    return layers;
+}
+
+QString YamlConfig::defaultCachePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) +
+           "/kde-browser-picker/config.bin";
+}
+
+YamlConfig YamlConfig::load(const QString& cachePath, bool* fromCache)
+{
+    if (fromCache) {
+        *fromCache = false;
+    }
+
+    const QList<QStringList> candidates = layerCandidates();
+    QList<SourceStamp> stamps;
+    for (const QStringList& layer : candidates) {
+        for (const QString& path : layer) {
+            stamps << statSource(path);
+        }
+    }
+
+    if (!cachePath.isEmpty()) {
+        YamlConfig cached;
+        QList<SourceStamp> cachedStamps;
+        bool refresh = false;
+        if (readCache(cachePath, cachedStamps, cached) && stampsMatch(cachedStamps, stamps, &refresh)) {
+            if (refresh) {
+                writeCache(cachePath, stamps, cached);
+            }
+            if (fromCache) {
+                *fromCache = true;
+            }
+            return cached;
+        }
+    }
+
+    YamlConfig config;
+    int index = 0;
+    for (const QStringList& layer : candidates) {
+        bool used = false;
+        for (const QString& path : layer) {
+            SourceStamp& stamp = stamps[index++];
+            if (used || !stamp.exists) {
+                continue;
+            }
+            QFile file(path);
+            if (!file.open(QIODevice::ReadOnly)) {
+                Diagnostic diagnostic;
+                diagnostic.file = path;
+                diagnostic.message = "cannot read file";
+                config.diagnostics << diagnostic;
+                continue;
+            }
+            // stat の後に書き換えられても、ハッシュは読み込んだ内容と一致する
+            const QByteArray contents = file.readAll();
+            stamp.sha256 = QCryptographicHash::hash(contents, QCryptographicHash::Sha256);
+            config.parseLayer(path, contents);
+            used = true;
+        }
+    }
+
+    for (const Diagnostic& diagnostic : config.diagnostics) {
+        qWarning().noquote() << diagnostic.toString();
+    }
+    if (!cachePath.isEmpty()) {
+        writeCache(cachePath, stamps, config);
+    }
+    return config;
+}
+
+// 簡易YAMLローダー: 以下の最小構文を想定
+// browsers:
+//   firefox: /opt/firefox/firefox
+//   chrome: /usr/bin/google-chrome-stable
+//   chromium: /usr/local/bin/chromium
+// もしくはネスト形式:
+//   firefox:
+//     path: /opt/firefox/firefox
+// メモリ逼迫（PSI）判定:
+// memory_pressure:
+//   threshold: 10
+void YamlConfig::parseLayer(const QString& path, const QByteArray& contents)
+{
+    layers << path;
+
+    int lineNo = 0;
+    auto report = [&](int column, const QString& message) {
+        Diagnostic diagnostic;
+        diagnostic.file = path;
+        diagnostic.line = lineNo;
+        diagnostic.column = column;
+        diagnostic.message = message;
+        diagnostics << diagnostic;
+    };
+
+    // launch: 起動テンプレートへの追加（検証に失敗したものは報告して無視）
+    auto addLaunchArg = [&](const QString& target, const QString& arg, int column) {
+        QString error;
+        LaunchTemplate& tmpl = launchTemplates[target];
+        if (!LaunchTemplate::validateArgument(arg, &error)) {
+            report(column, QString("launch.%1: ignoring argument \"%2\": %3").arg(target, arg, error));
+        } else if (arg == "{url}" && tmpl.args.contains(arg)) {
+            report(column, QString("launch.%1: {url} may appear only once").arg(target));
+        } else {
+            tmpl.args << arg;
+        }
+    };
+    auto addLaunchEnv = [&](const QString& target, const QString& name, const QString& value, int column) {
+        QString error;
+        if (!LaunchTemplate::validateEnvironment(name, value, &error)) {
+            report(column, QString("launch.%1: ignoring variable %2: %3").arg(target, name, error));
+            return;
+        }
+        launchTemplates[target].env.insert(name, value);
+    };
+
+    // この層で置き換えた launch のターゲット（前の層の定義は丸ごと破棄する）
+    QSet<QString> replacedTargets;
+
+    // 現在のトップレベルセクション（"browsers" / "memory_pressure" / "speculative" / "launch"）
+    QString section;
+    int baseIndent = -1;
+    QString currentKey;
+    QString launchField;  // launch セクション内の "args" / "env"
+
+    const QStringList lines = QString::fromUtf8(contents).split('\n');
+    for (QString line : lines) {
+        ++lineNo;
+        if (line.endsWith('\r')) {
+            line.chop(1);
+        }
+        const QString trimmed = line.trimmed();
+        if (trimmed.isEmpty() || trimmed.startsWith('#')) {
+            continue;
+        }
+
+        int indent = 0;
+        while (indent < line.size() && line[indent] == ' ') ++indent;
+        if (line[indent] == '\t') {
+            report(indent + 1, "tabs are not allowed for indentation");
+            continue;
+        }
+
+        if (!section.isEmpty() && indent <= baseIndent) {
+            // セクション終了（同じ行で次のセクションが始まる可能性がある）
+            section.clear();
+            currentKey.clear();
+        }
+
+        // "key: value" の区切り（キーの無い行は -1）
+        const int cpos = line.indexOf(':', indent);
+        const QString key = cpos > indent ? cleanValue(line.mid(indent, cpos - indent)) : QString();
+        const QString rest = cpos > indent ? stripComment(line.mid(cpos + 1)).trimmed() : QString();
+        const int valueColumn = cpos > indent ? columnAfter(line, cpos + 1) : indent + 1;
+
+        if (section.isEmpty()) {
+            if (key == "browsers" || key == "memory_pressure" || key == "speculative" || key == "launch") {
+                if (!rest.isEmpty()) {
+                    report(valueColumn, QString("\"%1\" must be a nested mapping").arg(key));
+                    continue;
+                }
+                section = key;
+                baseIndent = indent;
+                currentKey.clear();
+                launchField.clear();
+            } else if (key.isEmpty()) {
+                report(indent + 1, "expected \"key:\"");
+            } else {
+                report(indent + 1, QString("unknown section \"%1\"").arg(key));
+            }
+            continue;
+        }
+
+        if (section == "launch") {
+            // launch:
+            //   chrome:                 # ブラウザ全体
+            //     args: [--process-per-site]
+            //   "chrome/Profile 1":     # 特定のプロファイル
+            //     args:
+            //       - --disk-cache-dir=/tmp/chrome-cache/{profile}
+            //     env:
+            //       MOZ_ENABLE_WAYLAND: 1
+            if (indent == baseIndent + 2) {
+                const int tpos = stripComment(trimmed).trimmed().lastIndexOf(':');
+                const QString target = tpos > 0 ? cleanValue(trimmed.left(tpos)) : QString();
+                launchField.clear();
+                if (isKnownBrowser(target.section('/', 0, 0))) {
+                    currentKey = target;
+                    if (!replacedTargets.contains(target)) {
+                        replacedTargets.insert(target);
+                        launchTemplates.remove(target);
+                    }
+                } else {
+                    report(indent + 1, QString("launch: unknown browser \"%1\"").arg(target));
+                    currentKey.clear();
+                }
+                continue;
+            }
+            if (currentKey.isEmpty()) continue;
+
+            if (indent == baseIndent + 4 && launchField == "args" && trimmed.startsWith("- ")) {
+                // インデントなしのブロックリスト
+                addLaunchArg(currentKey, cleanValue(trimmed.mid(1)), columnAfter(line, indent + 1));
+                continue;
+            }
+
+            if (indent == baseIndent + 4) {
+                if (key.isEmpty()) {
+                    report(indent + 1, "expected \"key:\"");
+                    continue;
+                }
+                launchField.clear();
+                if (key == "args") {
+                    launchField = key;
+                    if (rest.startsWith('[') && rest.endsWith(']')) {
+                        for (const QString& arg : parseFlowList(rest)) {
+                            addLaunchArg(currentKey, arg, valueColumn);
+                        }
+                    } else if (!rest.isEmpty()) {
+                        report(valueColumn, QString("launch.%1.args must be a list").arg(currentKey));
+                    }
+                } else if (key == "env") {
+                    launchField = key;
+                } else {
+                    report(indent + 1, QString("launch.%1: unknown key \"%2\"").arg(currentKey, key));
+                }
+                continue;
+            }
+
+            if (indent >= baseIndent + 6 && launchField == "args" && trimmed.startsWith("- ")) {
+                addLaunchArg(currentKey, cleanValue(trimmed.mid(1)), columnAfter(line, indent + 1));
+            } else if (indent >= baseIndent + 6 && launchField == "env" && !key.isEmpty()) {
+                addLaunchEnv(currentKey, key, cleanValue(rest), indent + 1);
+            } else {
+                report(indent + 1, QString("launch.%1: unexpected line").arg(currentKey));
+            }
+            continue;
+        }
+
+        if (section == "memory_pressure" || section == "speculative") {
+            if (indent != baseIndent + 2 || key.isEmpty()) {
+                report(indent + 1, QString("%1: expected \"key: value\"").arg(section));
+                continue;
+            }
+            const QString value = cleanValue(rest);
+            if (value.isEmpty()) {
+                report(valueColumn, QString("%1.%2: missing value").arg(section, key));
+                continue;
+            }
+            auto invalid = [&]() {
+                report(valueColumn, QString("%1.%2: invalid value \"%3\"").arg(section, key, value));
+            };
+
+            if (section == "memory_pressure") {
+                // memory_pressure:
+                //   enabled: true
+                //   threshold: 10
+                //   metric: some
+                //   window: avg10
+                if (key == "enabled") {
+                    bool okb = false;
+                    const bool val = parseBool(value, okb);
+                    if (okb) memoryPressurePolicy.enabled = val;
+                    else invalid();
+                } else if (key == "threshold") {
+                    bool okd = false;
+                    const double val = value.toDouble(&okd);
+                    if (okd && val >= 0.0 && val <= 100.0) memoryPressurePolicy.threshold = val;
+                    else invalid();
+                } else if (key == "metric") {
+                    if (!MemoryPressure::parseMetric(value, memoryPressurePolicy.metric)) invalid();
+                } else if (key == "window") {
+                    if (!MemoryPressure::parseWindow(value, memoryPressurePolicy.window)) invalid();
+                } else {
+                    report(indent + 1, QString("memory_pressure: unknown key \"%1\"").arg(key));
+                }
+            } else {
+                // speculative:
+                //   enabled: true
+                //   on_cancel: keep | close
+                if (key == "enabled") {
+                    bool okb = false;
+                    const bool val = parseBool(value, okb);
+                    if (okb) speculativeEnabled = val;
+                    else invalid();
+                } else if (key == "on_cancel") {
+                    if (value == "keep") speculativeCancelPolicy = Constants::SpeculativeCancelPolicy::Keep;
+                    else if (value == "close") speculativeCancelPolicy = Constants::SpeculativeCancelPolicy::Close;
+                    else invalid();
+                } else {
+                    report(indent + 1, QString("speculative: unknown key \"%1\"").arg(key));
+                }
+            }
+            continue;
+        }
+
+        // browsers
+        if (indent == baseIndent + 2) {
+            // 新しいブラウザキー
+            currentKey.clear();
+            if (!isKnownBrowser(key)) {
+                report(indent + 1, QString("browsers: unknown browser \"%1\"").arg(key));
+                continue;
+            }
+            if (!rest.isEmpty()) {
+                executableOverrides.insert(key, cleanValue(rest));
+            } else {
+                currentKey = key;
+            }
+            continue;
+        }
+
+        if (currentKey.isEmpty()) {
+            continue;
+        }
+        if (indent < baseIndent + 4 || key.isEmpty()) {
+            report(indent + 1, QString("browsers.%1: expected \"key: value\"").arg(currentKey));
+            continue;
+        }
+        const QString value = cleanValue(rest);
+        if (key == "path" && !value.isEmpty()) {
+            executableOverrides.insert(currentKey, value);
+        } else if (key == "enabled" && !value.isEmpty()) {
+            bool okb = false;
+            const bool val = parseBool(value, okb);
+            if (okb) {
+                enabledOverrides.insert(currentKey, val);
+            } else {
+                report(valueColumn, QString("browsers.%1.enabled: invalid value \"%2\"").arg(currentKey, value));
+            }
+        } else if (key == "path" || key == "enabled") {
+            report(valueColumn, QString("browsers.%1.%2: missing value").arg(currentKey, key));
+        } else {
+            report(indent + 1, QString("browsers.%1: unknown key \"%2\"").arg(currentKey, key));
+        }
+    }
+}
@@ -0,0 +1,92 @@
+/**
+ * @file yamlconfig.h
+ * @brief 階層化したYAML設定の読み込みとバイナリキャッシュ
+ *
+ * システム全体（$XDG_CONFIG_DIRS、既定は /etc/xdg）、ユーザー（~/.config）、
+ * 環境変数 KDE_BROWSER_PICKER_YAML の順に重ねて読み込み、後の層が前の層を上書きします。
+ * 結合・検証した結果は各層の mtime・サイズ・SHA-256 をキーとしたバイナリキャッシュに保存し、
+ * 次回以降の起動では stat の確認だけでキャッシュを mmap して使用します。
+ */
+
+#ifndef YAMLCONFIG_H
+#define YAMLCONFIG_H
+
+#include <QByteArray>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+#include "memorypressure.h"
+#include "launchtemplate.h"
+#include "constants.h"
+
+/**
+ * @class YamlConfig
+ * @brief 全ての層を結合したYAML設定
+ *
+ * 結合の規則:
+ * - スカラー値（browsers.*.path / enabled、memory_pressure.*、speculative.*）は後の層が優先
+ * - launch の各ターゲット（"chrome" や "chrome/Profile 1"）は、後の層に現れた場合に丸ごと置き換え
+ *
+ * @note 実行パスの上書きは存在確認をせずに保持します。ブラウザの導入・削除は設定ファイルを
+ *       変更しないため、実行可能かどうかは読み込み側で毎回確認してください
+ */
+class YamlConfig {
+public:
+    /**
+     * @struct Diagnostic
+     * @brief 検証エラーの位置と内容
+     */
+    struct Diagnostic {
+        QString file;       ///< 設定ファイルのパス
+        int line;           ///< 行番号（1始まり）
+        int column;         ///< 列番号（1始まり）
+        QString message;    ///< エラー内容
+
+        Diagnostic() : line(0), column(0) {}
+
+        /**
+         * @brief "file:line:column: message" 形式の文字列
+         */
+        QString toString() const;
+    };
+
+    QMap<QString, QString> executableOverrides;     ///< browserId -> 実行パス
+    QMap<QString, bool> enabledOverrides;           ///< browserId -> 有効/無効
+    MemoryPressure::Policy memoryPressurePolicy;    ///< メモリ逼迫判定のポリシー
+    bool speculativeEnabled = false;                ///< 先行起動の有効/無効
+    Constants::SpeculativeCancelPolicy speculativeCancelPolicy = Constants::SpeculativeCancelPolicy::Keep; ///< キャンセル時の扱い
+    QMap<QString, LaunchTemplate> launchTemplates;  ///< "browser" または "browser/profile" -> テンプレート
+    QStringList layers;                             ///< 読み込んだ設定ファイル（優先度の低い順）
+    QList<Diagnostic> diagnostics;                  ///< 検証エラー
+
+    /**
+     * @brief 層ごとの設定ファイルの候補（優先度の低い順）
+     * @return 各層の候補パス（層の中では最初に存在するファイルを使用）
+     */
+    static QList<QStringList> layerCandidates();
+
+    /**
+     * @brief キャッシュの既定の保存先
+     */
+    static QString defaultCachePath();
+
+    /**
+     * @brief キャッシュが有効ならそれを使い、無効なら全ての層を読み込んでキャッシュを作り直す
+     * @param cachePath キャッシュファイルのパス（空の場合はキャッシュを使用しない）
+     * @param fromCache キャッシュを使用したかどうかの格納先（nullptr可）
+     * @return 結合済みの設定
+     * @note 作り直した場合のみ検証エラーを警告として出力します
+     */
+    static YamlConfig load(const QString& cachePath = defaultCachePath(), bool* fromCache = nullptr);
+
+    /**
+     * @brief 1つの層を解析して現在の設定に重ねる
+     * @param path 設定ファイルのパス（エラー位置の表示用）
+     * @param contents ファイルの内容（UTF-8）
+     */
+    void parseLayer(const QString& path, const QByteArray& contents);
+};
+
+#endif // YAMLCONFIG_H
@@ -0,0 +1,106 @@
+/**
+ * @file fakehome.h
+ * @brief 偽のホームディレクトリを用意するテスト用フィクスチャ
+ *
+ * HOME と XDG_* を一時ディレクトリに向け、テストの終了時に元の値へ戻します。
+ * Firefoxの2つのプロファイル（work: 既定, personal）と何もしないスタブのブラウザは
+ * addFirefoxProfiles() で追加できます。
+ */
+
+#ifndef FAKEHOME_H
+#define FAKEHOME_H
+
+#include <gtest/gtest.h>
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QString>
+#include <QTemporaryDir>
+
+#include "../include/constants.h"
+
+/**
+ * @class FakeHomeTest
+ * @brief 偽のホームを用意するフィクスチャの基底クラス
+ */
+class FakeHomeTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(m_root.isValid());
+        for (const char* name : {"HOME", "XDG_CONFIG_HOME", "XDG_CACHE_HOME", "XDG_DATA_HOME", "XDG_CONFIG_DIRS",
+                                 Constants::YAML_ENV_PATH}) {
+            m_saved.insert(name, qEnvironmentVariableIsSet(name) ? qgetenv(name) : QByteArray());
+        }
+
+        m_home = m_root.path() + "/home";
+        qputenv("HOME", m_home.toUtf8());
+        qputenv("XDG_CONFIG_HOME", (m_home + "/.config").toUtf8());
+        qputenv("XDG_CACHE_HOME", (m_root.path() + "/cache").toUtf8());
+        qputenv("XDG_DATA_HOME", (m_home + "/.local/share").toUtf8());
+        // システムのYAML（/etc/xdg）を読まないようにする
+        qputenv("XDG_CONFIG_DIRS", (m_root.path() + "/xdg").toUtf8());
+        qunsetenv(Constants::YAML_ENV_PATH);
+    }
+
+    void TearDown() override {
+        for (auto it = m_saved.cbegin(); it != m_saved.cend(); ++it) {
+            if (it.value().isNull()) {
+                qunsetenv(it.key().constData());
+            } else {
+                qputenv(it.key().constData(), it.value());
+            }
+        }
+    }
+
+    static void writeFile(const QString& path, const QByteArray& contents) {
+        ASSERT_TRUE(QDir().mkpath(QFileInfo(path).absolutePath()));
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write(contents);
+    }
+
+    /**
+     * @brief 何もしないで終了するスタブのブラウザを作成
+     * @return スタブのパス
+     */
+    QString writeStub(const QString& name) const {
+        const QString stub = m_home + "/bin/" + name;
+        writeFile(stub, "#!/bin/sh\nexit 0\n");
+        QFile::setPermissions(stub, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+        return stub;
+    }
+
+    /**
+     * @brief Firefoxの2つのプロファイル（work: 既定, personal）を追加し、
+     *        YAMLでFirefoxをスタブに向けて Chrome/Chromium を無効にする
+     */
+    void addFirefoxProfiles() const {
+        const QString mozilla = m_home + "/.mozilla/firefox";
+        writeFile(mozilla + "/profiles.ini",
+                  "[Profile0]\nName=work\nIsRelative=1\nPath=a1.work\nDefault=1\n\n"
+                  "[Profile1]\nName=personal\nIsRelative=1\nPath=b2.personal\n");
+        ASSERT_TRUE(QDir().mkpath(mozilla + "/a1.work"));
+        ASSERT_TRUE(QDir().mkpath(mozilla + "/b2.personal"));
+
+        writeFile(m_home + "/.config/kde-browser-picker.yaml",
+                  QString("browsers:\n"
+                          "  firefox:\n    path: %1\n"
+                          "  chrome:\n    enabled: false\n"
+                          "  chromium:\n    enabled: false\n").arg(writeStub("firefox-stub")).toUtf8());
+    }
+
+    /**
+     * @brief KConfigの設定ファイル（kde-browser-pickerrc）を書き込む
+     */
+    void writeRc(const QByteArray& contents) const {
+        writeFile(m_home + "/.config/kde-browser-pickerrc", contents);
+    }
+
+    QTemporaryDir m_root;
+    QString m_home;
+    QMap<QByteArray, QByteArray> m_saved;
+};
+
+#endif // FAKEHOME_H
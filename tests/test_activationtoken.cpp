@@ -0,0 +1,131 @@
+/**
+ * @file test_activationtoken.cpp
+ * @brief アクティベーショントークンの受け渡しのテスト
+ *
+ * 環境変数を書き出すスタブのブラウザを起動し、トークンが子プロセスの
+ * 環境に渡ることを検証します。
+ */
+
+#include <gtest/gtest.h>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QtEndian>
+
+#include "../src/browserdetector.h"
+#include "../src/remoteopen.h"
+
+/**
+ * @brief スタブのFirefoxと偽のHOMEを用意するフィクスチャ
+ */
+class ActivationTokenTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(m_home.isValid());
+        m_oldHome = qgetenv("HOME");
+        qputenv("HOME", m_home.path().toUtf8());
+
+        // profiles.ini に "work" プロファイルを1つ
+        const QString mozilla = m_home.path() + "/.mozilla/firefox";
+        ASSERT_TRUE(QDir().mkpath(mozilla + "/abcd.work"));
+        QFile ini(mozilla + "/profiles.ini");
+        ASSERT_TRUE(ini.open(QIODevice::WriteOnly));
+        ini.write("[Profile0]\nName=work\nIsRelative=1\nPath=abcd.work\nDefault=1\n");
+        ini.close();
+
+        // 環境変数をファイルに書き出すスタブのブラウザ
+        m_envOut = m_home.path() + "/child-env";
+        m_stub = m_home.path() + "/firefox-stub";
+        QFile stub(m_stub);
+        ASSERT_TRUE(stub.open(QIODevice::WriteOnly));
+        stub.write("#!/bin/sh\nenv > \"$STUB_ENV_OUT.tmp\" && mv \"$STUB_ENV_OUT.tmp\" \"$STUB_ENV_OUT\"\n");
+        stub.close();
+        stub.setPermissions(QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+        qputenv("STUB_ENV_OUT", m_envOut.toUtf8());
+
+        m_detector.setExecutableOverrides({{"firefox", m_stub}});
+        m_detector.setEnabledOverrides({{"chrome", false}, {"chromium", false}});
+        m_detector.detectBrowsers();
+    }
+
+    void TearDown() override {
+        qputenv("HOME", m_oldHome);
+        qunsetenv("STUB_ENV_OUT");
+        qunsetenv("XDG_ACTIVATION_TOKEN");
+        qunsetenv("DESKTOP_STARTUP_ID");
+    }
+
+    /// スタブが書き出した環境変数を読み込む（最大5秒待つ）
+    QStringList childEnvironment() {
+        for (int i = 0; i < 500 && !QFile::exists(m_envOut); ++i) {
+            QThread::msleep(10);
+        }
+        QFile file(m_envOut);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return {};
+        }
+        return QString::fromUtf8(file.readAll()).split('\n', Qt::SkipEmptyParts);
+    }
+
+    QTemporaryDir m_home;
+    QByteArray m_oldHome;
+    QString m_stub;
+    QString m_envOut;
+    BrowserDetector m_detector;
+};
+
+TEST_F(ActivationTokenTest, WaylandTokenReachesChildEnvironment)
+{
+    // ピッカー自身が受け取った古いトークンは引き継がない
+    qputenv("XDG_ACTIVATION_TOKEN", "stale-token");
+
+    LaunchToken token;
+    token.xdgActivationToken = "kwin-1234";
+    m_detector.setActivationToken(token);
+    ASSERT_TRUE(m_detector.launchBrowser("firefox", "work", "https://example.com"));
+
+    const QStringList env = childEnvironment();
+    ASSERT_FALSE(env.isEmpty());
+    EXPECT_TRUE(env.contains("XDG_ACTIVATION_TOKEN=kwin-1234"));
+    EXPECT_FALSE(env.contains("XDG_ACTIVATION_TOKEN=stale-token"));
+}
+
+TEST_F(ActivationTokenTest, X11StartupIdReachesChildEnvironment)
+{
+    LaunchToken token;
+    token.startupId = "kde-browser-picker-1-host-42_TIME1234";
+    m_detector.setActivationToken(token);
+    ASSERT_TRUE(m_detector.launchBrowser("firefox", "work", "https://example.com"));
+
+    const QStringList env = childEnvironment();
+    ASSERT_FALSE(env.isEmpty());
+    EXPECT_TRUE(env.contains("DESKTOP_STARTUP_ID=kde-browser-picker-1-host-42_TIME1234"));
+    EXPECT_FALSE(env.join('\n').contains("XDG_ACTIVATION_TOKEN="));
+}
+
+TEST_F(ActivationTokenTest, TokenIsUsedForOneLaunchOnly)
+{
+    LaunchToken token;
+    token.xdgActivationToken = "single-use";
+    m_detector.setActivationToken(token);
+    ASSERT_TRUE(m_detector.launchBrowser("firefox", "work", "https://example.com"));
+    ASSERT_FALSE(childEnvironment().isEmpty());
+    QFile::remove(m_envOut);
+
+    ASSERT_TRUE(m_detector.launchBrowser("firefox", "work", "https://example.org"));
+    const QStringList env = childEnvironment();
+    ASSERT_FALSE(env.isEmpty());
+    EXPECT_FALSE(env.contains("XDG_ACTIVATION_TOKEN=single-use"));
+}
+
+TEST(ActivationTokenRemote, FirefoxCommandLineCarriesToken)
+{
+    const QByteArray buffer = RemoteOpen::buildFirefoxCommandLine("/tmp", {"firefox", "https://example.com"},
+                                                                  "kwin-1234");
+    // 作業ディレクトリの後ろに付与され、引数の数は変わらない
+    EXPECT_EQ(qFromLittleEndian<qint32>(buffer.constData()), 2);
+    EXPECT_STREQ(buffer.constData() + 12, "/tmp STARTUP_TOKEN=kwin-1234");
+    const qint32 argv1 = qFromLittleEndian<qint32>(buffer.constData() + 8);
+    EXPECT_STREQ(buffer.constData() + argv1, "https://example.com");
+}
@@ -0,0 +1,160 @@
+/**
+ * @file test_avatarloader.cpp
+ * @brief プロファイルのアバター画像の非同期読み込みのテスト
+ *
+ * 大きな画像を一時ディレクトリに作成し、縮小デコードとサムネイルキャッシュ、
+ * ワーカースレッドからの通知、および Local State からのパスの決定を検証します。
+ */
+
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <QEventLoop>
+#include <QThread>
+
+#include "../src/avatarloader.h"
+#include "../src/browserdetector.h"
+#include "constants.h"
+
+// ヘルパー: 単色の画像を保存
+static bool writeImage(const QString& path, const QSize& size, Qt::GlobalColor color)
+{
+    QImage image(size, QImage::Format_RGB32);
+    image.fill(color);
+    return image.save(path, "PNG");
+}
+
+TEST(AvatarLoader, DecodesScaledThumbnailAndCachesIt)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString picture = dir.path() + "/Google Profile Picture.png";
+    const QString cacheDir = dir.path() + "/cache";
+    ASSERT_TRUE(writeImage(picture, QSize(1024, 768), Qt::red));
+
+    QDateTime mtime;
+    const QImage thumbnail = AvatarLoader::loadThumbnail(picture, QSize(64, 64), cacheDir, &mtime);
+    ASSERT_FALSE(thumbnail.isNull());
+    EXPECT_EQ(thumbnail.size(), QSize(64, 48));
+    EXPECT_EQ(QColor(thumbnail.pixel(10, 10)), QColor(Qt::red));
+
+    // 更新日時をキーにしたサムネイルが保存される
+    const QString cached = cacheDir + "/" + AvatarLoader::thumbnailName(picture, mtime);
+    EXPECT_TRUE(QFile::exists(cached));
+
+    // 2回目はサムネイルから読み込む（元の画像を壊しても同じ結果）
+    ASSERT_TRUE(QFile::resize(picture, 16));
+    QFile(picture).setFileTime(mtime, QFileDevice::FileModificationTime);
+    EXPECT_EQ(AvatarLoader::loadThumbnail(picture, QSize(64, 64), cacheDir).size(), QSize(64, 48));
+}
+
+TEST(AvatarLoader, ModifiedImageReplacesStaleThumbnail)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString picture = dir.path() + "/avatar.png";
+    const QString cacheDir = dir.path() + "/cache";
+    ASSERT_TRUE(writeImage(picture, QSize(200, 200), Qt::red));
+
+    QDateTime first;
+    ASSERT_FALSE(AvatarLoader::loadThumbnail(picture, QSize(64, 64), cacheDir, &first).isNull());
+
+    ASSERT_TRUE(writeImage(picture, QSize(200, 200), Qt::blue));
+    QFile(picture).setFileTime(first.addSecs(60), QFileDevice::FileModificationTime);
+
+    QDateTime second;
+    const QImage updated = AvatarLoader::loadThumbnail(picture, QSize(64, 64), cacheDir, &second);
+    ASSERT_FALSE(updated.isNull());
+    EXPECT_EQ(QColor(updated.pixel(10, 10)), QColor(Qt::blue));
+
+    // 同じ画像のサムネイルは1つだけ
+    EXPECT_FALSE(QFile::exists(cacheDir + "/" + AvatarLoader::thumbnailName(picture, first)));
+    EXPECT_TRUE(QFile::exists(cacheDir + "/" + AvatarLoader::thumbnailName(picture, second)));
+    EXPECT_EQ(QDir(cacheDir).entryList(QDir::Files).size(), 1);
+}
+
+TEST(AvatarLoader, MissingOrInvalidImage)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    EXPECT_TRUE(AvatarLoader::loadThumbnail(dir.path() + "/none.png", QSize(64, 64), QString()).isNull());
+
+    QFile broken(dir.path() + "/broken.png");
+    ASSERT_TRUE(broken.open(QIODevice::WriteOnly));
+    broken.write("not an image");
+    broken.close();
+    EXPECT_TRUE(AvatarLoader::loadThumbnail(broken.fileName(), QSize(64, 64), QString()).isNull());
+}
+
+TEST(AvatarLoader, RequestNotifiesOnOwnerThread)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString picture = dir.path() + "/avatar.png";
+    ASSERT_TRUE(writeImage(picture, QSize(512, 512), Qt::green));
+
+    AvatarLoader loader(dir.path() + "/cache");
+    EXPECT_TRUE(loader.cached(picture).isNull());
+
+    QEventLoop loop;
+    QString loadedPath;
+    QImage loadedImage;
+    bool onOwnerThread = false;
+    QObject::connect(&loader, &AvatarLoader::avatarLoaded, &loop,
+                     [&](const QString& path, const QImage& image) {
+        loadedPath = path;
+        loadedImage = image;
+        onOwnerThread = QThread::currentThread() == app.thread();
+        loop.quit();
+    });
+    QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+    loader.request(picture);
+    loop.exec();
+
+    EXPECT_EQ(loadedPath, picture);
+    EXPECT_TRUE(onOwnerThread);
+    EXPECT_EQ(loadedImage.size(), QSize(Constants::AVATAR_SIZE, Constants::AVATAR_SIZE));
+    EXPECT_EQ(loader.cached(picture).size(), loadedImage.size());
+}
+
+TEST(AvatarLoader, AvatarPathFromLocalState)
+{
+    QTemporaryDir home;
+    ASSERT_TRUE(home.isValid());
+    const QByteArray oldHome = qgetenv("HOME");
+    qputenv("HOME", home.path().toUtf8());
+
+    const QString config = home.path() + "/.config/chromium";
+    ASSERT_TRUE(QDir().mkpath(config + "/Default"));
+    ASSERT_TRUE(QDir().mkpath(config + "/Profile 1"));
+    ASSERT_TRUE(QDir().mkpath(config + "/Profile 2"));
+    QFile localState(config + "/Local State");
+    ASSERT_TRUE(localState.open(QIODevice::WriteOnly));
+    localState.write(R"({"profile": {"info_cache": {
+        "Default": {"name": "Personal", "avatar_icon": "chrome://theme/IDR_PROFILE_AVATAR_19"},
+        "Profile 1": {"name": "Work", "gaia_picture_file_name": "Google Profile Picture.png",
+                      "use_gaia_picture": true, "avatar_icon": "chrome://theme/IDR_PROFILE_AVATAR_0"},
+        "Profile 2": {"name": "Other", "avatar_icon": "chrome://theme/IDR_PROFILE_AVATAR_999"}
+    }}})");
+    localState.close();
+
+    BrowserDetector detector;
+    detector.setExecutableOverrides({{"chromium", "/bin/true"}});
+    detector.setEnabledOverrides({{"firefox", false}, {"chrome", false}});
+    const auto browsers = detector.detectBrowsers();
+    ASSERT_TRUE(browsers.contains("chromium"));
+    const auto& profiles = browsers["chromium"].profiles;
+
+    EXPECT_EQ(profiles["Profile 1"].avatarPath, config + "/Profile 1/Google Profile Picture.png");
+    EXPECT_EQ(profiles["Default"].avatarPath, config + "/Avatars/avatar_cat.png");
+    EXPECT_TRUE(profiles["Profile 2"].avatarPath.isEmpty());
+
+    qputenv("HOME", oldHome);
+}
@@ -0,0 +1,166 @@
+/**
+ * @file test_capi.cpp
+ * @brief コアライブラリのC API（kbp.h）のテスト
+ *
+ * QCoreApplication を作らずに、偽のホームのFirefoxプロファイルを一覧・振り分け・起動できること、
+ * および呼び出し側の確保関数とバッファだけでメモリを扱うことを検証します。
+ */
+
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "../include/kbp.h"
+#include "fakehome.h"
+
+namespace {
+
+/// 呼び出し回数を数える確保関数
+struct CountingAllocator {
+    int allocations = 0;
+    int deallocations = 0;
+
+    static void* allocate(size_t size, size_t /*alignment*/, void* userData) {
+        ++static_cast<CountingAllocator*>(userData)->allocations;
+        return std::malloc(size);
+    }
+
+    static void deallocate(void* pointer, void* userData) {
+        ++static_cast<CountingAllocator*>(userData)->deallocations;
+        std::free(pointer);
+    }
+};
+
+} // namespace
+
+/**
+ * @brief 2つのFirefoxプロファイルとスタブのブラウザを持つ偽のホームを用意するフィクスチャ
+ */
+class CApiTest : public FakeHomeTest {
+protected:
+    void SetUp() override {
+        FakeHomeTest::SetUp();
+        addFirefoxProfiles();
+        writeRc("[HostHistory]\nintranet.example=firefox/personal\n");
+    }
+};
+
+TEST_F(CApiTest, ListsProfilesWithoutApplication)
+{
+    ASSERT_EQ(QCoreApplication::instance(), nullptr);
+
+    kbp_context* context = nullptr;
+    ASSERT_EQ(kbp_open(KBP_API_VERSION, nullptr, &context), KBP_OK);
+    ASSERT_NE(context, nullptr);
+
+    // 件数だけを問い合わせる
+    size_t count = 0;
+    EXPECT_EQ(kbp_list_profiles(context, nullptr, 0, &count), KBP_ERROR_BUFFER_TOO_SMALL);
+    ASSERT_EQ(count, 2u);
+
+    // 収まる分だけ書き込む
+    kbp_profile one;
+    EXPECT_EQ(kbp_list_profiles(context, &one, 1, &count), KBP_ERROR_BUFFER_TOO_SMALL);
+    EXPECT_STREQ(one.browser, "firefox");
+
+    std::vector<kbp_profile> profiles(count);
+    ASSERT_EQ(kbp_list_profiles(context, profiles.data(), profiles.size(), &count), KBP_OK);
+    bool foundWork = false;
+    for (const kbp_profile& profile : profiles) {
+        EXPECT_STREQ(profile.browser, "firefox");
+        EXPECT_EQ(profile.is_enabled, 1);
+        if (std::strcmp(profile.profile_id, "work") == 0) {
+            foundWork = true;
+            EXPECT_EQ(profile.is_default, 1);
+            EXPECT_GT(std::strlen(profile.display_name), 0u);
+        }
+    }
+    EXPECT_TRUE(foundWork);
+
+    EXPECT_EQ(kbp_list_profiles(context, nullptr, 1, &count), KBP_ERROR_INVALID_ARGUMENT);
+    kbp_close(context);
+}
+
+TEST_F(CApiTest, ResolvesHostHistoryThenDefault)
+{
+    kbp_context* context = nullptr;
+    ASSERT_EQ(kbp_open(KBP_API_VERSION, nullptr, &context), KBP_OK);
+
+    kbp_target target;
+    ASSERT_EQ(kbp_resolve(context, "https://intranet.example/wiki", &target), KBP_OK);
+    EXPECT_STREQ(target.browser, "firefox");
+    EXPECT_STREQ(target.profile_id, "personal");
+    EXPECT_EQ(target.reason, KBP_REASON_HOST);
+
+    ASSERT_EQ(kbp_resolve(context, "https://kde.org/", &target), KBP_OK);
+    EXPECT_STREQ(target.browser, "firefox");
+    EXPECT_EQ(target.reason, KBP_REASON_DEFAULT);
+
+    // 起動時と同じ検証
+    EXPECT_EQ(kbp_resolve(context, "javascript:alert(1)", &target), KBP_ERROR_INVALID_URL);
+    EXPECT_EQ(kbp_resolve(context, "https://kde.org/$(id)", &target), KBP_ERROR_INVALID_URL);
+    // ブラウザのスイッチとして渡る値
+    EXPECT_EQ(kbp_resolve(context, "--gpu-launcher=/tmp/x", &target), KBP_ERROR_INVALID_URL);
+    EXPECT_EQ(kbp_resolve(context, "  -P other", &target), KBP_ERROR_INVALID_URL);
+    // スキームのないURLはコマンドラインと同じく補う
+    ASSERT_EQ(kbp_resolve(context, "intranet.example/wiki", &target), KBP_OK);
+    EXPECT_EQ(kbp_resolve(context, nullptr, &target), KBP_ERROR_INVALID_URL);
+    EXPECT_EQ(kbp_resolve(context, "https://kde.org/", nullptr), KBP_ERROR_INVALID_ARGUMENT);
+
+    kbp_close(context);
+}
+
+TEST_F(CApiTest, LaunchRecordsHostHistory)
+{
+    kbp_context* context = nullptr;
+    ASSERT_EQ(kbp_open(KBP_API_VERSION, nullptr, &context), KBP_OK);
+
+    EXPECT_EQ(kbp_launch(context, "firefox", "missing", "https://kde.org/"), KBP_ERROR_NOT_FOUND);
+    EXPECT_EQ(kbp_launch(context, "firefox", "work", "ftp://kde.org/"), KBP_ERROR_INVALID_URL);
+    EXPECT_EQ(kbp_launch(context, "chromium", "Default", "--gpu-launcher=/tmp/x"), KBP_ERROR_INVALID_URL);
+    EXPECT_EQ(kbp_launch(context, nullptr, nullptr, "--renderer-cmd-prefix=/tmp/x"), KBP_ERROR_INVALID_URL);
+    ASSERT_EQ(kbp_launch(context, "firefox", "work", "https://kde.org/"), KBP_OK);
+
+    // 起動したプロファイルがこのホストの振り分け先になる
+    kbp_target target;
+    ASSERT_EQ(kbp_resolve(context, "https://kde.org/news", &target), KBP_OK);
+    EXPECT_STREQ(target.profile_id, "work");
+    EXPECT_EQ(target.reason, KBP_REASON_HOST);
+
+    // 振り分け先を省略した起動
+    EXPECT_EQ(kbp_launch(context, nullptr, nullptr, "https://intranet.example/"), KBP_OK);
+    kbp_close(context);
+
+    // 履歴はピッカーと共有する設定に保存される
+    kbp_context* reopened = nullptr;
+    ASSERT_EQ(kbp_open(KBP_API_VERSION, nullptr, &reopened), KBP_OK);
+    ASSERT_EQ(kbp_resolve(reopened, "https://kde.org/", &target), KBP_OK);
+    EXPECT_STREQ(target.profile_id, "work");
+    kbp_close(reopened);
+}
+
+TEST_F(CApiTest, UsesCallerAllocator)
+{
+    CountingAllocator counter;
+    const kbp_allocator allocator = {&CountingAllocator::allocate, &CountingAllocator::deallocate, &counter};
+
+    kbp_context* context = nullptr;
+    EXPECT_EQ(kbp_open(KBP_API_VERSION + 1, &allocator, &context), KBP_ERROR_VERSION_MISMATCH);
+    EXPECT_EQ(context, nullptr);
+    EXPECT_EQ(counter.allocations, 0);
+
+    ASSERT_EQ(kbp_open(KBP_API_VERSION, &allocator, &context), KBP_OK);
+    EXPECT_EQ(counter.allocations, 1);
+    kbp_close(context);
+    EXPECT_EQ(counter.deallocations, 1);
+
+    const kbp_allocator incomplete = {&CountingAllocator::allocate, nullptr, &counter};
+    EXPECT_EQ(kbp_open(KBP_API_VERSION, &incomplete, &context), KBP_ERROR_INVALID_ARGUMENT);
+    EXPECT_EQ(kbp_open(KBP_API_VERSION, nullptr, nullptr), KBP_ERROR_INVALID_ARGUMENT);
+    kbp_close(nullptr);
+
+    EXPECT_STREQ(kbp_status_string(KBP_ERROR_INVALID_URL), "invalid URL");
+}
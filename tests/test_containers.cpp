@@ -0,0 +1,69 @@
+/**
+ * @file test_containers.cpp
+ * @brief Firefoxコンテナ（サブターゲット）のテスト
+ *
+ * containers.json の解析と、コンテナで開くための ext+container: URLの
+ * 作成を検証します。
+ */
+
+#include <gtest/gtest.h>
+#include <QUrl>
+#include <QUrlQuery>
+
+#include "../src/browserdetector.h"
+
+// Firefox 11x が作成する containers.json（抜粋）
+static const char* CONTAINERS_JSON = R"({
+  "version": 5,
+  "lastUserContextId": 7,
+  "identities": [
+    {"icon": "fingerprint", "color": "blue", "l10nID": "userContextPersonal.label",
+     "accessKey": "userContextPersonal.accesskey", "public": true, "userContextId": 1},
+    {"icon": "briefcase", "color": "orange", "l10nID": "userContextWork.label",
+     "accessKey": "userContextWork.accesskey", "public": true, "userContextId": 2},
+    {"public": false, "icon": "", "color": "", "name": "userContextIdInternal.thumbnail",
+     "accesskey": "", "userContextId": 3},
+    {"public": false, "icon": "", "color": "", "name": "userContextIdInternal.webextStorageLocal",
+     "accesskey": "", "userContextId": 4294967295},
+    {"userContextId": 7, "public": true, "icon": "dollar", "color": "green", "name": "Bank & Tax"}
+  ]
+})";
+
+TEST(Containers, ParsesPublicIdentities)
+{
+    const auto containers = BrowserDetector::parseContainers(CONTAINERS_JSON);
+    ASSERT_EQ(containers.size(), 3);
+
+    // 組み込みコンテナはローカライズ用IDから英語名を割り当てる
+    EXPECT_EQ(containers[0].name, QString("Personal"));
+    EXPECT_EQ(containers[0].userContextId, 1);
+    EXPECT_EQ(containers[0].color, QString("blue"));
+    EXPECT_EQ(containers[1].name, QString("Work"));
+    EXPECT_EQ(containers[1].icon, QString("briefcase"));
+
+    // ユーザー作成のコンテナ
+    EXPECT_EQ(containers[2].name, QString("Bank & Tax"));
+    EXPECT_EQ(containers[2].userContextId, 7);
+}
+
+TEST(Containers, ToleratesMissingOrBrokenFiles)
+{
+    EXPECT_TRUE(BrowserDetector::parseContainers(QByteArray()).isEmpty());
+    EXPECT_TRUE(BrowserDetector::parseContainers("{\"identities\": [").isEmpty());
+    EXPECT_TRUE(BrowserDetector::parseContainers("[]").isEmpty());
+}
+
+TEST(Containers, ContainerUrlEncodesNameAndUrl)
+{
+    const QString url = BrowserDetector::containerUrl(
+        "Bank & Tax", "https://example.com/search?q=a&b=c");
+
+    EXPECT_TRUE(url.startsWith("ext+container:"));
+    // 値に含まれる & や = でパラメータが分割されないこと
+    EXPECT_FALSE(url.contains("Bank & Tax"));
+    EXPECT_FALSE(url.contains("q=a&b=c"));
+
+    const QUrlQuery query(url.mid(QString("ext+container:").size()));
+    EXPECT_EQ(query.queryItemValue("name", QUrl::FullyDecoded), QString("Bank & Tax"));
+    EXPECT_EQ(query.queryItemValue("url", QUrl::FullyDecoded), QString("https://example.com/search?q=a&b=c"));
+}
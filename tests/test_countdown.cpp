@@ -0,0 +1,192 @@
+/**
+ * @file test_countdown.cpp
+ * @brief 自動選択のカウントダウンとアイドル時の起床回数のテスト
+ *
+ * アイドル時の起床回数は /proc/<pid>/status のコンテキストスイッチ数
+ * （voluntary_ctxt_switches + nonvoluntary_ctxt_switches）で数えます。
+ * イベントループはメインスレッドで動くため、スレッドグループリーダーの値がそのまま対象になります。
+ * 計測時間は既定で60秒です。KBP_IDLE_TEST_SECONDS で短縮できます。
+ */
+
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QTimer>
+
+#include "../src/countdown.h"
+
+namespace {
+
+/**
+ * @brief 自プロセスのコンテキストスイッチの合計（取得できない場合は -1）
+ */
+qint64 contextSwitches()
+{
+    QFile status(QString("/proc/%1/status").arg(QCoreApplication::applicationPid()));
+    if (!status.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+
+    qint64 total = 0;
+    int found = 0;
+    for (const QByteArray& line : status.readAll().split('\n')) {
+        if (line.startsWith("voluntary_ctxt_switches:") || line.startsWith("nonvoluntary_ctxt_switches:")) {
+            total += line.mid(line.indexOf(':') + 1).trimmed().toLongLong();
+            ++found;
+        }
+    }
+    return found == 2 ? total : -1;
+}
+
+/**
+ * @brief イベントループを指定時間だけ回す
+ */
+void runEventLoop(int ms)
+{
+    QEventLoop loop;
+    QTimer::singleShot(ms, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+int idleTestSeconds()
+{
+    bool ok = false;
+    const int seconds = qEnvironmentVariableIntValue("KBP_IDLE_TEST_SECONDS", &ok);
+    return ok && seconds > 0 ? seconds : 60;
+}
+
+} // namespace
+
+TEST(Countdown, TicksOncePerSecondAndExpiresOnce)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    Countdown countdown;
+    QList<int> ticks;
+    int expired = 0;
+    QElapsedTimer elapsed;
+    QEventLoop loop;
+    QObject::connect(&countdown, &Countdown::tick, [&](int seconds) { ticks.append(seconds); });
+    QObject::connect(&countdown, &Countdown::expired, [&]() {
+        ++expired;
+        loop.quit();
+    });
+
+    elapsed.start();
+    countdown.start(3);
+    EXPECT_TRUE(countdown.isActive());
+    EXPECT_EQ(countdown.remainingSeconds(), 3);
+    QTimer::singleShot(6000, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    EXPECT_EQ(ticks, QList<int>({3, 2, 1}));
+    EXPECT_EQ(expired, 1);
+    EXPECT_GE(elapsed.elapsed(), 2900);
+    EXPECT_FALSE(countdown.isActive());
+    EXPECT_EQ(countdown.remainingSeconds(), 0);
+
+    // 期限後に追加の通知がないこと
+    runEventLoop(1200);
+    EXPECT_EQ(expired, 1);
+    EXPECT_EQ(ticks.size(), 3);
+}
+
+TEST(Countdown, PauseKeepsRemainingTime)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    Countdown countdown;
+    int expired = 0;
+    QObject::connect(&countdown, &Countdown::expired, [&]() { ++expired; });
+
+    countdown.start(2);
+    runEventLoop(300);
+    countdown.pause();
+    EXPECT_FALSE(countdown.isActive());
+    EXPECT_TRUE(countdown.isPaused());
+    EXPECT_EQ(countdown.remainingSeconds(), 2);
+
+    // 一時停止中は期限を過ぎても満了しない
+    runEventLoop(2500);
+    EXPECT_EQ(expired, 0);
+    EXPECT_EQ(countdown.remainingSeconds(), 2);
+
+    QList<int> ticks;
+    QObject::connect(&countdown, &Countdown::tick, [&](int seconds) { ticks.append(seconds); });
+    countdown.resume();
+    EXPECT_TRUE(countdown.isActive());
+    EXPECT_FALSE(countdown.isPaused());
+    ASSERT_FALSE(ticks.isEmpty());
+    EXPECT_EQ(ticks.first(), 2);
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    QEventLoop loop;
+    QObject::connect(&countdown, &Countdown::expired, &loop, &QEventLoop::quit);
+    QTimer::singleShot(4000, &loop, &QEventLoop::quit);
+    loop.exec();
+    EXPECT_EQ(expired, 1);
+    EXPECT_GE(elapsed.elapsed(), 1500);
+}
+
+TEST(Countdown, StopDiscardsPausedTime)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    Countdown countdown;
+    int ticks = 0;
+    QObject::connect(&countdown, &Countdown::tick, [&]() { ++ticks; });
+
+    countdown.start(5);
+    countdown.pause();
+    countdown.stop();
+    EXPECT_FALSE(countdown.isPaused());
+    EXPECT_EQ(countdown.remainingSeconds(), 0);
+
+    // 停止後の再開は何もしない
+    countdown.resume();
+    EXPECT_FALSE(countdown.isActive());
+    EXPECT_EQ(ticks, 1);
+
+    // 0秒以下は開始しない
+    countdown.start(0);
+    EXPECT_FALSE(countdown.isActive());
+    EXPECT_EQ(ticks, 1);
+}
+
+TEST(Countdown, NoWakeupsWhilePaused)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    ASSERT_GE(contextSwitches(), 0) << "/proc/<pid>/status is not available";
+
+    // 計測方法が起床を検出できることを、実行中のカウントダウンで確認する
+    {
+        Countdown countdown;
+        countdown.start(60);
+        const qint64 before = contextSwitches();
+        runEventLoop(3500);
+        const qint64 wakeups = contextSwitches() - before;
+        EXPECT_GE(wakeups, 3) << "context switch counters did not observe the countdown";
+        countdown.stop();
+    }
+
+    // ウィンドウを隠した状態（一時停止中）ではタイマーを持たない
+    Countdown countdown;
+    countdown.start(5);
+    countdown.pause();
+
+    const int seconds = idleTestSeconds();
+    const qint64 before = contextSwitches();
+    runEventLoop(seconds * 1000);
+    const qint64 wakeups = contextSwitches() - before;
+
+    // 計測用の単発タイマー1回分と、スケジューラーによる若干の横取りのみを許容する
+    EXPECT_LE(wakeups, 5) << wakeups << " wakeups in " << seconds << " idle seconds";
+    EXPECT_EQ(countdown.remainingSeconds(), 5);
+}
@@ -0,0 +1,331 @@
+/**
+ * @file test_detection.cpp
+ * @brief 中断可能な検出と早期選択のテスト
+ *
+ * ブラウザの検出を遅いファイルシステムに見立てて遅延させ、検出中に選択された
+ * プロファイルの起動が残りの検出を待たないことを検証します。
+ */
+
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QTimer>
+
+#include <atomic>
+#include <cstdio>
+
+#include "../src/browserdetector.h"
+
+namespace {
+
+/// 遅いファイルシステムの1ブラウザあたりの検出時間
+constexpr int SLOW_PROBE_MS = 3000;
+
+/// 中断要求を確認しながら待つ（中断された場合は true）
+bool sleepUnlessStopped(int ms, const std::stop_token& stop)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < ms) {
+        if (stop.stop_requested()) {
+            return true;
+        }
+        QThread::msleep(5);
+    }
+    return false;
+}
+
+} // namespace
+
+/**
+ * @brief スタブのFirefox・Chromiumと偽のHOMEを用意するフィクスチャ
+ */
+class DetectionTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(m_home.isValid());
+        m_oldHome = qgetenv("HOME");
+        qputenv("HOME", m_home.path().toUtf8());
+
+        // Firefox: "work" プロファイル
+        const QString mozilla = m_home.path() + "/.mozilla/firefox";
+        ASSERT_TRUE(QDir().mkpath(mozilla + "/abcd.work"));
+        QFile ini(mozilla + "/profiles.ini");
+        ASSERT_TRUE(ini.open(QIODevice::WriteOnly));
+        ini.write("[Profile0]\nName=work\nIsRelative=1\nPath=abcd.work\nDefault=1\n");
+        ini.close();
+
+        // Chromium: "Default" プロファイル
+        const QString chromium = m_home.path() + "/.config/chromium";
+        ASSERT_TRUE(QDir().mkpath(chromium + "/Default"));
+        QFile localState(chromium + "/Local State");
+        ASSERT_TRUE(localState.open(QIODevice::WriteOnly));
+        localState.write(R"({"profile": {"info_cache": {"Default": {"name": "Person 1"}}}})");
+        localState.close();
+
+        // 引数を書き出すスタブのブラウザ
+        m_argsOut = m_home.path() + "/child-args";
+        m_stub = m_home.path() + "/browser-stub";
+        QFile stub(m_stub);
+        ASSERT_TRUE(stub.open(QIODevice::WriteOnly));
+        stub.write("#!/bin/sh\n"
+                   "for a in \"$@\"; do printf '%s\\n' \"$a\"; done > \"$STUB_ARGS_OUT.tmp\"\n"
+                   "mv \"$STUB_ARGS_OUT.tmp\" \"$STUB_ARGS_OUT\"\n");
+        stub.close();
+        stub.setPermissions(QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+        qputenv("STUB_ARGS_OUT", m_argsOut.toUtf8());
+
+        m_snapshot = m_home.path() + "/cache/profiles.json";
+    }
+
+    void TearDown() override {
+        qputenv("HOME", m_oldHome);
+        qunsetenv("STUB_ARGS_OUT");
+    }
+
+    /// スタブのブラウザと設定を使う検出器を設定
+    void configure(BrowserDetector& detector) {
+        detector.setExecutableOverrides({{"firefox", m_stub}, {"chromium", m_stub}});
+        detector.setEnabledOverrides({{"chrome", false}});
+        detector.setSnapshotPath(m_snapshot);
+    }
+
+    /// スタブが書き出した引数を読み込む（最大5秒待つ）
+    QStringList childArguments() {
+        for (int i = 0; i < 500 && !QFile::exists(m_argsOut); ++i) {
+            QThread::msleep(10);
+        }
+        QFile file(m_argsOut);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return {};
+        }
+        return QString::fromUtf8(file.readAll()).split('\n', Qt::SkipEmptyParts);
+    }
+
+    /// detectionFinished() を待つ（最大 timeoutMs）
+    static bool waitForDetection(BrowserDetector& detector, int timeoutMs) {
+        QEventLoop loop;
+        bool finished = false;
+        QObject::connect(&detector, &BrowserDetector::detectionFinished, &loop, [&]() {
+            finished = true;
+            loop.quit();
+        });
+        QTimer::singleShot(timeoutMs, &loop, &QEventLoop::quit);
+        loop.exec();
+        return finished;
+    }
+
+    QTemporaryDir m_home;
+    QByteArray m_oldHome;
+    QString m_stub;
+    QString m_argsOut;
+    QString m_snapshot;
+};
+
+TEST_F(DetectionTest, BackgroundDetectionFinishesAndWritesSnapshot)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    BrowserDetector detector;
+    configure(detector);
+    detector.startDetection();
+    EXPECT_TRUE(detector.isDetecting());
+    ASSERT_TRUE(waitForDetection(detector, 5000));
+    EXPECT_FALSE(detector.isDetecting());
+
+    const auto browsers = detector.cachedBrowsers();
+    ASSERT_TRUE(browsers.contains("firefox"));
+    ASSERT_TRUE(browsers.contains("chromium"));
+    EXPECT_FALSE(browsers.contains("chrome"));
+    EXPECT_TRUE(browsers["firefox"].profiles.contains("work"));
+    EXPECT_TRUE(QFile::exists(m_snapshot));
+
+    // スナップショットは起動引数の展開済みの状態で読み込まれる
+    BrowserDetector restored;
+    configure(restored);
+    ASSERT_TRUE(restored.loadSnapshot());
+    const auto snapshot = restored.cachedBrowsers();
+    ASSERT_TRUE(snapshot.contains("firefox"));
+    EXPECT_EQ(snapshot["firefox"].executable, m_stub);
+    EXPECT_EQ(snapshot["firefox"].profiles["work"].path, QString("abcd.work"));
+    EXPECT_EQ(snapshot["firefox"].profiles["work"].launch.argumentsFor("https://example.com"),
+              QStringList({"-P", "work", "https://example.com"}));
+    EXPECT_TRUE(snapshot["chromium"].profiles.contains("Default"));
+}
+
+TEST_F(DetectionTest, EarlyPickDoesNotWaitForRemainingProbes)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    // Chromiumのユーザーデータは遅いファイルシステム上にある
+    std::atomic<bool> chromiumCancelled(false);
+    QElapsedTimer total;
+    {
+        BrowserDetector detector;
+        configure(detector);
+        detector.setSnapshotPath(QString());
+        detector.setProbeHook([&chromiumCancelled](const QString& browserId, const std::stop_token& stop) {
+            if (browserId == "chromium" && sleepUnlessStopped(SLOW_PROBE_MS, stop)) {
+                chromiumCancelled = true;
+            }
+        });
+
+        total.start();
+        detector.startDetection();
+        QThread::msleep(50);
+
+        // スナップショットなし: Firefoxだけを検出して起動する
+        QElapsedTimer latency;
+        latency.start();
+        detector.cancelDetection();
+        ASSERT_TRUE(detector.resolveProfile("firefox", "work"));
+        ASSERT_TRUE(detector.launchBrowser("firefox", "work", "https://example.com"));
+        const qint64 launchMs = latency.elapsed();
+
+        std::printf("early pick: launch %lld ms while chromium probe takes %d ms\n",
+                    static_cast<long long>(launchMs), SLOW_PROBE_MS);
+        EXPECT_LT(launchMs, SLOW_PROBE_MS / 3);
+        EXPECT_FALSE(detector.isDetecting());
+        EXPECT_EQ(childArguments(), QStringList({"-P", "work", "https://example.com"}));
+
+        // 中断された検出の結果は反映されない
+        QCoreApplication::processEvents();
+        EXPECT_FALSE(detector.cachedBrowsers().contains("chromium"));
+    }
+
+    // 破棄時は中断済みの検出の終了を待つだけで、遅い検出の完了までは待たない
+    EXPECT_TRUE(chromiumCancelled);
+    EXPECT_LT(total.elapsed(), SLOW_PROBE_MS);
+}
+
+TEST_F(DetectionTest, EarlyPickFromSnapshotSkipsProbing)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    {
+        BrowserDetector first;
+        configure(first);
+        first.startDetection();
+        ASSERT_TRUE(waitForDetection(first, 5000));
+    }
+
+    // 全ブラウザが遅いファイルシステム上にあっても、スナップショットから起動できる
+    BrowserDetector detector;
+    configure(detector);
+    detector.setProbeHook([](const QString&, const std::stop_token& stop) {
+        sleepUnlessStopped(SLOW_PROBE_MS, stop);
+    });
+    ASSERT_TRUE(detector.loadSnapshot());
+    detector.startDetection();
+
+    QElapsedTimer latency;
+    latency.start();
+    detector.cancelDetection();
+    ASSERT_TRUE(detector.resolveProfile("chromium", "Default"));
+    ASSERT_TRUE(detector.launchBrowser("chromium", "Default", "https://example.com"));
+    const qint64 launchMs = latency.elapsed();
+
+    EXPECT_LT(launchMs, SLOW_PROBE_MS / 3);
+    EXPECT_EQ(childArguments(), QStringList({"--profile-directory=Default", "https://example.com"}));
+}
+
+TEST_F(DetectionTest, StaleSnapshotFallsBackToPointLookup)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    {
+        BrowserDetector first;
+        configure(first);
+        first.startDetection();
+        ASSERT_TRUE(waitForDetection(first, 5000));
+    }
+
+    // スナップショットの作成後にプロファイルが削除された
+    ASSERT_TRUE(QDir(m_home.path() + "/.mozilla/firefox/abcd.work").removeRecursively());
+    QFile ini(m_home.path() + "/.mozilla/firefox/profiles.ini");
+    ASSERT_TRUE(ini.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    ini.close();
+
+    BrowserDetector detector;
+    configure(detector);
+    ASSERT_TRUE(detector.loadSnapshot());
+    EXPECT_TRUE(detector.cachedBrowsers()["firefox"].profiles.contains("work"));
+    EXPECT_FALSE(detector.resolveProfile("firefox", "work"));
+    EXPECT_FALSE(detector.cachedBrowsers()["firefox"].profiles.contains("work"));
+}
+
+TEST_F(DetectionTest, PointLookupSkipsEnumeration)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    // 他のプロファイル（Chromiumの "Profile 2" はディレクトリなし）も一覧に含まれる
+    QFile ini(m_home.path() + "/.mozilla/firefox/profiles.ini");
+    ASSERT_TRUE(ini.open(QIODevice::Append));
+    ini.write("\n[Profile1]\nName=personal\nIsRelative=1\nPath=efgh.personal\n");
+    ini.close();
+    ASSERT_TRUE(QDir().mkpath(m_home.path() + "/.mozilla/firefox/efgh.personal"));
+
+    const QString chromium = m_home.path() + "/.config/chromium";
+    ASSERT_TRUE(QDir().mkpath(chromium + "/Profile 1"));
+    QFile localState(chromium + "/Local State");
+    ASSERT_TRUE(localState.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    localState.write(R"({"profile": {"info_cache": {"Default": {"name": "Person 1"},)"
+                     R"( "Profile 1": {"name": "Work"}, "Profile 2": {"name": "Gone"}}}})");
+    localState.close();
+
+    BrowserDetector detector;
+    configure(detector);
+    int probes = 0;
+    detector.setProbeHook([&probes](const QString&, const std::stop_token&) { ++probes; });
+
+    ASSERT_TRUE(detector.resolveProfile("firefox", "work"));
+    ASSERT_TRUE(detector.resolveProfile("chromium", "Profile 1"));
+    EXPECT_EQ(probes, 0);
+
+    // 対象のプロファイルだけがキャッシュに入り、一覧表示用の情報は読まない
+    const auto browsers = detector.cachedBrowsers();
+    EXPECT_EQ(browsers["firefox"].executable, m_stub);
+    EXPECT_EQ(QStringList(browsers["firefox"].profiles.keys()), QStringList({"work"}));
+    EXPECT_FALSE(browsers["firefox"].profiles["work"].lastUsed.isValid());
+    EXPECT_EQ(QStringList(browsers["chromium"].profiles.keys()), QStringList({"Profile 1"}));
+    EXPECT_EQ(browsers["chromium"].profiles["Profile 1"].displayName, QString("Work"));
+
+    ASSERT_TRUE(detector.launchBrowser("chromium", "Profile 1", "https://example.com"));
+    EXPECT_EQ(childArguments(), QStringList({"--profile-directory=Profile 1", "https://example.com"}));
+
+    // 2回目以降は既に確認したエントリを使う
+    ASSERT_TRUE(detector.resolveProfile("firefox", "personal"));
+    EXPECT_EQ(detector.cachedBrowsers()["firefox"].profiles.size(), 2);
+    EXPECT_EQ(probes, 0);
+}
+
+TEST_F(DetectionTest, PointLookupRejectsUnavailableProfiles)
+{
+    BrowserDetector detector;
+    configure(detector);
+
+    // 一覧にないプロファイル、ディレクトリのないプロファイル、不正なID
+    EXPECT_FALSE(detector.resolveProfile("firefox", "missing"));
+    EXPECT_FALSE(detector.resolveProfile("chromium", "Profile 2"));
+    EXPECT_FALSE(detector.resolveProfile("chromium", "../Default"));
+    EXPECT_FALSE(detector.resolveProfile("safari", "Default"));
+
+    // 無効化されたブラウザ
+    EXPECT_FALSE(detector.resolveProfile("chrome", "Default"));
+
+    // 実行ファイルが見つからない
+    BrowserDetector missingExec;
+    missingExec.setExecutableOverrides({{"chromium", m_home.path() + "/no-such-browser"}});
+    EXPECT_FALSE(missingExec.resolveProfile("chromium", "Default"));
+    EXPECT_FALSE(missingExec.cachedBrowsers().contains("chromium"));
+}
@@ -0,0 +1,519 @@
+/**
+ * @file test_detectionarena.cpp
+ * @brief 検出のアリーナとパーサー、および検出1回あたりのヒープ確保回数のテスト
+ *
+ * malloc/calloc/realloc をこの実行ファイルで置き換えて回数を数え（Qt・libstdc++ の確保も含む）、
+ * 偽のホームに対する detectBrowsers() の確保回数を「基本 + プロファイルあたり」で確認します。
+ * 比較のため、アリーナ導入前のプロファイルの読み込み（QSettings・QJsonDocument・QFileInfo）に
+ * 差し替えた検出の回数も数え、作業データの確保が1桁以上減っていることを確認します。
+ */
+
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QSettings>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../src/browserdetector.h"
+#include "../src/detectionarena.h"
+#include "../include/constants.h"
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+}
+
+namespace {
+
+std::atomic<bool> g_counting{false};
+std::atomic<long> g_allocations{0};
+
+void countAllocation()
+{
+    if (g_counting.load(std::memory_order_relaxed)) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+/// 関数の実行中のヒープ確保回数
+template <typename Function>
+long countAllocations(Function&& function)
+{
+    g_allocations = 0;
+    g_counting = true;
+    function();
+    g_counting = false;
+    return g_allocations.load();
+}
+
+} // namespace
+
+extern "C" void* malloc(size_t size) noexcept
+{
+    countAllocation();
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) noexcept
+{
+    countAllocation();
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size) noexcept
+{
+    countAllocation();
+    return __libc_realloc(pointer, size);
+}
+
+namespace {
+
+/// 1回の検出の確保回数の予算（基本 + Firefox・Chromiumのプロファイル1組あたり）
+constexpr long BASE_BUDGET = 600;
+constexpr long PER_PROFILE_BUDGET = 16;
+
+/// firstUse に書き込む時刻（ミリ秒）
+constexpr qint64 FIRST_USE_MS = 1700000000000;
+
+/*
+ * アリーナ導入前の getFirefoxProfiles() / getChromeProfiles() とその下請け関数（比較用）。
+ * BrowserDetector::setProfileReader() で差し替え、同じ detectBrowsers() の中で確保回数を数えます。
+ * 下請け関数は置き換えた実装そのままで、メンバー関数を自由関数にし、トレースの出力を除いています。
+ */
+
+QString legacyChromiumAvatarPath(const QString& configDir, const QString& profileDir, const QJsonObject& info)
+{
+    // サインイン中のGoogleアカウントの写真（プロファイルディレクトリ内）
+    const QString gaiaPicture = info.value("gaia_picture_file_name").toString();
+    if (!gaiaPicture.isEmpty() && !gaiaPicture.contains('/') &&
+        info.value("use_gaia_picture").toBool(true)) {
+        return configDir + "/" + profileDir + "/" + gaiaPicture;
+    }
+
+    // 組み込みアバター "chrome://theme/IDR_PROFILE_AVATAR_<n>" はダウンロード済みの高解像度版のみ使用
+    static const QStringList highResAvatars = {
+        "avatar_generic.png", "avatar_generic_aqua.png", "avatar_generic_blue.png",
+        "avatar_generic_green.png", "avatar_generic_orange.png", "avatar_generic_purple.png",
+        "avatar_generic_red.png", "avatar_generic_yellow.png", "avatar_secret_agent.png",
+        "avatar_superhero.png", "avatar_volley_ball.png", "avatar_businessman.png",
+        "avatar_ninja.png", "avatar_alien.png", "avatar_smiley.png", "avatar_flower.png",
+        "avatar_pizza.png", "avatar_soccer.png", "avatar_burger.png", "avatar_cat.png",
+        "avatar_cupcake.png", "avatar_dog.png", "avatar_horse.png", "avatar_margarita.png",
+        "avatar_note.png", "avatar_sun_cloud.png",
+    };
+    static const QRegularExpression builtin(R"(^chrome://theme/IDR_PROFILE_AVATAR_(\d+)$)");
+    const QRegularExpressionMatch match = builtin.match(info.value("avatar_icon").toString());
+    if (match.hasMatch()) {
+        const int index = match.captured(1).toInt();
+        if (index >= 0 && index < highResAvatars.size()) {
+            return configDir + "/Avatars/" + highResAvatars.at(index);
+        }
+    }
+
+    return QString();
+}
+
+QDateTime legacyProfileLastUsed(const QString& browserPath, const QString& profilePath)
+{
+    // For Firefox, check times.json
+    if (browserPath == "firefox") {
+        QString timesPath = profilePath + "/times.json";
+        if (QFile::exists(timesPath)) {
+            QFile file(timesPath);
+            if (file.open(QIODevice::ReadOnly)) {
+                QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+                file.close();
+
+                if (doc.isObject()) {
+                    QJsonObject times = doc.object();
+                    qint64 firstUse = static_cast<qint64>(times["firstUse"].toDouble() / 1000); // Convert from ms to s
+                    if (firstUse > 0) {
+                        return QDateTime::fromSecsSinceEpoch(firstUse);
+                    }
+                }
+            }
+        }
+    }
+
+    // For Chrome/Chromium, check Preferences file
+    else if (browserPath == "chrome" || browserPath == "chromium") {
+        QString prefsPath = profilePath + "/Preferences";
+        if (QFile::exists(prefsPath)) {
+            // Just use file modification time for now
+            QFileInfo info(prefsPath);
+            return info.lastModified();
+        }
+    }
+
+    // Fallback: use directory modification time
+    QFileInfo dirInfo(profilePath);
+    return dirInfo.lastModified();
+}
+
+void legacyParseFirefoxIni(const QString& iniPath, QMap<QString, BrowserDetector::ProfileInfo>& profiles)
+{
+    QSettings settings(iniPath, QSettings::IniFormat);
+
+    // Firefoxは[Profile0], [Profile1]などのセクションを使用
+    QStringList groups = settings.childGroups();
+
+    for (const QString& group : groups) {
+        if (!group.startsWith("Profile")) {
+            continue;
+        }
+
+        settings.beginGroup(group);
+
+        QString name = settings.value("Name").toString();
+        QString path = settings.value("Path").toString();
+        bool isDefault = settings.value("Default", false).toBool();
+
+        if (!name.isEmpty() && !path.isEmpty()) {
+            BrowserDetector::ProfileInfo info(name, path);
+            info.isDefault = isDefault;
+            profiles[name] = info;
+        }
+
+        settings.endGroup();
+    }
+}
+
+void legacyParseChromiumLocalState(const QString& localStatePath, const QString& configDir,
+                                   QMap<QString, BrowserDetector::ProfileInfo>& profiles)
+{
+    QFile file(localStatePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QByteArray data = file.readAll();
+    file.close();
+
+    QJsonDocument doc = QJsonDocument::fromJson(data);
+    if (!doc.isObject()) {
+        return;
+    }
+
+    QJsonObject root = doc.object();
+    QJsonObject profileObj = root["profile"].toObject();
+    QJsonObject infoCache = profileObj["info_cache"].toObject();
+
+    // Always add Default profile
+    BrowserDetector::ProfileInfo defaultProfile("Default", "Default");
+    defaultProfile.displayName = "Default";
+    profiles["Default"] = defaultProfile;
+
+    // Parse other profiles
+    for (auto it = infoCache.begin(); it != infoCache.end(); ++it) {
+        QString profileDir = it.key();
+        QJsonObject info = it.value().toObject();
+
+        QString name = info["name"].toString();
+        if (name.isEmpty()) {
+            name = profileDir;
+        }
+
+        BrowserDetector::ProfileInfo profile(name, profileDir);
+        profile.displayName = name;
+        profile.avatarPath = legacyChromiumAvatarPath(configDir, profileDir, info);
+
+        // Check if this profile exists
+        QString profilePath = configDir + "/" + profileDir;
+        if (QDir(profilePath).exists()) {
+            profiles[profileDir] = profile;
+        }
+    }
+}
+
+/// アリーナ導入前の getFirefoxProfiles() / getChromeProfiles()
+QMap<QString, BrowserDetector::ProfileInfo> legacyProfiles(BrowserDetector* detector, const QString& browserName,
+                                                           const std::stop_token& stop)
+{
+    QMap<QString, BrowserDetector::ProfileInfo> profiles;
+    const bool firefox = browserName == "firefox";
+
+    QString configPath = firefox ? QDir::homePath() + "/.mozilla/firefox"
+                                 : QDir::homePath() + "/.config/" + browserName;
+    QString configFile = configPath + "/" + (firefox ? Constants::FIREFOX_CONFIG : Constants::CHROME_CONFIG);
+    if (!QFile::exists(configFile)) {
+        return profiles;
+    }
+
+    if (firefox) {
+        legacyParseFirefoxIni(configFile, profiles);
+    } else {
+        legacyParseChromiumLocalState(configFile, configPath, profiles);
+    }
+
+    for (auto& profile : profiles) {
+        if (stop.stop_requested()) {
+            break;
+        }
+        QString profileFullPath = configPath + "/" + profile.path;
+        profile.lastUsed = legacyProfileLastUsed(browserName, profileFullPath);
+        emit detector->profileDetected(browserName, profile.name);
+    }
+
+    return profiles;
+}
+
+/**
+ * @brief 検出結果と同じ文字列・マップを新しく作り直す
+ *
+ * 結果として残す QString / QMap の確保はどちらの実装でも必要なため、
+ * この回数を差し引いた残り（作業データの確保）で実装を比較します。
+ */
+void materialise(const QMap<QString, BrowserDetector::BrowserInfo>& browsers)
+{
+    const auto copy = [](const QString& text) { return QString(text.constData(), text.size()); };
+    QMap<QString, QMap<QString, BrowserDetector::ProfileInfo>> result;
+    for (auto browser = browsers.cbegin(); browser != browsers.cend(); ++browser) {
+        QMap<QString, BrowserDetector::ProfileInfo>& profiles = result[browser.key()];
+        for (auto it = browser->profiles.cbegin(); it != browser->profiles.cend(); ++it) {
+            BrowserDetector::ProfileInfo profile(copy(it->name), copy(it->path));
+            profile.avatarPath = copy(it->avatarPath);
+            for (const QString& arg : it->launch.args) {
+                profile.launch.args.append(copy(arg));
+            }
+            profiles.insert(copy(it.key()), profile);
+        }
+    }
+}
+
+} // namespace
+
+/**
+ * @brief 指定数のFirefox・Chromiumプロファイルを持つ偽のホームを用意するフィクスチャ
+ */
+class DetectionArenaTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        m_oldHome = qgetenv("HOME");
+        m_stub = m_stubDir.path() + "/browser-stub";
+        QFile stub(m_stub);
+        ASSERT_TRUE(stub.open(QIODevice::WriteOnly));
+        stub.write("#!/bin/sh\nexit 0\n");
+        stub.close();
+        stub.setPermissions(QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+    }
+
+    void TearDown() override {
+        qputenv("HOME", m_oldHome);
+    }
+
+    /// profiles 組のプロファイルを作成
+    static bool createHome(const QTemporaryDir& home, int profiles) {
+        const QString mozilla = home.path() + "/.mozilla/firefox";
+        const QString chromium = home.path() + "/.config/chromium";
+        QByteArray ini = "[General]\nStartWithLastProfile=1\nVersion=2\n\n";
+        QByteArray entries;
+        for (int i = 0; i < profiles; ++i) {
+            const QString dir = QString("p%1.profile-%1").arg(i, 3, 10, QChar('0'));
+            ini += QString("[Profile%1]\nName=profile-%2\nIsRelative=1\nPath=%3\n%4\n")
+                       .arg(i).arg(i, 3, 10, QChar('0')).arg(dir).arg(i == 0 ? "Default=1\n" : "")
+                       .toUtf8();
+            if (!writeFile(mozilla + "/" + dir + "/times.json",
+                           QString(R"({"created":%1,"firstUse":%1})").arg(FIRST_USE_MS).toUtf8())) {
+                return false;
+            }
+
+            // 実際の Local State と同程度のキーを持つエントリ
+            const QString chromiumDir = i == 0 ? QString("Default") : QString("Profile %1").arg(i);
+            if (!writeFile(chromium + "/" + chromiumDir + "/Preferences", "{}")) {
+                return false;
+            }
+            entries += QString(R"(%1"%2": {"active_time": 1700000000.5, "avatar_icon": )"
+                               R"("chrome://theme/IDR_PROFILE_AVATAR_%3", "background_apps": false, )"
+                               R"("force_signin_profile_locked": false, "gaia_given_name": "", "gaia_id": "", )"
+                               R"("gaia_name": "", "hosted_domain": "", "is_consented_primary_account": false, )"
+                               R"("is_ephemeral": false, "is_using_default_avatar": true, )"
+                               R"("is_using_default_name": true, "managed_user_id": "", )"
+                               R"("metrics_bucket_index": %4, "name": "Person é %4", )"
+                               R"("shortcut_name": "Person %4", "user_name": ""})")
+                           .arg(i == 0 ? "" : ", ").arg(chromiumDir).arg(i % 26).arg(i + 1)
+                           .toUtf8();
+        }
+        return writeFile(mozilla + "/profiles.ini", ini) &&
+               writeFile(chromium + "/Local State",
+                         R"({"browser": {"enabled_labs_experiments": [], "last_redirect_origin": ""}, )"
+                         R"("profile": {"info_cache": {)" + entries + R"(}, "last_used": "Default", )"
+                         R"("profiles_order": ["Default"]}, "variations_seed": "abc"})");
+    }
+
+    static bool writeFile(const QString& path, const QByteArray& contents) {
+        if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+            return false;
+        }
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return false;
+        }
+        return file.write(contents) == contents.size();
+    }
+
+    /// スタブのブラウザを使う検出器を設定
+    void configure(BrowserDetector& detector) const {
+        detector.setExecutableOverrides({{"firefox", m_stub}, {"chromium", m_stub}});
+        detector.setEnabledOverrides({{"chrome", false}});
+    }
+
+    /**
+     * @brief 検出1回の確保回数
+     * @param legacy true: アリーナ導入前のプロファイルの読み込みを使う
+     * @param output 結果の文字列・マップを作り直す確保回数を返す（nullptr可）
+     */
+    long detectionAllocations(const QTemporaryDir& home, bool legacy = false, long* output = nullptr) {
+        qputenv("HOME", home.path().toUtf8());
+        BrowserDetector detector;
+        configure(detector);
+        if (legacy) {
+            detector.setProfileReader([&detector](const QString& browserName, const std::stop_token& stop) {
+                return legacyProfiles(&detector, browserName, stop);
+            });
+        }
+        QMap<QString, BrowserDetector::BrowserInfo> browsers;
+        const long count = countAllocations([&]() { browsers = detector.detectBrowsers(); });
+        EXPECT_EQ(browsers.size(), 2);
+        if (output) {
+            *output = countAllocations([&]() { materialise(browsers); });
+        }
+        return count;
+    }
+
+    QTemporaryDir m_stubDir;
+    QByteArray m_oldHome;
+    QString m_stub;
+};
+
+TEST(DetectionArenaParserTest, ParsesProfilesIni)
+{
+    DetectionArena arena;
+    std::pmr::vector<DetectionArena::FirefoxEntry> entries(arena.resource());
+    DetectionArena::parseProfilesIni("[General]\nName=ignored\nPath=ignored\n\n"
+                                     "[Profile1]\r\nName = work \r\nIsRelative=1\r\nPath=\"a1.work\"\r\nDefault=1\r\n"
+                                     "; comment\n[Install4F96D1932A9F858E]\nDefault=a1.work\n\n"
+                                     "[Profile0]\nName=日本語\nPath=b2.ja\nDefault=false\n"
+                                     "[Profile2]\nName=no-path\n",
+                                     &entries);
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0].name, "work");
+    EXPECT_EQ(entries[0].path, "a1.work");
+    EXPECT_TRUE(entries[0].isDefault);
+    EXPECT_EQ(DetectionArena::toQString(entries[1].name), QString::fromUtf8("日本語"));
+    EXPECT_FALSE(entries[1].isDefault);
+}
+
+TEST(DetectionArenaParserTest, ParsesLocalStateInfoCache)
+{
+    DetectionArena arena;
+    std::pmr::vector<DetectionArena::ChromiumEntry> entries(arena.resource());
+    ASSERT_TRUE(arena.parseLocalState(
+        R"({"browser": {"list": [1, -2.5e3, {"a": null}]}, "profile": {"info_cache": {)"
+        R"("Default": {"name": "Person \"1\" é😀", "use_gaia_picture": false,)"
+        R"( "avatar_icon": "chrome://theme/IDR_PROFILE_AVATAR_3"},)"
+        R"( "Profile 1": {"name": 5, "gaia_picture_file_name": "Google Profile Picture.png"},)"
+        R"( "Profile 2": []}}})",
+        &entries));
+    ASSERT_EQ(entries.size(), 3u);
+    EXPECT_EQ(entries[0].directory, "Default");
+    EXPECT_EQ(DetectionArena::toQString(entries[0].name), QString::fromUtf8("Person \"1\" é😀"));
+    EXPECT_FALSE(entries[0].useGaiaPicture);
+    EXPECT_EQ(entries[0].avatarIcon, "chrome://theme/IDR_PROFILE_AVATAR_3");
+    // 文字列でない値は QJsonValue::toString() と同じく空
+    EXPECT_TRUE(entries[1].name.empty());
+    EXPECT_EQ(entries[1].gaiaPicture, "Google Profile Picture.png");
+    EXPECT_TRUE(entries[1].useGaiaPicture);
+    EXPECT_EQ(entries[2].directory, "Profile 2");
+
+    // QJsonDocument と同じく、不正なJSONは全体を拒否する
+    for (const char* invalid : {"", "[]", R"({"profile": {}} trailing)", R"({"a": 1,})", R"({"a": "\x"})",
+                                R"({"a": tru})", R"({"a": "unterminated})"}) {
+        EXPECT_FALSE(arena.parseLocalState(invalid, &entries)) << invalid;
+    }
+}
+
+TEST(DetectionArenaParserTest, ParsesFirstUseAndConvertsPaths)
+{
+    DetectionArena arena;
+    EXPECT_EQ(arena.parseFirstUse(R"({"created": 1, "firstUse": 1700000000123})"), 1700000000123.0);
+    EXPECT_EQ(arena.parseFirstUse(R"({"firstUse": null})"), 0.0);
+    EXPECT_EQ(arena.parseFirstUse("not json"), 0.0);
+
+    EXPECT_EQ(arena.utf8(QString::fromUtf8("/home/ユーザー/😀")), "/home/ユーザー/😀");
+    EXPECT_EQ(arena.join({"/a", "/", "b c"}), "/a/b c");
+}
+
+TEST_F(DetectionArenaTest, DetectsRealisticProfiles)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    QTemporaryDir home;
+    ASSERT_TRUE(createHome(home, 3));
+    qputenv("HOME", home.path().toUtf8());
+    BrowserDetector detector;
+    configure(detector);
+    const auto browsers = detector.detectBrowsers();
+
+    const auto firefox = browsers.value("firefox").profiles;
+    ASSERT_EQ(firefox.size(), 3);
+    EXPECT_TRUE(firefox.value("profile-000").isDefault);
+    EXPECT_EQ(firefox.value("profile-001").path, "p001.profile-001");
+    EXPECT_EQ(firefox.value("profile-001").lastUsed.toMSecsSinceEpoch(), FIRST_USE_MS);
+    EXPECT_EQ(firefox.value("profile-002").launch.args, QStringList({"-P", "profile-002"}));
+
+    // info_cache の全エントリに加え、常に Default を含む
+    const auto chromium = browsers.value("chromium").profiles;
+    ASSERT_EQ(chromium.size(), 3);
+    EXPECT_EQ(chromium.value("Profile 2").displayName, QString::fromUtf8("Person é 3"));
+    EXPECT_EQ(chromium.value("Profile 2").avatarPath,
+              home.path() + "/.config/chromium/Avatars/avatar_generic_blue.png");
+    EXPECT_EQ(chromium.value("Profile 1").launch.args, QStringList({"--profile-directory=Profile 1"}));
+}
+
+TEST_F(DetectionArenaTest, AllocationsPerPassStayWithinBudget)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    QTemporaryDir small;
+    QTemporaryDir large;
+    ASSERT_TRUE(createHome(small, 20));
+    ASSERT_TRUE(createHome(large, 200));
+
+    // 初回のみの初期化（静的な文字列・ロケール・タイムゾーン）を除くため一度実行しておく
+    detectionAllocations(small);
+
+    long smallOutput = 0;
+    long largeOutput = 0;
+    const long smallCount = detectionAllocations(small, false, &smallOutput);
+    const long largeCount = detectionAllocations(large, false, &largeOutput);
+    const long perProfile = (largeCount - smallCount) / 180;
+    const long outputPerProfile = (largeOutput - smallOutput) / 180;
+
+    detectionAllocations(small, true);
+    const long legacyPerProfile = (detectionAllocations(large, true) - detectionAllocations(small, true)) / 180;
+
+    // 結果の QString / QMap を除いた作業データの確保（0以下は結果の分だけで済んでいる）
+    const long scratchPerProfile = perProfile - outputPerProfile;
+    const long legacyScratchPerProfile = legacyPerProfile - outputPerProfile;
+    std::printf("allocations per detection pass: %ld (20 profiles), %ld (200 profiles), "
+                "%ld per profile (%ld for the result); before the arena: %ld per profile\n",
+                smallCount, largeCount, perProfile, outputPerProfile, legacyPerProfile);
+
+    EXPECT_LE(largeCount, BASE_BUDGET + PER_PROFILE_BUDGET * 200);
+    EXPECT_LE(perProfile, PER_PROFILE_BUDGET);
+    EXPECT_GE(legacyScratchPerProfile, 10 * std::max(scratchPerProfile, 1L));
+}
@@ -0,0 +1,121 @@
+/**
+ * @file test_dnsprefetch.cpp
+ * @brief URLのホスト名の先行解決のテスト
+ *
+ * 外部のDNSサーバーに依存しないよう、hosts ファイルで解決される localhost を使います。
+ */
+
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+
+#include "../src/dnsprefetch.h"
+
+namespace {
+
+/**
+ * @brief イベントループを指定時間だけ回す
+ */
+void runEventLoop(int ms)
+{
+    QEventLoop loop;
+    QTimer::singleShot(ms, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+} // namespace
+
+TEST(DnsPrefetch, SkipsLiteralsAndLocalSchemes)
+{
+    EXPECT_EQ(DnsPrefetcher::hostToResolve("https://example.com/path?q=1"), QString("example.com"));
+    EXPECT_EQ(DnsPrefetcher::hostToResolve("http://Example.COM:8080/"), QString("example.com"));
+    EXPECT_TRUE(DnsPrefetcher::hostToResolve("file:///etc/hosts").isEmpty());
+    EXPECT_TRUE(DnsPrefetcher::hostToResolve("mailto:user@example.com").isEmpty());
+    EXPECT_TRUE(DnsPrefetcher::hostToResolve("https://192.0.2.1/").isEmpty());
+    EXPECT_TRUE(DnsPrefetcher::hostToResolve("http://[2001:db8::1]:8080/").isEmpty());
+    EXPECT_TRUE(DnsPrefetcher::hostToResolve("about:blank").isEmpty());
+    EXPECT_TRUE(DnsPrefetcher::hostToResolve("").isEmpty());
+
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    DnsPrefetcher prefetcher;
+    EXPECT_FALSE(prefetcher.prefetch("file:///tmp/page.html"));
+    EXPECT_FALSE(prefetcher.prefetch("https://127.0.0.1/"));
+    EXPECT_EQ(prefetcher.issued(), 0);
+}
+
+TEST(DnsPrefetch, ResolvesFromHostsFile)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    DnsPrefetcher prefetcher;
+    QStringList hosts;
+    bool resolved = false;
+    QEventLoop loop;
+    QObject::connect(&prefetcher, &DnsPrefetcher::finished, [&](const QString& host, bool ok) {
+        hosts.append(host);
+        resolved = ok;
+        loop.quit();
+    });
+
+    ASSERT_TRUE(prefetcher.prefetch("http://localhost:8080/index.html"));
+    EXPECT_EQ(prefetcher.issued(), 1);
+    QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    EXPECT_EQ(hosts, QStringList({"localhost"}));
+    EXPECT_TRUE(resolved);
+    EXPECT_EQ(prefetcher.completed(), 1);
+    EXPECT_EQ(prefetcher.cancelled(), 0);
+
+    // 同じホストは二度解決しない
+    EXPECT_FALSE(prefetcher.prefetch("https://localhost/other"));
+    EXPECT_EQ(prefetcher.issued(), 1);
+}
+
+TEST(DnsPrefetch, CancelDropsTheResult)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    DnsPrefetcher prefetcher;
+    int finished = 0;
+    QObject::connect(&prefetcher, &DnsPrefetcher::finished, [&]() { ++finished; });
+
+    ASSERT_TRUE(prefetcher.prefetch("http://localhost/"));
+    prefetcher.cancel();
+
+    // 取り消したか、実行中だったものが完了するまで待つ
+    QElapsedTimer elapsed;
+    elapsed.start();
+    while (prefetcher.completed() + prefetcher.cancelled() < 1 && elapsed.elapsed() < 5000) {
+        runEventLoop(10);
+    }
+    runEventLoop(100);
+
+    EXPECT_EQ(prefetcher.issued(), 1);
+    EXPECT_EQ(prefetcher.completed() + prefetcher.cancelled(), 1);
+    EXPECT_EQ(finished, 0);
+
+    // 取り消した後は同じホストをもう一度解決できる
+    EXPECT_TRUE(prefetcher.prefetch("http://localhost/"));
+    EXPECT_EQ(prefetcher.issued(), 2);
+}
+
+TEST(DnsPrefetch, DestroyingWithPendingLookupIsSafe)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    {
+        DnsPrefetcher prefetcher;
+        ASSERT_TRUE(prefetcher.prefetch("http://localhost/"));
+    }
+
+    // 破棄後に完了した通知が解放済みのオブジェクトに届かないこと
+    runEventLoop(500);
+}
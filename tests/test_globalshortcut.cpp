@@ -0,0 +1,263 @@
+/**
+ * @file test_globalshortcut.cpp
+ * @brief グローバルショートカットによるクリップボードのURLの受け渡しのテスト
+ *
+ * kglobalaccel の代わりに org.kde.kglobalaccel を名乗る偽のサービスを別の接続で公開し、
+ * ショートカットの登録と、押下シグナルから urlRequested() までの経路を検証します。
+ * トレイメニューからの起動で、選ばれたアクションの通知中にメニューが作り直されないことも検証します。
+ * 実行中のデスクトップに影響しないよう、dbus-run-session の専用バスで実行してください。
+ */
+
+#include <gtest/gtest.h>
+#include <QApplication>
+#include <QClipboard>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusObjectPath>
+#include <QDBusVirtualObject>
+#include <QElapsedTimer>
+#include <QMenu>
+#include <QMutex>
+#include <QPointer>
+#include <QThread>
+
+#include <functional>
+
+#include "../src/kdeintegration.h"
+#include "../src/configmanager.h"
+#include "../src/profilemanager.h"
+#include "../include/constants.h"
+#include "fakehome.h"
+
+namespace {
+
+constexpr auto SERVICE = "org.kde.kglobalaccel";
+constexpr auto COMPONENT_PATH = "/component/kde_browser_picker";
+
+/**
+ * @brief kglobalaccel の最小限の代役
+ *
+ * 全てのメソッド呼び出しを記録し、getComponent にはコンポーネントのパスを、
+ * setShortcut* には要求されたキーをそのまま返します。
+ */
+class FakeKGlobalAccel : public QDBusVirtualObject {
+public:
+    bool handleMessage(const QDBusMessage& message, const QDBusConnection& connection) override {
+        {
+            QMutexLocker lock(&m_mutex);
+            m_calls << message.member();
+            if (message.member() == "doRegister") {
+                m_registered << message.arguments().value(0).toStringList();
+            }
+        }
+
+        QDBusMessage reply;
+        if (message.member() == "getComponent") {
+            reply = message.createReply(QVariant::fromValue(QDBusObjectPath(COMPONENT_PATH)));
+        } else if (message.member().startsWith("setShortcut") && message.arguments().size() > 1) {
+            reply = message.createReply(message.arguments().at(1));
+        } else {
+            reply = message.createReply();
+        }
+        connection.send(reply);
+        return true;
+    }
+
+    QString introspect(const QString&) const override { return QString(); }
+
+    QStringList calls() const {
+        QMutexLocker lock(&m_mutex);
+        return m_calls;
+    }
+
+    QList<QStringList> registered() const {
+        QMutexLocker lock(&m_mutex);
+        return m_registered;
+    }
+
+private:
+    mutable QMutex m_mutex;
+    QStringList m_calls;
+    QList<QStringList> m_registered;
+};
+
+/// 条件が満たされるまでイベントを処理する（最大 timeoutMs）
+bool waitFor(const std::function<bool()>& condition, int timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition()) {
+        if (timer.elapsed() > timeoutMs) {
+            return false;
+        }
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 20);
+        QThread::msleep(5);
+    }
+    return true;
+}
+
+} // namespace
+
+/**
+ * @brief オフスクリーンで QApplication を作るフィクスチャ
+ */
+class GlobalShortcutTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+    }
+};
+
+TEST_F(GlobalShortcutTest, AcceptsOnlySingleHttpUrls)
+{
+    int argc = 0;
+    QApplication app(argc, nullptr);
+
+    EXPECT_EQ(KDEIntegration::urlFromClipboardText("  https://example.com/x \n"), "https://example.com/x");
+    EXPECT_EQ(KDEIntegration::urlFromClipboardText("http://intranet.local:8080/"), "http://intranet.local:8080/");
+    EXPECT_TRUE(KDEIntegration::urlFromClipboardText("see https://example.com").isEmpty());
+    EXPECT_TRUE(KDEIntegration::urlFromClipboardText("ftp://example.com/file").isEmpty());
+    EXPECT_TRUE(KDEIntegration::urlFromClipboardText("javascript:alert(1)").isEmpty());
+    EXPECT_TRUE(KDEIntegration::urlFromClipboardText("https://").isEmpty());
+    EXPECT_TRUE(KDEIntegration::urlFromClipboardText(QString()).isEmpty());
+
+    // 起動時と同じ検証（シェルのメタ文字）も通す
+    QGuiApplication::clipboard()->setText("https://kde.org/$(id)");
+    EXPECT_TRUE(KDEIntegration::clipboardOrSelectionUrl().isEmpty());
+    QGuiApplication::clipboard()->setText("https://kde.org/");
+    EXPECT_EQ(KDEIntegration::clipboardOrSelectionUrl(), "https://kde.org/");
+}
+
+TEST_F(GlobalShortcutTest, ShortcutRoutesClipboardUrl)
+{
+    int argc = 0;
+    QApplication app(argc, nullptr);
+
+    // 偽のサービスは別の接続・別のスレッドで応答する（クライアントの同期呼び出しを待たせない）
+    QDBusConnection bus = QDBusConnection::connectToBus(QDBusConnection::SessionBus, "fake-kglobalaccel");
+    if (!bus.isConnected() || !QDBusConnection::sessionBus().isConnected()) {
+        GTEST_SKIP() << "no session bus (run under dbus-run-session)";
+    }
+
+    QThread serviceThread;
+    serviceThread.start();
+    FakeKGlobalAccel fake;
+    fake.moveToThread(&serviceThread);
+    ASSERT_TRUE(bus.registerVirtualObject("/kglobalaccel", &fake, QDBusConnection::SubPath));
+    ASSERT_TRUE(bus.registerVirtualObject("/component", &fake, QDBusConnection::SubPath));
+    ASSERT_TRUE(bus.registerService(SERVICE));
+
+    {
+        KDEIntegration integration;
+        QStringList requested;
+        QObject::connect(&integration, &KDEIntegration::urlRequested,
+                         [&requested](const QString& url) { requested << url; });
+
+        integration.registerGlobalShortcuts();
+        ASSERT_TRUE(waitFor([&fake]() {
+            for (const QStringList& actionId : fake.registered()) {
+                if (actionId.value(0) == Constants::GLOBAL_SHORTCUT_COMPONENT &&
+                    actionId.value(1) == Constants::GLOBAL_SHORTCUT_ACTION) {
+                    return true;
+                }
+            }
+            return false;
+        }, 5000)) << fake.calls().join(',').toStdString();
+
+        auto press = [&bus]() {
+            QDBusMessage signal = QDBusMessage::createSignal(COMPONENT_PATH, "org.kde.kglobalaccel.Component",
+                                                             "globalShortcutPressed");
+            signal << QString(Constants::GLOBAL_SHORTCUT_COMPONENT) << QString(Constants::GLOBAL_SHORTCUT_ACTION)
+                   << qlonglong(0);
+            return bus.send(signal);
+        };
+
+        // クライアント側のシグナルの購読は非同期に追加されるため、届くまで押し直す
+        QGuiApplication::clipboard()->setText("https://example.com/a?b=c");
+        ASSERT_TRUE(waitFor([&]() {
+            if (requested.isEmpty()) {
+                press();
+                QThread::msleep(50);
+            }
+            return !requested.isEmpty();
+        }, 5000));
+        EXPECT_EQ(requested.first(), "https://example.com/a?b=c");
+
+        // 検証を通らない内容では何も要求しない
+        requested.clear();
+        QGuiApplication::clipboard()->setText("https://example.com/`reboot`");
+        ASSERT_TRUE(press());
+        waitFor([]() { return false; }, 300);
+        EXPECT_TRUE(requested.isEmpty());
+
+        integration.unregisterGlobalShortcuts();
+        EXPECT_TRUE(waitFor([&fake]() {
+            return !fake.calls().filter("unregister", Qt::CaseInsensitive).isEmpty();
+        }, 5000)) << fake.calls().join(',').toStdString();
+    }
+
+    bus.unregisterService(SERVICE);
+    bus.unregisterObject("/kglobalaccel", QDBusConnection::UnregisterTree);
+    bus.unregisterObject("/component", QDBusConnection::UnregisterTree);
+    serviceThread.quit();
+    serviceThread.wait();
+    QDBusConnection::disconnectFromBus("fake-kglobalaccel");
+}
+
+/**
+ * @brief Firefoxの2つのプロファイルを持つ偽のホームでトレイメニューを使うフィクスチャ
+ */
+class TrayMenuTest : public FakeHomeTest {
+protected:
+    void SetUp() override {
+        FakeHomeTest::SetUp();
+        if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+        addFirefoxProfiles();
+    }
+
+    /// トレイメニューのプロファイルを起動するアクション
+    static QAction* launchAction() {
+        for (QWidget* widget : QApplication::topLevelWidgets()) {
+            QMenu* menu = qobject_cast<QMenu*>(widget);
+            if (!menu) {
+                continue;
+            }
+            for (QAction* action : menu->actions()) {
+                if (action->data().toStringList().value(0) == "launch") {
+                    return action;
+                }
+            }
+        }
+        return nullptr;
+    }
+};
+
+TEST_F(TrayMenuTest, LaunchRebuildsMenuAfterTheTriggeredAction)
+{
+    int argc = 0;
+    QApplication app(argc, nullptr);
+
+    ConfigManager config;
+    ProfileManager profiles(&config);
+    profiles.refreshProfiles();
+    bool launched = false;
+    QObject::connect(&profiles, &ProfileManager::profileLaunched, [&launched]() { launched = true; });
+
+    KDEIntegration integration;
+    integration.setProfileManager(&profiles);
+    QPointer<QAction> action = launchAction();
+    ASSERT_FALSE(action.isNull());
+
+    // 起動の通知を受けても、選ばれたアクションは通知が終わるまで残る
+    action->trigger();
+    EXPECT_TRUE(launched);
+    EXPECT_FALSE(action.isNull());
+
+    // 作り直しはイベントループに戻ってから行われる
+    ASSERT_TRUE(waitFor([&action]() { return action.isNull(); }, 5000));
+    EXPECT_NE(launchAction(), nullptr);
+}
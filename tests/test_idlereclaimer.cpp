@@ -0,0 +1,280 @@
+/**
+ * @file test_idlereclaimer.cpp
+ * @brief 非表示のまま常駐しているときのメモリ解放のテスト
+ *
+ * デコード済みのアバター画像に相当する QImage を大量に保持し、解放の前後の
+ * RSS/PSS（/proc/self/smaps_rollup）を比較します。画像の間に小さな確保を挟んで
+ * ヒープの末尾を塞ぎ、free() だけでは返らないページが malloc_trim() で返ることを確認します。
+ * さらにオフスクリーンの MainWindow を 表示 → 非表示で解放 → 再表示 と動かし、
+ * 行とアバターを解放した前後と、再表示で行が戻ることを確認します。
+ */
+
+#include <gtest/gtest.h>
+#include <QApplication>
+#include <QColor>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QImage>
+#include <QList>
+#include <QTimer>
+
+#include <cstdio>
+#include <functional>
+
+#include "../src/idlereclaimer.h"
+#include "../src/avatarloader.h"
+#include "../src/mainwindow.h"
+#include "../src/ui/profileitem.h"
+#include "fakehome.h"
+
+namespace {
+
+/**
+ * @brief イベントループを指定時間だけ回す
+ */
+void runEventLoop(int ms)
+{
+    QEventLoop loop;
+    QTimer::singleShot(ms, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+/**
+ * @brief 条件を満たすまでイベントループを回す
+ * @return 5秒以内に満たした場合 true
+ */
+bool waitUntil(const std::function<bool()>& condition)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition()) {
+        if (timer.hasExpired(5000)) {
+            return false;
+        }
+        runEventLoop(10);
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(IdleReclaimer, ParsesSmapsRollupAndStatus)
+{
+    const QByteArray rollup =
+        "55d0c0a00000-7ffd1c3fe000 ---p 00000000 00:00 0                          [rollup]\n"
+        "Rss:               48212 kB\n"
+        "Pss:               21007 kB\n"
+        "Pss_Anon:          12000 kB\n"
+        "Shared_Clean:      30000 kB\n";
+    const IdleReclaimer::MemoryUsage usage = IdleReclaimer::parse(rollup);
+    EXPECT_EQ(usage.rss, 48212);
+    EXPECT_EQ(usage.pss, 21007);
+
+    const QByteArray status = "Name:\tkde-browser-pi\nVmHWM:\t   60000 kB\nVmRSS:\t   48212 kB\n";
+    const IdleReclaimer::MemoryUsage fallback = IdleReclaimer::parse(status);
+    EXPECT_EQ(fallback.rss, 48212);
+    EXPECT_EQ(fallback.pss, -1);
+
+    EXPECT_EQ(IdleReclaimer::parse(QByteArray()).rss, -1);
+
+    const IdleReclaimer::MemoryUsage self = IdleReclaimer::sample();
+    EXPECT_GT(self.rss, 0);
+}
+
+TEST(IdleReclaimer, ReclaimsOnlyAfterStayingHidden)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    IdleReclaimer reclaimer;
+    int requests = 0;
+    QObject::connect(&reclaimer, &IdleReclaimer::reclaimRequested, [&]() { ++requests; });
+    reclaimer.setDelay(1);
+
+    // 期限前に表示されれば解放しない
+    reclaimer.arm();
+    EXPECT_TRUE(reclaimer.isArmed());
+    runEventLoop(300);
+    EXPECT_FALSE(reclaimer.disarm());
+    runEventLoop(1200);
+    EXPECT_EQ(requests, 0);
+
+    // 非表示のままなら1回だけ解放する
+    reclaimer.arm();
+    runEventLoop(2500);
+    EXPECT_EQ(requests, 1);
+    EXPECT_TRUE(reclaimer.isReclaimed());
+    EXPECT_FALSE(reclaimer.isArmed());
+
+    // 解放済みの間は待機しない
+    reclaimer.arm();
+    EXPECT_FALSE(reclaimer.isArmed());
+
+    // 表示で解放済みの状態が戻る
+    EXPECT_TRUE(reclaimer.disarm());
+    EXPECT_FALSE(reclaimer.isReclaimed());
+    EXPECT_FALSE(reclaimer.disarm());
+}
+
+TEST(IdleReclaimer, ZeroDelayDisablesReclaim)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    IdleReclaimer reclaimer;
+    reclaimer.setDelay(0);
+    reclaimer.arm();
+    EXPECT_FALSE(reclaimer.isArmed());
+
+    // 待機中に 0 にすると止まる
+    reclaimer.setDelay(5);
+    reclaimer.arm();
+    EXPECT_TRUE(reclaimer.isArmed());
+    reclaimer.setDelay(0);
+    EXPECT_FALSE(reclaimer.isArmed());
+}
+
+TEST(IdleReclaimer, ReturnsReleasedImagesToTheKernel)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    // 64x64 ARGB32 のサムネイル 2000 枚（約 31 MiB、mmap のしきい値未満なのでヒープに置かれる）
+    constexpr int IMAGE_COUNT = 2000;
+    constexpr qint64 IMAGE_KIB = 64 * 64 * 4 / 1024;
+    QList<QImage> images;
+    QList<QByteArray> pins;
+    for (int i = 0; i < IMAGE_COUNT; ++i) {
+        QImage image(64, 64, QImage::Format_ARGB32);
+        image.fill(QColor::fromRgb(i % 256, 128, 255 - i % 256));
+        images.append(image);
+        pins.append(QByteArray(32, 'x'));
+    }
+
+    IdleReclaimer reclaimer;
+    IdleReclaimer::MemoryUsage freedOnly;
+    QObject::connect(&reclaimer, &IdleReclaimer::reclaimRequested, [&]() {
+        images.clear();
+        freedOnly = IdleReclaimer::sample();
+    });
+    reclaimer.reclaimNow();
+
+    const IdleReclaimer::MemoryUsage before = reclaimer.usageBefore();
+    const IdleReclaimer::MemoryUsage after = reclaimer.usageAfter();
+    std::printf("images: %lld KiB\n", static_cast<long long>(IMAGE_COUNT * IMAGE_KIB));
+    std::printf("RSS: before %lld KiB, freed only %lld KiB, after trim %lld KiB\n",
+                static_cast<long long>(before.rss), static_cast<long long>(freedOnly.rss),
+                static_cast<long long>(after.rss));
+    std::printf("PSS: before %lld KiB, freed only %lld KiB, after trim %lld KiB\n",
+                static_cast<long long>(before.pss), static_cast<long long>(freedOnly.pss),
+                static_cast<long long>(after.pss));
+
+    ASSERT_GT(before.rss, 0);
+    EXPECT_LT(after.rss, before.rss - IMAGE_COUNT * IMAGE_KIB / 2);
+    if (before.pss >= 0) {
+        EXPECT_LT(after.pss, before.pss - IMAGE_COUNT * IMAGE_KIB / 2);
+    }
+    EXPECT_EQ(pins.size(), IMAGE_COUNT);
+}
+
+/**
+ * @brief アバター付きのChromiumプロファイルを多数持つ偽のホームを用意するフィクスチャ
+ */
+class IdlePickerTest : public FakeHomeTest {
+protected:
+    static constexpr int PROFILE_COUNT = 300;
+
+    void SetUp() override {
+        FakeHomeTest::SetUp();
+        if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+
+        // 各プロファイルにサインイン中のアカウントの写真（プロファイルごとに異なる画像）
+        const QString chromium = m_home + "/.config/chromium";
+        QByteArray entries;
+        for (int i = 0; i < PROFILE_COUNT; ++i) {
+            const QString dir = i == 0 ? QString("Default") : QString("Profile %1").arg(i);
+            writeFile(chromium + "/" + dir + "/Preferences", "{}");
+            QImage picture(256, 256, QImage::Format_ARGB32);
+            picture.fill(QColor::fromRgb(i % 256, (i * 7) % 256, 255 - i % 256));
+            ASSERT_TRUE(picture.save(chromium + "/" + dir + "/Google Profile Picture.png"));
+            entries += QString(R"(%1"%2": {"name": "Person %3", "gaia_picture_file_name": "Google Profile Picture.png"})")
+                           .arg(i == 0 ? "" : ", ", dir).arg(i + 1).toUtf8();
+        }
+        writeFile(chromium + "/Local State", R"({"profile": {"info_cache": {)" + entries + "}}}");
+
+        writeFile(m_home + "/.config/kde-browser-picker.yaml",
+                  QString("browsers:\n"
+                          "  firefox:\n    enabled: false\n"
+                          "  chrome:\n    enabled: false\n"
+                          "  chromium:\n    path: %1\n").arg(writeStub("chromium-stub")).toUtf8());
+        // 常駐用に URL なしで作成するためタイムアウトは動かない。非表示になって1秒で解放する
+        writeRc("[General]\nDefaultTimeout=0\nIdleReclaimSeconds=1\n");
+    }
+
+    /// 行が揃い、全てのアバターがデコードされるまで待つ
+    static bool waitForRows(const MainWindow& window) {
+        const AvatarLoader* loader = window.findChild<AvatarLoader*>();
+        return loader && waitUntil([&window, loader]() {
+            const QList<ProfileItem*> items = window.findChildren<ProfileItem*>();
+            if (items.size() < PROFILE_COUNT) {
+                return false;
+            }
+            for (const ProfileItem* item : items) {
+                if (!item->avatarPath().isEmpty() && loader->cached(item->avatarPath()).isNull()) {
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+};
+
+TEST_F(IdlePickerTest, HiddenPickerReturnsRowsAndAvatarsAndRebuildsThemOnShow)
+{
+    int argc = 0;
+    QApplication app(argc, nullptr);
+
+    MainWindow window;
+    window.show();
+    ASSERT_TRUE(waitForRows(window));
+    const IdleReclaimer::MemoryUsage shown = IdleReclaimer::sample();
+
+    // 非表示のまま待つと、行・アバター・キャッシュを破棄してヒープを返す
+    const IdleReclaimer* reclaimer = window.findChild<IdleReclaimer*>();
+    ASSERT_NE(reclaimer, nullptr);
+    window.hide();
+    ASSERT_TRUE(waitUntil([reclaimer]() { return reclaimer->isReclaimed(); }));
+    EXPECT_TRUE(window.findChildren<ProfileItem*>().isEmpty());
+    const IdleReclaimer::MemoryUsage before = reclaimer->usageBefore();
+    const IdleReclaimer::MemoryUsage after = reclaimer->usageAfter();
+
+    // 再表示で最初の描画の前に行が戻り、アバターはディスクのサムネイルから読み直す
+    QElapsedTimer rebuild;
+    rebuild.start();
+    window.show();
+    const qint64 rebuildMs = rebuild.elapsed();
+    EXPECT_EQ(window.findChildren<ProfileItem*>().size(), PROFILE_COUNT);
+    EXPECT_FALSE(reclaimer->isReclaimed());
+    ASSERT_TRUE(waitForRows(window));
+    const IdleReclaimer::MemoryUsage reshown = IdleReclaimer::sample();
+
+    // 64x64 ARGB32 のアバター（行の QPixmap とローダーのキャッシュ）
+    constexpr qint64 AVATAR_KIB = Constants::AVATAR_SIZE * Constants::AVATAR_SIZE * 4 / 1024;
+    std::printf("%d rows with avatars: RSS shown %lld KiB, hidden %lld -> %lld KiB after reclaim, "
+                "shown again %lld KiB (rows rebuilt in %lld ms)\n",
+                PROFILE_COUNT, static_cast<long long>(shown.rss), static_cast<long long>(before.rss),
+                static_cast<long long>(after.rss), static_cast<long long>(reshown.rss),
+                static_cast<long long>(rebuildMs));
+    std::printf("PSS: shown %lld KiB, hidden %lld -> %lld KiB after reclaim, shown again %lld KiB\n",
+                static_cast<long long>(shown.pss), static_cast<long long>(before.pss),
+                static_cast<long long>(after.pss), static_cast<long long>(reshown.pss));
+
+    ASSERT_GT(before.rss, 0);
+    EXPECT_LT(after.rss, before.rss - PROFILE_COUNT * AVATAR_KIB / 2);
+    if (before.pss >= 0) {
+        EXPECT_LT(after.pss, before.pss - PROFILE_COUNT * AVATAR_KIB / 2);
+    }
+}
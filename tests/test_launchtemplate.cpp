@@ -0,0 +1,167 @@
+/**
+ * @file test_launchtemplate.cpp
+ * @brief 起動引数・環境変数テンプレートのテスト
+ *
+ * テンプレートの検証と展開、YAMLからの読み込み、およびスタブのブラウザに
+ * 渡される引数と環境変数を検証します。
+ */
+
+#include <gtest/gtest.h>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+
+#include "../src/configmanager.h"
+#include "../src/browserdetector.h"
+#include "../src/launchtemplate.h"
+
+TEST(LaunchTemplate, ValidatesArguments)
+{
+    EXPECT_TRUE(LaunchTemplate::validateArgument("--process-per-site"));
+    EXPECT_TRUE(LaunchTemplate::validateArgument("--renderer-process-limit=4"));
+    EXPECT_TRUE(LaunchTemplate::validateArgument("--disk-cache-dir=/dev/shm/cache/{profile}"));
+    EXPECT_TRUE(LaunchTemplate::validateArgument("--ozone-platform=wayland"));
+    EXPECT_TRUE(LaunchTemplate::validateArgument("{url}"));
+
+    // 位置引数（追加のURLや実行ファイル）
+    EXPECT_FALSE(LaunchTemplate::validateArgument("https://evil.example.com"));
+    EXPECT_FALSE(LaunchTemplate::validateArgument("/bin/sh"));
+    EXPECT_FALSE(LaunchTemplate::validateArgument(""));
+    EXPECT_FALSE(LaunchTemplate::validateArgument("--"));
+    // 起動先のプロファイルの変更
+    EXPECT_FALSE(LaunchTemplate::validateArgument("-P"));
+    EXPECT_FALSE(LaunchTemplate::validateArgument("--profile-directory=Other"));
+    EXPECT_FALSE(LaunchTemplate::validateArgument("--user-data-dir=/tmp/x"));
+    // {url} は引数全体としてのみ
+    EXPECT_FALSE(LaunchTemplate::validateArgument("--app={url}"));
+    // 未知のプレースホルダー
+    QString error;
+    EXPECT_FALSE(LaunchTemplate::validateArgument("--cache={home}", &error));
+    EXPECT_TRUE(error.contains("{home}"));
+    // 制御文字
+    EXPECT_FALSE(LaunchTemplate::validateArgument(QString("--a\nb")));
+}
+
+TEST(LaunchTemplate, ValidatesEnvironment)
+{
+    EXPECT_TRUE(LaunchTemplate::validateEnvironment("MOZ_ENABLE_WAYLAND", "1"));
+    EXPECT_TRUE(LaunchTemplate::validateEnvironment("XDG_CACHE_HOME", "/dev/shm/{profile}"));
+
+    EXPECT_FALSE(LaunchTemplate::validateEnvironment("LD_PRELOAD", "/tmp/evil.so"));
+    EXPECT_FALSE(LaunchTemplate::validateEnvironment("LD_LIBRARY_PATH", "/tmp"));
+    EXPECT_FALSE(LaunchTemplate::validateEnvironment("BAD-NAME", "1"));
+    EXPECT_FALSE(LaunchTemplate::validateEnvironment("1ABC", "1"));
+    EXPECT_FALSE(LaunchTemplate::validateEnvironment("OPEN", "{url}"));
+}
+
+TEST(LaunchTemplate, CompilesToArgvPrefix)
+{
+    LaunchTemplate browserWide;
+    browserWide.args << "--process-per-site";
+    browserWide.env.insert("MOZ_ENABLE_WAYLAND", "0");
+
+    LaunchTemplate profileSpecific;
+    profileSpecific.args << "--disk-cache-dir={dir}/cache" << "{url}" << "--ozone-platform=wayland";
+    profileSpecific.env.insert("MOZ_ENABLE_WAYLAND", "1");
+
+    LaunchTemplate merged = browserWide;
+    merged.append(profileSpecific);
+    const auto compiled = merged.compile({"--profile-directory=Work"}, "Work", "/home/u/.config/chromium/Profile 1");
+
+    EXPECT_EQ(compiled.args, QStringList({"--profile-directory=Work", "--process-per-site",
+                                          "--disk-cache-dir=/home/u/.config/chromium/Profile 1/cache",
+                                          "--ozone-platform=wayland"}));
+    EXPECT_EQ(compiled.env.value("MOZ_ENABLE_WAYLAND"), QString("1"));
+
+    // {url} の位置に挿入される
+    EXPECT_EQ(compiled.argumentsFor("https://example.com").at(3), QString("https://example.com"));
+
+    // {url} がない場合は末尾に追加
+    const auto plain = LaunchTemplate().compile({"-P", "work"}, "work", "/p");
+    EXPECT_EQ(plain.argumentsFor("https://example.com"), QStringList({"-P", "work", "https://example.com"}));
+}
+
+TEST(LaunchTemplate, LoadsFromYamlAndReachesStubBrowser)
+{
+    QTemporaryDir home;
+    ASSERT_TRUE(home.isValid());
+    const QByteArray oldHome = qgetenv("HOME");
+    qputenv("HOME", home.path().toUtf8());
+
+    // Firefoxプロファイル "work"
+    const QString mozilla = home.path() + "/.mozilla/firefox";
+    ASSERT_TRUE(QDir().mkpath(mozilla + "/abcd.work"));
+    QFile ini(mozilla + "/profiles.ini");
+    ASSERT_TRUE(ini.open(QIODevice::WriteOnly));
+    ini.write("[Profile0]\nName=work\nIsRelative=1\nPath=abcd.work\n");
+    ini.close();
+
+    // 引数と環境変数を書き出すスタブ
+    const QString out = home.path() + "/child-out";
+    const QString stub = home.path() + "/firefox-stub";
+    QFile stubFile(stub);
+    ASSERT_TRUE(stubFile.open(QIODevice::WriteOnly));
+    stubFile.write("#!/bin/sh\n"
+                   "{ for a in \"$@\"; do printf '%s\\n' \"$a\"; done; echo \"MOZ=$MOZ_ENABLE_WAYLAND\"; } > \"$STUB_OUT.tmp\"\n"
+                   "mv \"$STUB_OUT.tmp\" \"$STUB_OUT\"\n");
+    stubFile.close();
+    stubFile.setPermissions(QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+    qputenv("STUB_OUT", out.toUtf8());
+
+    const QString yamlPath = home.path() + "/kde-browser-picker.yaml";
+    QFile yaml(yamlPath);
+    ASSERT_TRUE(yaml.open(QIODevice::WriteOnly | QIODevice::Text));
+    {
+        QTextStream stream(&yaml);
+        stream.setCodec("UTF-8");
+        stream << "browsers:\n"
+               << "  firefox: " << stub << "\n"
+               << "launch:\n"
+               << "  firefox:\n"
+               << "    args: [--no-remote-hint, \"https://evil.example.com\"]\n"
+               << "    env:\n"
+               << "      MOZ_ENABLE_WAYLAND: 1\n"
+               << "      LD_PRELOAD: /tmp/evil.so\n"
+               << "  \"firefox/work\":\n"
+               << "    args:\n"
+               << "      - --class={profile}\n"
+               << "      - \"{url}\"\n"
+               << "      - --safe-tail\n"
+               << "  opera:\n"
+               << "    args: [--x]\n";
+    }
+    yaml.close();
+    qputenv(Constants::YAML_ENV_PATH, yamlPath.toUtf8());
+
+    ConfigManager cfg;
+    const auto templates = cfg.launchTemplates();
+    ASSERT_TRUE(templates.contains("firefox"));
+    ASSERT_TRUE(templates.contains("firefox/work"));
+    EXPECT_FALSE(templates.contains("opera"));
+    // 検証に失敗した要素は読み込み時に除外される
+    EXPECT_EQ(templates["firefox"].args, QStringList({"--no-remote-hint"}));
+    EXPECT_FALSE(templates["firefox"].env.contains("LD_PRELOAD"));
+    EXPECT_EQ(templates["firefox/work"].args, QStringList({"--class={profile}", "{url}", "--safe-tail"}));
+
+    BrowserDetector detector;
+    detector.setExecutableOverrides(cfg.browserExecutableOverrides());
+    detector.setEnabledOverrides({{"chrome", false}, {"chromium", false}});
+    detector.setLaunchTemplates(templates);
+    detector.detectBrowsers();
+    ASSERT_TRUE(detector.launchBrowser("firefox", "work", "https://example.com"));
+
+    for (int i = 0; i < 500 && !QFile::exists(out); ++i) {
+        QThread::msleep(10);
+    }
+    QFile result(out);
+    ASSERT_TRUE(result.open(QIODevice::ReadOnly));
+    const QStringList lines = QString::fromUtf8(result.readAll()).split('\n', Qt::SkipEmptyParts);
+    EXPECT_EQ(lines, QStringList({"-P", "work", "--no-remote-hint", "--class=work",
+                                  "https://example.com", "--safe-tail", "MOZ=1"}));
+
+    qunsetenv(Constants::YAML_ENV_PATH);
+    qunsetenv("STUB_OUT");
+    qputenv("HOME", oldHome);
+}
@@ -0,0 +1,147 @@
+/**
+ * @file test_memorypressure.cpp
+ * @brief メモリ逼迫（PSI）に応じたデフォルトプロファイル選択のテスト
+ */
+
+#include <gtest/gtest.h>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include "../src/memorypressure.h"
+#include "../src/profilemanager.h"
+#include "../src/configmanager.h"
+
+static const QByteArray kIdlePsi =
+    "some avg10=0.00 avg60=0.12 avg300=0.30 total=123456\n"
+    "full avg10=0.00 avg60=0.00 avg300=0.10 total=2345\n";
+
+static const QByteArray kBusyPsi =
+    "some avg10=42.50 avg60=20.00 avg300=5.00 total=99999999\n"
+    "full avg10=12.25 avg60=8.00 avg300=1.00 total=8888888\n";
+
+// ヘルパー: テスト用のプロファイルエントリを作成
+static ProfileManager::ProfileEntry makeEntry(const QString& browser, const QString& profile, bool running)
+{
+    ProfileManager::ProfileEntry entry;
+    entry.browser = browser;
+    entry.profileId = profile;
+    entry.profileDisplayName = profile;
+    entry.isRunning = running;
+    return entry;
+}
+
+TEST(MemoryPressure, ParseProcFormat)
+{
+    auto sample = MemoryPressure::parse(kBusyPsi);
+    ASSERT_TRUE(sample.valid);
+    EXPECT_DOUBLE_EQ(sample.value(MemoryPressure::Metric::Some, MemoryPressure::Window::Avg10), 42.5);
+    EXPECT_DOUBLE_EQ(sample.value(MemoryPressure::Metric::Some, MemoryPressure::Window::Avg300), 5.0);
+    EXPECT_DOUBLE_EQ(sample.value(MemoryPressure::Metric::Full, MemoryPressure::Window::Avg10), 12.25);
+
+    EXPECT_FALSE(MemoryPressure::parse("").valid);
+    EXPECT_FALSE(MemoryPressure::parse("garbage\n").valid);
+}
+
+TEST(MemoryPressure, ThresholdWithInjectedSource)
+{
+    QByteArray psi = kIdlePsi;
+    MemoryPressure pressure([&psi]() { return psi; });
+
+    MemoryPressure::Policy policy;
+    policy.threshold = 10.0;
+    EXPECT_FALSE(pressure.isUnderPressure(policy));
+
+    psi = kBusyPsi;
+    EXPECT_TRUE(pressure.isUnderPressure(policy));
+
+    // full avg10 = 12.25 なのでしきい値15では逼迫しない
+    policy.metric = MemoryPressure::Metric::Full;
+    policy.threshold = 15.0;
+    EXPECT_FALSE(pressure.isUnderPressure(policy));
+
+    policy.enabled = false;
+    policy.threshold = 0.0;
+    EXPECT_FALSE(pressure.isUnderPressure(policy));
+
+    // PSI非対応のカーネル
+    psi.clear();
+    policy.enabled = true;
+    EXPECT_FALSE(pressure.isUnderPressure(policy));
+}
+
+TEST(MemoryPressure, DefaultProfilePrefersRunningUnderPressure)
+{
+    QList<ProfileManager::ProfileEntry> profiles = {
+        makeEntry("chrome", "Default", false),
+        makeEntry("firefox", "work", false),
+        makeEntry("firefox", "personal", true),
+        makeEntry("chromium", "Default", true),
+    };
+    const auto lastUsed = qMakePair(QString("firefox"), QString("work"));
+
+    // 逼迫していなければ最後に使用したプロファイル
+    auto entry = ProfileManager::selectDefaultProfile(profiles, lastUsed, false);
+    EXPECT_EQ(entry.browser, "firefox");
+    EXPECT_EQ(entry.profileId, "work");
+
+    // 逼迫中は同じブラウザの起動済みプロファイルを優先
+    entry = ProfileManager::selectDefaultProfile(profiles, lastUsed, true);
+    EXPECT_EQ(entry.browser, "firefox");
+    EXPECT_EQ(entry.profileId, "personal");
+
+    // 最後に使用したブラウザが起動していなければ任意の起動済みプロファイル
+    profiles[2].isRunning = false;
+    entry = ProfileManager::selectDefaultProfile(profiles, lastUsed, true);
+    EXPECT_EQ(entry.browser, "chromium");
+
+    // 最後に使用したプロファイル自体が起動済みならそのまま
+    profiles[1].isRunning = true;
+    entry = ProfileManager::selectDefaultProfile(profiles, lastUsed, true);
+    EXPECT_EQ(entry.profileId, "work");
+
+    // 起動済みのものが1つもなければ通常の選択
+    for (auto& p : profiles) p.isRunning = false;
+    entry = ProfileManager::selectDefaultProfile(profiles, lastUsed, true);
+    EXPECT_EQ(entry.profileId, "work");
+}
+
+TEST(MemoryPressure, PolicyFromYaml)
+{
+    QTemporaryDir tmpdir;
+    ASSERT_TRUE(tmpdir.isValid());
+
+    QString yamlPath = tmpdir.path() + "/kde-browser-picker.yaml";
+    QFile yaml(yamlPath);
+    ASSERT_TRUE(yaml.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate));
+    {
+        QTextStream out(&yaml);
+        out.setCodec("UTF-8");
+        out << "memory_pressure:\n";
+        out << "  enabled: yes\n";
+        out << "  threshold: 25.5\n";
+        out << "  metric: full\n";
+        out << "  window: avg60\n";
+        out << "browsers:\n";
+        out << "  chrome:\n";
+        out << "    enabled: false\n";
+    }
+    yaml.close();
+
+    qputenv(Constants::YAML_ENV_PATH, yamlPath.toUtf8());
+    ConfigManager cfg;
+    auto policy = cfg.memoryPressurePolicy();
+    EXPECT_TRUE(policy.enabled);
+    EXPECT_DOUBLE_EQ(policy.threshold, 25.5);
+    EXPECT_EQ(policy.metric, MemoryPressure::Metric::Full);
+    EXPECT_EQ(policy.window, MemoryPressure::Window::Avg60);
+    // 後続のセクションも読み込まれること
+    EXPECT_FALSE(cfg.isBrowserEnabledOverride("chrome"));
+
+    // ProfileManagerに注入したPSIで判定されること
+    ProfileManager manager(&cfg);
+    manager.setMemoryPressureSource([]() { return kBusyPsi; }); // full avg60 = 8.0
+    EXPECT_FALSE(manager.isUnderMemoryPressure());
+
+    qunsetenv(Constants::YAML_ENV_PATH);
+}
@@ -0,0 +1,229 @@
+/**
+ * @file test_perfbundle.cpp
+ * @brief 性能調査用バンドルの作成と再現のテスト
+ *
+ * 個人情報に見立てた名前を含む偽のホームからバンドルを作成し、
+ * バンドルにその名前が残らないこと、別のディレクトリに再現した環境で
+ * 同じ数のプロファイルが検出され、更新日時が保たれることと、
+ * 細工したバンドルが再現先の外に書き込まないことを検証します。
+ */
+
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+
+#include <utime.h>
+
+#include "../src/perfbundle.h"
+#include "../src/browserdetector.h"
+#include "../src/yamlconfig.h"
+#include "fakehome.h"
+
+namespace {
+
+/// バンドルに残ってはいけない文字列
+const QStringList SECRETS = {"alice-secret", "Bob Secret", "bob@secretcorp.example", "intranet.secretcorp"};
+
+/// Chromiumの "Profile 1" の Preferences に設定する更新日時
+constexpr time_t PREFERENCES_MTIME = 1234567890;
+
+} // namespace
+
+/**
+ * @brief 偽のホーム（Firefox・Chromium・rc・YAML）を用意するフィクスチャ
+ */
+class PerfBundleTest : public FakeHomeTest {
+protected:
+    void SetUp() override {
+        FakeHomeTest::SetUp();
+
+        // Firefox: 名前とディレクトリ名に個人情報を含むプロファイル
+        const QString mozilla = m_home + "/.mozilla/firefox";
+        writeFile(mozilla + "/profiles.ini",
+                  "[Profile0]\nName=alice-secret\nIsRelative=1\nPath=x1y2.alice-secret\nDefault=1\n\n"
+                  "[Install4F96D1932A9F858E]\nDefault=x1y2.alice-secret\nLocked=1\n");
+        writeFile(mozilla + "/installs.ini", "[4F96D1932A9F858E]\nDefault=x1y2.alice-secret\nLocked=1\n");
+        writeFile(mozilla + "/x1y2.alice-secret/times.json", R"({"created":1600000000000,"firstUse":null})");
+        writeFile(mozilla + "/x1y2.alice-secret/prefs.js", QByteArray(4096, 'x'));
+
+        // Chromium: 表示名とアカウントに個人情報を含む2つのプロファイル
+        const QString chromium = m_home + "/.config/chromium";
+        writeFile(chromium + "/Local State",
+                  R"({"profile": {"info_cache": {)"
+                  R"("Default": {"name": "Bob Secret", "user_name": "bob@secretcorp.example",)"
+                  R"( "avatar_icon": "chrome://theme/IDR_PROFILE_AVATAR_26"},)"
+                  R"("Profile 1": {"name": "Work", "gaia_name": "Bob Secret"}}},)"
+                  R"("account_info": {"bob@secretcorp.example": {"full_name": "Bob Secret"}}})");
+        writeFile(chromium + "/Default/Preferences", "{}");
+        writeFile(chromium + "/Profile 1/Preferences", "{}");
+        struct utimbuf times = {PREFERENCES_MTIME, PREFERENCES_MTIME};
+        ASSERT_EQ(::utime(QFile::encodeName(chromium + "/Profile 1/Preferences").constData(), &times), 0);
+
+        // 何もしないスタブのブラウザ
+        const QString stub = writeStub("browser-stub");
+        writeFile(m_home + "/.config/kde-browser-picker.yaml",
+                  QString("browsers:\n"
+                          "  firefox:\n    path: %1\n"
+                          "  chromium:\n    path: %1\n"
+                          "  chrome:\n    enabled: false\n"
+                          "launch:\n"
+                          "  firefox/alice-secret:\n    args: [--private-window]\n").arg(stub).toUtf8());
+
+        writeRc("[General]\nDefaultTimeout=10\n\n"
+                "[LastUsed]\nBrowser=firefox\nProfile=alice-secret\n\n"
+                "[LaunchStats]\nfirefox/alice-secret=12\nchromium/Profile 1=3\n\n"
+                "[HostHistory]\nintranet.secretcorp.example=firefox/alice-secret\n");
+    }
+
+    /// 現在の環境（YAMLの上書きを含む）でブラウザを検出
+    static QMap<QString, BrowserDetector::BrowserInfo> detect() {
+        const YamlConfig yaml = YamlConfig::load(QString());
+        BrowserDetector detector;
+        detector.setExecutableOverrides(yaml.executableOverrides);
+        detector.setEnabledOverrides(yaml.enabledOverrides);
+        return detector.detectBrowsers();
+    }
+};
+
+TEST_F(PerfBundleTest, ExportContainsNoPersonalNames)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    const QString bundle = m_root.path() + "/bundle";
+    QString error;
+    ASSERT_TRUE(PerfBundle::exportTo(bundle, &error)) << error.toStdString();
+    ASSERT_TRUE(QFile::exists(bundle + "/manifest.json"));
+    ASSERT_TRUE(QFile::exists(bundle + "/trace.json"));
+
+    // ファイルの内容とパスのどちらにも、名前とホームディレクトリのパスが残らない
+    int files = 0;
+    QDirIterator it(bundle, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+        const QString contents = QString::fromUtf8(file.readAll());
+        for (const QString& secret : SECRETS + QStringList{m_home}) {
+            EXPECT_FALSE(contents.contains(secret)) << path.toStdString() << ": " << secret.toStdString();
+            EXPECT_FALSE(path.mid(bundle.size()).contains(secret)) << path.toStdString();
+        }
+        ++files;
+    }
+    EXPECT_GE(files, 7);
+
+    // 空でないディレクトリには書き出さない
+    EXPECT_FALSE(PerfBundle::exportTo(bundle, &error));
+}
+
+TEST_F(PerfBundleTest, ReplayDetectsTheSameProfiles)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    const QMap<QString, BrowserDetector::BrowserInfo> original = detect();
+    ASSERT_EQ(original.value("firefox").profiles.size(), 1);
+    ASSERT_EQ(original.value("chromium").profiles.size(), 2);
+
+    const QString bundle = m_root.path() + "/bundle";
+    ASSERT_TRUE(PerfBundle::exportTo(bundle));
+
+    QTemporaryDir replayRoot;
+    ASSERT_TRUE(replayRoot.isValid());
+    QString error;
+    ASSERT_TRUE(PerfBundle::materialize(bundle, replayRoot.path(), &error)) << error.toStdString();
+    EXPECT_TRUE(QDir::homePath().startsWith(replayRoot.path()));
+
+    const QMap<QString, BrowserDetector::BrowserInfo> replayed = detect();
+    EXPECT_FALSE(replayed.contains("chrome"));
+    EXPECT_EQ(replayed.value("firefox").profiles.size(), 1);
+    EXPECT_EQ(replayed.value("chromium").profiles.size(), 2);
+    EXPECT_TRUE(replayed.value("firefox").executable.startsWith(replayRoot.path()));
+
+    // Firefoxのプロファイル名は同じ長さの別の名前になる
+    const QString firefoxProfile = replayed.value("firefox").profiles.firstKey();
+    EXPECT_NE(firefoxProfile, "alice-secret");
+    EXPECT_EQ(firefoxProfile.size(), QString("alice-secret").size());
+
+    // 内容の代わりに元のサイズのファイルと更新日時を再現する
+    const QFileInfo preferences(QDir::homePath() + "/.config/chromium/Profile 1/Preferences");
+    ASSERT_TRUE(preferences.exists());
+    EXPECT_EQ(preferences.lastModified().toSecsSinceEpoch(), PREFERENCES_MTIME);
+    const QString firefoxDir = QDir::homePath() + "/.mozilla/firefox";
+    const QStringList profileDirs = QDir(firefoxDir).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    ASSERT_EQ(profileDirs.size(), 1);
+    EXPECT_NE(profileDirs.first(), "x1y2.alice-secret");
+    EXPECT_EQ(QFileInfo(firefoxDir + "/" + profileDirs.first() + "/prefs.js").size(), 4096);
+
+    // 再現した環境では自動選択と先行起動を無効にする
+    QFile rc(QDir::homePath() + "/.config/kde-browser-pickerrc");
+    ASSERT_TRUE(rc.open(QIODevice::ReadOnly));
+    EXPECT_TRUE(rc.readAll().contains("DefaultTimeout=0"));
+    EXPECT_FALSE(YamlConfig::load(QString()).speculativeEnabled);
+
+    const QJsonObject trace = PerfBundle::measureStartup();
+    EXPECT_EQ(trace.value("detection").toArray().size(), PerfBundle::DETECTION_RUNS);
+    EXPECT_FALSE(PerfBundle::report(trace, trace).isEmpty());
+}
+
+TEST_F(PerfBundleTest, MaterializeStaysInsideTheReplayHome)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    QTemporaryDir outside;
+    ASSERT_TRUE(outside.isValid());
+
+    // 再現先の外や親を指すシンボリックリンクと、その下に書き込むエントリを含む細工したバンドル
+    const QString bundle = m_root.path() + "/crafted";
+    auto entry = [](const QString& path, const QString& type, const QString& target = QString()) {
+        QJsonObject object{{"path", path}, {"type", type}, {"size", 3}};
+        if (!target.isEmpty()) object["target"] = target;
+        return object;
+    };
+    const QJsonArray entries = {entry("a", "l", outside.path()), entry("a/victim", "f"), entry("b", "l", ".."),
+                                entry("c", "l", "d"), entry("d", "d")};
+    writeFile(bundle + "/manifest.json",
+              QJsonDocument(QJsonObject{{"format", PerfBundle::FORMAT_VERSION}, {"entries", entries}}).toJson());
+    writeFile(bundle + "/home/b/victim", "pwned");
+
+    QTemporaryDir replayRoot;
+    ASSERT_TRUE(replayRoot.isValid());
+    QString error;
+    ASSERT_TRUE(PerfBundle::materialize(bundle, replayRoot.path(), &error)) << error.toStdString();
+    const QString replayHome = replayRoot.path() + "/home";
+    EXPECT_FALSE(QFile::exists(outside.path() + "/victim"));
+    EXPECT_FALSE(QFileInfo(replayHome + "/a").isSymLink());
+    EXPECT_EQ(QFileInfo(replayHome + "/a/victim").size(), 3);
+    EXPECT_FALSE(QFileInfo(replayHome + "/b").isSymLink());
+    EXPECT_FALSE(QFile::exists(replayRoot.path() + "/victim"));
+    // 同じディレクトリの名前を指すリンクだけを作成する
+    EXPECT_EQ(QFileInfo(replayHome + "/c").symLinkTarget(), replayHome + "/d");
+
+    // 再現先に既にある外へのリンクも辿らない
+    ASSERT_TRUE(QFile::link(outside.path(), replayHome + "/e"));
+    writeFile(bundle + "/home/e/victim", "pwned");
+    EXPECT_FALSE(PerfBundle::materialize(bundle, replayRoot.path(), &error));
+    EXPECT_FALSE(QFile::exists(outside.path() + "/victim"));
+}
+
+TEST(PerfBundleAnonymizeTest, KeepsLengthAndDependsOnKey)
+{
+    const QString a = PerfBundle::anonymize("alice-secret", "key-1");
+    EXPECT_EQ(a.size(), 12);
+    EXPECT_EQ(a, PerfBundle::anonymize("alice-secret", "key-1"));
+    EXPECT_NE(a, PerfBundle::anonymize("alice-secret", "key-2"));
+    EXPECT_NE(a, PerfBundle::anonymize("alice-secreT", "key-1"));
+
+    // 長い文字列も同じ長さになる
+    const QString longText(100, QLatin1Char('z'));
+    EXPECT_EQ(PerfBundle::anonymize(longText, "key-1").size(), 100);
+    EXPECT_TRUE(PerfBundle::anonymize(QString(), "key-1").isEmpty());
+}
@@ -0,0 +1,193 @@
+/**
+ * @file test_processscanner.cpp
+ * @brief 起動中ブラウザのリソース使用量集計のテスト
+ *
+ * 偽の /proc ツリーを一時ディレクトリに作成し、プロセスツリーの
+ * グループ化とPSS/CPU時間の集計を検証します。
+ */
+
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <cstdio>
+#include <unistd.h>
+
+#include "../src/processscanner.h"
+
+// ヘルパー: 偽のプロセスを作成
+static void addFakeProcess(const QString& procRoot, int pid, int ppid, const QByteArray& comm,
+                           const QList<QByteArray>& args, qint64 pssKiB, int utime, int stime)
+{
+    const QString dir = procRoot + "/" + QString::number(pid);
+    QDir().mkpath(dir);
+
+    QFile stat(dir + "/stat");
+    ASSERT_TRUE(stat.open(QIODevice::WriteOnly));
+    stat.write(QByteArray::number(pid) + " (" + comm + ") S " + QByteArray::number(ppid)
+               + " 1 1 0 -1 4194304 100 0 0 0 " + QByteArray::number(utime) + " "
+               + QByteArray::number(stime) + " 0 0 20 0 1 0 100 0 0\n");
+
+    QFile cmdline(dir + "/cmdline");
+    ASSERT_TRUE(cmdline.open(QIODevice::WriteOnly));
+    for (const QByteArray& arg : args) {
+        cmdline.write(arg);
+        cmdline.write("\0", 1);
+    }
+
+    QFile smaps(dir + "/smaps_rollup");
+    ASSERT_TRUE(smaps.open(QIODevice::WriteOnly));
+    smaps.write("55d0c0000000-7ffd00000000 ---p 00000000 00:00 0    [rollup]\n"
+                "Rss:              " + QByteArray::number(pssKiB * 2) + " kB\n"
+                "Pss:              " + QByteArray::number(pssKiB) + " kB\n");
+}
+
+static QList<ProcessScanner::Target> makeTargets()
+{
+    ProcessScanner::Target work;
+    work.browser = "firefox";
+    work.profileId = "work";
+    work.profilePath = "/home/user/.mozilla/firefox/abcd.work";
+    work.executable = "/usr/bin/firefox";
+    work.type = Constants::BrowserType::Firefox;
+
+    ProcessScanner::Target personal = work;
+    personal.profileId = "personal";
+    personal.profilePath = "/home/user/.mozilla/firefox/efgh.default";
+    personal.isDefault = true;
+
+    ProcessScanner::Target chrome;
+    chrome.browser = "chrome";
+    chrome.profileId = "Default";
+    chrome.profilePath = "Default";
+    chrome.dataDir = "/home/user/.config/google-chrome";
+    chrome.executable = "/usr/bin/google-chrome-stable";
+    chrome.type = Constants::BrowserType::Chrome;
+
+    return {work, personal, chrome};
+}
+
+TEST(ProcessScanner, GroupsProcessTreesByProfile)
+{
+    QTemporaryDir tmpdir;
+    ASSERT_TRUE(tmpdir.isValid());
+    const QString proc = tmpdir.path();
+    const long hz = sysconf(_SC_CLK_TCK);
+
+    // firefox -P work とそのコンテンツプロセス
+    addFakeProcess(proc, 100, 1, "firefox", {"/usr/lib/firefox/firefox", "-P", "work"}, 300000, int(hz * 10), int(hz * 2));
+    addFakeProcess(proc, 101, 100, "Isolated Web Co", {"/usr/lib/firefox/firefox", "-contentproc"}, 100000, int(hz), 0);
+    addFakeProcess(proc, 102, 100, "Web Content", {"/usr/lib/firefox/firefox", "-contentproc"}, 50000, 0, int(hz));
+    // 引数なしの firefox はデフォルトプロファイル
+    addFakeProcess(proc, 200, 1, "firefox", {"/usr/lib/firefox/firefox"}, 200000, int(hz), 0);
+    // Chromeのインスタンス（プロファイル指定なし）とレンダラ
+    addFakeProcess(proc, 300, 1, "chrome", {"/opt/google/chrome/chrome"}, 500000, int(hz * 60), 0);
+    addFakeProcess(proc, 301, 300, "chrome", {"/opt/google/chrome/chrome", "--type=renderer"}, 250000, int(hz * 60), 0);
+    // 無関係なプロセス
+    addFakeProcess(proc, 400, 1, "bash", {"/bin/bash"}, 4000, 0, 0);
+
+    const auto usage = ProcessScanner::scan(makeTargets(), proc);
+
+    const QString workKey = ProcessScanner::usageKey("firefox", "work");
+    ASSERT_TRUE(usage.contains(workKey));
+    EXPECT_EQ(usage[workKey].processCount, 3);
+    EXPECT_EQ(usage[workKey].pssKiB, 450000);
+    EXPECT_EQ(usage[workKey].cpuMs, 14000);
+
+    const QString personalKey = ProcessScanner::usageKey("firefox", "personal");
+    ASSERT_TRUE(usage.contains(personalKey));
+    EXPECT_EQ(usage[personalKey].processCount, 1);
+
+    const QString chromeKey = ProcessScanner::usageKey("chrome", QString());
+    ASSERT_TRUE(usage.contains(chromeKey));
+    EXPECT_EQ(usage[chromeKey].processCount, 2);
+    EXPECT_EQ(usage[chromeKey].pssKiB, 750000);
+
+    EXPECT_EQ(usage.size(), 3);
+}
+
+TEST(ProcessScanner, DiscardsScansOfReplacedTargets)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    QTemporaryDir tmpdir;
+    ASSERT_TRUE(tmpdir.isValid());
+    const QString proc = tmpdir.path();
+    addFakeProcess(proc, 100, 1, "firefox", {"/usr/lib/firefox/firefox", "-P", "work"}, 300000, 0, 0);
+    addFakeProcess(proc, 300, 1, "chrome", {"/opt/google/chrome/chrome"}, 500000, 0, 0);
+
+    const QList<ProcessScanner::Target> targets = makeTargets();
+    ProcessScanner scanner;
+    scanner.setProcRoot(proc);
+    QList<ProcessScanner::UsageMap> updates;
+    QObject::connect(&scanner, &ProcessScanner::usageUpdated,
+                     [&updates](const ProcessScanner::UsageMap& usage) { updates.append(usage); });
+
+    // Firefoxの走査中に対象をChromeに切り替える
+    scanner.setTargets({targets.at(0)});
+    scanner.requestScan();
+    scanner.setTargets({targets.at(2)});
+    scanner.requestScan();
+
+    QElapsedTimer timer;
+    timer.start();
+    while (updates.isEmpty() && !timer.hasExpired(5000)) {
+        QCoreApplication::processEvents();
+        QThread::msleep(5);
+    }
+    // 古い走査の結果が後から届かないことも確認する
+    while (!timer.hasExpired(200)) {
+        QCoreApplication::processEvents();
+        QThread::msleep(5);
+    }
+
+    const QString chromeKey = ProcessScanner::usageKey("chrome", QString());
+    ASSERT_EQ(updates.size(), 1);
+    EXPECT_TRUE(updates.first().contains(chromeKey));
+    EXPECT_FALSE(updates.first().contains(ProcessScanner::usageKey("firefox", "work")));
+    EXPECT_EQ(scanner.lastUsage().size(), 1);
+    EXPECT_TRUE(scanner.lastUsage().contains(chromeKey));
+}
+
+TEST(ProcessScanner, FormatUsage)
+{
+    ProcessScanner::Usage usage;
+    EXPECT_TRUE(ProcessScanner::formatUsage(usage).isEmpty());
+
+    usage.processCount = 4;
+    usage.pssKiB = 1572864;  // 1.5 GiB
+    usage.cpuMs = 185000;
+    EXPECT_EQ(ProcessScanner::formatUsage(usage), QString::fromUtf8("1.5 GB · 3m CPU"));
+
+    usage.pssKiB = 307200;
+    usage.cpuMs = 5000;
+    EXPECT_EQ(ProcessScanner::formatUsage(usage), QString::fromUtf8("300 MB · 5s CPU"));
+}
+
+TEST(ProcessScanner, ScalesToManyProcesses)
+{
+    QTemporaryDir tmpdir;
+    ASSERT_TRUE(tmpdir.isValid());
+    const QString proc = tmpdir.path();
+
+    // 1500の無関係なプロセスと1つのブラウザ
+    for (int pid = 1000; pid < 2500; ++pid) {
+        addFakeProcess(proc, pid, 1, "kworker/u16:3", {}, 0, 0, 0);
+    }
+    addFakeProcess(proc, 3000, 1, "firefox", {"/usr/bin/firefox", "-P", "work"}, 1000, 0, 0);
+
+    QElapsedTimer timer;
+    timer.start();
+    const auto usage = ProcessScanner::scan(makeTargets(), proc);
+    const qint64 elapsedMs = timer.elapsed();
+
+    EXPECT_EQ(usage.size(), 1);
+    // 実際の /proc では数ミリ秒。CI上の一時ディレクトリでも十分に小さいこと
+    EXPECT_LT(elapsedMs, 500);
+    std::printf("scan of 1501 processes: %lld ms\n", static_cast<long long>(elapsedMs));
+}
@@ -0,0 +1,76 @@
+/**
+ * @file test_quicklaunch.cpp
+ * @brief トレイのクイック起動に表示するプロファイルの選択のテスト
+ */
+
+#include <gtest/gtest.h>
+#include <QDateTime>
+#include <QMap>
+
+#include "../src/profilemanager.h"
+
+namespace {
+
+ProfileManager::ProfileEntry makeEntry(const QString& browser, const QString& profile, qint64 lastUsedSecs = 0)
+{
+    ProfileManager::ProfileEntry entry;
+    entry.browser = browser;
+    entry.profileId = profile;
+    entry.profileDisplayName = profile;
+    if (lastUsedSecs > 0) {
+        entry.lastUsed = QDateTime::fromSecsSinceEpoch(lastUsedSecs);
+    }
+    return entry;
+}
+
+} // namespace
+
+TEST(QuickLaunch, OrdersByFrecencyAndSkipsUnused)
+{
+    QList<ProfileManager::ProfileEntry> profiles = {
+        makeEntry("firefox", "work"),
+        makeEntry("firefox", "personal"),
+        makeEntry("chrome", "Default"),
+        makeEntry("chromium", "Default"),
+    };
+    const QMap<QString, double> scores = {
+        {"firefox/work", 300.0},
+        {"chrome/Default", 700.0},
+        {"chromium/Default", 0.0},
+    };
+    auto score = [&scores](const ProfileManager::ProfileEntry& entry) {
+        return scores.value(entry.browser + "/" + entry.profileId, 0.0);
+    };
+
+    const auto recent = ProfileManager::selectRecentProfiles(profiles, score, 5);
+    ASSERT_EQ(recent.size(), 2);
+    EXPECT_EQ(recent[0].browser, "chrome");
+    EXPECT_EQ(recent[1].profileId, "work");
+
+    // 件数の上限
+    const auto top = ProfileManager::selectRecentProfiles(profiles, score, 1);
+    ASSERT_EQ(top.size(), 1);
+    EXPECT_EQ(top[0].browser, "chrome");
+
+    // 無効なプロファイルは表示しない
+    profiles[2].isEnabled = false;
+    const auto enabled = ProfileManager::selectRecentProfiles(profiles, score, 5);
+    ASSERT_EQ(enabled.size(), 1);
+    EXPECT_EQ(enabled[0].profileId, "work");
+}
+
+TEST(QuickLaunch, TiesPreferRecentThenListOrder)
+{
+    const QList<ProfileManager::ProfileEntry> profiles = {
+        makeEntry("firefox", "a", 1000),
+        makeEntry("firefox", "b", 2000),
+        makeEntry("firefox", "c", 1000),
+    };
+    auto score = [](const ProfileManager::ProfileEntry&) { return 100.0; };
+
+    const auto recent = ProfileManager::selectRecentProfiles(profiles, score, 3);
+    ASSERT_EQ(recent.size(), 3);
+    EXPECT_EQ(recent[0].profileId, "b");
+    EXPECT_EQ(recent[1].profileId, "a");
+    EXPECT_EQ(recent[2].profileId, "c");
+}
@@ -0,0 +1,364 @@
+/**
+ * @file test_remotelink.cpp
+ * @brief 転送ソケットでリモートホストのURLを開く機能のテスト
+ *
+ * ssh を使わず、socketpair の片側をリスナーに渡し（RemoteListener::adopt）、
+ * もう片側でクライアントの送受信（RemoteClient::exchange）を別スレッドで実行します。
+ */
+
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTimer>
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../src/pickerqueue.h"
+#include "../src/remoteclient.h"
+#include "../src/remotelistener.h"
+#include "../src/remoteprotocol.h"
+
+namespace {
+
+const QByteArray TOKEN = "0123456789abcdef";
+
+/**
+ * @brief イベントループを回しながらクライアントの送受信を1回実行
+ */
+bool roundTrip(RemoteListener* listener, std::string_view token, const std::vector<std::string>& urls,
+               std::vector<RemoteClient::Reply>* replies, std::string* error)
+{
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) {
+        *error = "socketpair failed";
+        return false;
+    }
+    listener->adopt(fds[1]);
+
+    std::atomic<bool> done{false};
+    bool ok = false;
+    std::thread client([&]() {
+        ok = RemoteClient::exchange(fds[0], token, urls, replies, 5000, error);
+        done = true;
+    });
+
+    QEventLoop loop;
+    QTimer poll;
+    QObject::connect(&poll, &QTimer::timeout, &loop, [&]() {
+        if (done) {
+            loop.quit();
+        }
+    });
+    poll.start(1);
+    QTimer::singleShot(10000, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    client.join();
+    ::close(fds[0]);
+    return ok;
+}
+
+/**
+ * @brief イベントループを指定時間だけ回す
+ */
+void runEventLoop(int ms)
+{
+    QEventLoop loop;
+    QTimer::singleShot(ms, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+mode_t fileMode(const QString& path)
+{
+    struct stat info {};
+    ::stat(QFile::encodeName(path).constData(), &info);
+    return info.st_mode & 0777;
+}
+
+} // namespace
+
+TEST(RemoteProtocol, ReaderWaitsForPartialFrames)
+{
+    using namespace RemoteProtocol;
+
+    std::string stream;
+    ASSERT_TRUE(appendFrame(&stream, FrameType::Url, "https://example.com"));
+    ASSERT_TRUE(appendReply(&stream, Status::Rejected, "not a valid URL"));
+
+    FrameReader reader;
+    FrameType type;
+    std::string payload;
+    // 1バイトずつ届いても、フレームが揃うまでは取り出さない
+    for (size_t i = 0; i < HEADER_SIZE + 18; ++i) {
+        reader.append(&stream[i], 1);
+        EXPECT_EQ(reader.next(&type, &payload), FrameReader::Result::NeedMore);
+    }
+    reader.append(&stream[HEADER_SIZE + 18], stream.size() - HEADER_SIZE - 18);
+
+    ASSERT_EQ(reader.next(&type, &payload), FrameReader::Result::Frame);
+    EXPECT_EQ(type, FrameType::Url);
+    EXPECT_EQ(payload, "https://example.com");
+    ASSERT_EQ(reader.next(&type, &payload), FrameReader::Result::Frame);
+    EXPECT_EQ(type, FrameType::Reply);
+    EXPECT_EQ(payload, std::string("\x01not a valid URL"));
+    EXPECT_EQ(reader.next(&type, &payload), FrameReader::Result::NeedMore);
+    EXPECT_EQ(reader.pending(), 0u);
+
+    // 上限を超える長さは受信を待たずに不正とする
+    const char oversized[] = {'\x7f', '\xff', '\xff', '\xff', 'U'};
+    reader.append(oversized, sizeof(oversized));
+    EXPECT_EQ(reader.next(&type, &payload), FrameReader::Result::Invalid);
+    EXPECT_FALSE(appendFrame(&stream, FrameType::Url, std::string(MAX_PAYLOAD + 1, 'a')));
+}
+
+TEST(RemoteListener, ValidatesUrls)
+{
+    QString reason;
+    EXPECT_EQ(RemoteListener::validateUrl("  https://example.com/path?q=1\n", &reason),
+              QString("https://example.com/path?q=1"));
+    EXPECT_EQ(RemoteListener::validateUrl("example.com", &reason), QString("https://www.example.com"));
+
+    EXPECT_TRUE(RemoteListener::validateUrl("file:///etc/passwd", &reason).isEmpty());
+    EXPECT_EQ(reason, QString("file URLs refer to the remote host"));
+    EXPECT_TRUE(RemoteListener::validateUrl("ftp://example.com/", &reason).isEmpty());
+    EXPECT_TRUE(RemoteListener::validateUrl("https://example.com/$(reboot)", &reason).isEmpty());
+    EXPECT_TRUE(RemoteListener::validateUrl("https://example.com/\r\nX-Injected: 1", &reason).isEmpty());
+    EXPECT_TRUE(RemoteListener::validateUrl("", &reason).isEmpty());
+}
+
+TEST(RemoteListener, AcceptsAndRejectsInOneRoundTrip)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    RemoteListener listener(TOKEN);
+    QStringList opened;
+    QObject::connect(&listener, &RemoteListener::urlReceived, [&](const QString& url) { opened.append(url); });
+
+    std::vector<RemoteClient::Reply> replies;
+    std::string error;
+    ASSERT_TRUE(roundTrip(&listener, TOKEN.toStdString(),
+                          {"https://example.com/a", "file:///home/user/.ssh/id_ed25519", "example.org"},
+                          &replies, &error))
+        << error;
+
+    ASSERT_EQ(replies.size(), 3u);
+    EXPECT_EQ(replies[0].status, RemoteProtocol::Status::Accepted);
+    EXPECT_EQ(replies[1].status, RemoteProtocol::Status::Rejected);
+    EXPECT_EQ(replies[1].message, "file URLs refer to the remote host");
+    EXPECT_EQ(replies[2].status, RemoteProtocol::Status::Accepted);
+    EXPECT_EQ(opened, QStringList({"https://example.com/a", "https://www.example.org"}));
+
+    // クライアントが閉じた接続は片付ける
+    runEventLoop(20);
+    EXPECT_EQ(listener.connectionCount(), 0);
+}
+
+TEST(RemoteListener, QueuesEveryUrlForThePicker)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    // main.cpp と同じ接続（リスナー → キュー → ピッカー）
+    RemoteListener listener(TOKEN);
+    PickerQueue queue;
+    QStringList shown;
+    QObject::connect(&listener, &RemoteListener::urlReceived, &queue, &PickerQueue::enqueue);
+    QObject::connect(&queue, &PickerQueue::showRequested, [&](const QString& url) { shown.append(url); });
+
+    // ピッカーが既に別のURLを表示している
+    queue.enqueue("https://local.example/");
+    ASSERT_EQ(shown, QStringList({"https://local.example/"}));
+
+    std::vector<RemoteClient::Reply> replies;
+    std::string error;
+    ASSERT_TRUE(roundTrip(&listener, TOKEN.toStdString(), {"https://example.com/1", "https://example.com/2"},
+                          &replies, &error))
+        << error;
+    ASSERT_EQ(replies.size(), 2u);
+    EXPECT_EQ(replies[0].status, RemoteProtocol::Status::Accepted);
+    EXPECT_EQ(replies[1].status, RemoteProtocol::Status::Accepted);
+
+    // 表示中のURLは上書きせず、閉じられるたびに届いた順に表示する
+    EXPECT_EQ(queue.current(), QString("https://local.example/"));
+    EXPECT_EQ(queue.pending(), QStringList({"https://example.com/1", "https://example.com/2"}));
+    queue.pickerClosed();
+    queue.pickerClosed();
+    EXPECT_EQ(shown, QStringList({"https://local.example/", "https://example.com/1", "https://example.com/2"}));
+    queue.pickerClosed();
+    EXPECT_TRUE(queue.current().isEmpty());
+
+    // 閉じている間に届いたURLはすぐに表示する
+    queue.enqueue("https://example.com/3");
+    EXPECT_EQ(shown.last(), QString("https://example.com/3"));
+}
+
+TEST(RemoteListener, RejectsWrongToken)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    RemoteListener listener(TOKEN);
+    int opened = 0;
+    QObject::connect(&listener, &RemoteListener::urlReceived, [&]() { ++opened; });
+
+    std::vector<RemoteClient::Reply> replies;
+    std::string error;
+    EXPECT_FALSE(roundTrip(&listener, "0123456789abcdeX", {"https://example.com/"}, &replies, &error));
+    EXPECT_EQ(error, "unauthorized: token does not match");
+    EXPECT_FALSE(roundTrip(&listener, "", {"https://example.com/"}, &replies, &error));
+    EXPECT_EQ(error, "unauthorized: token does not match");
+    EXPECT_EQ(opened, 0);
+    EXPECT_EQ(listener.connectionCount(), 0);
+}
+
+TEST(RemoteListener, DropsOversizedFrames)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    RemoteListener listener(TOKEN);
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds), 0);
+    listener.adopt(fds[1]);
+
+    // Hello の前に巨大な長さを宣言したフレーム
+    const char header[] = {'\x01', '\x00', '\x00', '\x00', 'H'};
+    ASSERT_EQ(::write(fds[0], header, sizeof(header)), static_cast<ssize_t>(sizeof(header)));
+    runEventLoop(20);
+    EXPECT_EQ(listener.connectionCount(), 0);
+
+    char buffer[256];
+    const ssize_t n = ::read(fds[0], buffer, sizeof(buffer));
+    ASSERT_GT(n, 0);
+    RemoteProtocol::FrameReader reader;
+    reader.append(buffer, static_cast<size_t>(n));
+    RemoteProtocol::FrameType type;
+    std::string payload;
+    ASSERT_EQ(reader.next(&type, &payload), RemoteProtocol::FrameReader::Result::Frame);
+    EXPECT_EQ(type, RemoteProtocol::FrameType::Reply);
+    EXPECT_EQ(static_cast<RemoteProtocol::Status>(payload[0]), RemoteProtocol::Status::ProtocolError);
+    // 切断済み
+    EXPECT_EQ(::read(fds[0], buffer, sizeof(buffer)), 0);
+    ::close(fds[0]);
+}
+
+TEST(RemoteListener, CreatesOwnerOnlyTokenFile)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath("config/kde-browser-picker/remote-token");
+
+    QString error;
+    const QByteArray token = RemoteListener::loadOrCreateToken(path, &error);
+    ASSERT_EQ(token.size(), 64) << error.toStdString();
+    EXPECT_EQ(fileMode(path), 0600u);
+    EXPECT_EQ(RemoteListener::loadOrCreateToken(path, &error), token);
+
+    // クライアントも同じトークンを読む
+    std::string clientToken;
+    std::string clientError;
+    ASSERT_TRUE(RemoteClient::readToken(path.toStdString(), &clientToken, &clientError)) << clientError;
+    EXPECT_EQ(clientToken, token.toStdString());
+
+    // 他のユーザーが読めるファイルはどちらも使わない
+    ASSERT_EQ(::chmod(QFile::encodeName(path).constData(), 0640), 0);
+    EXPECT_TRUE(RemoteListener::loadOrCreateToken(path, &error).isEmpty());
+    EXPECT_FALSE(error.isEmpty());
+    EXPECT_FALSE(RemoteClient::readToken(path.toStdString(), &clientToken, &clientError));
+}
+
+TEST(RemoteListener, ListensOnOwnerOnlySocket)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath("remote.sock");
+    const QString tokenPath = dir.filePath("token");
+    QFile tokenFile(tokenPath);
+    ASSERT_TRUE(tokenFile.open(QIODevice::WriteOnly));
+    tokenFile.write(TOKEN + '\n');
+    tokenFile.close();
+    ASSERT_EQ(::chmod(QFile::encodeName(tokenPath).constData(), 0600), 0);
+
+    QString error;
+    {
+        RemoteListener listener(TOKEN);
+        ASSERT_TRUE(listener.listen(path, &error)) << error.toStdString();
+        EXPECT_EQ(fileMode(path), 0600u);
+
+        QStringList opened;
+        QObject::connect(&listener, &RemoteListener::urlReceived, [&](const QString& url) { opened.append(url); });
+
+        // 実際の接続と同じ経路（connect と SO_PEERCRED の確認）を通す
+        std::atomic<int> status{-1};
+        std::thread client([&]() {
+            const std::string socketArg = "--socket=" + path.toStdString();
+            const std::string tokenArg = "--token-file=" + tokenPath.toStdString();
+            char* argv[] = {const_cast<char*>("kbp-remote-client"), const_cast<char*>(socketArg.c_str()),
+                            const_cast<char*>(tokenArg.c_str()), const_cast<char*>("https://example.com/x"),
+                            nullptr};
+            status = RemoteClient::main(4, argv);
+        });
+        QEventLoop loop;
+        QTimer poll;
+        QObject::connect(&poll, &QTimer::timeout, &loop, [&]() {
+            if (status >= 0) {
+                loop.quit();
+            }
+        });
+        poll.start(1);
+        QTimer::singleShot(10000, &loop, &QEventLoop::quit);
+        loop.exec();
+        client.join();
+
+        EXPECT_EQ(status, 0);
+        EXPECT_EQ(opened, QStringList({"https://example.com/x"}));
+    }
+    // 終了時にソケットファイルを削除する
+    EXPECT_FALSE(QFile::exists(path));
+
+    // ソケット以外のファイルは置き換えない
+    QFile regular(path);
+    ASSERT_TRUE(regular.open(QIODevice::WriteOnly));
+    regular.close();
+    RemoteListener listener(TOKEN);
+    EXPECT_FALSE(listener.listen(path, &error));
+    EXPECT_TRUE(QFile::exists(path));
+}
+
+TEST(RemoteListener, RoundTripIsDominatedByTransport)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    RemoteListener listener(TOKEN);
+    std::vector<RemoteClient::Reply> replies;
+    std::string error;
+
+    // ローカルの往復（転送の遅延なし）はリスナー側の処理時間とほぼ等しい
+    constexpr int ITERATIONS = 50;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        ASSERT_TRUE(roundTrip(&listener, TOKEN.toStdString(), {"https://example.com/"}, &replies, &error)) << error;
+    }
+    const double averageMs = static_cast<double>(timer.nsecsElapsed()) / 1e6 / ITERATIONS;
+    std::cout << "Remote link round trip over socketpair: " << averageMs << " ms" << std::endl;
+    // 一般的な ssh の往復（数ms〜数十ms）に比べて十分に小さいこと
+    EXPECT_LT(averageMs, 20.0);
+}
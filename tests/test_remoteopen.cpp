@@ -0,0 +1,324 @@
+/**
+ * @file test_remoteopen.cpp
+ * @brief 起動中ブラウザへのURL受け渡しのテスト
+ *
+ * ローカルに SingletonSocket の代役サーバーを立て、Chromiumのプロトコルで
+ * コマンドラインが届くこと、およびexecによる起動との所要時間を比較します。
+ * Firefoxは org.mozilla.firefox.<Base64> を名乗る代役のサービスを別の接続で公開し、
+ * OpenURL で届くコマンドラインを検証します（dbus-run-session の専用バスで実行してください）。
+ */
+
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusVirtualObject>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QtEndian>
+
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../src/remoteopen.h"
+#include "../include/constants.h"
+
+/**
+ * @brief SingletonSocket の代役サーバー
+ *
+ * 1接続ずつ受け付け、EOFまで読み取ったメッセージを保存して応答を返します。
+ */
+class StandInSingleton {
+public:
+    StandInSingleton(const QString& socketPath, const QByteArray& reply)
+        : m_reply(reply)
+    {
+        m_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        const QByteArray path = QFile::encodeName(socketPath);
+        std::memcpy(addr.sun_path, path.constData(), static_cast<size_t>(path.size()));
+        m_listening = m_fd >= 0 &&
+                      ::bind(m_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+                      ::listen(m_fd, 4) == 0;
+    }
+
+    ~StandInSingleton()
+    {
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+    }
+
+    bool isListening() const { return m_listening; }
+
+    /// 指定回数の接続を別スレッドで処理する
+    void serve(int connections)
+    {
+        m_thread = std::thread([this, connections]() {
+            for (int i = 0; i < connections; ++i) {
+                const int client = ::accept(m_fd, nullptr, nullptr);
+                if (client < 0) {
+                    return;
+                }
+                QByteArray message;
+                char buffer[256];
+                ssize_t n;
+                while ((n = ::read(client, buffer, sizeof(buffer))) > 0) {
+                    message.append(buffer, static_cast<int>(n));
+                }
+                m_lastMessage = message;
+                if (!m_reply.isEmpty()) {
+                    (void)::write(client, m_reply.constData(), static_cast<size_t>(m_reply.size()));
+                }
+                ::close(client);
+            }
+        });
+    }
+
+    /// serve() の完了を待ち、最後に受信したメッセージを返す
+    QByteArray waitForMessage()
+    {
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+        return m_lastMessage;
+    }
+
+private:
+    int m_fd = -1;
+    bool m_listening = false;
+    QByteArray m_reply;
+    QByteArray m_lastMessage;
+    std::thread m_thread;
+};
+
+/**
+ * @brief Firefoxの /org/mozilla/firefox/Remote の代役
+ *
+ * OpenURL の引数を保存して空の応答を返します。拒否する設定では D-Bus のエラーを返します。
+ */
+class StandInFirefox : public QDBusVirtualObject {
+public:
+    explicit StandInFirefox(bool refuse = false) : m_refuse(refuse) {}
+
+    bool handleMessage(const QDBusMessage& message, const QDBusConnection& connection) override {
+        if (message.interface() != "org.mozilla.firefox" || message.member() != "OpenURL") {
+            return false;
+        }
+        {
+            QMutexLocker lock(&m_mutex);
+            m_commandLines << message.arguments().value(0).toByteArray();
+        }
+        connection.send(m_refuse ? message.createErrorReply("org.freedesktop.DBus.Error.Failed", "refused")
+                                 : message.createReply());
+        return true;
+    }
+
+    QString introspect(const QString&) const override { return QString(); }
+
+    /// 受け取ったコマンドライン
+    QList<QByteArray> commandLines() const {
+        QMutexLocker lock(&m_mutex);
+        return m_commandLines;
+    }
+
+private:
+    bool m_refuse;
+    mutable QMutex m_mutex;
+    QList<QByteArray> m_commandLines;
+};
+
+TEST(RemoteOpen, ChromiumMessageFormat)
+{
+    const QByteArray message = RemoteOpen::buildChromiumMessage(
+        "/home/user", {"/usr/bin/chromium", "--profile-directory=Profile 1", "https://example.com"});
+    const QByteArray expected("START\0/home/user\0/usr/bin/chromium\0--profile-directory=Profile 1\0https://example.com", 84);
+    EXPECT_EQ(message, expected);
+}
+
+TEST(RemoteOpen, ChromiumDeliversThroughSymlinkedSocket)
+{
+    QTemporaryDir socketDir;
+    QTemporaryDir userDataDir;
+    ASSERT_TRUE(socketDir.isValid());
+    ASSERT_TRUE(userDataDir.isValid());
+
+    // 実際のChromiumと同様、ユーザーデータディレクトリにはシンボリックリンクを置く
+    const QString realSocket = socketDir.path() + "/SingletonSocket";
+    StandInSingleton server(realSocket, "ACK");
+    ASSERT_TRUE(server.isListening());
+    ASSERT_TRUE(QFile::link(realSocket, userDataDir.path() + "/SingletonSocket"));
+    server.serve(1);
+
+    const QStringList argv = {"/usr/bin/chromium", "--profile-directory=Default", "https://example.com"};
+    EXPECT_EQ(RemoteOpen::openInChromium(userDataDir.path(), argv), RemoteOpen::Result::Delivered);
+    EXPECT_EQ(server.waitForMessage(), RemoteOpen::buildChromiumMessage(QDir::currentPath(), argv));
+}
+
+TEST(RemoteOpen, ChromiumNotRunning)
+{
+    QTemporaryDir userDataDir;
+    ASSERT_TRUE(userDataDir.isValid());
+
+    // SingletonSocket なし
+    EXPECT_EQ(RemoteOpen::openInChromium(userDataDir.path(), {"chromium"}), RemoteOpen::Result::NotRunning);
+
+    // ブラウザ終了後に残ったソケット（誰もlistenしていない）
+    {
+        StandInSingleton stale(userDataDir.path() + "/SingletonSocket", "ACK");
+        ASSERT_TRUE(stale.isListening());
+    }
+    EXPECT_EQ(RemoteOpen::openInChromium(userDataDir.path(), {"chromium"}), RemoteOpen::Result::NotRunning);
+}
+
+TEST(RemoteOpen, ChromiumShutdownAndMissingAck)
+{
+    QTemporaryDir userDataDir;
+    ASSERT_TRUE(userDataDir.isValid());
+    const QString socketPath = userDataDir.path() + "/SingletonSocket";
+
+    {
+        StandInSingleton shuttingDown(socketPath, "SHUTDOWN");
+        ASSERT_TRUE(shuttingDown.isListening());
+        shuttingDown.serve(1);
+        EXPECT_EQ(RemoteOpen::openInChromium(userDataDir.path(), {"chromium"}),
+                  RemoteOpen::Result::NotRunning);
+    }
+    QFile::remove(socketPath);
+
+    {
+        StandInSingleton silent(socketPath, QByteArray());
+        ASSERT_TRUE(silent.isListening());
+        silent.serve(1);
+        EXPECT_EQ(RemoteOpen::openInChromium(userDataDir.path(), {"chromium"}, 100),
+                  RemoteOpen::Result::Failed);
+    }
+    QFile::remove(socketPath);
+
+    // GUIスレッドで呼ばれるため、既定では応答しない（acceptもしない）相手を短時間で諦める
+    {
+        StandInSingleton hung(socketPath, QByteArray());
+        ASSERT_TRUE(hung.isListening());
+        QElapsedTimer timer;
+        timer.start();
+        EXPECT_EQ(RemoteOpen::openInChromium(userDataDir.path(), {"chromium"}), RemoteOpen::Result::Failed);
+        EXPECT_GE(timer.elapsed(), Constants::REMOTE_OPEN_TIMEOUT_MS - 10);
+        EXPECT_LT(timer.elapsed(), Constants::REMOTE_OPEN_TIMEOUT_MS + 500);
+    }
+}
+
+TEST(RemoteOpen, FirefoxCommandLineFormat)
+{
+    const QByteArray buffer = RemoteOpen::buildFirefoxCommandLine("/tmp", {"firefox", "https://example.com"});
+
+    // ヘッダー: argc + オフセット2つ
+    ASSERT_GE(buffer.size(), 12);
+    EXPECT_EQ(qFromLittleEndian<qint32>(buffer.constData()), 2);
+    const qint32 argv0 = qFromLittleEndian<qint32>(buffer.constData() + 4);
+    const qint32 argv1 = qFromLittleEndian<qint32>(buffer.constData() + 8);
+
+    // 作業ディレクトリはヘッダー直後
+    EXPECT_STREQ(buffer.constData() + 12, "/tmp");
+    EXPECT_EQ(argv0, 12 + 5);
+    EXPECT_STREQ(buffer.constData() + argv0, "firefox");
+    EXPECT_STREQ(buffer.constData() + argv1, "https://example.com");
+    EXPECT_EQ(buffer.size(), argv1 + int(std::strlen("https://example.com")) + 1);
+}
+
+TEST(RemoteOpen, FirefoxServiceName)
+{
+    EXPECT_EQ(RemoteOpen::firefoxServiceName("default-release"),
+              QString("org.mozilla.firefox.ZGVmYXVsdC1yZWxlYXNl"));
+    // Base64のパディング '=' は '_' に置換される
+    EXPECT_EQ(RemoteOpen::firefoxServiceName("work"), QString("org.mozilla.firefox.d29yaw__"));
+}
+
+TEST(RemoteOpen, FirefoxDeliversOverDBus)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    // 代役は別の接続・別のスレッドで応答する（openInFirefox() の同期呼び出しを待たせない）
+    QDBusConnection bus = QDBusConnection::connectToBus(QDBusConnection::SessionBus, "stand-in-firefox");
+    if (!bus.isConnected() || !QDBusConnection::sessionBus().isConnected()) {
+        GTEST_SKIP() << "no session bus (run under dbus-run-session)";
+    }
+
+    QThread serviceThread;
+    serviceThread.start();
+    StandInFirefox work;
+    work.moveToThread(&serviceThread);
+    ASSERT_TRUE(bus.registerVirtualObject("/org/mozilla/firefox/Remote", &work));
+    ASSERT_TRUE(bus.registerService(RemoteOpen::firefoxServiceName("work")));
+
+    const QStringList argv = {"/usr/bin/firefox", "-P", "work", "https://example.com/a?b=c"};
+    EXPECT_EQ(RemoteOpen::openInFirefox("work", argv, "startup-token"), RemoteOpen::Result::Delivered);
+    ASSERT_EQ(work.commandLines().size(), 1);
+    EXPECT_EQ(work.commandLines().first(),
+              RemoteOpen::buildFirefoxCommandLine(QDir::currentPath(), argv, "startup-token"));
+
+    // そのプロファイルのFirefoxが起動していない（サービスがない）
+    EXPECT_EQ(RemoteOpen::openInFirefox("personal", argv), RemoteOpen::Result::NotRunning);
+    EXPECT_EQ(work.commandLines().size(), 1);
+
+    bus.unregisterService(RemoteOpen::firefoxServiceName("work"));
+    bus.unregisterObject("/org/mozilla/firefox/Remote");
+
+    // 受け取りを拒否された
+    StandInFirefox refusing(true);
+    refusing.moveToThread(&serviceThread);
+    ASSERT_TRUE(bus.registerVirtualObject("/org/mozilla/firefox/Remote", &refusing));
+    ASSERT_TRUE(bus.registerService(RemoteOpen::firefoxServiceName("work")));
+    EXPECT_EQ(RemoteOpen::openInFirefox("work", argv), RemoteOpen::Result::Failed);
+    EXPECT_EQ(refusing.commandLines().size(), 1);
+
+    bus.unregisterService(RemoteOpen::firefoxServiceName("work"));
+    bus.unregisterObject("/org/mozilla/firefox/Remote");
+    serviceThread.quit();
+    serviceThread.wait();
+    QDBusConnection::disconnectFromBus("stand-in-firefox");
+}
+
+TEST(RemoteOpen, LatencyComparedToExec)
+{
+    QTemporaryDir userDataDir;
+    ASSERT_TRUE(userDataDir.isValid());
+
+    constexpr int iterations = 20;
+    StandInSingleton server(userDataDir.path() + "/SingletonSocket", "ACK");
+    ASSERT_TRUE(server.isListening());
+    server.serve(iterations);
+
+    const QStringList argv = {"/usr/bin/chromium", "--profile-directory=Default", "https://example.com"};
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        ASSERT_EQ(RemoteOpen::openInChromium(userDataDir.path(), argv), RemoteOpen::Result::Delivered);
+    }
+    const qint64 remoteNs = timer.nsecsElapsed() / iterations;
+    server.waitForMessage();
+
+    // execの代役: 何もせず終了するプロセスの起動（実際のブラウザはさらにバイナリの読み込みが加わる）
+    timer.restart();
+    for (int i = 0; i < iterations; ++i) {
+        ASSERT_EQ(QProcess::execute("/bin/true", {}), 0);
+    }
+    const qint64 execNs = timer.nsecsElapsed() / iterations;
+
+    std::printf("remote open: %lld us, exec of /bin/true: %lld us\n",
+                static_cast<long long>(remoteNs / 1000), static_cast<long long>(execNs / 1000));
+    EXPECT_LT(remoteNs, execNs);
+}
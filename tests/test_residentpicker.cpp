@@ -0,0 +1,166 @@
+/**
+ * @file test_residentpicker.cpp
+ * @brief 常駐モード（トレイ・--remote-listen）のピッカーのテスト
+ *
+ * トレイと同じ ConfigManager / ProfileManager を共有するオフスクリーンの MainWindow から
+ * プロファイルを選び、起動の通知と起動履歴が共有のオブジェクトに届くことを確認します。
+ * また、検出の途中で選んだ後に再表示すると、中断した検出が完了して一覧が最新になることを確認します。
+ */
+
+#include <gtest/gtest.h>
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QKeyEvent>
+#include <QThread>
+#include <QTimer>
+
+#include <atomic>
+#include <functional>
+
+#include "../src/mainwindow.h"
+#include "../src/configmanager.h"
+#include "../src/profilemanager.h"
+#include "../src/browserdetector.h"
+#include "../src/ui/profileitem.h"
+#include "fakehome.h"
+
+namespace {
+
+/**
+ * @brief 条件を満たすまでイベントループを回す
+ * @return 5秒以内に満たした場合 true
+ */
+bool waitUntil(const std::function<bool()>& condition)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition()) {
+        if (timer.hasExpired(5000)) {
+            return false;
+        }
+        QEventLoop loop;
+        QTimer::singleShot(10, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+    return true;
+}
+
+/// 数字キーでプロファイルを選ぶ
+void pressNumber(MainWindow& window, int number)
+{
+    QKeyEvent press(QEvent::KeyPress, Qt::Key_0 + number, Qt::NoModifier, QString::number(number));
+    QCoreApplication::sendEvent(&window, &press);
+}
+
+/// 遅いファイルシステム上のプロファイルに見立てて待つ（中断されれば途中で戻る）
+void sleepUnlessStopped(int ms, const std::stop_token& stop)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!stop.stop_requested() && !timer.hasExpired(ms)) {
+        QThread::msleep(10);
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Firefoxの2つのプロファイルを持つ偽のホームを用意するフィクスチャ
+ */
+class ResidentPickerTest : public FakeHomeTest {
+protected:
+    void SetUp() override {
+        FakeHomeTest::SetUp();
+        if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+        addFirefoxProfiles();
+        // 常駐用に URL なしで作成するためタイムアウトは動かさない
+        writeRc("[General]\nDefaultTimeout=0\n");
+    }
+};
+
+TEST_F(ResidentPickerTest, SharesTheTrayProfileList)
+{
+    int argc = 0;
+    QApplication app(argc, nullptr);
+
+    // main.cpp のトレイと同じ構成（ピッカーの作成で共有の一覧の検出が始まる）
+    ConfigManager config;
+    ProfileManager profiles(&config);
+    QStringList launched;
+    QObject::connect(&profiles, &ProfileManager::profileLaunched,
+                     [&launched](const QString& browser, const QString& profile) {
+                         launched << browser + "/" + profile;
+                     });
+    MainWindow picker(&config, &profiles);
+    ASSERT_TRUE(waitUntil([&profiles]() { return !profiles.isRefreshing(); }));
+    EXPECT_EQ(profiles.getAllProfiles(true).size(), 2);
+
+    picker.setUrl("https://example.com/");
+    picker.show();
+    ASSERT_TRUE(waitUntil([&picker]() { return picker.findChildren<ProfileItem*>().size() == 2; }));
+
+    // ピッカーでの起動は共有の ProfileManager から通知され、共有の設定に記録される
+    pressNumber(picker, 1);
+    ASSERT_TRUE(waitUntil([&launched]() { return !launched.isEmpty(); }));
+    EXPECT_EQ(launched.size(), 1);
+    EXPECT_FALSE(picker.isVisible());
+    const QPair<QString, QString> lastUsed = config.getLastUsedForHost("example.com");
+    EXPECT_EQ(lastUsed.first + "/" + lastUsed.second, launched.first());
+    EXPECT_GT(config.frecencyScore(lastUsed.first, lastUsed.second), 0.0);
+}
+
+TEST_F(ResidentPickerTest, PickDuringDetectionCompletesItOnReshow)
+{
+    int argc = 0;
+    QApplication app(argc, nullptr);
+
+    // 前回の検出結果（work, personal）のスナップショット
+    {
+        ConfigManager config;
+        ProfileManager profiles(&config);
+        profiles.startRefresh();
+        ASSERT_TRUE(waitUntil([&profiles]() { return !profiles.isRefreshing(); }));
+    }
+    // その後に追加されたプロファイルは検出で初めて一覧に入る
+    writeFile(m_home + "/.mozilla/firefox/profiles.ini",
+              "[Profile0]\nName=work\nIsRelative=1\nPath=a1.work\nDefault=1\n\n"
+              "[Profile1]\nName=personal\nIsRelative=1\nPath=b2.personal\n\n"
+              "[Profile2]\nName=spare\nIsRelative=1\nPath=c3.spare\n");
+    ASSERT_TRUE(QDir().mkpath(m_home + "/.mozilla/firefox/c3.spare"));
+
+    ConfigManager config;
+    ProfileManager profiles(&config);
+    std::atomic<int> probeMs(10000);
+    profiles.browserDetector()->setProbeHook([&probeMs](const QString&, const std::stop_token& stop) {
+        sleepUnlessStopped(probeMs, stop);
+    });
+    bool launched = false;
+    QObject::connect(&profiles, &ProfileManager::profileLaunched, [&launched]() { launched = true; });
+
+    // スナップショットの行から、検出の完了を待たずに選ぶ
+    MainWindow picker(&config, &profiles);
+    picker.setUrl("https://example.com/");
+    picker.show();
+    ASSERT_TRUE(waitUntil([&picker]() { return picker.findChildren<ProfileItem*>().size() == 2; }));
+    ASSERT_TRUE(profiles.isRefreshing());
+    pressNumber(picker, 1);
+    ASSERT_TRUE(waitUntil([&launched]() { return launched; }));
+    EXPECT_FALSE(profiles.isRefreshing());
+    EXPECT_EQ(profiles.getAllProfiles(true).size(), 2);
+
+    // 再表示で中断した検出を続け、完了すると検出した一覧に置き換わる
+    probeMs = 0;
+    picker.setUrl("https://example.org/");
+    picker.show();
+    EXPECT_TRUE(profiles.isRefreshing());
+    ASSERT_TRUE(waitUntil([&picker]() { return picker.findChildren<ProfileItem*>().size() == 3; }));
+    EXPECT_EQ(profiles.getAllProfiles(true).size(), 3);
+
+    // 続けて表示しても検出をやり直さない
+    picker.hide();
+    picker.show();
+    EXPECT_FALSE(profiles.isRefreshing());
+}
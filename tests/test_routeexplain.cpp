@@ -0,0 +1,150 @@
+/**
+ * @file test_routeexplain.cpp
+ * @brief 振り分けの説明（--explain）のテスト
+ *
+ * ホストの履歴・起動回数・最後に使用したプロファイルを設定した偽のホームで、
+ * 各段階の結果と最終的な起動先がピッカーの選択と一致することを検証します。
+ */
+
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QJsonArray>
+
+#include "../src/routeexplain.h"
+#include "../src/browserdetector.h"
+#include "fakehome.h"
+
+namespace {
+
+QStringList stageNames(const RouteExplain::Report& report)
+{
+    QStringList names;
+    for (const RouteExplain::Stage& stage : report.stages) {
+        names << stage.name;
+    }
+    return names;
+}
+
+const RouteExplain::Stage* findStage(const RouteExplain::Report& report, const QString& name)
+{
+    for (const RouteExplain::Stage& stage : report.stages) {
+        if (stage.name == name) {
+            return &stage;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+/**
+ * @brief 2つのFirefoxプロファイルと起動履歴を持つ偽のホームを用意するフィクスチャ
+ */
+class RouteExplainTest : public FakeHomeTest {
+protected:
+    void SetUp() override {
+        FakeHomeTest::SetUp();
+        addFirefoxProfiles();
+        writeRc(QString("[General]\nDefaultTimeout=7\n\n"
+                        "[LastUsed]\nBrowser=firefox\nProfile=work\n\n"
+                        "[LaunchStats]\nfirefox/personal=5,%1\n\n"
+                        "[HostHistory]\nintranet.example=firefox/work\n")
+                    .arg(QDateTime::currentSecsSinceEpoch()).toUtf8());
+    }
+};
+
+TEST_F(RouteExplainTest, ReportsEveryStageAndTheDefaultTarget)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    const RouteExplain::Report report = RouteExplain::explain("intranet.example/wiki");
+    EXPECT_EQ(stageNames(report), QStringList({"config", "detection", "canonicalize", "validate", "host_rule",
+                                               "frecency", "prediction", "running", "default"}));
+    EXPECT_EQ(report.url, "https://www.intranet.example/wiki");
+
+    // スキームの補完で "www." が付くため、ホストの履歴には一致しない
+    ASSERT_NE(findStage(report, "host_rule"), nullptr);
+    EXPECT_TRUE(findStage(report, "host_rule")->result.startsWith("no entry for www.intranet.example"));
+
+    // 起動回数の多いプロファイルが予測され、タイムアウト時は最後に使用したプロファイルが開かれる
+    EXPECT_EQ(findStage(report, "prediction")->details.value("profile").toString(), "personal");
+    EXPECT_EQ(findStage(report, "prediction")->details.value("reason").toString(), "frecency");
+    EXPECT_EQ(report.browser, "firefox");
+    EXPECT_EQ(report.profileId, "work");
+    EXPECT_EQ(findStage(report, "default")->details.value("reason").toString(), "last used");
+    EXPECT_TRUE(report.decision.contains("7 s"));
+
+    for (const RouteExplain::Stage& stage : report.stages) {
+        EXPECT_GE(stage.elapsedNs, 0) << qPrintable(stage.name);
+    }
+}
+
+TEST_F(RouteExplainTest, HostHistoryDrivesThePrediction)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    const RouteExplain::Report report = RouteExplain::explain("https://intranet.example/");
+    const RouteExplain::Stage* host = findStage(report, "host_rule");
+    ASSERT_NE(host, nullptr);
+    EXPECT_EQ(host->result, "intranet.example -> firefox/work");
+    EXPECT_TRUE(host->details.value("available").toBool());
+    EXPECT_EQ(findStage(report, "prediction")->details.value("reason").toString(), "host");
+
+    // JSONにも同じ内容を出力する
+    const QJsonObject json = RouteExplain::toJson(report);
+    EXPECT_EQ(json.value("url").toString(), "https://intranet.example/");
+    EXPECT_EQ(json.value("stages").toArray().size(), report.stages.size());
+    EXPECT_EQ(json.value("stages").toArray().at(4).toObject().value("name").toString(), "host_rule");
+    EXPECT_TRUE(json.value("stages").toArray().at(4).toObject().contains("elapsed_ns"));
+    EXPECT_EQ(json.value("target").toObject().value("profile").toString(), "work");
+
+    const QString text = RouteExplain::toText(report);
+    EXPECT_TRUE(text.contains("host_rule"));
+    EXPECT_TRUE(text.contains("Target: firefox/work"));
+}
+
+TEST_F(RouteExplainTest, HostHistoryDecidesTheTarget)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    // 最後に使用したプロファイル（work）より、前回このホストを開いたプロファイルを優先する
+    writeRc("[LastUsed]\nBrowser=firefox\nProfile=work\n\n"
+            "[HostHistory]\nintranet.example=firefox/personal\n");
+    const RouteExplain::Report report = RouteExplain::explain("https://intranet.example/");
+    EXPECT_EQ(report.browser, "firefox");
+    EXPECT_EQ(report.profileId, "personal");
+    EXPECT_EQ(findStage(report, "default")->details.value("reason").toString(), "host history");
+
+    // 履歴のないホストはデフォルトプロファイル
+    const RouteExplain::Report other = RouteExplain::explain("https://other.example/");
+    EXPECT_EQ(other.profileId, "work");
+    EXPECT_EQ(findStage(other, "default")->details.value("reason").toString(), "last used");
+}
+
+TEST_F(RouteExplainTest, StopsAtValidation)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    const RouteExplain::Report report = RouteExplain::explain("https://example.com/$(reboot)");
+    EXPECT_EQ(stageNames(report).last(), "validate");
+    EXPECT_EQ(report.stages.last().result, "rejected");
+    EXPECT_TRUE(report.browser.isEmpty());
+    EXPECT_TRUE(RouteExplain::toJson(report).value("target").isNull());
+}
+
+TEST(RouteExplainFormatTest, CompletesSchemeAndFormatsDurations)
+{
+    EXPECT_EQ(BrowserDetector::completeUrlScheme("example.com"), "https://www.example.com");
+    EXPECT_EQ(BrowserDetector::completeUrlScheme("www.example.com"), "https://www.example.com");
+    EXPECT_EQ(BrowserDetector::completeUrlScheme("http://example.com"), "http://example.com");
+    EXPECT_TRUE(BrowserDetector::completeUrlScheme(QString()).isEmpty());
+
+    EXPECT_EQ(RouteExplain::formatDuration(850), "850 ns");
+    EXPECT_EQ(RouteExplain::formatDuration(12340), QString::fromUtf8("12.3 µs"));
+    EXPECT_EQ(RouteExplain::formatDuration(4560000), "4.56 ms");
+}
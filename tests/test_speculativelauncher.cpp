@@ -0,0 +1,297 @@
+/**
+ * @file test_speculativelauncher.cpp
+ * @brief 先行起動の予測・結果の記録・先行起動したプロセスの扱いのテスト
+ *
+ * Chromiumのスタブは先行起動で起動したまま待機するため（sleep）、
+ * on_cancel: close で終了されたかどうかを /proc で確認できます。
+ */
+
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QThread>
+
+#include <signal.h>
+
+#include "../src/speculativelauncher.h"
+#include "../src/profilemanager.h"
+#include "../src/configmanager.h"
+#include "fakehome.h"
+
+namespace {
+
+/**
+ * @brief プロセスが終了していない（ゾンビでもない）かどうか
+ */
+bool isAlive(qint64 pid)
+{
+    QFile stat(QString("/proc/%1/stat").arg(pid));
+    if (!stat.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    // "pid (comm) state ..." の state を確認する
+    const QByteArray line = stat.readAll();
+    const int close = line.lastIndexOf(')');
+    return close > 0 && line.size() > close + 2 && line.at(close + 2) != 'Z';
+}
+
+/**
+ * @brief プロセスの終了を最大2秒待つ
+ */
+bool waitForExit(qint64 pid)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (isAlive(pid)) {
+        if (timer.hasExpired(2000)) {
+            return false;
+        }
+        QThread::msleep(10);
+    }
+    return true;
+}
+
+} // namespace
+
+/**
+ * @brief Firefox（work, personal）とChromium（Default, Profile 1）を持つ偽のホームを用意するフィクスチャ
+ */
+class SpeculativeLauncherTest : public FakeHomeTest {
+protected:
+    void SetUp() override {
+        FakeHomeTest::SetUp();
+        addFirefoxProfiles();
+
+        const QString chromium = m_home + "/.config/chromium";
+        writeFile(chromium + "/Local State",
+                  R"({"profile": {"info_cache": {"Default": {"name": "Personal"}, "Profile 1": {"name": "Work"}}}})");
+        writeFile(chromium + "/Default/Preferences", "{}");
+        writeFile(chromium + "/Profile 1/Preferences", "{}");
+
+        // 先行起動したインスタンスの代わりに待機し続けるスタブ
+        m_chromiumStub = m_home + "/bin/chromium-stub";
+        writeFile(m_chromiumStub, "#!/bin/sh\nexec sleep 30\n");
+        QFile::setPermissions(m_chromiumStub, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+    }
+
+    void TearDown() override {
+        for (qint64 pid : m_pids) {
+            ::kill(static_cast<pid_t>(pid), SIGKILL);
+        }
+        FakeHomeTest::TearDown();
+    }
+
+    /**
+     * @brief 先行起動を有効にしたYAMLを書き込む
+     * @param onCancel キャンセル時の扱い（"keep" / "close"）
+     */
+    void enableSpeculative(const QString& onCancel) const {
+        writeFile(m_home + "/.config/kde-browser-picker.yaml",
+                  QString("browsers:\n"
+                          "  firefox:\n    path: %1\n"
+                          "  chromium:\n    path: %2\n"
+                          "  chrome:\n    enabled: false\n"
+                          "speculative:\n  enabled: true\n  on_cancel: %3\n")
+                      .arg(writeStub("firefox-stub"), m_chromiumStub, onCancel).toUtf8());
+    }
+
+    /**
+     * @brief 予測したChromiumを先行起動し、PIDを記録する
+     */
+    qint64 startChromium(SpeculativeLauncher* launcher) {
+        launcher->start("https://chromium.example/");
+        const qint64 pid = launcher->prelaunchedPid();
+        if (pid > 0) {
+            m_pids << pid;
+        }
+        return pid;
+    }
+
+    static QString launchStats(int count) {
+        return QString("%1,%2").arg(count).arg(QDateTime::currentSecsSinceEpoch());
+    }
+
+    QString m_chromiumStub;
+    QList<qint64> m_pids;
+};
+
+TEST_F(SpeculativeLauncherTest, PredictsFromHostHistoryFirst)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    writeRc(QString("[LaunchStats]\nfirefox/work=%1\n\n"
+                    "[HostHistory]\nintranet.example=firefox/personal\n").arg(launchStats(9)).toUtf8());
+    ConfigManager config;
+    ProfileManager profiles(&config);
+    profiles.refreshProfiles();
+    SpeculativeLauncher launcher(&profiles, &config);
+
+    // ホストの履歴は frecency より優先する
+    const SpeculativeLauncher::Prediction prediction = launcher.predict("https://intranet.example/wiki");
+    EXPECT_EQ(prediction.browser, "firefox");
+    EXPECT_EQ(prediction.profileId, "personal");
+    EXPECT_EQ(prediction.reason, "host");
+
+    // 履歴のないホストは frecency で予測する
+    const SpeculativeLauncher::Prediction other = launcher.predict("https://other.example/");
+    EXPECT_EQ(other.profileId, "work");
+    EXPECT_EQ(other.reason, "frecency");
+}
+
+TEST_F(SpeculativeLauncherTest, FrecencyNeedsAClearLeader)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    const auto predictWith = [this](const QString& rc, const QString& url) {
+        writeRc(rc.toUtf8());
+        ConfigManager config;
+        ProfileManager profiles(&config);
+        profiles.refreshProfiles();
+        return SpeculativeLauncher(&profiles, &config).predict(url);
+    };
+
+    // 500 対 300: 2位の2倍に届かない
+    EXPECT_FALSE(predictWith(QString("[LaunchStats]\nfirefox/work=%1\nfirefox/personal=%2\n")
+                                 .arg(launchStats(5), launchStats(3)),
+                             "https://other.example/").isValid());
+
+    // 最小スコアに届かない
+    EXPECT_FALSE(predictWith(QString("[LaunchStats]\nfirefox/work=%1\n").arg(launchStats(2)),
+                             "https://other.example/").isValid());
+
+    // 履歴のプロファイルが存在しなければ frecency に進む
+    const SpeculativeLauncher::Prediction prediction =
+        predictWith(QString("[LaunchStats]\nfirefox/work=%1\n\n"
+                            "[HostHistory]\nintranet.example=firefox/removed\n").arg(launchStats(4)),
+                    "https://intranet.example/");
+    EXPECT_EQ(prediction.profileId, "work");
+    EXPECT_EQ(prediction.reason, "frecency");
+}
+
+TEST_F(SpeculativeLauncherTest, RecordsHitsMissesAndCancels)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    enableSpeculative("keep");
+    writeRc("[HostHistory]\nintranet.example=firefox/work\n");
+    ConfigManager config;
+    ProfileManager profiles(&config);
+    profiles.refreshProfiles();
+    SpeculativeLauncher launcher(&profiles, &config);
+
+    launcher.start("https://intranet.example/");
+    ASSERT_TRUE(launcher.currentPrediction().isValid());
+    launcher.confirm("firefox", "work");
+    launcher.launchFinished(true);
+    // 1つの予測につき結果は1回だけ記録する
+    launcher.cancel();
+
+    launcher.reset();
+    launcher.start("https://intranet.example/");
+    launcher.confirm("firefox", "personal");
+    launcher.launchFinished(true);
+
+    launcher.reset();
+    launcher.start("https://intranet.example/");
+    launcher.cancel();
+
+    // 予測がなければ何も記録しない
+    launcher.reset();
+    launcher.start("https://unknown.example/");
+    EXPECT_FALSE(launcher.currentPrediction().isValid());
+    launcher.confirm("firefox", "work");
+
+    const QMap<QString, int> stats = config.speculativeStats();
+    EXPECT_EQ(stats.value("Hits"), 1);
+    EXPECT_EQ(stats.value("Misses"), 1);
+    EXPECT_EQ(stats.value("Cancels"), 1);
+}
+
+TEST_F(SpeculativeLauncherTest, KeepsTheWarmedInstanceForAnotherProfileOfTheSameBrowser)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    enableSpeculative("close");
+    writeRc("[HostHistory]\nchromium.example=chromium/Default\n");
+    ConfigManager config;
+    ProfileManager profiles(&config);
+    profiles.refreshProfiles();
+    SpeculativeLauncher launcher(&profiles, &config);
+
+    const qint64 pid = startChromium(&launcher);
+    ASSERT_GT(pid, 0);
+    ASSERT_TRUE(isAlive(pid));
+
+    // 予測は外れたが、同じChromiumのインスタンスがURLを受け取る
+    launcher.confirm("chromium", "Profile 1");
+    EXPECT_TRUE(isAlive(pid));
+    launcher.launchFinished(true);
+    EXPECT_EQ(launcher.prelaunchedPid(), 0);
+
+    // 起動に使われたプロセスは、ピッカーを閉じても終了させない
+    launcher.cancel();
+    QThread::msleep(100);
+    EXPECT_TRUE(isAlive(pid));
+    EXPECT_EQ(config.speculativeStats().value("Misses"), 1);
+}
+
+TEST_F(SpeculativeLauncherTest, ClosesTheWarmedInstanceWhenItIsNotUsed)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    enableSpeculative("close");
+    writeRc("[HostHistory]\nchromium.example=chromium/Default\n");
+    ConfigManager config;
+    ProfileManager profiles(&config);
+    profiles.refreshProfiles();
+    SpeculativeLauncher launcher(&profiles, &config);
+
+    // 別のブラウザが選ばれた: 起動の前に終了する
+    qint64 pid = startChromium(&launcher);
+    ASSERT_GT(pid, 0);
+    launcher.confirm("firefox", "work");
+    EXPECT_TRUE(waitForExit(pid));
+
+    // 同じブラウザでも起動に失敗した場合は終了する
+    launcher.reset();
+    pid = startChromium(&launcher);
+    ASSERT_GT(pid, 0);
+    launcher.confirm("chromium", "Default");
+    EXPECT_TRUE(isAlive(pid));
+    launcher.launchFinished(false);
+    EXPECT_TRUE(waitForExit(pid));
+
+    // キャンセル
+    launcher.reset();
+    pid = startChromium(&launcher);
+    ASSERT_GT(pid, 0);
+    launcher.cancel();
+    EXPECT_TRUE(waitForExit(pid));
+}
+
+TEST_F(SpeculativeLauncherTest, KeepPolicyNeverClosesTheWarmedInstance)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    enableSpeculative("keep");
+    writeRc("[HostHistory]\nchromium.example=chromium/Default\n");
+    ConfigManager config;
+    ProfileManager profiles(&config);
+    profiles.refreshProfiles();
+    SpeculativeLauncher launcher(&profiles, &config);
+
+    const qint64 pid = startChromium(&launcher);
+    ASSERT_GT(pid, 0);
+    launcher.confirm("firefox", "work");
+    launcher.launchFinished(true);
+    QThread::msleep(100);
+    EXPECT_TRUE(isAlive(pid));
+}
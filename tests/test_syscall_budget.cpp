@@ -0,0 +1,345 @@
+/**
+ * @file test_syscall_budget.cpp
+ * @brief リンクを開く経路のシステムコール数の回帰テスト
+ *
+ * アプリケーション本体を strace -f の下で偽のHOMEに対して実行し、
+ * stat/openat/read/write の系統ごとの回数が予算内であることを確認します。
+ * プロファイル数は 1, 20, 200 とし、予算は「基本 + プロファイルあたり」で定めます。
+ *
+ * - ピッカー: オフスクリーンで表示し、タイムアウト（1秒）で既定のプロファイルを起動
+ * - コマンドライン: --browser/--profile（一覧を作らないため、プロファイル数に依存しない）
+ *
+ * 予算を超えた場合は、系統ごとに回数の多いシステムコールとパスを表示します。
+ * KBP_SYSCALL_BUDGET_SCALE で全予算を倍率指定できます（ディストリビューション差の吸収用）。
+ */
+
+#include <gtest/gtest.h>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QSet>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+/// 系統とそれに含まれるシステムコール
+struct Category {
+    const char* name;
+    QSet<QString> syscalls;
+};
+
+const QList<Category>& categories()
+{
+    static const QList<Category> list = {
+        {"stat", {"stat", "lstat", "fstat", "newfstatat", "fstatat64", "statx", "statfs", "fstatfs",
+                  "access", "faccessat", "faccessat2", "readlink", "readlinkat"}},
+        {"openat", {"open", "openat", "openat2", "creat"}},
+        {"read", {"read", "pread64", "readv", "preadv", "preadv2", "getdents64"}},
+        {"write", {"write", "pwrite64", "writev", "pwritev", "pwritev2"}},
+    };
+    return list;
+}
+
+/// 予算（基本 + プロファイルあたり）
+struct Budget {
+    int base;
+    int perProfile;
+
+    int limit(int profiles) const
+    {
+        static const double scale = qEnvironmentVariableIsSet("KBP_SYSCALL_BUDGET_SCALE")
+            ? qEnvironmentVariable("KBP_SYSCALL_BUDGET_SCALE").toDouble() : 1.0;
+        return static_cast<int>((base + perProfile * profiles) * scale);
+    }
+};
+
+// Qt/KFの初期化（プラグイン・フォント・設定のカスケード）を含む。検出はプロファイルあたりの項目
+const QHash<QString, Budget> PICKER_BUDGETS = {
+    {"stat", {3000, 25}},
+    {"openat", {1500, 12}},
+    {"read", {3000, 15}},
+    {"write", {300, 2}},
+};
+
+// 1つのプロファイルだけを確認する（プロファイル数に依存しない）
+const QHash<QString, Budget> HEADLESS_BUDGETS = {
+    {"stat", {1500, 0}},
+    {"openat", {800, 0}},
+    {"read", {1500, 0}},
+    {"write", {100, 0}},
+};
+
+/// strace の出力を集計した結果
+struct SyscallReport {
+    QHash<QString, int> perCategory;                    ///< 系統ごとの回数
+    QHash<QString, QHash<QString, int>> perSyscall;     ///< 系統 → システムコール → 回数
+    QHash<QString, QHash<QString, int>> perPath;        ///< 系統 → パス → 回数
+};
+
+/**
+ * @brief strace -f -y の出力を集計
+ * @param log 出力ファイル
+ * @param excludedExec このパスを exec したプロセスは以降を数えない（スタブのブラウザ）
+ * @param home パスの表示で $HOME に置き換えるディレクトリ
+ */
+SyscallReport parseStraceLog(const QString& log, const QString& excludedExec, const QString& home)
+{
+    static const QRegularExpression callLine(R"(^(\d+)\s+(\w+)\((.*)$)");
+    static const QRegularExpression quoted(R"("((?:[^"\\]|\\.)*)")");
+    static const QRegularExpression fdPath(R"(\d+<([^>]*)>)");
+
+    QHash<QString, QString> categoryOf;
+    for (const Category& category : categories()) {
+        for (const QString& syscall : category.syscalls) {
+            categoryOf.insert(syscall, category.name);
+        }
+    }
+
+    SyscallReport report;
+    const QString excludedPath = QString(excludedExec).replace(home, "$HOME");
+    QSet<QString> excludedPids;
+    QFile file(log);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return report;
+    }
+    QTextStream stream(&file);
+    QString line;
+    while (stream.readLineInto(&line)) {
+        // "<... xxx resumed>" は開始行で数え済み。シグナル・終了通知は対象外
+        const auto match = callLine.match(line);
+        if (!match.hasMatch()) {
+            continue;
+        }
+        const QString pid = match.captured(1);
+        const QString syscall = match.captured(2);
+        const QString args = match.captured(3);
+        if (excludedPids.contains(pid)) {
+            continue;
+        }
+
+        // 引数のパス（なければファイルディスクリプタのパス）
+        QString path;
+        for (auto it = quoted.globalMatch(args); it.hasNext();) {
+            const QString candidate = it.next().captured(1);
+            if (!candidate.isEmpty()) {
+                path = candidate;
+                break;
+            }
+        }
+        if (path.isEmpty()) {
+            path = fdPath.match(args).captured(1);
+        }
+        path.replace(home, "$HOME");
+
+        if (syscall == "execve" && path == excludedPath) {
+            excludedPids.insert(pid);
+            continue;
+        }
+
+        const QString category = categoryOf.value(syscall);
+        if (category.isEmpty()) {
+            continue;
+        }
+        ++report.perCategory[category];
+        ++report.perSyscall[category][syscall];
+        ++report.perPath[category][path.isEmpty() ? QString("(none)") : path];
+    }
+    return report;
+}
+
+/// 回数の多い順に上位を整形
+QString topEntries(const QHash<QString, int>& counts, int limit)
+{
+    QList<QPair<int, QString>> entries;
+    for (auto it = counts.begin(); it != counts.end(); ++it) {
+        entries.append({it.value(), it.key()});
+    }
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+
+    QString text;
+    for (int i = 0; i < entries.size() && i < limit; ++i) {
+        text += QString("    %1  %2\n").arg(entries[i].first, 6).arg(entries[i].second);
+    }
+    return text;
+}
+
+/**
+ * @brief 予算を確認し、超えた系統の内訳を失敗メッセージにする
+ */
+void expectWithinBudgets(const SyscallReport& report, const QHash<QString, Budget>& budgets,
+                         int profiles, const QString& scenario)
+{
+    for (const Category& category : categories()) {
+        const int count = report.perCategory.value(category.name);
+        const int limit = budgets.value(category.name).limit(profiles);
+        std::printf("%-9s %3d profiles  %-6s %6d / %6d\n",
+                    qPrintable(scenario), profiles, category.name, count, limit);
+        EXPECT_LE(count, limit)
+            << qPrintable(scenario) << " with " << profiles << " profiles exceeded the "
+            << category.name << " budget\n  top syscalls:\n"
+            << qPrintable(topEntries(report.perSyscall.value(category.name), 5))
+            << "  top paths:\n"
+            << qPrintable(topEntries(report.perPath.value(category.name), 15));
+    }
+}
+
+} // namespace
+
+/**
+ * @brief プロファイル数を指定した偽のHOMEとスタブのブラウザを用意するフィクスチャ
+ */
+class SyscallBudgetTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        m_binary = qEnvironmentVariable("KBP_APP_BINARY");
+        m_strace = QStandardPaths::findExecutable("strace");
+        if (m_binary.isEmpty() || m_strace.isEmpty()) {
+            GTEST_SKIP() << "KBP_APP_BINARY or strace is not available";
+        }
+        // コンテナなど ptrace が禁止されている環境
+        if (QProcess::execute(m_strace, {"-o", "/dev/null", "/bin/true"}) != 0) {
+            GTEST_SKIP() << "strace cannot trace processes here";
+        }
+    }
+
+    /// プロファイル数 profiles の偽のHOMEを作成（Firefox と Chromium で半分ずつ）
+    bool createHome(QTemporaryDir& home, int profiles) {
+        if (!home.isValid()) {
+            return false;
+        }
+        const QString root = home.path();
+        const int firefoxProfiles = (profiles + 1) / 2;
+        const int chromiumProfiles = profiles / 2;
+
+        m_stub = root + "/browser-stub";
+        QFile stub(m_stub);
+        if (!stub.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+        stub.write("#!/bin/sh\nexit 0\n");
+        stub.close();
+        stub.setPermissions(QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+
+        const QString mozilla = root + "/.mozilla/firefox";
+        QString ini;
+        for (int i = 0; i < firefoxProfiles; ++i) {
+            const QString dir = QString("p%1.profile-%1").arg(i, 3, 10, QChar('0'));
+            QDir().mkpath(mozilla + "/" + dir);
+            ini += QString("[Profile%1]\nName=profile-%2\nIsRelative=1\nPath=%3\n%4\n")
+                       .arg(i).arg(i, 3, 10, QChar('0')).arg(dir).arg(i == 0 ? "Default=1\n" : "");
+        }
+        QFile iniFile(mozilla + "/profiles.ini");
+        if (!iniFile.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+        iniFile.write(ini.toUtf8());
+        iniFile.close();
+
+        if (chromiumProfiles > 0) {
+            const QString chromium = root + "/.config/chromium";
+            QStringList entries;
+            for (int i = 0; i < chromiumProfiles; ++i) {
+                const QString dir = i == 0 ? QString("Default") : QString("Profile %1").arg(i);
+                QDir().mkpath(chromium + "/" + dir);
+                entries << QString(R"("%1": {"name": "Person %2"})").arg(dir).arg(i + 1);
+            }
+            QFile localState(chromium + "/Local State");
+            if (!localState.open(QIODevice::WriteOnly)) {
+                return false;
+            }
+            localState.write(QString(R"({"profile": {"info_cache": {%1}}})").arg(entries.join(", ")).toUtf8());
+            localState.close();
+        }
+
+        // 1秒のタイムアウトで既定のプロファイルを起動して終了する
+        QDir().mkpath(root + "/.config");
+        QFile rc(root + "/.config/kde-browser-pickerrc");
+        if (!rc.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+        rc.write("[General]\nDefaultTimeout=1\nRememberLastUsed=true\nShowTrayIcon=false\n");
+        rc.close();
+
+        QFile yaml(root + "/.config/kde-browser-picker.yaml");
+        if (!yaml.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+        yaml.write(QString("browsers:\n  firefox:\n    path: %1\n  chrome:\n    enabled: false\n"
+                           "  chromium:\n    path: %1\n").arg(m_stub).toUtf8());
+        yaml.close();
+        return true;
+    }
+
+    /// strace の下で実行して集計
+    SyscallReport trace(const QTemporaryDir& home, const QStringList& arguments) {
+        const QString root = home.path();
+        const QString log = root + "/strace.log";
+
+        QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+        env.insert("HOME", root);
+        env.insert("XDG_CONFIG_HOME", root + "/.config");
+        env.insert("XDG_CACHE_HOME", root + "/.cache");
+        env.insert("XDG_DATA_HOME", root + "/.local/share");
+        env.insert("XDG_RUNTIME_DIR", root);
+        env.insert("KDE_BROWSER_PICKER_YAML", root + "/.config/kde-browser-picker.yaml");
+        env.insert("QT_QPA_PLATFORM", "offscreen");
+        env.remove("QT_QPA_PLATFORMTHEME");
+        // 実際のセッションの起動中ブラウザにURLを渡さない
+        env.insert("DBUS_SESSION_BUS_ADDRESS", "unix:path=" + root + "/no-session-bus");
+
+        QProcess process;
+        process.setProcessEnvironment(env);
+        process.setProgram(m_strace);
+        process.setArguments(QStringList{"-f", "-qq", "-y", "-s", "8", "-o", log, m_binary} + arguments);
+        process.start();
+        EXPECT_TRUE(process.waitForFinished(60000)) << "picker did not exit";
+
+        return parseStraceLog(log, m_stub, root);
+    }
+
+    QString m_binary;
+    QString m_strace;
+    QString m_stub;
+};
+
+TEST_F(SyscallBudgetTest, PickerOpenLink)
+{
+    for (int profiles : {1, 20, 200}) {
+        QTemporaryDir home;
+        ASSERT_TRUE(createHome(home, profiles));
+        const SyscallReport report = trace(home, {"https://example.com/"});
+        ASSERT_GT(report.perCategory.value("openat"), 0) << "strace log is empty";
+        expectWithinBudgets(report, PICKER_BUDGETS, profiles, "picker");
+    }
+}
+
+TEST_F(SyscallBudgetTest, HeadlessOpenLinkDoesNotScaleWithProfiles)
+{
+    QHash<int, SyscallReport> reports;
+    for (int profiles : {1, 20, 200}) {
+        QTemporaryDir home;
+        ASSERT_TRUE(createHome(home, profiles));
+        reports[profiles] = trace(home, {"--browser", "firefox", "--profile", "profile-000",
+                                         "https://example.com/"});
+        ASSERT_GT(reports[profiles].perCategory.value("openat"), 0) << "strace log is empty";
+        expectWithinBudgets(reports[profiles], HEADLESS_BUDGETS, profiles, "headless");
+    }
+
+    // 一覧を作らないため、プロファイルのディレクトリや設定は数に比例して増えない
+    // （profiles.ini の読み込みだけはファイルサイズに応じて read が増える）
+    for (const Category& category : categories()) {
+        EXPECT_LE(reports[200].perCategory.value(category.name),
+                  reports[1].perCategory.value(category.name) + 20)
+            << category.name << " grows with the number of profiles\n  top paths at 200 profiles:\n"
+            << qPrintable(topEntries(reports[200].perPath.value(category.name), 15));
+    }
+}
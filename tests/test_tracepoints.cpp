@@ -0,0 +1,159 @@
+/**
+ * @file test_tracepoints.cpp
+ * @brief USDT静的トレースポイントのテスト
+ *
+ * ENABLE_USDT でビルドしたコアライブラリと実行ファイルのELFに .note.stapsdt のプローブ情報が
+ * 含まれること、およびトレーサーが接続していない間は引数を評価しないことを確認します。
+ */
+
+#include <gtest/gtest.h>
+#include <QByteArray>
+#include <QFile>
+#include <QSet>
+#include <QString>
+
+#include <cstring>
+#include <elf.h>
+
+#include "../src/tracepoints.h"
+
+namespace {
+
+/// stapsdt ノートの種類（<sys/sdt.h> の NT_STAPSDT）
+constexpr Elf64_Word NOTE_TYPE_STAPSDT = 3;
+
+struct ProbeNote {
+    QString provider;
+    QString name;
+    QString arguments;      ///< 引数の格納場所（"-8@%rax" など）
+    quint64 semaphore;      ///< セマフォのアドレス（0: なし）
+};
+
+size_t align4(size_t size)
+{
+    return (size + 3) & ~size_t(3);
+}
+
+/**
+ * @brief ELFファイルの .note.stapsdt セクションからプローブを読み込む
+ */
+QList<ProbeNote> readProbeNotes(const QString& path)
+{
+    QList<ProbeNote> probes;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return probes;
+    }
+    const QByteArray data = file.readAll();
+    const char* base = data.constData();
+    const auto size = static_cast<size_t>(data.size());
+
+    if (size < sizeof(Elf64_Ehdr) || std::memcmp(base, ELFMAG, SELFMAG) != 0 || base[EI_CLASS] != ELFCLASS64) {
+        return probes;
+    }
+    const auto* header = reinterpret_cast<const Elf64_Ehdr*>(base);
+    if (header->e_shoff + size_t(header->e_shnum) * sizeof(Elf64_Shdr) > size) {
+        return probes;
+    }
+    const auto* sections = reinterpret_cast<const Elf64_Shdr*>(base + header->e_shoff);
+    const Elf64_Shdr& names = sections[header->e_shstrndx];
+
+    for (int i = 0; i < header->e_shnum; ++i) {
+        if (std::strcmp(base + names.sh_offset + sections[i].sh_name, ".note.stapsdt") != 0) {
+            continue;
+        }
+        size_t offset = sections[i].sh_offset;
+        const size_t end = offset + sections[i].sh_size;
+        while (offset + sizeof(Elf64_Nhdr) <= end) {
+            const auto* note = reinterpret_cast<const Elf64_Nhdr*>(base + offset);
+            const char* owner = base + offset + sizeof(Elf64_Nhdr);
+            const char* desc = owner + align4(note->n_namesz);
+            if (note->n_type == NOTE_TYPE_STAPSDT && std::strcmp(owner, "stapsdt") == 0) {
+                // pc, リンク時のベースアドレス, セマフォ の後に provider, name, args が続く
+                ProbeNote probe;
+                std::memcpy(&probe.semaphore, desc + 16, sizeof(probe.semaphore));
+                const char* text = desc + 24;
+                probe.provider = QString::fromLatin1(text);
+                text += std::strlen(text) + 1;
+                probe.name = QString::fromLatin1(text);
+                text += std::strlen(text) + 1;
+                probe.arguments = QString::fromLatin1(text);
+                probes.append(probe);
+            }
+            offset += sizeof(Elf64_Nhdr) + align4(note->n_namesz) + align4(note->n_descsz);
+        }
+    }
+    return probes;
+}
+
+QSet<QString> probeNames(const QList<ProbeNote>& probes)
+{
+    QSet<QString> names;
+    for (const ProbeNote& probe : probes) {
+        if (probe.provider == "kde_browser_picker") {
+            names.insert(probe.name);
+        }
+    }
+    return names;
+}
+
+} // namespace
+
+TEST(Tracepoints, ProbeNotesExistInElf)
+{
+    // 検出・設定・起動のプローブはコアライブラリに含まれる
+    const QString library = qEnvironmentVariable("KBP_CORE_LIBRARY");
+    if (library.isEmpty()) {
+        GTEST_SKIP() << "KBP_CORE_LIBRARY is not set";
+    }
+
+    const QList<ProbeNote> probes = readProbeNotes(library);
+    const QSet<QString> names = probeNames(probes);
+    for (const char* expected : {"detection_start", "detection_end", "profile_parsed", "launch",
+                                 "config_load", "config_sync"}) {
+        EXPECT_TRUE(names.contains(expected)) << expected;
+    }
+
+    for (const ProbeNote& probe : probes) {
+        if (probe.provider != "kde_browser_picker") {
+            continue;
+        }
+        // 引数の評価はセマフォで制御する
+        EXPECT_NE(probe.semaphore, 0u) << qPrintable(probe.name);
+        if (probe.name == "detection_end") {
+            EXPECT_EQ(probe.arguments.split(' ').size(), 3) << qPrintable(probe.arguments);
+        }
+        if (probe.name == "launch") {
+            EXPECT_EQ(probe.arguments.split(' ').size(), 6) << qPrintable(probe.arguments);
+        }
+    }
+}
+
+TEST(Tracepoints, ApplicationBinaryHasAllProbes)
+{
+    const QString binary = qEnvironmentVariable("KBP_APP_BINARY");
+    if (binary.isEmpty()) {
+        GTEST_SKIP() << "KBP_APP_BINARY is not set";
+    }
+
+    const QSet<QString> names = probeNames(readProbeNotes(binary) +
+                                           readProbeNotes(qEnvironmentVariable("KBP_CORE_LIBRARY")));
+    for (const char* expected : {"detection_start", "detection_end", "profile_parsed", "config_load",
+                                 "config_sync", "search_filter", "profile_selected", "launch"}) {
+        EXPECT_TRUE(names.contains(expected)) << expected;
+    }
+}
+
+TEST(Tracepoints, ArgumentsAreNotEvaluatedWithoutTracer)
+{
+    // このテストはトレーサーを接続せずに実行する
+    ASSERT_EQ(static_cast<int>(KBP_TRACE_SEMAPHORE(detection_start)), 0);
+
+    int evaluated = 0;
+    auto argument = [&evaluated]() {
+        ++evaluated;
+        return "firefox";
+    };
+    KBP_TRACE(detection_start, argument());
+    EXPECT_EQ(evaluated, 0);
+}
@@ -0,0 +1,230 @@
+/**
+ * @file test_yamlconfig.cpp
+ * @brief 階層化したYAML設定とバイナリキャッシュのテスト
+ *
+ * システム（XDG_CONFIG_DIRS）・ユーザー（HOME）・環境変数の各層を一時ディレクトリに作り、
+ * 結合の順序、エラー位置、キャッシュの再利用と作り直しを検証します。
+ */
+
+#include <gtest/gtest.h>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include <utime.h>
+
+#include "../src/yamlconfig.h"
+
+/**
+ * @brief 各層の設定ファイルを置く一時ディレクトリを用意するフィクスチャ
+ */
+class YamlConfigTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(m_root.isValid());
+        m_oldHome = qgetenv("HOME");
+        m_oldConfigDirs = qgetenv("XDG_CONFIG_DIRS");
+        m_vendorDir = m_root.path() + "/vendor";
+        m_systemDir = m_root.path() + "/etc/xdg";
+        m_home = m_root.path() + "/home";
+        ASSERT_TRUE(QDir().mkpath(m_vendorDir));
+        ASSERT_TRUE(QDir().mkpath(m_systemDir));
+        ASSERT_TRUE(QDir().mkpath(m_home + "/.config"));
+        qputenv("HOME", m_home.toUtf8());
+        // 先頭のディレクトリが優先される
+        qputenv("XDG_CONFIG_DIRS", (m_systemDir + ":" + m_vendorDir).toUtf8());
+        qunsetenv(Constants::YAML_ENV_PATH);
+        m_cache = m_root.path() + "/cache/config.bin";
+    }
+
+    void TearDown() override {
+        qputenv("HOME", m_oldHome);
+        if (m_oldConfigDirs.isEmpty()) {
+            qunsetenv("XDG_CONFIG_DIRS");
+        } else {
+            qputenv("XDG_CONFIG_DIRS", m_oldConfigDirs);
+        }
+        qunsetenv(Constants::YAML_ENV_PATH);
+    }
+
+    static void writeFile(const QString& path, const QByteArray& contents) {
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write(contents);
+    }
+
+    QString systemYaml() const { return m_systemDir + "/kde-browser-picker.yaml"; }
+    QString vendorYaml() const { return m_vendorDir + "/kde-browser-picker.yaml"; }
+    QString userYaml() const { return m_home + "/.config/kde-browser-picker.yaml"; }
+
+    QTemporaryDir m_root;
+    QByteArray m_oldHome;
+    QByteArray m_oldConfigDirs;
+    QString m_vendorDir;
+    QString m_systemDir;
+    QString m_home;
+    QString m_cache;
+};
+
+TEST_F(YamlConfigTest, LaterLayersOverrideEarlierOnes)
+{
+    writeFile(vendorYaml(), "speculative:\n  enabled: true\n  on_cancel: close\n");
+    writeFile(systemYaml(),
+              "memory_pressure:\n"
+              "  threshold: 30\n"
+              "  metric: full\n"
+              "browsers:\n"
+              "  chrome:\n"
+              "    enabled: false\n"
+              "launch:\n"
+              "  chrome:\n"
+              "    args: [--admin-flag]\n"
+              "  firefox:\n"
+              "    args: [--system-only]\n");
+    writeFile(userYaml(),
+              "memory_pressure:\n"
+              "  threshold: 15   # percent\n"
+              "launch:\n"
+              "  chrome:\n"
+              "    args: [--user-flag]\n");
+    const QString envYaml = m_root.path() + "/env.yaml";
+    writeFile(envYaml, "browsers:\n  chrome:\n    enabled: true\n");
+    qputenv(Constants::YAML_ENV_PATH, envYaml.toUtf8());
+
+    const YamlConfig config = YamlConfig::load(QString());
+    EXPECT_EQ(config.layers, QStringList({vendorYaml(), systemYaml(), userYaml(), envYaml}));
+    EXPECT_TRUE(config.diagnostics.isEmpty());
+
+    // スカラー値は後の層が優先され、指定のない項目は前の層の値が残る
+    EXPECT_DOUBLE_EQ(config.memoryPressurePolicy.threshold, 15.0);
+    EXPECT_EQ(config.memoryPressurePolicy.metric, MemoryPressure::Metric::Full);
+    EXPECT_TRUE(config.speculativeEnabled);
+    EXPECT_EQ(config.speculativeCancelPolicy, Constants::SpeculativeCancelPolicy::Close);
+    EXPECT_TRUE(config.enabledOverrides.value("chrome", false));
+
+    // launch のターゲットは丸ごと置き換わる
+    EXPECT_EQ(config.launchTemplates.value("chrome").args, QStringList({"--user-flag"}));
+    EXPECT_EQ(config.launchTemplates.value("firefox").args, QStringList({"--system-only"}));
+}
+
+TEST_F(YamlConfigTest, ReportsErrorLocations)
+{
+    writeFile(userYaml(),
+              "browsers:\n"
+              "  opera: /usr/bin/opera\n"
+              "  firefox:\n"
+              "    enabled: maybe\n"
+              "memory_pressure:\n"
+              "  threshold: 150\n"
+              "  colour: red\n"
+              "theme: dark\n"
+              "launch:\n"
+              "  chrome:\n"
+              "    args:\n"
+              "      - positional\n");
+
+    const YamlConfig config = YamlConfig::load(QString());
+    ASSERT_EQ(config.diagnostics.size(), 6);
+
+    auto at = [&](int i) {
+        const YamlConfig::Diagnostic& d = config.diagnostics[i];
+        return QString("%1:%2").arg(d.line).arg(d.column);
+    };
+    EXPECT_EQ(at(0), "2:3");    // unknown browser
+    EXPECT_EQ(at(1), "4:14");   // enabled の値
+    EXPECT_EQ(at(2), "6:14");   // threshold の値
+    EXPECT_EQ(at(3), "7:3");    // unknown key
+    EXPECT_EQ(at(4), "8:1");    // unknown section
+    EXPECT_EQ(at(5), "12:9");   // 位置引数
+    EXPECT_EQ(config.diagnostics[0].file, userYaml());
+    EXPECT_TRUE(config.diagnostics[4].toString().startsWith(userYaml() + ":8:1: "));
+
+    // エラーの項目は既定値のまま
+    EXPECT_FALSE(config.executableOverrides.contains("opera"));
+    EXPECT_FALSE(config.enabledOverrides.contains("firefox"));
+    EXPECT_DOUBLE_EQ(config.memoryPressurePolicy.threshold, MemoryPressure::Policy().threshold);
+    EXPECT_TRUE(config.launchTemplates.value("chrome").args.isEmpty());
+}
+
+TEST_F(YamlConfigTest, ReusesCacheUntilALayerChanges)
+{
+    writeFile(userYaml(), "speculative:\n  enabled: yes\n");
+
+    bool fromCache = true;
+    YamlConfig config = YamlConfig::load(m_cache, &fromCache);
+    EXPECT_FALSE(fromCache);
+    EXPECT_TRUE(config.speculativeEnabled);
+    ASSERT_TRUE(QFile::exists(m_cache));
+
+    config = YamlConfig::load(m_cache, &fromCache);
+    EXPECT_TRUE(fromCache);
+    EXPECT_TRUE(config.speculativeEnabled);
+    EXPECT_EQ(config.layers, QStringList({userYaml()}));
+
+    // 内容を変えずに mtime だけ更新した場合はキャッシュを使い続ける
+    struct utimbuf times = {1000000000, 1000000000};
+    ASSERT_EQ(::utime(QFile::encodeName(userYaml()).constData(), &times), 0);
+    config = YamlConfig::load(m_cache, &fromCache);
+    EXPECT_TRUE(fromCache);
+    config = YamlConfig::load(m_cache, &fromCache);
+    EXPECT_TRUE(fromCache);
+
+    // 同じサイズで内容が変わった場合は作り直す
+    writeFile(userYaml(), "speculative:\n  enabled: off\n");
+    config = YamlConfig::load(m_cache, &fromCache);
+    EXPECT_FALSE(fromCache);
+    EXPECT_FALSE(config.speculativeEnabled);
+}
+
+TEST_F(YamlConfigTest, NewSystemLayerInvalidatesCache)
+{
+    writeFile(userYaml(), "memory_pressure:\n  metric: full\n");
+
+    bool fromCache = false;
+    YamlConfig::load(m_cache, &fromCache);
+    YamlConfig::load(m_cache, &fromCache);
+    ASSERT_TRUE(fromCache);
+
+    writeFile(systemYaml(), "speculative:\n  on_cancel: close\n");
+    const YamlConfig config = YamlConfig::load(m_cache, &fromCache);
+    EXPECT_FALSE(fromCache);
+    EXPECT_EQ(config.speculativeCancelPolicy, Constants::SpeculativeCancelPolicy::Close);
+    EXPECT_EQ(config.memoryPressurePolicy.metric, MemoryPressure::Metric::Full);
+
+    // 層の削除でも作り直す
+    ASSERT_TRUE(QFile::remove(systemYaml()));
+    const YamlConfig removed = YamlConfig::load(m_cache, &fromCache);
+    EXPECT_FALSE(fromCache);
+    EXPECT_EQ(removed.speculativeCancelPolicy, Constants::SpeculativeCancelPolicy::Keep);
+}
+
+TEST_F(YamlConfigTest, CorruptCacheIsRebuilt)
+{
+    writeFile(userYaml(), "browsers:\n  firefox: /opt/firefox/firefox\n");
+    ASSERT_TRUE(QDir().mkpath(QFileInfo(m_cache).absolutePath()));
+    writeFile(m_cache, "KBPY garbage");
+
+    bool fromCache = true;
+    const YamlConfig config = YamlConfig::load(m_cache, &fromCache);
+    EXPECT_FALSE(fromCache);
+    // 実行パスは存在確認をせずに保持する（確認は読み込み側）
+    EXPECT_EQ(config.executableOverrides.value("firefox"), "/opt/firefox/firefox");
+
+    const YamlConfig cached = YamlConfig::load(m_cache, &fromCache);
+    EXPECT_TRUE(fromCache);
+    EXPECT_EQ(cached.executableOverrides, config.executableOverrides);
+}
+
+TEST_F(YamlConfigTest, DiagnosticsSurviveTheCache)
+{
+    writeFile(userYaml(), "speculative:\n  on_cancel: later\n");
+
+    bool fromCache = false;
+    YamlConfig::load(m_cache, &fromCache);
+    const YamlConfig cached = YamlConfig::load(m_cache, &fromCache);
+    ASSERT_TRUE(fromCache);
+    ASSERT_EQ(cached.diagnostics.size(), 1);
+    EXPECT_EQ(cached.diagnostics[0].line, 2);
+    EXPECT_EQ(cached.diagnostics[0].column, 14);
+}
@@ -0,0 +1,67 @@
+#!/bin/bash
+set -e
+
+# 起動時間の比較（通常のReleaseビルドと最適化ビルド）
+#
+#   tools/pgo/bench-startup.sh [bench-dir]
+#
+# 次の3種類をビルドし、偽のHOMEで各コマンドの所要時間の中央値を比較します。
+#   default: -DCMAKE_BUILD_TYPE=Release
+#   lazy:    KBP_OPTIMIZE_STARTUP + PGO、遅延バインディング（-z lazy）
+#   now:     KBP_OPTIMIZE_STARTUP + PGO、起動時バインディング（-z now）
+#
+# 既にビルド済みのディレクトリを使う場合は KBP_BENCH_SKIP_BUILD=1 を指定します。
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+SOURCE_DIR="$(cd "$SCRIPT_DIR/../.." && pwd)"
+BENCH_DIR="$(realpath -m "${1:-$SOURCE_DIR/build-bench}")"
+RUNS="${KBP_BENCH_RUNS:-30}"
+URL="https://example.com/"
+VARIANTS=(default lazy now)
+
+if [ -z "$KBP_BENCH_SKIP_BUILD" ]; then
+    cmake -S "$SOURCE_DIR" -B "$BENCH_DIR/default" \
+        -DCMAKE_BUILD_TYPE=Release -DENABLE_CLANG_TIDY=OFF -DENABLE_CPPCHECK=OFF -DBUILD_TESTS=OFF
+    cmake --build "$BENCH_DIR/default" -j"$(nproc)"
+    "$SCRIPT_DIR/build-optimized.sh" "$BENCH_DIR/lazy" -DKBP_BIND_NOW=OFF
+    "$SCRIPT_DIR/build-optimized.sh" "$BENCH_DIR/now" -DKBP_BIND_NOW=ON
+fi
+
+source "$SCRIPT_DIR/fakehome.sh"
+FAKE_HOME="$(mktemp -d)"
+trap 'rm -rf "$FAKE_HOME"' EXIT
+kbp_fake_home "$FAKE_HOME"
+
+# コマンドを RUNS 回実行し、所要時間の中央値（マイクロ秒）を出力
+median_us() {
+    local samples=()
+    local start end
+    "$@" > /dev/null 2>&1 || true   # ページキャッシュを温める
+    for _ in $(seq "$RUNS"); do
+        start=$(date +%s%N)
+        "$@" > /dev/null 2>&1 || true
+        end=$(date +%s%N)
+        samples+=($(( (end - start) / 1000 )))
+    done
+    printf '%s\n' "${samples[@]}" | sort -n | awk '{ a[NR] = $1 } END { print a[int((NR + 1) / 2)] }'
+}
+
+declare -A RESULTS
+BENCHMARKS=(version cli)
+for variant in "${VARIANTS[@]}"; do
+    binary="$BENCH_DIR/$variant/kde-browser-picker"
+    # 動的リンクと Qt/KF の初期化のみ
+    RESULTS[$variant,version]=$(median_us "$binary" --version)
+    # 設定の読み込み、1プロファイルの確認、起動
+    RESULTS[$variant,cli]=$(median_us "$binary" --browser firefox --profile work "$URL")
+done
+
+printf '%-10s %-8s %12s %10s\n' variant bench "median(us)" "vs default"
+for bench in "${BENCHMARKS[@]}"; do
+    base=${RESULTS[default,$bench]}
+    for variant in "${VARIANTS[@]}"; do
+        value=${RESULTS[$variant,$bench]}
+        printf '%-10s %-8s %12d %9.1f%%\n' "$variant" "$bench" "$value" \
+            "$(awk -v v="$value" -v b="$base" 'BEGIN { print (v - b) * 100 / b }')"
+    done
+done
@@ -0,0 +1,50 @@
+#!/bin/bash
+set -e
+
+# 起動時間向けの最適化ビルド（LTO + PGO）
+#
+#   tools/pgo/build-optimized.sh [build-dir] [追加のCMake引数...]
+#
+# 1. KBP_PGO=generate でビルドし、tools/pgo/train.sh で学習データを収集
+# 2. 同じビルドディレクトリで KBP_PGO=use として再ビルド
+#
+# GCCの学習データはオブジェクトファイルのパスに対応付けられるため、
+# 両方の段階を同じビルドディレクトリで実行します。
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+SOURCE_DIR="$(cd "$SCRIPT_DIR/../.." && pwd)"
+BUILD_DIR="$(realpath -m "${1:-$SOURCE_DIR/build-optimized}")"
+shift || true
+PGO_DIR="$BUILD_DIR/pgo"
+
+configure() {
+    cmake -S "$SOURCE_DIR" -B "$BUILD_DIR" \
+        -DCMAKE_BUILD_TYPE=Release \
+        -DENABLE_CLANG_TIDY=OFF \
+        -DENABLE_CPPCHECK=OFF \
+        -DBUILD_TESTS=OFF \
+        -DKBP_OPTIMIZE_STARTUP=ON \
+        -DKBP_PGO_DIR="$PGO_DIR" \
+        -DKBP_PGO="$1" \
+        "${@:2}"
+}
+
+echo "== Instrumented build"
+configure generate "$@"
+cmake --build "$BUILD_DIR" -j"$(nproc)"
+
+echo "== Training"
+rm -rf "$PGO_DIR"
+mkdir -p "$PGO_DIR"
+LLVM_PROFILE_FILE="$PGO_DIR/%p-%m.profraw" "$SCRIPT_DIR/train.sh" "$BUILD_DIR/kde-browser-picker"
+
+# Clang: 生の学習データを結合（GCCは .gcda をそのまま使用）
+if compgen -G "$PGO_DIR/*.profraw" > /dev/null; then
+    "${LLVM_PROFDATA:-llvm-profdata}" merge -output="$PGO_DIR/default.profdata" "$PGO_DIR"/*.profraw
+fi
+
+echo "== Optimized build"
+configure use "$@"
+cmake --build "$BUILD_DIR" -j"$(nproc)"
+
+echo "Optimized binary: $BUILD_DIR/kde-browser-picker"
@@ -0,0 +1,69 @@
+#!/bin/bash
+# 学習・ベンチマーク用の偽のHOMEを作成する（source して使用）
+#
+#   source tools/pgo/fakehome.sh
+#   kbp_fake_home /tmp/kbp-home
+#
+# Firefox（work, personal とコンテナ）と Chromium（Default, Profile 1）の
+# プロファイルを作成し、起動してもすぐに終了するスタブのブラウザを設定します。
+# 環境変数（HOME, XDG_*, KDE_BROWSER_PICKER_YAML, QT_QPA_PLATFORM など）も設定します。
+
+kbp_fake_home() {
+    local home="$1"
+    mkdir -p "$home"
+
+    # 起動してもすぐに終了するスタブのブラウザ
+    printf '#!/bin/sh\nexit 0\n' > "$home/browser-stub"
+    chmod +x "$home/browser-stub"
+
+    # Firefox
+    local mozilla="$home/.mozilla/firefox"
+    mkdir -p "$mozilla/abcd.work" "$mozilla/efgh.personal"
+    cat > "$mozilla/profiles.ini" <<INI
+[Profile0]
+Name=work
+IsRelative=1
+Path=abcd.work
+Default=1
+
+[Profile1]
+Name=personal
+IsRelative=1
+Path=efgh.personal
+INI
+    cat > "$mozilla/abcd.work/containers.json" <<'JSON'
+{"version": 4, "identities": [
+  {"userContextId": 1, "public": true, "name": "Shopping", "icon": "cart", "color": "pink"},
+  {"userContextId": 2, "public": true, "name": "Banking", "icon": "dollar", "color": "green"}
+]}
+JSON
+
+    # Chromium
+    local chromium="$home/.config/chromium"
+    mkdir -p "$chromium/Default" "$chromium/Profile 1"
+    cat > "$chromium/Local State" <<'JSON'
+{"profile": {"info_cache": {
+  "Default": {"name": "Person 1", "avatar_icon": "chrome://theme/IDR_PROFILE_AVATAR_0"},
+  "Profile 1": {"name": "Work", "avatar_icon": "chrome://theme/IDR_PROFILE_AVATAR_19"}
+}}}
+JSON
+
+    cat > "$home/.config/kde-browser-picker.yaml" <<YAML
+browsers:
+  firefox:
+    path: $home/browser-stub
+  chrome:
+    enabled: false
+  chromium:
+    path: $home/browser-stub
+YAML
+
+    export HOME="$home"
+    export XDG_CONFIG_HOME="$home/.config"
+    export XDG_CACHE_HOME="$home/.cache"
+    export XDG_DATA_HOME="$home/.local/share"
+    export KDE_BROWSER_PICKER_YAML="$home/.config/kde-browser-picker.yaml"
+    export QT_QPA_PLATFORM=offscreen
+    # 実際のセッションバスの起動中ブラウザにURLを渡さない
+    export DBUS_SESSION_BUS_ADDRESS="unix:path=$home/no-session-bus"
+}
@@ -0,0 +1,45 @@
+#!/bin/bash
+set -e
+
+# PGO学習用ビルド（KBP_PGO=generate）のピッカーを偽のHOMEで自動操作する
+#
+#   tools/pgo/train.sh build/kde-browser-picker
+#
+# 検出（スナップショットなし/あり）、検索、Enter による起動と、
+# --browser/--profile によるピッカーを表示しない起動を繰り返します。
+
+BINARY="$(realpath "$1")"
+ROUNDS="${KBP_TRAINING_ROUNDS:-5}"
+URL="https://example.com/path?q=training"
+
+if [ ! -x "$BINARY" ]; then
+    echo "Usage: $0 <kde-browser-picker built with KBP_PGO=generate>" >&2
+    exit 1
+fi
+
+source "$(dirname "$0")/fakehome.sh"
+FAKE_HOME="$(mktemp -d)"
+trap 'rm -rf "$FAKE_HOME"' EXIT
+kbp_fake_home "$FAKE_HOME"
+export KBP_TRAINING=1
+
+pick() {
+    KBP_TRAINING_SEARCH="$1" "$BINARY" "$URL"
+}
+
+for round in $(seq "$ROUNDS"); do
+    echo "Training round $round/$ROUNDS"
+
+    # 初回起動（前回の検出結果・アバターのキャッシュなし）
+    rm -rf "$XDG_CACHE_HOME"
+    pick ""
+
+    # 前回の検出結果から表示して検索・起動
+    pick "work"
+    pick "chromium"
+    pick "shopping"
+
+    # ピッカーを表示しない起動
+    "$BINARY" --browser firefox --profile work "$URL"
+    "$BINARY" --browser chromium --profile "Profile 1" "$URL"
+done
@@ -0,0 +1,125 @@
+/**
+ * @file trainingdriver.cpp
+ * @brief PGO学習用ビルドでピッカーを自動操作するドライバー
+ *
+ * KBP_PGO=generate のビルドにのみリンクされます。環境変数 KBP_TRAINING が
+ * 設定されている場合、ピッカーの表示後にプロファイル一覧の検出完了を待ち、
+ * 検索語（KBP_TRAINING_SEARCH）の入力と Enter による起動をキーイベントで再現します。
+ *
+ * main.cpp を変更せずに Q_COREAPP_STARTUP_FUNCTION で組み込むため、
+ * 学習用ビルドと最適化ビルドでプロファイルの対象となるコードは一致します。
+ */
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QKeyEvent>
+#include <QLineEdit>
+#include <QTimer>
+#include <QWidget>
+
+#include <memory>
+
+namespace {
+
+constexpr int POLL_MS = 20;         ///< ウィンドウ状態の確認間隔
+constexpr int STABLE_MS = 300;      ///< 一覧の件数がこの時間変化しなければ検出完了とみなす
+constexpr int DEADLINE_MS = 15000;  ///< 操作を諦めて終了するまでの時間
+
+/**
+ * @brief 表示中のピッカーのウィンドウ
+ */
+QWidget* pickerWindow()
+{
+    for (QWidget* widget : QApplication::topLevelWidgets()) {
+        if (widget->isVisible() && widget->inherits("MainWindow")) {
+            return widget;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief 一覧に表示されているプロファイルの数
+ */
+int profileItemCount(const QWidget* window)
+{
+    int count = 0;
+    for (const QWidget* child : window->findChildren<QWidget*>()) {
+        if (child->inherits("ProfileItem") && !child->isHidden()) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void sendKey(QWidget* target, int key, const QString& text = QString())
+{
+    QKeyEvent press(QEvent::KeyPress, key, Qt::NoModifier, text);
+    QCoreApplication::sendEvent(target, &press);
+    QKeyEvent release(QEvent::KeyRelease, key, Qt::NoModifier, text);
+    QCoreApplication::sendEvent(target, &release);
+}
+
+/**
+ * @brief 検索フィールドに1文字ずつ入力（ASCIIのみ）
+ */
+void typeQuery(QWidget* window, const QString& query)
+{
+    auto* search = window->findChild<QLineEdit*>("searchLineEdit");
+    if (!search) {
+        return;
+    }
+    search->setFocus();
+    for (const QChar c : query) {
+        // ASCIIの英数字・空白はキーコードと文字コードが一致する
+        sendKey(search, c.toUpper().unicode(), QString(c));
+    }
+}
+
+void startTraining()
+{
+    if (!qEnvironmentVariableIsSet("KBP_TRAINING")) {
+        return;
+    }
+
+    struct State {
+        QElapsedTimer stable;
+        int lastCount = -1;
+    };
+    auto state = std::make_shared<State>();
+    const QString query = qEnvironmentVariable("KBP_TRAINING_SEARCH");
+
+    auto* poll = new QTimer(QCoreApplication::instance());
+    QObject::connect(poll, &QTimer::timeout, poll, [poll, state, query]() {
+        QWidget* window = pickerWindow();
+        if (!window) {
+            return;
+        }
+
+        // 前回のスナップショットによる表示の後、バックグラウンドの検出が終わるまで待つ
+        const int count = profileItemCount(window);
+        if (count != state->lastCount) {
+            state->lastCount = count;
+            state->stable.restart();
+            return;
+        }
+        if (count == 0 || state->stable.elapsed() < STABLE_MS) {
+            return;
+        }
+
+        poll->stop();
+        typeQuery(window, query);
+        sendKey(window, Qt::Key_Return);
+    });
+    poll->start(POLL_MS);
+
+    // 起動できずにウィンドウが残った場合も学習データを書き出して終了する
+    QTimer::singleShot(DEADLINE_MS, QCoreApplication::instance(), []() {
+        qWarning("Training run did not finish, exiting");
+        QCoreApplication::exit(1);
+    });
+}
+
+} // namespace
+
+Q_COREAPP_STARTUP_FUNCTION(startTraining)